@@ -0,0 +1,210 @@
+// The engine end to end on the fake TRDP stack and the virtual clock: a cyclic PD publication with a PD stream fed
+// back into a subscription, and MD requests answered by the engine's own replier. Exits non-zero when a publication,
+// an RX update or a reply goes missing. Usage: trdp_engine_benchmark [simulated-seconds] [md-requests]
+#include "fake_stack/fake_trdp_stack.h"
+#include "telegram_events.h"
+#include "telegram_model.h"
+#include "trdp_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr std::uint32_t kPdTxComId = 1000;
+constexpr std::uint32_t kPdRxComId = 2000;
+constexpr std::uint32_t kMdComId = 3000;
+constexpr std::uint32_t kMdReplyComId = 3001;
+constexpr std::chrono::milliseconds kCycle{10};
+constexpr double kRxRatePerSecond = 1000.0;
+// Wall-clock bound on every wait, so a lost telegram fails the run instead of hanging it.
+constexpr std::chrono::seconds kWallLimit{30};
+
+// Counts what the engine reports instead of forwarding it to WebSocket clients.
+class CountingSink : public trdp::TelegramEventSink {
+  public:
+    std::atomic<std::uint64_t> rxUpdates{0};
+    std::atomic<std::uint64_t> mdReplies{0};
+    // Stamped on the thread that delivers the reply, so the waiting thread's scheduling does not count.
+    std::atomic<std::chrono::steady_clock::rep> lastReplyAt{0};
+
+    bool hasSubscribers() override { return false; }
+
+    void publishRxUpdate(std::uint32_t comId, const std::map<std::string, trdp::FieldValue> &) override {
+        if (comId == kPdRxComId) {
+            rxUpdates.fetch_add(1, std::memory_order_relaxed);
+        } else if (comId == kMdReplyComId) {
+            lastReplyAt.store(std::chrono::steady_clock::now().time_since_epoch().count());
+            mdReplies.fetch_add(1);
+        }
+    }
+
+    void publishTxConfirmation(std::uint32_t, const std::map<std::string, trdp::FieldValue> &,
+                               std::optional<bool>) override {}
+
+    void publishMdStatus(const std::string &, std::uint32_t, const std::string &, const std::string &, std::uint32_t,
+                         std::uint32_t, const std::string &, const Json::Value &, const Json::Value &) override {}
+};
+
+trdp::RegistrySnapshot benchRegistry() {
+    trdp::RegistrySnapshot snapshot;
+    trdp::DatasetDef dataset;
+    dataset.name = "BenchDataset";
+    dataset.size = 8;
+    dataset.fields.push_back(trdp::FieldDef{"Value", trdp::FieldType::UINT32, 0, 4, 0, 1});
+    dataset.fields.push_back(trdp::FieldDef{"Status", trdp::FieldType::UINT32, 4, 4, 0, 1});
+    snapshot.addDataset(dataset);
+
+    trdp::TelegramDef pdTx;
+    pdTx.comId = kPdTxComId;
+    pdTx.name = "BenchPdTx";
+    pdTx.type = trdp::TelegramType::PD;
+    pdTx.direction = trdp::Direction::Tx;
+    pdTx.datasetName = dataset.name;
+    pdTx.destIp = 0x0A000002U;
+    pdTx.srcPort = pdTx.destPort = 17224;
+    pdTx.cycle = kCycle;
+    pdTx.generators = {{"Value", trdp::FieldGeneratorKind::Counter, 0, 0, 1, std::chrono::milliseconds(1000), 0, 1}};
+    snapshot.addTelegram(pdTx);
+
+    trdp::TelegramDef pdRx = pdTx;
+    pdRx.comId = kPdRxComId;
+    pdRx.name = "BenchPdRx";
+    pdRx.direction = trdp::Direction::Rx;
+    pdRx.destIp = 0;
+    pdRx.cycle = {};
+    pdRx.generators.clear();
+    snapshot.addTelegram(pdRx);
+
+    // Every MD endpoint listens on its ComId, so the engine's requests reach its own replier. The replies carry
+    // their own ComId, which tells them apart from the requests arriving at that listener.
+    trdp::TelegramDef md;
+    md.comId = kMdComId;
+    md.name = "BenchMd";
+    md.type = trdp::TelegramType::MD;
+    md.direction = trdp::Direction::Tx;
+    md.datasetName = dataset.name;
+    md.destIp = 0x0A000002U;
+    md.srcPort = md.destPort = 17225;
+    md.replier.enabled = true;
+    md.replier.replyComId = kMdReplyComId;
+    snapshot.addTelegram(md);
+
+    trdp::TelegramDef mdReply = md;
+    mdReply.comId = kMdReplyComId;
+    mdReply.name = "BenchMdReply";
+    mdReply.direction = trdp::Direction::Rx;
+    mdReply.destIp = 0;
+    mdReply.replier = {};
+    snapshot.addTelegram(mdReply);
+    return snapshot;
+}
+
+template <typename Done> bool waitFor(Done done) {
+    const auto deadline = std::chrono::steady_clock::now() + kWallLimit;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const double simulatedSeconds = argc > 1 ? std::strtod(argv[1], nullptr) : 60.0;
+    const std::uint32_t mdRequests = argc > 2 ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1000U;
+    if (simulatedSeconds <= 0.0) {
+        std::cerr << "usage: trdp_engine_benchmark [simulated-seconds] [md-requests]" << std::endl;
+        return 2;
+    }
+
+    trdp::TelegramRegistry::instance().publish(benchRegistry());
+    trdp::markRegistryPopulated();
+
+    auto &fake = trdp::FakeTrdpStack::instance();
+    trdp::FakeTrdpStack::RxStream stream;
+    stream.comId = kPdRxComId;
+    stream.ratePerSecond = kRxRatePerSecond;
+    stream.payload = {0, 0, 0, 42, 0, 0, 0, 1};
+    const auto streamId = fake.addRxStream(stream);
+
+    CountingSink sink;
+    auto &engine = trdp::TrdpEngine::instance();
+    engine.setHub(&sink);
+    engine.setPdSendLogging(false);
+    trdp::TrdpEngine::TrdpConfig config;
+    config.virtualTime = true;
+    if (!engine.start(config)) {
+        std::cerr << "engine did not start on the fake stack" << std::endl;
+        return 1;
+    }
+
+    // PD: the cyclic publication and the injected stream run until the virtual clock reaches the target; then
+    // the stream stops and everything it injected must have reached the subscription.
+    const auto pdStarted = std::chrono::steady_clock::now();
+    bool ok = waitFor([&]() { return engine.transportStatus().clockSeconds >= simulatedSeconds; });
+    const auto simulated = engine.transportStatus().clockSeconds;
+    const auto published = fake.stats().pdPublished;
+    fake.removeRxStream(streamId);
+    ok = waitFor([&]() { return sink.rxUpdates.load() == fake.stats().pdInjected; }) && ok;
+    const auto pdWall = std::chrono::duration<double>(std::chrono::steady_clock::now() - pdStarted).count();
+    const auto injected = fake.stats().pdInjected;
+    const auto rxUpdates = sink.rxUpdates.load();
+    const auto expectedPublications =
+        static_cast<std::uint64_t>(simulated / std::chrono::duration<double>(kCycle).count());
+    const auto expectedRx = static_cast<std::uint64_t>(simulated * kRxRatePerSecond);
+    engine.stopTxTelegram(kPdTxComId);
+
+    // MD round trips, one at a time: the request, the replier's answer and its arrival at the requester.
+    trdp::MdSendOptions request;
+    request.mode = trdp::MdMode::Request;
+    request.expectedReplies = 1;
+    request.replyTimeout = std::chrono::milliseconds(1000);
+    std::chrono::steady_clock::duration roundTrips{0};
+    for (std::uint32_t i = 0; i < mdRequests && ok; ++i) {
+        const auto sent = std::chrono::steady_clock::now();
+        if (!engine.sendTxTelegram(kMdComId, {{"Value", i}}, request)) {
+            std::cerr << "MD request " << i << " was not sent" << std::endl;
+            ok = false;
+            break;
+        }
+        ok = waitFor([&]() { return sink.mdReplies.load() > i; });
+        roundTrips += std::chrono::steady_clock::duration(sink.lastReplyAt.load()) - sent.time_since_epoch();
+    }
+    const auto replier = engine.mdReplierStats(kMdComId);
+    engine.stop();
+    engine.setHub(nullptr);
+    const auto mdStats = fake.stats();
+    const auto replies = sink.mdReplies.load();
+
+    std::cout << std::fixed << std::setprecision(2) << "PD   simulated " << simulated << " s in " << pdWall
+              << " s wall (" << simulated / pdWall << "x): published " << published << " (expected "
+              << expectedPublications << "), received " << rxUpdates << " of " << injected
+              << " injected (expected " << expectedRx << ")" << std::endl;
+    std::cout << "MD   " << replies << " of " << mdRequests << " replies to "
+              << (replier ? replier->requests : 0U) << " requests answered, " << mdStats.mdReplyTimeouts
+              << " reply timeouts, "
+              << std::chrono::duration<double, std::micro>(roundTrips).count() / std::max(mdRequests, 1U)
+              << " us per round trip" << std::endl;
+
+    // One cycle of slack at either end of the run.
+    ok = ok && published + 1U >= expectedPublications && rxUpdates == injected &&
+         rxUpdates + 1U >= expectedRx && replies == mdRequests && mdStats.mdReplyTimeouts == 0U;
+    if (!ok) {
+        std::cerr << "engine benchmark lost telegrams" << std::endl;
+        return 1;
+    }
+    return 0;
+}
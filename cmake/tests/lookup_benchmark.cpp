@@ -0,0 +1,171 @@
+// Lookup cost of the flat ComId indexes and the perfect-hash field index against the std::map / linear-scan
+// lookups they replace. Usage: trdp_lookup_benchmark [telegrams] [fields-per-dataset]
+#include "flat_index.h"
+#include "telegram_model.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kLookups = 4'000'000;
+
+// Keeps the optimiser from discarding lookup results.
+volatile std::uintptr_t sink = 0;
+
+template <typename Lookup> double nsPerLookup(const std::vector<std::uint32_t> &keys, Lookup lookup) {
+    std::uintptr_t accumulated = 0;
+    const auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < kLookups; ++i) {
+        accumulated += reinterpret_cast<std::uintptr_t>(lookup(keys[i % keys.size()]));
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    sink = sink + accumulated;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(kLookups);
+}
+
+template <typename Lookup> double nsPerFieldLookup(const std::vector<std::string> &names, Lookup lookup) {
+    std::uintptr_t accumulated = 0;
+    const auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < kLookups; ++i) {
+        accumulated += reinterpret_cast<std::uintptr_t>(lookup(names[i % names.size()]));
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    sink = sink + accumulated;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(kLookups);
+}
+
+void report(const std::string &label, double baseline, double indexed) {
+    std::cout << std::left << std::setw(44) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << baseline << " ns" << std::setw(9) << indexed << " ns" << std::setw(8)
+              << baseline / indexed << "x" << std::endl;
+}
+
+// Compare ComIdIndex and FlatComIdMap with std::map over one key set; false when any lookup disagrees.
+bool benchComIds(const std::string &label, const std::vector<std::uint32_t> &comIds, std::mt19937 &rng) {
+    std::map<std::uint32_t, std::uint32_t> map;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> entries;
+    trdp::FlatComIdMap<std::uint32_t> flat;
+    for (const auto comId : comIds) {
+        map[comId] = comId ^ 0x5A5AU;
+        entries.emplace_back(comId, comId ^ 0x5A5AU);
+        flat[comId] = comId ^ 0x5A5AU;
+    }
+    trdp::ComIdIndex<std::uint32_t> index;
+    index.build(entries);
+
+    // Mostly hits in random order, plus some misses.
+    std::vector<std::uint32_t> keys;
+    std::uniform_int_distribution<std::size_t> pick(0, comIds.size() - 1U);
+    for (std::size_t i = 0; i < 1U << 16U; ++i) {
+        keys.push_back(i % 8U == 0U ? comIds[pick(rng)] + 0x01000000U : comIds[pick(rng)]);
+    }
+    for (const auto key : keys) {
+        const auto it = map.find(key);
+        const auto *expected = it != map.end() ? &it->second : nullptr;
+        const auto *fromIndex = index.find(key);
+        const auto *fromFlat = flat.find(key);
+        if ((expected == nullptr) != (fromIndex == nullptr) || (expected == nullptr) != (fromFlat == nullptr) ||
+            (expected != nullptr && (*expected != *fromIndex || *expected != *fromFlat))) {
+            std::cerr << label << ": lookup of ComId " << key << " disagrees with std::map" << std::endl;
+            return false;
+        }
+    }
+
+    const auto mapNs = nsPerLookup(keys, [&](std::uint32_t key) -> const void * {
+        const auto it = map.find(key);
+        return it != map.end() ? &it->second : nullptr;
+    });
+    report(label + (index.isDense() ? " ComIdIndex (dense)" : " ComIdIndex (hashed)"), mapNs,
+           nsPerLookup(keys, [&](std::uint32_t key) -> const void * { return index.find(key); }));
+    report(label + " FlatComIdMap", mapNs,
+           nsPerLookup(keys, [&](std::uint32_t key) -> const void * { return flat.find(key); }));
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const std::size_t telegramCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000U;
+    const std::size_t fieldCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64U;
+    if (telegramCount == 0U || fieldCount == 0U) {
+        std::cerr << "usage: trdp_lookup_benchmark [telegrams] [fields-per-dataset]" << std::endl;
+        return 1;
+    }
+    std::mt19937 rng(42);
+
+    std::cout << telegramCount << " telegrams, " << fieldCount << " fields per dataset, " << kLookups
+              << " lookups per row" << std::endl;
+    std::cout << std::left << std::setw(44) << "lookup" << std::right << std::setw(12) << "baseline" << std::setw(12)
+              << "indexed" << std::setw(9) << "speedup" << std::endl;
+
+    std::vector<std::uint32_t> contiguous;
+    std::vector<std::uint32_t> sparse;
+    std::uniform_int_distribution<std::uint32_t> anyComId(1U, 0x00FFFFFFU);
+    for (std::size_t i = 0; i < telegramCount; ++i) {
+        contiguous.push_back(static_cast<std::uint32_t>(1000U + i));
+        sparse.push_back(anyComId(rng));
+    }
+    if (!benchComIds("contiguous", contiguous, rng) || !benchComIds("sparse", sparse, rng)) {
+        return 1;
+    }
+
+    // Registry lookups: the published snapshot's index against its ComId map.
+    trdp::RegistrySnapshot contents;
+    trdp::DatasetDef dataset;
+    dataset.name = "wide";
+    for (std::size_t i = 0; i < fieldCount; ++i) {
+        trdp::FieldDef field;
+        field.name = "signal_" + std::to_string(i) + "_value";
+        field.type = trdp::FieldType::UINT32;
+        field.offset = i * 4U;
+        dataset.fields.push_back(field);
+    }
+    contents.addDataset(dataset);
+    for (const auto comId : sparse) {
+        trdp::TelegramDef telegram;
+        telegram.comId = comId;
+        telegram.datasetName = dataset.name;
+        contents.addTelegram(telegram);
+    }
+    // Before the index: the ComId map, then the dataset map by name.
+    const auto registryNs = nsPerLookup(sparse, [&](std::uint32_t key) -> const void * {
+        const auto it = contents.telegrams.find(key);
+        return it != contents.telegrams.end() ? contents.findDataset(it->second->datasetName) : nullptr;
+    });
+    contents.buildIndex();
+    report("RegistrySnapshot::datasetOf", registryNs,
+           nsPerLookup(sparse, [&](std::uint32_t key) -> const void * { return contents.datasetOf(key); }));
+
+    // Field names: linear scan of an unindexed copy against the perfect-hash index.
+    const auto *indexed = contents.findDataset(dataset.name);
+    std::vector<std::string> names;
+    std::uniform_int_distribution<std::size_t> anyField(0, fieldCount - 1U);
+    for (std::size_t i = 0; i < 1U << 12U; ++i) {
+        names.push_back(dataset.fields[anyField(rng)].name);
+    }
+    for (const auto &field : dataset.fields) {
+        if (indexed->findField(field.name) != &indexed->fields[static_cast<std::size_t>(&field - dataset.fields.data())]) {
+            std::cerr << "field index: lookup of " << field.name << " returned the wrong field" << std::endl;
+            return 1;
+        }
+    }
+    if (indexed->findField("missing") != nullptr) {
+        std::cerr << "field index: lookup of an unknown name succeeded" << std::endl;
+        return 1;
+    }
+    report("DatasetDef::findField", nsPerFieldLookup(names, [&](const std::string &name) -> const void * {
+               return dataset.findField(name);
+           }),
+           nsPerFieldLookup(names, [&](const std::string &name) -> const void * { return indexed->findField(name); }));
+    std::cout << "field index: " << indexed->fieldIndex.footprint() << " bytes" << std::endl;
+    return 0;
+}
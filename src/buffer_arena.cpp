@@ -0,0 +1,43 @@
+#include "buffer_arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace trdp {
+
+namespace {
+
+std::size_t roundUp(std::size_t value, std::size_t alignment) { return (value + alignment - 1U) / alignment * alignment; }
+
+} // namespace
+
+void BufferArena::Free::operator()(std::uint8_t *data) const { std::free(data); }
+
+std::shared_ptr<BufferArena> BufferArena::create(const std::vector<Request> &requests) {
+    std::shared_ptr<BufferArena> arena(new BufferArena());
+    std::size_t blockAlignment = kCacheLine;
+    std::size_t offset = 0;
+    arena->offsets.reserve(requests.size());
+    arena->capacities.reserve(requests.size());
+    for (const auto &request : requests) {
+        const auto alignment = std::max(kCacheLine, roundUp(request.alignment, kCacheLine));
+        blockAlignment = std::max(blockAlignment, alignment);
+        offset = roundUp(offset, alignment);
+        const auto capacity = roundUp(std::max<std::size_t>(request.size, 1U), alignment);
+        arena->offsets.push_back(offset);
+        arena->capacities.push_back(capacity);
+        offset += capacity;
+    }
+    arena->total = roundUp(std::max(offset, blockAlignment), blockAlignment);
+    auto *data = static_cast<std::uint8_t *>(std::aligned_alloc(blockAlignment, arena->total));
+    if (data == nullptr) {
+        throw std::bad_alloc();
+    }
+    std::memset(data, 0, arena->total);
+    arena->block.reset(data);
+    return arena;
+}
+
+} // namespace trdp
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * One contiguous block carved into telegram buffers, laid out in the order they were requested.
+ *
+ * Every slot starts on a cache line and is padded to a whole number of its alignment, so a thread writing one
+ * buffer never invalidates a line another thread is reading from the neighbouring buffer. The layout is fixed
+ * at creation; slots are handed out by position and the arena lives as long as any runtime refers to it.
+ */
+class BufferArena {
+  public:
+    static constexpr std::size_t kCacheLine = 64;
+    // For buffers rewritten on every publication or receipt: adjacent-line prefetchers pull lines in 128-byte
+    // pairs, so these are kept a full pair apart from their neighbours.
+    static constexpr std::size_t kWriterAlignment = 2 * kCacheLine;
+
+    struct Request {
+        std::size_t size{0};
+        std::size_t alignment{kCacheLine};
+    };
+
+    static std::shared_ptr<BufferArena> create(const std::vector<Request> &requests);
+
+    BufferArena(const BufferArena &) = delete;
+    BufferArena &operator=(const BufferArena &) = delete;
+
+    [[nodiscard]] std::uint8_t *slot(std::size_t index) const { return block.get() + offsets[index]; }
+    // Usable bytes of a slot, including its padding.
+    [[nodiscard]] std::size_t slotCapacity(std::size_t index) const { return capacities[index]; }
+    [[nodiscard]] std::size_t slotCount() const noexcept { return offsets.size(); }
+    [[nodiscard]] std::size_t footprint() const noexcept { return total; }
+
+  private:
+    struct Free {
+        void operator()(std::uint8_t *data) const;
+    };
+
+    BufferArena() = default;
+
+    std::unique_ptr<std::uint8_t, Free> block;
+    std::vector<std::size_t> offsets;
+    std::vector<std::size_t> capacities;
+    std::size_t total{0};
+};
+
+} // namespace trdp
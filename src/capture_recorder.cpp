@@ -0,0 +1,391 @@
+#include "capture_recorder.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace trdp {
+
+namespace {
+
+constexpr std::size_t kIpv4HeaderSize = 20U;
+constexpr std::size_t kUdpHeaderSize = 8U;
+constexpr std::size_t kMaxIpv4Packet = 0xFFFFU;
+constexpr std::size_t kMinFileBytes = 64U * 1024U;
+constexpr std::uint32_t kMaxFileCount = 1024U;
+
+// pcapng block layout (section 4 of the pcapng specification), written in host byte order.
+constexpr std::uint32_t kSectionHeaderBlock = 0x0A0D0D0AU;
+constexpr std::uint32_t kInterfaceDescriptionBlock = 0x00000001U;
+constexpr std::uint32_t kEnhancedPacketBlock = 0x00000006U;
+constexpr std::uint32_t kByteOrderMagic = 0x1A2B3C4DU;
+constexpr std::uint16_t kLinkTypeRaw = 101U;
+constexpr std::size_t kSectionHeaderSize = 28U;
+constexpr std::size_t kInterfaceDescriptionSize = 40U;
+constexpr std::size_t kFileHeaderSize = kSectionHeaderSize + kInterfaceDescriptionSize;
+// Fixed EPB fields (28) plus the epb_flags option (8), opt_endofopt (4) and the trailing length (4).
+constexpr std::size_t kPacketBlockOverhead = 44U;
+constexpr std::uint32_t kEpbFlagsInbound = 1U;
+constexpr std::uint32_t kEpbFlagsOutbound = 2U;
+
+constexpr std::size_t padded(std::size_t length) {
+    return (length + 3U) & ~static_cast<std::size_t>(3U);
+}
+
+void put16(std::uint8_t *&dest, std::uint16_t value) {
+    std::memcpy(dest, &value, sizeof(value));
+    dest += sizeof(value);
+}
+
+void put32(std::uint8_t *&dest, std::uint32_t value) {
+    std::memcpy(dest, &value, sizeof(value));
+    dest += sizeof(value);
+}
+
+void putBe16(std::uint8_t *dest, std::uint16_t value) {
+    dest[0] = static_cast<std::uint8_t>(value >> 8U);
+    dest[1] = static_cast<std::uint8_t>(value);
+}
+
+void putBe32(std::uint8_t *dest, std::uint32_t value) {
+    dest[0] = static_cast<std::uint8_t>(value >> 24U);
+    dest[1] = static_cast<std::uint8_t>(value >> 16U);
+    dest[2] = static_cast<std::uint8_t>(value >> 8U);
+    dest[3] = static_cast<std::uint8_t>(value);
+}
+
+std::uint16_t ipv4Checksum(const std::uint8_t *header) {
+    std::uint32_t sum = 0;
+    for (std::size_t i = 0; i < kIpv4HeaderSize; i += 2U) {
+        sum += static_cast<std::uint32_t>((header[i] << 8U) | header[i + 1U]);
+    }
+    while ((sum >> 16U) != 0U) {
+        sum = (sum & 0xFFFFU) + (sum >> 16U);
+    }
+    return static_cast<std::uint16_t>(~sum);
+}
+
+// Section header plus a single raw-IPv4 interface with nanosecond timestamps.
+std::size_t writeFileHeader(std::uint8_t *dest) {
+    auto *p = dest;
+    put32(p, kSectionHeaderBlock);
+    put32(p, kSectionHeaderSize);
+    put32(p, kByteOrderMagic);
+    put16(p, 1U); // major version
+    put16(p, 0U); // minor version
+    put32(p, 0xFFFFFFFFU); // section length unknown (-1 as 64 bit)
+    put32(p, 0xFFFFFFFFU);
+    put32(p, kSectionHeaderSize);
+
+    put32(p, kInterfaceDescriptionBlock);
+    put32(p, kInterfaceDescriptionSize);
+    put16(p, kLinkTypeRaw);
+    put16(p, 0U); // reserved
+    put32(p, 0U); // snaplen: unlimited
+    put16(p, 2U); // if_name
+    put16(p, 4U);
+    std::memcpy(p, "trdp", 4U);
+    p += 4;
+    put16(p, 9U); // if_tsresol: 10^-9
+    put16(p, 1U);
+    put32(p, 9U); // value byte plus padding
+    put32(p, 0U); // opt_endofopt
+    put32(p, kInterfaceDescriptionSize);
+    return static_cast<std::size_t>(p - dest);
+}
+
+} // namespace
+
+CaptureRecorder &CaptureRecorder::instance() {
+    static CaptureRecorder recorder;
+    return recorder;
+}
+
+CaptureRecorder::~CaptureRecorder() {
+    shutdown();
+}
+
+bool CaptureRecorder::start(const Config &config, std::string &error) {
+    std::lock_guard control(controlMtx);
+    if (recording.load()) {
+        error = "Capture already running";
+        return false;
+    }
+    if (config.fileCount < 2U || config.fileCount > kMaxFileCount) {
+        error = "fileCount must be between 2 and " + std::to_string(kMaxFileCount);
+        return false;
+    }
+    if (config.fileBytes < kMinFileBytes) {
+        error = "fileBytes must be at least " + std::to_string(kMinFileBytes);
+        return false;
+    }
+    if (config.prefix.empty() || config.prefix.find('/') != std::string::npos) {
+        error = "prefix must be a plain file name prefix";
+        return false;
+    }
+    if (config.rotateAfter.count() < 0) {
+        error = "rotateAfter must not be negative";
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(config.directory, ec);
+    if (ec) {
+        error = "Unable to create capture directory '" + config.directory + "': " + ec.message();
+        return false;
+    }
+
+    // A new capture replaces the previous ring in the same directory.
+    shutdown();
+    activeConfig = config;
+    files.assign(config.fileCount, RingFile{});
+    for (std::uint32_t i = 0; i < config.fileCount; ++i) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "_%02u.pcapng", i);
+        auto &file = files[i];
+        file.path = (std::filesystem::path(config.directory) / (config.prefix + name)).string();
+        file.fd = ::open(file.path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (file.fd < 0) {
+            error = "Unable to open '" + file.path + "': " + std::strerror(errno);
+            shutdown();
+            return false;
+        }
+    }
+    if (!mapFile(files[0]) || !mapFile(files[1])) {
+        error = "Unable to pre-allocate capture files of " + std::to_string(config.fileBytes) + " bytes in '" +
+                config.directory + "'";
+        shutdown();
+        return false;
+    }
+
+    {
+        std::lock_guard lock(writeMtx);
+        current = 0;
+        files[0].used = writeFileHeader(files[0].map);
+        files[0].openedAtNs = 0;
+        next = 1U;
+        toFinalise.clear();
+        wantNext = false;
+        housekeepingStop = false;
+        packets = 0;
+        bytes = 0;
+        dropped = 0;
+        rotations = 0;
+        recording = true;
+    }
+    housekeeper = std::thread([this]() { housekeeping(); });
+
+    std::cout << "[TRDP] Capture started in " << config.directory << " (" << config.fileCount << " x "
+              << config.fileBytes / 1024U << " KiB)" << std::endl;
+    return true;
+}
+
+void CaptureRecorder::stop() {
+    std::lock_guard control(controlMtx);
+    if (!recording.load()) {
+        return;
+    }
+    shutdown();
+    std::cout << "[TRDP] Capture stopped after " << packets.load() << " telegrams (" << dropped.load()
+              << " dropped)" << std::endl;
+}
+
+void CaptureRecorder::shutdown() {
+    {
+        std::lock_guard lock(writeMtx);
+        recording = false;
+        housekeepingStop = true;
+    }
+    housekeepingCv.notify_all();
+    if (housekeeper.joinable()) {
+        housekeeper.join();
+    }
+    // Writers are gone; trim every file to the data it holds.
+    for (auto &file : files) {
+        finaliseFile(file);
+        if (file.fd >= 0) {
+            ::close(file.fd);
+            file.fd = -1;
+        }
+    }
+    next.reset();
+    toFinalise.clear();
+}
+
+CaptureRecorder::Status CaptureRecorder::status() {
+    std::lock_guard control(controlMtx);
+    Status status;
+    status.running = recording.load();
+    status.config = activeConfig;
+    status.packets = packets.load(std::memory_order_relaxed);
+    status.bytes = bytes.load(std::memory_order_relaxed);
+    status.dropped = dropped.load(std::memory_order_relaxed);
+    status.rotations = rotations.load(std::memory_order_relaxed);
+    std::lock_guard lock(writeMtx);
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        status.files.push_back(FileStatus{files[i].path, files[i].used, status.running && i == current});
+    }
+    return status;
+}
+
+bool CaptureRecorder::mapFile(RingFile &file) {
+    if (file.map != nullptr) {
+        return true;
+    }
+    // Allocate the blocks up front so a full disk fails here rather than as SIGBUS in a writer.
+    if (posix_fallocate(file.fd, 0, static_cast<off_t>(activeConfig.fileBytes)) != 0) {
+        std::cerr << "[TRDP] Capture: unable to pre-allocate " << file.path << std::endl;
+        return false;
+    }
+    void *map = ::mmap(nullptr, activeConfig.fileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+    if (map == MAP_FAILED) {
+        std::cerr << "[TRDP] Capture: unable to map " << file.path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    ::madvise(map, activeConfig.fileBytes, MADV_SEQUENTIAL);
+    file.map = static_cast<std::uint8_t *>(map);
+    return true;
+}
+
+void CaptureRecorder::finaliseFile(RingFile &file) {
+    if (file.map == nullptr) {
+        return;
+    }
+    ::munmap(file.map, activeConfig.fileBytes);
+    file.map = nullptr;
+    if (::ftruncate(file.fd, static_cast<off_t>(file.used)) != 0) {
+        std::cerr << "[TRDP] Capture: unable to trim " << file.path << ": " << std::strerror(errno) << std::endl;
+    }
+}
+
+bool CaptureRecorder::rotateLocked(std::int64_t nowNs) {
+    if (!next) {
+        return false;
+    }
+    toFinalise.push_back(current);
+    current = *next;
+    next.reset();
+    auto &file = files[current];
+    file.used = writeFileHeader(file.map);
+    file.openedAtNs = nowNs;
+    wantNext = true;
+    rotations.fetch_add(1, std::memory_order_relaxed);
+    housekeepingCv.notify_one();
+    return true;
+}
+
+void CaptureRecorder::housekeeping() {
+    std::unique_lock lock(writeMtx);
+    while (!housekeepingStop) {
+        if (toFinalise.empty() && !wantNext) {
+            housekeepingCv.wait(lock);
+            continue;
+        }
+        auto finalise = std::move(toFinalise);
+        toFinalise.clear();
+        const bool prepare = wantNext;
+        wantNext = false;
+        const auto candidate = (current + 1U) % files.size();
+        lock.unlock();
+
+        // The writer never touches files other than the current one, so these run without the lock.
+        for (const auto index : finalise) {
+            finaliseFile(files[index]);
+        }
+        const bool mapped = prepare && mapFile(files[candidate]);
+
+        lock.lock();
+        if (mapped) {
+            next = candidate;
+        } else if (prepare) {
+            wantNext = true;
+            housekeepingCv.wait_for(lock, std::chrono::seconds(1), [this]() { return housekeepingStop; });
+        }
+    }
+}
+
+void CaptureRecorder::record(const CapturedTelegram &telegram) {
+    const auto headerSize = trdpHeaderSize(telegram.header.msgType);
+    const auto packetLength = kIpv4HeaderSize + kUdpHeaderSize + headerSize + telegram.size;
+    if (packetLength > kMaxIpv4Packet) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const auto blockLength = kPacketBlockOverhead + padded(packetLength);
+    const auto nowNs = telegram.timestampNs;
+
+    std::lock_guard lock(writeMtx);
+    if (!recording.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto *file = &files[current];
+    if (file->openedAtNs == 0) {
+        file->openedAtNs = nowNs;
+    }
+    const auto rotateAfterNs = std::chrono::duration_cast<std::chrono::nanoseconds>(activeConfig.rotateAfter).count();
+    const bool expired = rotateAfterNs > 0 && nowNs - file->openedAtNs >= rotateAfterNs;
+    if (expired || file->used + blockLength > activeConfig.fileBytes) {
+        if (kFileHeaderSize + blockLength > activeConfig.fileBytes || !rotateLocked(nowNs)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        file = &files[current];
+    }
+
+    const auto timestamp = static_cast<std::uint64_t>(nowNs);
+    auto *p = file->map + file->used;
+    put32(p, kEnhancedPacketBlock);
+    put32(p, static_cast<std::uint32_t>(blockLength));
+    put32(p, 0U); // interface id
+    put32(p, static_cast<std::uint32_t>(timestamp >> 32U));
+    put32(p, static_cast<std::uint32_t>(timestamp));
+    put32(p, static_cast<std::uint32_t>(packetLength));
+    put32(p, static_cast<std::uint32_t>(packetLength));
+
+    auto *ip = p;
+    ip[0] = 0x45U; // IPv4, 20 byte header
+    ip[1] = 0U;
+    putBe16(ip + 2, static_cast<std::uint16_t>(packetLength));
+    putBe16(ip + 4, ipIdentification++);
+    putBe16(ip + 6, 0x4000U); // don't fragment
+    ip[8] = 64U;
+    ip[9] = 17U; // UDP
+    putBe16(ip + 10, 0U);
+    putBe32(ip + 12, telegram.srcIp);
+    putBe32(ip + 16, telegram.destIp);
+    putBe16(ip + 10, ipv4Checksum(ip));
+
+    auto *udp = ip + kIpv4HeaderSize;
+    putBe16(udp + 0, telegram.srcPort);
+    putBe16(udp + 2, telegram.destPort);
+    putBe16(udp + 4, static_cast<std::uint16_t>(packetLength - kIpv4HeaderSize));
+    putBe16(udp + 6, 0U); // checksum optional for IPv4
+
+    auto header = telegram.header;
+    header.datasetLength = static_cast<std::uint32_t>(telegram.size);
+    auto *frame = udp + kUdpHeaderSize;
+    writeTrdpHeader(frame, header);
+    if (telegram.size > 0U) {
+        std::memcpy(frame + headerSize, telegram.data, telegram.size);
+    }
+    std::memset(p + packetLength, 0, padded(packetLength) - packetLength);
+    p += padded(packetLength);
+
+    put16(p, 2U); // epb_flags
+    put16(p, 4U);
+    put32(p, telegram.direction == CaptureDirection::Rx ? kEpbFlagsInbound : kEpbFlagsOutbound);
+    put32(p, 0U); // opt_endofopt
+    put32(p, static_cast<std::uint32_t>(blockLength));
+
+    file->used += blockLength;
+    packets.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(blockLength, std::memory_order_relaxed);
+}
+
+} // namespace trdp
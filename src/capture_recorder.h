@@ -0,0 +1,126 @@
+#pragma once
+
+#include "native_transport.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trdp {
+
+enum class CaptureDirection { Rx, Tx };
+
+// One telegram as seen by the engine. The TRDP header is rebuilt from these fields when it is recorded.
+struct CapturedTelegram {
+    CaptureDirection direction{CaptureDirection::Rx};
+    TrdpHeader header;
+    std::uint32_t srcIp{0};
+    std::uint32_t destIp{0};
+    std::uint16_t srcPort{0};
+    std::uint16_t destPort{0};
+    const std::uint8_t *data{nullptr};
+    std::size_t size{0};
+    // Packet timestamp: the engine's wall time (EngineClock::wallNs), so captures follow virtual time.
+    std::int64_t timestampNs{0};
+};
+
+/**
+ * pcapng recorder for every telegram the engine sends or receives.
+ *
+ * Telegrams are written as raw IPv4 packets with synthesized IP/UDP headers and a rebuilt TRDP header into a
+ * ring of pre-allocated, memory-mapped files. Recording a telegram is a copy into the mapped file under a
+ * mutex; no system call is made per packet. A housekeeping thread finalises the file that was just closed
+ * (unmap and trim to its used length) and maps the next ring file ahead of time. Files rotate when full or,
+ * with rotateAfter set, on the first telegram after the interval. If the next file is not ready yet, the
+ * telegram is counted as dropped instead of blocking the caller.
+ */
+class CaptureRecorder {
+  public:
+    struct Config {
+        std::string directory{"captures"};
+        std::string prefix{"trdp"};
+        std::size_t fileBytes{64U * 1024U * 1024U};
+        std::uint32_t fileCount{4};
+        // Zero rotates by size only.
+        std::chrono::seconds rotateAfter{0};
+    };
+
+    struct FileStatus {
+        std::string path;
+        std::size_t bytes{0};
+        bool current{false};
+    };
+
+    struct Status {
+        bool running{false};
+        Config config;
+        std::uint64_t packets{0};
+        std::uint64_t bytes{0};
+        std::uint64_t dropped{0};
+        std::uint64_t rotations{0};
+        std::vector<FileStatus> files;
+    };
+
+    static CaptureRecorder &instance();
+
+    // Create (or truncate) the ring files and start recording. Returns false with a reason in error.
+    bool start(const Config &config, std::string &error);
+    // Stop recording and trim every ring file to the data it holds.
+    void stop();
+    Status status();
+
+    // Cheap check for the capture hooks so they skip building a CapturedTelegram when idle.
+    [[nodiscard]] bool active() const noexcept { return recording.load(std::memory_order_relaxed); }
+    void record(const CapturedTelegram &telegram);
+
+  private:
+    struct RingFile {
+        std::string path;
+        int fd{-1};
+        std::uint8_t *map{nullptr};
+        // Bytes of valid pcapng data in the file.
+        std::size_t used{0};
+        // Timestamp of the first packet; 0 until one is written.
+        std::int64_t openedAtNs{0};
+    };
+
+    CaptureRecorder() = default;
+    ~CaptureRecorder();
+    CaptureRecorder(const CaptureRecorder &) = delete;
+    CaptureRecorder &operator=(const CaptureRecorder &) = delete;
+
+    bool mapFile(RingFile &file);
+    void finaliseFile(RingFile &file);
+    bool rotateLocked(std::int64_t nowNs);
+    void housekeeping();
+    void shutdown();
+
+    std::mutex controlMtx;
+    Config activeConfig;
+
+    // Guards the ring state shared between writers and the housekeeping thread.
+    std::mutex writeMtx;
+    std::condition_variable housekeepingCv;
+    std::vector<RingFile> files;
+    std::size_t current{0};
+    std::optional<std::size_t> next;
+    std::vector<std::size_t> toFinalise;
+    bool wantNext{false};
+    bool housekeepingStop{false};
+    std::thread housekeeper;
+    std::uint16_t ipIdentification{0};
+
+    std::atomic<bool> recording{false};
+    std::atomic<std::uint64_t> packets{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> dropped{0};
+    std::atomic<std::uint64_t> rotations{0};
+};
+
+} // namespace trdp
@@ -0,0 +1,643 @@
+#include "capture_replay.h"
+
+#include "native_transport.h"
+#include "trdp_engine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace trdp {
+
+namespace {
+
+// Telegrams handed to the engine per call; also bounds how long the batch lock is held.
+constexpr std::size_t kReplayBatch = 64U;
+// Release mapped pages behind the read position in steps of this size.
+constexpr std::size_t kReleaseStep = 64U * 1024U * 1024U;
+
+constexpr std::uint32_t kPcapMagicMicros = 0xA1B2C3D4U;
+constexpr std::uint32_t kPcapMagicNanos = 0xA1B23C4DU;
+constexpr std::size_t kPcapHeaderSize = 24U;
+constexpr std::size_t kPcapRecordHeaderSize = 16U;
+
+constexpr std::uint32_t kSectionHeaderBlock = 0x0A0D0D0AU;
+constexpr std::uint32_t kInterfaceDescriptionBlock = 0x00000001U;
+constexpr std::uint32_t kObsoletePacketBlock = 0x00000002U;
+constexpr std::uint32_t kEnhancedPacketBlock = 0x00000006U;
+constexpr std::uint32_t kByteOrderMagic = 0x1A2B3C4DU;
+
+constexpr std::uint32_t kLinkTypeNull = 0U;
+constexpr std::uint32_t kLinkTypeEthernet = 1U;
+constexpr std::uint32_t kLinkTypeRaw = 101U;
+constexpr std::uint32_t kLinkTypeLinuxSll = 113U;
+constexpr std::uint32_t kLinkTypeIpv4 = 228U;
+constexpr std::uint32_t kLinkTypeLinuxSll2 = 276U;
+
+std::uint16_t readBe16(const std::uint8_t *src) {
+    return static_cast<std::uint16_t>((src[0] << 8U) | src[1]);
+}
+
+std::uint32_t readBe32(const std::uint8_t *src) {
+    return (static_cast<std::uint32_t>(src[0]) << 24U) | (static_cast<std::uint32_t>(src[1]) << 16U) |
+           (static_cast<std::uint32_t>(src[2]) << 8U) | static_cast<std::uint32_t>(src[3]);
+}
+
+struct CapturedPacket {
+    std::int64_t timestampNs{0};
+    std::uint32_t linkType{0};
+    const std::uint8_t *data{nullptr};
+    std::size_t length{0};
+};
+
+struct DecodedTelegram {
+    TrdpHeader header;
+    std::uint32_t destIp{0};
+    std::uint16_t destPort{0};
+    const std::uint8_t *data{nullptr};
+};
+
+// Strip the link layer, IPv4 and UDP headers and validate the TRDP header. Fragments are not reassembled.
+bool decodeTelegram(const CapturedPacket &packet, DecodedTelegram &telegram) {
+    const auto *bytes = packet.data;
+    auto length = packet.length;
+    std::uint16_t etherType = 0x0800U;
+    switch (packet.linkType) {
+    case kLinkTypeEthernet: {
+        std::size_t offset = 12U;
+        if (length < offset + 2U) {
+            return false;
+        }
+        etherType = readBe16(bytes + offset);
+        // Up to two VLAN tags (802.1Q / 802.1ad).
+        for (int tag = 0; tag < 2 && (etherType == 0x8100U || etherType == 0x88A8U); ++tag) {
+            offset += 4U;
+            if (length < offset + 2U) {
+                return false;
+            }
+            etherType = readBe16(bytes + offset);
+        }
+        offset += 2U;
+        bytes += offset;
+        length -= offset;
+        break;
+    }
+    case kLinkTypeLinuxSll:
+        if (length < 16U) {
+            return false;
+        }
+        etherType = readBe16(bytes + 14);
+        bytes += 16;
+        length -= 16U;
+        break;
+    case kLinkTypeLinuxSll2:
+        if (length < 20U) {
+            return false;
+        }
+        etherType = readBe16(bytes);
+        bytes += 20;
+        length -= 20U;
+        break;
+    case kLinkTypeNull: {
+        if (length < 4U) {
+            return false;
+        }
+        // Address family in the byte order of the capturing host; AF_INET is 2 everywhere.
+        const bool inet = (bytes[0] == 2U && bytes[3] == 0U) || (bytes[0] == 0U && bytes[3] == 2U);
+        etherType = inet ? 0x0800U : 0U;
+        bytes += 4;
+        length -= 4U;
+        break;
+    }
+    case kLinkTypeRaw:
+    case kLinkTypeIpv4:
+        break;
+    default:
+        return false;
+    }
+    if (etherType != 0x0800U || length < 20U || (bytes[0] >> 4U) != 4U) {
+        return false;
+    }
+
+    const std::size_t ipHeaderSize = (bytes[0] & 0x0FU) * 4U;
+    const std::size_t ipLength = readBe16(bytes + 2);
+    if (ipHeaderSize < 20U || ipLength < ipHeaderSize + 8U || ipLength > length || bytes[9] != 17U ||
+        (readBe16(bytes + 6) & 0x3FFFU) != 0U) {
+        return false;
+    }
+    telegram.destIp = readBe32(bytes + 16);
+
+    const auto *udp = bytes + ipHeaderSize;
+    const std::size_t udpLength = readBe16(udp + 4);
+    if (udpLength < 8U || udpLength > ipLength - ipHeaderSize) {
+        return false;
+    }
+    telegram.destPort = readBe16(udp + 2);
+
+    const auto *payload = udp + 8;
+    if (readTrdpHeader(payload, udpLength - 8U, telegram.header) != TrdpHeaderCheck::Ok) {
+        return false;
+    }
+    telegram.data = payload + trdpHeaderSize(telegram.header.msgType);
+    return true;
+}
+
+bool isPdMessage(TrdpMsgType type) {
+    return trdpHeaderSize(type) == kTrdpPdHeaderSize;
+}
+
+} // namespace
+
+// Sequential reader over a memory-mapped pcap or pcapng file.
+class CaptureFile {
+  public:
+    CaptureFile() = default;
+    ~CaptureFile() {
+        if (map != nullptr) {
+            ::munmap(const_cast<std::uint8_t *>(map), size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    CaptureFile(const CaptureFile &) = delete;
+    CaptureFile &operator=(const CaptureFile &) = delete;
+
+    bool open(const std::string &path, std::string &error) {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "Unable to open '" + path + "': " + std::strerror(errno);
+            return false;
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || info.st_size < 12) {
+            error = "'" + path + "' is not a capture file";
+            return false;
+        }
+        size = static_cast<std::size_t>(info.st_size);
+        void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            error = "Unable to map '" + path + "': " + std::strerror(errno);
+            return false;
+        }
+        map = static_cast<const std::uint8_t *>(mapped);
+        ::madvise(mapped, size, MADV_SEQUENTIAL);
+
+        std::uint32_t magic = 0;
+        std::memcpy(&magic, map, sizeof(magic));
+        if (magic == kSectionHeaderBlock) {
+            format = Format::PcapNg;
+            start = 0;
+        } else if (magic == kPcapMagicMicros || magic == kPcapMagicNanos ||
+                   __builtin_bswap32(magic) == kPcapMagicMicros || __builtin_bswap32(magic) == kPcapMagicNanos) {
+            if (size < kPcapHeaderSize) {
+                error = "'" + path + "' has a truncated pcap header";
+                return false;
+            }
+            format = Format::Pcap;
+            swapped = magic != kPcapMagicMicros && magic != kPcapMagicNanos;
+            const bool nanos = magic == kPcapMagicNanos || __builtin_bswap32(magic) == kPcapMagicNanos;
+            pcapUnitsPerSecond = nanos ? 1000000000ULL : 1000000ULL;
+            pcapLinkType = u32(map + 20) & 0x0FFFFFFFU;
+            start = kPcapHeaderSize;
+        } else {
+            error = "'" + path + "' is neither pcap nor pcapng";
+            return false;
+        }
+        offset = start;
+        return true;
+    }
+
+    // Next packet, or false at the end of the file. error is set when the file is malformed.
+    bool next(CapturedPacket &packet, std::string &error) {
+        return format == Format::Pcap ? nextPcap(packet, error) : nextPcapNg(packet, error);
+    }
+
+    void rewind() {
+        releaseBehind(size);
+        offset = start;
+        released = 0;
+        interfaces.clear();
+    }
+
+    // Drop the page cache mapping for data the replay has moved past.
+    void release() {
+        if (offset - released >= kReleaseStep) {
+            releaseBehind(offset);
+        }
+    }
+
+    [[nodiscard]] std::size_t fileSize() const { return size; }
+    [[nodiscard]] std::size_t position() const { return offset; }
+
+  private:
+    enum class Format { Pcap, PcapNg };
+
+    struct Interface {
+        std::uint32_t linkType{0};
+        std::uint64_t unitsPerSecond{1000000ULL};
+    };
+
+    std::uint16_t u16(const std::uint8_t *src) const {
+        std::uint16_t value = 0;
+        std::memcpy(&value, src, sizeof(value));
+        return swapped ? __builtin_bswap16(value) : value;
+    }
+
+    std::uint32_t u32(const std::uint8_t *src) const {
+        std::uint32_t value = 0;
+        std::memcpy(&value, src, sizeof(value));
+        return swapped ? __builtin_bswap32(value) : value;
+    }
+
+    static std::int64_t toNanoseconds(std::uint64_t units, std::uint64_t unitsPerSecond) {
+        const auto seconds = units / unitsPerSecond;
+        const auto fraction = units % unitsPerSecond;
+        return static_cast<std::int64_t>(seconds * 1000000000ULL) +
+               static_cast<std::int64_t>(static_cast<long double>(fraction) * 1e9L /
+                                         static_cast<long double>(unitsPerSecond));
+    }
+
+    void releaseBehind(std::size_t end) {
+        const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const auto from = released / page * page;
+        const auto to = end / page * page;
+        if (to > from) {
+            ::madvise(const_cast<std::uint8_t *>(map) + from, to - from, MADV_DONTNEED);
+            released = to;
+        }
+    }
+
+    bool nextPcap(CapturedPacket &packet, std::string &error) {
+        if (offset + kPcapRecordHeaderSize > size) {
+            return false;
+        }
+        const auto *record = map + offset;
+        const auto capturedLength = u32(record + 8);
+        if (capturedLength > size - offset - kPcapRecordHeaderSize) {
+            // A capture cut off mid-packet (e.g. the recorder was killed) just ends here.
+            return false;
+        }
+        const std::uint64_t units = static_cast<std::uint64_t>(u32(record)) * pcapUnitsPerSecond + u32(record + 4);
+        packet.timestampNs = toNanoseconds(units, pcapUnitsPerSecond);
+        packet.linkType = pcapLinkType;
+        packet.data = record + kPcapRecordHeaderSize;
+        packet.length = capturedLength;
+        offset += kPcapRecordHeaderSize + capturedLength;
+        (void)error;
+        return true;
+    }
+
+    bool nextPcapNg(CapturedPacket &packet, std::string &error) {
+        while (offset + 12U <= size) {
+            const auto *block = map + offset;
+            std::uint32_t type = 0;
+            std::memcpy(&type, block, sizeof(type));
+            if (type == kSectionHeaderBlock) {
+                // Each section carries its own byte order.
+                std::uint32_t bom = 0;
+                std::memcpy(&bom, block + 8, sizeof(bom));
+                if (bom != kByteOrderMagic && __builtin_bswap32(bom) != kByteOrderMagic) {
+                    error = "Bad pcapng byte-order magic at offset " + std::to_string(offset);
+                    return false;
+                }
+                swapped = bom != kByteOrderMagic;
+                interfaces.clear();
+            } else {
+                type = u32(block);
+            }
+            const auto length = u32(block + 4);
+            if (length < 12U || (length % 4U) != 0U || length > size - offset) {
+                if (length > size - offset) {
+                    return false; // truncated final block
+                }
+                error = "Bad pcapng block length at offset " + std::to_string(offset);
+                return false;
+            }
+            offset += length;
+
+            if (type == kInterfaceDescriptionBlock && length >= 20U) {
+                Interface entry;
+                entry.linkType = u16(block + 8);
+                parseInterfaceOptions(block + 16, block + length - 4, entry);
+                interfaces.push_back(entry);
+            } else if ((type == kEnhancedPacketBlock || type == kObsoletePacketBlock) && length >= 32U) {
+                const auto interfaceId = type == kEnhancedPacketBlock ? u32(block + 8) : u16(block + 8);
+                const auto capturedLength = u32(block + 20);
+                if (interfaceId >= interfaces.size() || capturedLength > length - 32U) {
+                    continue;
+                }
+                const auto &entry = interfaces[interfaceId];
+                const std::uint64_t units = (static_cast<std::uint64_t>(u32(block + 12)) << 32U) | u32(block + 16);
+                packet.timestampNs = toNanoseconds(units, entry.unitsPerSecond);
+                packet.linkType = entry.linkType;
+                packet.data = block + 28;
+                packet.length = capturedLength;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void parseInterfaceOptions(const std::uint8_t *option, const std::uint8_t *end, Interface &entry) const {
+        while (option + 4 <= end) {
+            const auto code = u16(option);
+            const auto length = u16(option + 2);
+            if (code == 0U || option + 4 + length > end) {
+                return;
+            }
+            if (code == 9U && length >= 1U) { // if_tsresol
+                const auto resolution = option[4];
+                const auto exponent = resolution & 0x7FU;
+                if ((resolution & 0x80U) != 0U) {
+                    entry.unitsPerSecond = exponent < 64U ? (1ULL << exponent) : entry.unitsPerSecond;
+                } else if (exponent <= 19U) {
+                    entry.unitsPerSecond = 1;
+                    for (unsigned i = 0; i < exponent; ++i) {
+                        entry.unitsPerSecond *= 10U;
+                    }
+                }
+                if (entry.unitsPerSecond == 0U) {
+                    entry.unitsPerSecond = 1000000ULL;
+                }
+            }
+            option += 4U + ((length + 3U) & ~3U);
+        }
+    }
+
+    int fd{-1};
+    const std::uint8_t *map{nullptr};
+    std::size_t size{0};
+    std::size_t start{0};
+    std::size_t offset{0};
+    std::size_t released{0};
+    Format format{Format::Pcap};
+    bool swapped{false};
+    std::uint64_t pcapUnitsPerSecond{1000000ULL};
+    std::uint32_t pcapLinkType{0};
+    std::vector<Interface> interfaces;
+};
+
+CaptureReplay &CaptureReplay::instance() {
+    static CaptureReplay replay;
+    return replay;
+}
+
+CaptureReplay::~CaptureReplay() {
+    shutdown();
+}
+
+bool CaptureReplay::start(const Config &config, std::string &error) {
+    std::lock_guard control(controlMtx);
+    if (config.path.empty()) {
+        error = "Missing capture file path";
+        return false;
+    }
+    if (!(config.speed >= kMinSpeed && config.speed <= kMaxSpeed)) {
+        error = "speed must be between 0.1 and 100";
+        return false;
+    }
+    if (config.target == Target::Wire && !TrdpEngine::instance().isRunning()) {
+        error = "TRDP engine is not running";
+        return false;
+    }
+
+    auto file = std::make_shared<CaptureFile>();
+    if (!file->open(config.path, error)) {
+        return false;
+    }
+
+    shutdown();
+    {
+        std::lock_guard lock(mtx);
+        running = true;
+        stopRequested = false;
+        active = config;
+        fileBytes = file->fileSize();
+        position = 0;
+        replayed = 0;
+        filtered = 0;
+        failed = 0;
+        skipped = 0;
+        loops = 0;
+        captureSeconds = 0.0;
+        maxLateMs = 0.0;
+        index.clear();
+        lastError.clear();
+    }
+    worker = std::thread([this, config, file]() { run(config, *file); });
+    std::cout << "[TRDP] Replay of " << config.path << " started at " << config.speed << "x ("
+              << targetToString(config.target) << (config.loop ? ", loop" : "") << ")" << std::endl;
+    return true;
+}
+
+void CaptureReplay::stop() {
+    std::lock_guard control(controlMtx);
+    shutdown();
+}
+
+void CaptureReplay::shutdown() {
+    {
+        std::lock_guard lock(mtx);
+        stopRequested = true;
+    }
+    cv.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+CaptureReplay::Status CaptureReplay::status() {
+    std::lock_guard lock(mtx);
+    Status status;
+    status.running = running;
+    status.config = active;
+    status.fileBytes = fileBytes;
+    status.position = position;
+    status.replayed = replayed;
+    status.filtered = filtered;
+    status.failed = failed;
+    status.skipped = skipped;
+    status.loops = loops;
+    status.captureSeconds = captureSeconds;
+    status.maxLateMs = maxLateMs;
+    status.error = lastError;
+    status.comIds.reserve(index.size());
+    for (const auto &[comId, stats] : index) {
+        (void)comId;
+        status.comIds.push_back(stats);
+    }
+    return status;
+}
+
+void CaptureReplay::run(const Config &config, CaptureFile &file) {
+    using Clock = std::chrono::steady_clock;
+    auto &engine = TrdpEngine::instance();
+    const std::unordered_set<std::uint32_t> comIdFilter(config.comIds.begin(), config.comIds.end());
+    std::unordered_set<std::uint32_t> rxComIds;
+    if (config.target == Target::Rx) {
+        const auto contents = TelegramRegistry::instance().snapshot();
+        for (const auto &[comId, telegram] : contents->telegrams) {
+            if (telegram->direction == Direction::Rx) {
+                rxComIds.insert(comId);
+            }
+        }
+    }
+
+    std::vector<TrdpEngine::ReplayTelegram> batch;
+    batch.reserve(kReplayBatch);
+    std::vector<std::uint8_t> rxPayload;
+    // Counters accumulated between two batch hand-offs and folded into the shared status under mtx.
+    std::uint64_t pendingSkipped = 0;
+    std::uint64_t pendingFiltered = 0;
+    std::uint64_t pendingRx = 0;
+    std::map<std::uint32_t, ComIdStats> pendingIndex;
+    double lateMs = 0.0;
+    double passSeconds = 0.0;
+
+    const auto deliver = [&]() {
+        const auto sent = batch.empty() ? 0U : engine.sendReplayTelegrams(batch);
+        const auto attempted = batch.size();
+        batch.clear();
+        file.release();
+        std::lock_guard lock(mtx);
+        replayed += sent + pendingRx;
+        failed += attempted - sent;
+        skipped += pendingSkipped;
+        filtered += pendingFiltered;
+        position = file.position();
+        captureSeconds = passSeconds;
+        maxLateMs = std::max(maxLateMs, lateMs);
+        for (const auto &[comId, stats] : pendingIndex) {
+            auto &entry = index[comId];
+            entry.comId = comId;
+            entry.telegrams += stats.telegrams;
+            entry.bytes += stats.bytes;
+        }
+        pendingIndex.clear();
+        pendingSkipped = 0;
+        pendingFiltered = 0;
+        pendingRx = 0;
+        return stopRequested;
+    };
+
+    std::string error;
+    bool firstPass = true;
+    bool stopping = false;
+    while (!stopping) {
+        std::optional<std::int64_t> captureStart;
+        const auto wallStart = Clock::now();
+        CapturedPacket packet;
+        DecodedTelegram telegram;
+        while (!stopping && file.next(packet, error)) {
+            if (!decodeTelegram(packet, telegram)) {
+                pendingSkipped += firstPass ? 1U : 0U;
+                continue;
+            }
+            const auto comId = telegram.header.comId;
+            const auto size = static_cast<std::size_t>(telegram.header.datasetLength);
+            if (firstPass) {
+                auto &entry = pendingIndex[comId];
+                ++entry.telegrams;
+                entry.bytes += size;
+            }
+            if ((!comIdFilter.empty() && comIdFilter.count(comId) == 0U) ||
+                (config.target == Target::Rx && rxComIds.count(comId) == 0U)) {
+                ++pendingFiltered;
+                continue;
+            }
+
+            if (!captureStart) {
+                captureStart = packet.timestampNs;
+            }
+            const auto offset = std::max<std::int64_t>(0, packet.timestampNs - *captureStart);
+            passSeconds = static_cast<double>(offset) / 1e9;
+            const auto deadline = wallStart + std::chrono::nanoseconds(static_cast<std::int64_t>(
+                                                  std::llround(static_cast<double>(offset) / config.speed)));
+            auto now = Clock::now();
+            if (deadline > now) {
+                // Hand off what is already due before sleeping, then wait for this telegram's deadline.
+                stopping = deliver();
+                std::unique_lock lock(mtx);
+                stopping = cv.wait_until(lock, deadline, [this]() { return stopRequested; });
+                if (stopping) {
+                    break;
+                }
+                now = Clock::now();
+            }
+            lateMs = std::max(lateMs, std::chrono::duration<double, std::milli>(now - deadline).count());
+
+            if (config.target == Target::Wire) {
+                TrdpEngine::ReplayTelegram out;
+                out.msgType = telegram.header.msgType;
+                out.comId = comId;
+                out.destIp = config.destIp != 0U ? config.destIp : telegram.destIp;
+                out.destPort = config.destPort != 0U ? config.destPort : telegram.destPort;
+                out.data = telegram.data;
+                out.size = size;
+                batch.push_back(out);
+                if (batch.size() >= kReplayBatch) {
+                    stopping = deliver();
+                }
+            } else {
+                rxPayload.assign(telegram.data, telegram.data + size);
+                if (isPdMessage(telegram.header.msgType)) {
+                    engine.handleRxTelegram(comId, rxPayload);
+                } else {
+                    engine.handleRxMdTelegram(comId, rxPayload);
+                }
+                if (++pendingRx >= kReplayBatch) {
+                    stopping = deliver();
+                }
+            }
+        }
+        stopping = deliver() || stopping;
+        if (!error.empty() || !config.loop || stopping) {
+            break;
+        }
+        if (!captureStart) {
+            // Nothing in the file passes the filters; looping would spin.
+            error = "No telegrams to replay";
+            break;
+        }
+        firstPass = false;
+        file.rewind();
+        std::lock_guard lock(mtx);
+        ++loops;
+    }
+
+    std::lock_guard lock(mtx);
+    running = false;
+    lastError = error;
+    if (!error.empty()) {
+        std::cerr << "[TRDP] Replay of " << config.path << " stopped: " << error << std::endl;
+    } else {
+        std::cout << "[TRDP] Replay of " << config.path << " finished after " << replayed << " telegrams"
+                  << std::endl;
+    }
+}
+
+std::optional<CaptureReplay::Target> CaptureReplay::parseTarget(const std::string &value) {
+    if (value == "wire") {
+        return Target::Wire;
+    }
+    if (value == "rx") {
+        return Target::Rx;
+    }
+    return std::nullopt;
+}
+
+std::string CaptureReplay::targetToString(Target target) {
+    return target == Target::Wire ? "wire" : "rx";
+}
+
+} // namespace trdp
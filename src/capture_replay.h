@@ -0,0 +1,114 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace trdp {
+
+class CaptureFile;
+
+/**
+ * Replays recorded TRDP traffic from a pcap or pcapng file.
+ *
+ * The file is memory-mapped and walked block by block; pages behind the read position are released as the
+ * replay advances, so multi-GB captures stream with bounded memory. Every UDP packet that carries a valid TRDP
+ * header is due at an absolute deadline derived from its capture timestamp (start + offset / speed), so wake-up
+ * jitter and slow batches never accumulate into drift. Telegrams are either sent to the network (Target::Wire,
+ * through TrdpEngine::sendReplayTelegrams) or fed into the RX path as if they had been received (Target::Rx).
+ * A per-ComId index (telegrams and bytes) is built while the file is read.
+ */
+class CaptureReplay {
+  public:
+    enum class Target { Wire, Rx };
+
+    static constexpr double kMinSpeed = 0.1;
+    static constexpr double kMaxSpeed = 100.0;
+
+    struct Config {
+        std::string path;
+        double speed{1.0};
+        bool loop{false};
+        Target target{Target::Wire};
+        // Replay only these ComIds; empty replays everything.
+        std::vector<std::uint32_t> comIds;
+        // Wire only: send to this address/port instead of the recorded destination when non-zero.
+        std::uint32_t destIp{0};
+        std::uint16_t destPort{0};
+    };
+
+    struct ComIdStats {
+        std::uint32_t comId{0};
+        std::uint64_t telegrams{0};
+        std::uint64_t bytes{0};
+    };
+
+    struct Status {
+        bool running{false};
+        Config config;
+        std::uint64_t fileBytes{0};
+        std::uint64_t position{0};
+        std::uint64_t replayed{0};
+        // Telegrams excluded by the ComId filter or, for Target::Rx, without an RX endpoint.
+        std::uint64_t filtered{0};
+        std::uint64_t failed{0};
+        // Packets that are not unfragmented IPv4/UDP TRDP telegrams.
+        std::uint64_t skipped{0};
+        std::uint64_t loops{0};
+        // Capture time covered by the current pass.
+        double captureSeconds{0.0};
+        // Largest delay between a telegram's deadline and its hand-off.
+        double maxLateMs{0.0};
+        std::vector<ComIdStats> comIds;
+        // Set when the replay ended on a malformed file.
+        std::string error;
+    };
+
+    static CaptureReplay &instance();
+
+    // Open and validate the file, then replay it on a background thread. Returns false with a reason in error.
+    bool start(const Config &config, std::string &error);
+    void stop();
+    Status status();
+
+    static std::optional<Target> parseTarget(const std::string &value);
+    static std::string targetToString(Target target);
+
+  private:
+    CaptureReplay() = default;
+    ~CaptureReplay();
+    CaptureReplay(const CaptureReplay &) = delete;
+    CaptureReplay &operator=(const CaptureReplay &) = delete;
+
+    void run(const Config &config, CaptureFile &file);
+    void shutdown();
+
+    std::mutex controlMtx;
+
+    // Guards everything below; the replay thread takes it once per batch.
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool running{false};
+    bool stopRequested{false};
+    std::thread worker;
+    Config active;
+    std::uint64_t fileBytes{0};
+    std::uint64_t position{0};
+    std::uint64_t replayed{0};
+    std::uint64_t filtered{0};
+    std::uint64_t failed{0};
+    std::uint64_t skipped{0};
+    std::uint64_t loops{0};
+    double captureSeconds{0.0};
+    double maxLateMs{0.0};
+    std::map<std::uint32_t, ComIdStats> index;
+    std::string lastError;
+};
+
+} // namespace trdp
@@ -0,0 +1,249 @@
+#include "checksum.h"
+
+#include <array>
+#include <cstring>
+
+namespace trdp {
+
+namespace {
+
+// Slicing-by-8: table[k][b] is the CRC contribution of byte b followed by k zero bytes, so eight input bytes are
+// folded with eight independent lookups instead of eight dependent ones.
+using Crc16Tables = std::array<std::array<std::uint16_t, 256>, 8>;
+using Crc32Tables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+constexpr Crc16Tables makeCrc16Tables() {
+    Crc16Tables tables{};
+    for (std::uint32_t i = 0; i < 256U; ++i) {
+        std::uint16_t crc = static_cast<std::uint16_t>(i << 8U);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = static_cast<std::uint16_t>((crc & 0x8000U) != 0U ? (crc << 1U) ^ 0x1021U : crc << 1U);
+        }
+        tables[0][i] = crc;
+    }
+    for (std::size_t k = 1; k < tables.size(); ++k) {
+        for (std::uint32_t i = 0; i < 256U; ++i) {
+            const auto prev = tables[k - 1][i];
+            tables[k][i] = static_cast<std::uint16_t>((prev << 8U) ^ tables[0][prev >> 8U]);
+        }
+    }
+    return tables;
+}
+
+constexpr Crc32Tables makeCrc32Tables() {
+    Crc32Tables tables{};
+    for (std::uint32_t i = 0; i < 256U; ++i) {
+        std::uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1U) != 0U ? (crc >> 1U) ^ 0xEDB88320U : crc >> 1U;
+        }
+        tables[0][i] = crc;
+    }
+    for (std::size_t k = 1; k < tables.size(); ++k) {
+        for (std::uint32_t i = 0; i < 256U; ++i) {
+            const auto prev = tables[k - 1][i];
+            tables[k][i] = (prev >> 8U) ^ tables[0][prev & 0xFFU];
+        }
+    }
+    return tables;
+}
+
+constexpr Crc32Tables makeSc32Tables() {
+    Crc32Tables tables{};
+    for (std::uint32_t i = 0; i < 256U; ++i) {
+        std::uint32_t crc = i << 24U;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000U) != 0U ? (crc << 1U) ^ 0xF4ACFB13U : crc << 1U;
+        }
+        tables[0][i] = crc;
+    }
+    for (std::size_t k = 1; k < tables.size(); ++k) {
+        for (std::uint32_t i = 0; i < 256U; ++i) {
+            const auto prev = tables[k - 1][i];
+            tables[k][i] = (prev << 8U) ^ tables[0][prev >> 24U];
+        }
+    }
+    return tables;
+}
+
+constexpr auto kCrc16Tables = makeCrc16Tables();
+constexpr auto kCrc32Tables = makeCrc32Tables();
+constexpr auto kSc32Tables = makeSc32Tables();
+
+std::uint32_t readLe32(const std::uint8_t *src) {
+    std::uint32_t value = 0;
+    std::memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+std::size_t checksumWidth(ChecksumKind kind) {
+    switch (kind) {
+    case ChecksumKind::Crc16:
+        return 2U;
+    case ChecksumKind::Crc32:
+        return 4U;
+    case ChecksumKind::None:
+        break;
+    }
+    return 0U;
+}
+
+std::size_t storageWidth(const FieldDef &field) {
+    switch (field.type) {
+    case FieldType::BOOL:
+    case FieldType::INT8:
+    case FieldType::UINT8:
+        return field.arrayLength;
+    case FieldType::INT16:
+    case FieldType::UINT16:
+        return 2U * field.arrayLength;
+    case FieldType::INT32:
+    case FieldType::UINT32:
+    case FieldType::FLOAT:
+        return 4U * field.arrayLength;
+    case FieldType::DOUBLE:
+        return 8U * field.arrayLength;
+    case FieldType::STRING:
+    case FieldType::BYTES:
+        return field.size;
+    }
+    return 0U;
+}
+
+std::uint32_t compute(const ChecksumField &field, const std::uint8_t *data) {
+    switch (field.kind) {
+    case ChecksumKind::Crc16:
+        return crc16Ccitt(data + field.start, field.length);
+    case ChecksumKind::Crc32:
+        return crc32(data + field.start, field.length);
+    case ChecksumKind::None:
+        break;
+    }
+    return 0U;
+}
+
+} // namespace
+
+std::uint16_t crc16Ccitt(const std::uint8_t *data, std::size_t length, std::uint16_t crc) {
+    const auto &t = kCrc16Tables;
+    // MSB-first CRC: the register lines up with the first two bytes of each block.
+    while (length >= 8U) {
+        const auto head = static_cast<std::uint16_t>(crc ^ ((data[0] << 8U) | data[1]));
+        crc = static_cast<std::uint16_t>(t[7][head >> 8U] ^ t[6][head & 0xFFU] ^ t[5][data[2]] ^ t[4][data[3]] ^
+                                         t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]]);
+        data += 8U;
+        length -= 8U;
+    }
+    for (std::size_t i = 0; i < length; ++i) {
+        crc = static_cast<std::uint16_t>((crc << 8U) ^ t[0][((crc >> 8U) ^ data[i]) & 0xFFU]);
+    }
+    return crc;
+}
+
+std::uint32_t crc32(const std::uint8_t *data, std::size_t length) {
+    const auto &t = kCrc32Tables;
+    std::uint32_t crc = 0xFFFFFFFFU;
+    // Reflected CRC: the register lines up with the first four bytes of each block read little-endian.
+    while (length >= 8U) {
+        const auto low = crc ^ readLe32(data);
+        const auto high = readLe32(data + 4U);
+        crc = t[7][low & 0xFFU] ^ t[6][(low >> 8U) & 0xFFU] ^ t[5][(low >> 16U) & 0xFFU] ^ t[4][low >> 24U] ^
+              t[3][high & 0xFFU] ^ t[2][(high >> 8U) & 0xFFU] ^ t[1][(high >> 16U) & 0xFFU] ^ t[0][high >> 24U];
+        data += 8U;
+        length -= 8U;
+    }
+    for (std::size_t i = 0; i < length; ++i) {
+        crc = (crc >> 8U) ^ t[0][(crc ^ data[i]) & 0xFFU];
+    }
+    return ~crc;
+}
+
+std::uint32_t sc32(const std::uint8_t *data, std::size_t length, std::uint32_t seed) {
+    const auto &t = kSc32Tables;
+    auto crc = seed;
+    while (length >= 8U) {
+        const auto head = crc ^ ((static_cast<std::uint32_t>(data[0]) << 24U) |
+                                 (static_cast<std::uint32_t>(data[1]) << 16U) |
+                                 (static_cast<std::uint32_t>(data[2]) << 8U) | data[3]);
+        crc = t[7][head >> 24U] ^ t[6][(head >> 16U) & 0xFFU] ^ t[5][(head >> 8U) & 0xFFU] ^ t[4][head & 0xFFU] ^
+              t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+        data += 8U;
+        length -= 8U;
+    }
+    for (std::size_t i = 0; i < length; ++i) {
+        crc = (crc << 8U) ^ t[0][((crc >> 24U) ^ data[i]) & 0xFFU];
+    }
+    return crc;
+}
+
+std::vector<ChecksumField> resolveChecksums(const DatasetDef &dataset, std::string &error) {
+    std::vector<ChecksumField> result;
+    const auto bufferSize = dataset.computeSize();
+    for (const auto &field : dataset.fields) {
+        if (field.checksum == ChecksumKind::None) {
+            continue;
+        }
+        ChecksumField resolved;
+        resolved.field = field.name;
+        resolved.kind = field.checksum;
+        resolved.offset = field.offset;
+        resolved.start = field.checksumStart;
+        resolved.length = field.checksumLength > 0U
+                              ? field.checksumLength
+                              : (field.offset > field.checksumStart ? field.offset - field.checksumStart : 0U);
+        const auto width = checksumWidth(field.checksum);
+        const auto end = resolved.start + resolved.length;
+        if (storageWidth(field) != width) {
+            error = "checksum field '" + field.name + "' must be " + std::to_string(width) + " bytes wide";
+        } else if (resolved.length == 0U || end > bufferSize || field.offset + width > bufferSize) {
+            error = "checksum range of '" + field.name + "' lies outside dataset " + dataset.name;
+        } else if (resolved.start < field.offset + width && field.offset < end) {
+            error = "checksum range of '" + field.name + "' covers the field itself";
+        } else {
+            result.push_back(std::move(resolved));
+        }
+    }
+    return result;
+}
+
+void writeChecksums(const std::vector<ChecksumField> &fields, std::uint8_t *data, std::size_t size) {
+    for (const auto &field : fields) {
+        const auto width = checksumWidth(field.kind);
+        if (field.start + field.length > size || field.offset + width > size) {
+            continue;
+        }
+        const auto value = compute(field, data);
+        if (width == 2U) {
+            const auto crc = static_cast<std::uint16_t>(value);
+            std::memcpy(data + field.offset, &crc, sizeof(crc));
+        } else {
+            std::memcpy(data + field.offset, &value, sizeof(value));
+        }
+    }
+}
+
+std::size_t checksumMismatches(const std::vector<ChecksumField> &fields, const std::uint8_t *data, std::size_t size) {
+    std::size_t mismatches = 0;
+    for (const auto &field : fields) {
+        const auto width = checksumWidth(field.kind);
+        if (field.start + field.length > size || field.offset + width > size) {
+            // A truncated payload cannot carry a valid checksum.
+            ++mismatches;
+            continue;
+        }
+        std::uint32_t stored = 0;
+        if (width == 2U) {
+            std::uint16_t crc = 0;
+            std::memcpy(&crc, data + field.offset, sizeof(crc));
+            stored = crc;
+        } else {
+            stored = readLe32(data + field.offset);
+        }
+        if (stored != compute(field, data)) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+} // namespace trdp
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "telegram_model.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trdp {
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), as used by the maintenance datasets.
+std::uint16_t crc16Ccitt(const std::uint8_t *data, std::size_t length, std::uint16_t crc = 0xFFFFU);
+
+// CRC-32 (IEEE 802.3), the TRDP header frame check sequence.
+std::uint32_t crc32(const std::uint8_t *data, std::size_t length);
+
+// SDTv2 safety code SC-32 (poly 0xF4ACFB13, MSB first, no final XOR), seeded with the SID or 0xFFFFFFFF.
+std::uint32_t sc32(const std::uint8_t *data, std::size_t length, std::uint32_t seed);
+
+// Checksum field of a dataset resolved to byte offsets.
+struct ChecksumField {
+    std::string field;
+    ChecksumKind kind{ChecksumKind::None};
+    std::size_t offset{0};
+    std::size_t start{0};
+    std::size_t length{0};
+};
+
+// Resolve the checksum fields of dataset in field order. Fields whose range does not fit the dataset, covers the
+// field itself or whose type is too narrow for the checksum are left out and described in error.
+std::vector<ChecksumField> resolveChecksums(const DatasetDef &dataset, std::string &error);
+
+// Compute every checksum into its field (little-endian, like all payload fields). Later fields see the checksums
+// written before them.
+void writeChecksums(const std::vector<ChecksumField> &fields, std::uint8_t *data, std::size_t size);
+
+// Number of checksum fields whose stored value differs from the one computed over data.
+std::size_t checksumMismatches(const std::vector<ChecksumField> &fields, const std::uint8_t *data, std::size_t size);
+
+} // namespace trdp
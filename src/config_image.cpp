@@ -0,0 +1,549 @@
+#include "config_image.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace trdp {
+
+namespace {
+
+constexpr char kImageMagic[8] = {'T', 'R', 'D', 'P', 'C', 'I', 'M', 'G'};
+// Written as a native word: an image moved to a host of the other byte order fails this check.
+constexpr std::uint32_t kByteOrderMark = 0x01020304U;
+
+struct ImageHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t sourceHash;
+    std::uint64_t payloadChecksum;
+    std::uint64_t payloadSize;
+    std::uint32_t strings;
+    std::uint32_t datasets;
+    std::uint32_t telegrams;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(ImageHeader) == 56, "image header layout changed");
+
+std::mutex imageDirMtx;
+std::string imageDirectory;
+
+std::uint64_t fnv1a(const std::uint8_t *data, std::size_t length) {
+    std::uint64_t hash = 0xCBF29CE484222325ULL;
+    for (std::size_t i = 0; i < length; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Appends records; names go through the string table and are written as their index.
+class ImageWriter {
+  public:
+    void u32(std::uint32_t value) { raw(&value, sizeof(value)); }
+    void u64(std::uint64_t value) { raw(&value, sizeof(value)); }
+    void i64(std::int64_t value) { raw(&value, sizeof(value)); }
+    void f64(double value) { raw(&value, sizeof(value)); }
+    void raw(const void *data, std::size_t length) {
+        const auto *bytes = static_cast<const std::uint8_t *>(data);
+        payload.insert(payload.end(), bytes, bytes + length);
+    }
+    void str(const std::string &value) {
+        const auto [it, inserted] = interned.emplace(value, static_cast<std::uint32_t>(strings.size()));
+        if (inserted) {
+            strings.push_back(&it->first);
+        }
+        u32(it->second);
+    }
+
+    // String table followed by the records.
+    [[nodiscard]] std::vector<std::uint8_t> finish() const {
+        std::vector<std::uint8_t> out;
+        for (const auto *value : strings) {
+            const auto length = static_cast<std::uint32_t>(value->size());
+            const auto *lengthBytes = reinterpret_cast<const std::uint8_t *>(&length);
+            out.insert(out.end(), lengthBytes, lengthBytes + sizeof(length));
+            out.insert(out.end(), value->begin(), value->end());
+        }
+        out.insert(out.end(), payload.begin(), payload.end());
+        return out;
+    }
+
+    [[nodiscard]] std::size_t stringCount() const noexcept { return strings.size(); }
+
+  private:
+    std::unordered_map<std::string, std::uint32_t> interned;
+    std::vector<const std::string *> strings;
+    std::vector<std::uint8_t> payload;
+};
+
+// Bounds-checked reads over the mapped payload; after the first short read every read fails.
+class ImageReader {
+  public:
+    ImageReader(const std::uint8_t *data, std::size_t size) : cursor(data), end(data + size) {}
+
+    bool raw(void *out, std::size_t length) {
+        if (static_cast<std::size_t>(end - cursor) < length) {
+            cursor = end;
+            ok = false;
+            return false;
+        }
+        std::memcpy(out, cursor, length);
+        cursor += length;
+        return true;
+    }
+    std::uint32_t u32() {
+        std::uint32_t value = 0;
+        raw(&value, sizeof(value));
+        return value;
+    }
+    std::uint64_t u64() {
+        std::uint64_t value = 0;
+        raw(&value, sizeof(value));
+        return value;
+    }
+    std::int64_t i64() {
+        std::int64_t value = 0;
+        raw(&value, sizeof(value));
+        return value;
+    }
+    double f64() {
+        double value = 0.0;
+        raw(&value, sizeof(value));
+        return value;
+    }
+    std::chrono::milliseconds ms() { return std::chrono::milliseconds(i64()); }
+    // Enumerator stored as its value; out of range fails the read.
+    template <typename E> E enumerator(E last) {
+        const auto value = u32();
+        if (value > static_cast<std::uint32_t>(last)) {
+            ok = false;
+        }
+        return ok ? static_cast<E>(value) : E{};
+    }
+
+    // count comes from the header, which the checksum does not cover: reject it before reserving when the
+    // strings could not fit in the bytes left (each carries at least its u32 length).
+    bool readStrings(std::uint32_t count) {
+        if (static_cast<std::size_t>(end - cursor) / sizeof(std::uint32_t) < count) {
+            ok = false;
+            return false;
+        }
+        strings.reserve(count);
+        for (std::uint32_t i = 0; i < count && ok; ++i) {
+            const auto length = u32();
+            if (static_cast<std::size_t>(end - cursor) < length) {
+                ok = false;
+                break;
+            }
+            strings.emplace_back(reinterpret_cast<const char *>(cursor), length);
+            cursor += length;
+        }
+        return ok;
+    }
+    std::string str() {
+        const auto index = u32();
+        if (!ok || index >= strings.size()) {
+            ok = false;
+            return {};
+        }
+        return strings[index];
+    }
+    // Element count of a table, rejected when it could not fit in the bytes left.
+    std::uint32_t count(std::size_t minElementSize) {
+        const auto value = u32();
+        if (static_cast<std::size_t>(end - cursor) / minElementSize < value) {
+            ok = false;
+            return 0;
+        }
+        return value;
+    }
+
+    [[nodiscard]] bool good() const noexcept { return ok; }
+    [[nodiscard]] bool atEnd() const noexcept { return cursor == end; }
+
+  private:
+    const std::uint8_t *cursor;
+    const std::uint8_t *end;
+    std::vector<std::string> strings;
+    bool ok{true};
+};
+
+class MappedImage {
+  public:
+    MappedImage() = default;
+    ~MappedImage() {
+        if (map != nullptr) {
+            ::munmap(const_cast<std::uint8_t *>(map), size);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    MappedImage(const MappedImage &) = delete;
+    MappedImage &operator=(const MappedImage &) = delete;
+
+    // False without a message when there is no image yet.
+    bool open(const std::string &path) {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            if (errno != ENOENT) {
+                std::cerr << "[TRDP] Unable to open config image " << path << ": " << std::strerror(errno)
+                          << std::endl;
+            }
+            return false;
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(ImageHeader)) {
+            std::cerr << "[TRDP] Ignoring config image " << path << ": truncated" << std::endl;
+            return false;
+        }
+        size = static_cast<std::size_t>(info.st_size);
+        void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "[TRDP] Unable to map config image " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        map = static_cast<const std::uint8_t *>(mapped);
+        ::madvise(mapped, size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    const std::uint8_t *map{nullptr};
+    std::size_t size{0};
+
+  private:
+    int fd{-1};
+};
+
+void writeDataset(ImageWriter &out, const DatasetDef &dataset) {
+    out.str(dataset.name);
+    out.u64(dataset.size);
+    out.u32(static_cast<std::uint32_t>(dataset.fields.size()));
+    for (const auto &field : dataset.fields) {
+        out.str(field.name);
+        out.u32(static_cast<std::uint32_t>(field.type));
+        out.u64(field.offset);
+        out.u64(field.size);
+        out.u64(field.bitOffset);
+        out.u64(field.arrayLength);
+        out.u32(static_cast<std::uint32_t>(field.checksum));
+        out.u64(field.checksumStart);
+        out.u64(field.checksumLength);
+    }
+    // The field-name index, stored unindexed when it does not cover the fields.
+    const bool indexed = !dataset.fields.empty() && dataset.fieldIndex.size() == dataset.fields.size();
+    const auto &displacements = dataset.fieldIndex.displacementTable();
+    const auto &slots = dataset.fieldIndex.slotTable();
+    out.u32(indexed ? static_cast<std::uint32_t>(displacements.size()) : 0U);
+    if (indexed) {
+        out.raw(displacements.data(), displacements.size() * sizeof(std::uint32_t));
+    }
+    out.u32(indexed ? static_cast<std::uint32_t>(slots.size()) : 0U);
+    if (indexed) {
+        out.raw(slots.data(), slots.size() * sizeof(std::int32_t));
+    }
+}
+
+bool readDataset(ImageReader &in, DatasetDef &dataset) {
+    dataset.name = in.str();
+    dataset.size = in.u64();
+    const auto fieldCount = in.count(4U);
+    dataset.fields.reserve(fieldCount);
+    for (std::uint32_t i = 0; i < fieldCount && in.good(); ++i) {
+        FieldDef field;
+        field.name = in.str();
+        field.type = in.enumerator(FieldType::BYTES);
+        field.offset = in.u64();
+        field.size = in.u64();
+        field.bitOffset = in.u64();
+        field.arrayLength = in.u64();
+        field.checksum = in.enumerator(ChecksumKind::Crc32);
+        field.checksumStart = in.u64();
+        field.checksumLength = in.u64();
+        dataset.fields.push_back(std::move(field));
+    }
+    std::vector<std::uint32_t> displacements(in.count(sizeof(std::uint32_t)));
+    in.raw(displacements.data(), displacements.size() * sizeof(std::uint32_t));
+    std::vector<std::int32_t> slots(in.count(sizeof(std::int32_t)));
+    in.raw(slots.data(), slots.size() * sizeof(std::int32_t));
+    return in.good() && dataset.fieldIndex.restore(std::move(displacements), std::move(slots), dataset.fields.size());
+}
+
+void writeTelegram(ImageWriter &out, const TelegramDef &telegram) {
+    out.u32(telegram.comId);
+    out.str(telegram.name);
+    out.u32(static_cast<std::uint32_t>(telegram.direction));
+    out.u32(static_cast<std::uint32_t>(telegram.type));
+    out.str(telegram.datasetName);
+    out.u32(telegram.srcIp);
+    out.u32(telegram.destIp);
+    out.u32(telegram.ttl);
+    out.u32(telegram.srcPort);
+    out.u32(telegram.destPort);
+    out.u32(telegram.trdpFlags);
+    out.u32(telegram.qos);
+    out.i64(telegram.cycle.count());
+    out.u32(telegram.expectedReplies);
+    out.i64(telegram.replyTimeout.count());
+    out.i64(telegram.confirmTimeout.count());
+
+    const auto &replier = telegram.replier;
+    out.u32(replier.enabled ? 1U : 0U);
+    out.u32(replier.replyComId);
+    out.str(replier.replyDataset);
+    out.i64(replier.delay.count());
+    out.u32(replier.maxRepliesPerSecond);
+    out.u32(replier.requireConfirm ? 1U : 0U);
+    out.i64(replier.confirmTimeout.count());
+    out.u32(replier.userStatus);
+    out.u32(static_cast<std::uint32_t>(replier.fields.size()));
+    for (const auto &rule : replier.fields) {
+        out.str(rule.field);
+        out.u32(static_cast<std::uint32_t>(rule.source));
+        out.str(rule.requestField);
+        out.u64(rule.crcStart);
+        out.u64(rule.crcLength);
+    }
+
+    out.u32(static_cast<std::uint32_t>(telegram.generators.size()));
+    for (const auto &generator : telegram.generators) {
+        out.str(generator.field);
+        out.u32(static_cast<std::uint32_t>(generator.kind));
+        out.f64(generator.min);
+        out.f64(generator.max);
+        out.f64(generator.step);
+        out.i64(generator.period.count());
+        out.u32(generator.order);
+        out.u32(generator.seed);
+    }
+
+    const auto &sdt = telegram.sdt;
+    out.u32(sdt.enabled ? 1U : 0U);
+    out.u32(sdt.smi);
+    out.u32(sdt.userDataVersion);
+    out.raw(sdt.consistId.data(), sdt.consistId.size());
+    out.u32(sdt.safeTopoCount);
+    out.i64(sdt.txPeriod.count());
+    out.i64(sdt.rxPeriod.count());
+    out.u32(sdt.nRxSafe);
+    out.u32(sdt.lmiMax);
+}
+
+bool readTelegram(ImageReader &in, TelegramDef &telegram) {
+    telegram.comId = in.u32();
+    telegram.name = in.str();
+    telegram.direction = in.enumerator(Direction::Rx);
+    telegram.type = in.enumerator(TelegramType::MD);
+    telegram.datasetName = in.str();
+    telegram.srcIp = in.u32();
+    telegram.destIp = in.u32();
+    telegram.ttl = static_cast<std::uint8_t>(in.u32());
+    telegram.srcPort = static_cast<std::uint16_t>(in.u32());
+    telegram.destPort = static_cast<std::uint16_t>(in.u32());
+    telegram.trdpFlags = in.u32();
+    telegram.qos = static_cast<std::uint8_t>(in.u32());
+    telegram.cycle = in.ms();
+    telegram.expectedReplies = in.u32();
+    telegram.replyTimeout = in.ms();
+    telegram.confirmTimeout = in.ms();
+
+    auto &replier = telegram.replier;
+    replier.enabled = in.u32() != 0U;
+    replier.replyComId = in.u32();
+    replier.replyDataset = in.str();
+    replier.delay = in.ms();
+    replier.maxRepliesPerSecond = in.u32();
+    replier.requireConfirm = in.u32() != 0U;
+    replier.confirmTimeout = in.ms();
+    replier.userStatus = static_cast<std::uint16_t>(in.u32());
+    const auto ruleCount = in.count(4U);
+    replier.fields.reserve(ruleCount);
+    for (std::uint32_t i = 0; i < ruleCount && in.good(); ++i) {
+        ReplyFieldRule rule;
+        rule.field = in.str();
+        rule.source = in.enumerator(ReplyFieldSource::Crc16);
+        rule.requestField = in.str();
+        rule.crcStart = in.u64();
+        rule.crcLength = in.u64();
+        replier.fields.push_back(std::move(rule));
+    }
+
+    const auto generatorCount = in.count(4U);
+    telegram.generators.reserve(generatorCount);
+    for (std::uint32_t i = 0; i < generatorCount && in.good(); ++i) {
+        FieldGeneratorDef generator;
+        generator.field = in.str();
+        generator.kind = in.enumerator(FieldGeneratorKind::Prbs);
+        generator.min = in.f64();
+        generator.max = in.f64();
+        generator.step = in.f64();
+        generator.period = in.ms();
+        generator.order = in.u32();
+        generator.seed = in.u32();
+        telegram.generators.push_back(std::move(generator));
+    }
+
+    auto &sdt = telegram.sdt;
+    sdt.enabled = in.u32() != 0U;
+    sdt.smi = in.u32();
+    sdt.userDataVersion = static_cast<std::uint16_t>(in.u32());
+    in.raw(sdt.consistId.data(), sdt.consistId.size());
+    sdt.safeTopoCount = in.u32();
+    sdt.txPeriod = in.ms();
+    sdt.rxPeriod = in.ms();
+    sdt.nRxSafe = in.u32();
+    sdt.lmiMax = in.u32();
+    return in.good();
+}
+
+} // namespace
+
+std::uint64_t configSourceHash(const std::string &source) {
+    return fnv1a(reinterpret_cast<const std::uint8_t *>(source.data()), source.size());
+}
+
+void setConfigImageDirectory(const std::string &directory) {
+    std::lock_guard<std::mutex> lock(imageDirMtx);
+    imageDirectory = directory;
+}
+
+std::string configImagePath(const std::string &xmlPath) {
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(imageDirMtx);
+        directory = imageDirectory;
+    }
+    if (directory == "off") {
+        return {};
+    }
+    if (directory.empty()) {
+        return xmlPath + ".trdpimg";
+    }
+    // XMLs of the same name in different places share the directory, so the name carries a hash of the full path.
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    auto absolute = fs::absolute(xmlPath, ec);
+    if (ec) {
+        absolute = xmlPath;
+    }
+    char suffix[17];
+    std::snprintf(suffix, sizeof(suffix), "%016llx",
+                  static_cast<unsigned long long>(configSourceHash(absolute.string())));
+    return (fs::path(directory) / (fs::path(xmlPath).filename().string() + "." + suffix + ".trdpimg")).string();
+}
+
+bool writeConfigImage(const std::string &imagePath, const RegistrySnapshot &contents, std::uint64_t sourceHash) {
+    ImageWriter out;
+    for (const auto &entry : contents.datasets) {
+        writeDataset(out, *entry.second);
+    }
+    for (const auto &entry : contents.telegrams) {
+        writeTelegram(out, *entry.second);
+    }
+    const auto payload = out.finish();
+
+    ImageHeader header{};
+    std::memcpy(header.magic, kImageMagic, sizeof(header.magic));
+    header.version = kConfigImageVersion;
+    header.byteOrder = kByteOrderMark;
+    header.sourceHash = sourceHash;
+    header.payloadChecksum = fnv1a(payload.data(), payload.size());
+    header.payloadSize = payload.size();
+    header.strings = static_cast<std::uint32_t>(out.stringCount());
+    header.datasets = static_cast<std::uint32_t>(contents.datasets.size());
+    header.telegrams = static_cast<std::uint32_t>(contents.telegrams.size());
+
+    std::error_code ec;
+    const auto directory = std::filesystem::path(imagePath).parent_path();
+    if (!directory.empty()) {
+        std::filesystem::create_directories(directory, ec);
+    }
+    // Readers only ever see a complete image: the old one or the new one.
+    const auto temporary = imagePath + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!file) {
+            std::cerr << "[TRDP] Unable to write config image " << temporary << std::endl;
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), imagePath.c_str()) != 0) {
+        std::cerr << "[TRDP] Unable to replace config image " << imagePath << ": " << std::strerror(errno)
+                  << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::optional<RegistrySnapshot> readConfigImage(const std::string &imagePath, std::uint64_t sourceHash) {
+    MappedImage image;
+    if (!image.open(imagePath)) {
+        return std::nullopt;
+    }
+    ImageHeader header{};
+    std::memcpy(&header, image.map, sizeof(header));
+    if (std::memcmp(header.magic, kImageMagic, sizeof(header.magic)) != 0 || header.byteOrder != kByteOrderMark) {
+        std::cerr << "[TRDP] Ignoring config image " << imagePath << ": not a config image for this host"
+                  << std::endl;
+        return std::nullopt;
+    }
+    if (header.version != kConfigImageVersion || header.sourceHash != sourceHash) {
+        std::cout << "[TRDP] Config image " << imagePath << " is out of date" << std::endl;
+        return std::nullopt;
+    }
+    const auto *payload = image.map + sizeof(header);
+    if (header.payloadSize != image.size - sizeof(header) ||
+        fnv1a(payload, image.size - sizeof(header)) != header.payloadChecksum) {
+        std::cerr << "[TRDP] Ignoring config image " << imagePath << ": checksum mismatch" << std::endl;
+        return std::nullopt;
+    }
+
+    ImageReader in(payload, image.size - sizeof(header));
+    RegistrySnapshot contents;
+    bool ok = in.readStrings(header.strings);
+    // Stored definitions go in as they are: datasets keep their stored field index rather than being re-indexed by
+    // addDataset.
+    for (std::uint32_t i = 0; i < header.datasets && ok; ++i) {
+        DatasetDef dataset;
+        ok = readDataset(in, dataset);
+        if (ok) {
+            auto name = dataset.name;
+            contents.datasets[std::move(name)] = std::make_shared<const DatasetDef>(std::move(dataset));
+        }
+    }
+    for (std::uint32_t i = 0; i < header.telegrams && ok; ++i) {
+        TelegramDef telegram;
+        ok = readTelegram(in, telegram) && contents.datasets.count(telegram.datasetName) != 0U;
+        if (ok) {
+            const auto comId = telegram.comId;
+            contents.telegrams[comId] = std::make_shared<const TelegramDef>(std::move(telegram));
+        }
+    }
+    if (!ok || !in.atEnd()) {
+        std::cerr << "[TRDP] Ignoring config image " << imagePath << ": malformed records" << std::endl;
+        return std::nullopt;
+    }
+    return contents;
+}
+
+} // namespace trdp
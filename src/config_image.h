@@ -0,0 +1,37 @@
+#pragma once
+
+#include "telegram_model.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace trdp {
+
+/**
+ * Compiled form of a TRDP XML configuration: the datasets, their field-name indexes and the telegrams of one
+ * RegistrySnapshot, with every name stored once in a string table. The file starts with a versioned header that
+ * records a hash of the XML it was compiled from and a checksum of everything after the header; an image whose
+ * hash no longer matches the XML, or that fails any check, is ignored and compiled again.
+ *
+ * Records are fixed-width, in host byte order, and read straight out of a memory mapping in one pass.
+ */
+
+// Bump whenever the record layout or the XML interpretation changes, so older images are recompiled.
+constexpr std::uint32_t kConfigImageVersion = 1;
+
+// FNV-1a over the XML bytes; an image is valid only for the source it was compiled from.
+std::uint64_t configSourceHash(const std::string &source);
+
+// Where images go: "" next to their XML (<xml>.trdpimg), a directory to keep them together, or "off" to always
+// parse the XML.
+void setConfigImageDirectory(const std::string &directory);
+// Image path for xmlPath; empty while images are off.
+std::string configImagePath(const std::string &xmlPath);
+
+// Write atomically (temporary file, then rename); false, with the reason logged, when the file cannot be written.
+bool writeConfigImage(const std::string &imagePath, const RegistrySnapshot &contents, std::uint64_t sourceHash);
+// Contents of the image at imagePath when it exists, is intact and was compiled from sourceHash.
+std::optional<RegistrySnapshot> readConfigImage(const std::string &imagePath, std::uint64_t sourceHash);
+
+} // namespace trdp
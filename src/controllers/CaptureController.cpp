@@ -0,0 +1,110 @@
+#include "controllers/CaptureController.h"
+
+#include "capture_recorder.h"
+
+#include <drogon/drogon.h>
+
+namespace trdp {
+
+namespace {
+// Fill config from the request body; unknown keys are ignored, invalid values reported through error.
+bool applyCaptureJson(const Json::Value &json, CaptureRecorder::Config &config, std::string &error) {
+    if (json.isMember("directory")) {
+        config.directory = json["directory"].asString();
+        if (config.directory.empty()) {
+            error = "Invalid 'directory'";
+            return false;
+        }
+    }
+    if (json.isMember("prefix")) {
+        config.prefix = json["prefix"].asString();
+    }
+    if (json.isMember("fileMiB")) {
+        if (!json["fileMiB"].isUInt() || json["fileMiB"].asUInt() == 0U) {
+            error = "Invalid 'fileMiB'";
+            return false;
+        }
+        config.fileBytes = static_cast<std::size_t>(json["fileMiB"].asUInt()) * 1024U * 1024U;
+    }
+    if (json.isMember("fileCount")) {
+        if (!json["fileCount"].isUInt()) {
+            error = "Invalid 'fileCount'";
+            return false;
+        }
+        config.fileCount = json["fileCount"].asUInt();
+    }
+    if (json.isMember("rotateSeconds")) {
+        if (!json["rotateSeconds"].isUInt()) {
+            error = "Invalid 'rotateSeconds'";
+            return false;
+        }
+        config.rotateAfter = std::chrono::seconds(json["rotateSeconds"].asUInt());
+    }
+    return true;
+}
+
+Json::Value statusToJson(const CaptureRecorder::Status &status) {
+    Json::Value json;
+    json["running"] = status.running;
+    json["packets"] = static_cast<Json::UInt64>(status.packets);
+    json["bytes"] = static_cast<Json::UInt64>(status.bytes);
+    json["dropped"] = static_cast<Json::UInt64>(status.dropped);
+    json["rotations"] = static_cast<Json::UInt64>(status.rotations);
+    json["files"] = Json::Value(Json::arrayValue);
+    for (const auto &file : status.files) {
+        Json::Value entry;
+        entry["path"] = file.path;
+        entry["bytes"] = static_cast<Json::UInt64>(file.bytes);
+        entry["current"] = file.current;
+        json["files"].append(entry);
+    }
+
+    const auto &config = status.config;
+    Json::Value cfg;
+    cfg["directory"] = config.directory;
+    cfg["prefix"] = config.prefix;
+    cfg["fileBytes"] = static_cast<Json::UInt64>(config.fileBytes);
+    cfg["fileCount"] = config.fileCount;
+    cfg["rotateSeconds"] = static_cast<Json::Int64>(config.rotateAfter.count());
+    json["config"] = cfg;
+    return json;
+}
+} // namespace
+
+void CaptureController::startCapture(const drogon::HttpRequestPtr &req,
+                                     std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    CaptureRecorder::Config config{};
+    std::string error;
+    // An empty body starts a capture with the defaults.
+    if (const auto json = req->getJsonObject(); json && !applyCaptureJson(*json, config, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    auto &recorder = CaptureRecorder::instance();
+    if (!recorder.start(config, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(recorder.status())));
+}
+
+void CaptureController::stopCapture(const drogon::HttpRequestPtr &,
+                                    std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto &recorder = CaptureRecorder::instance();
+    recorder.stop();
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(recorder.status())));
+}
+
+void CaptureController::getStatus(const drogon::HttpRequestPtr &,
+                                  std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(CaptureRecorder::instance().status())));
+}
+
+} // namespace trdp
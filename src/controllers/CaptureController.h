@@ -0,0 +1,22 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+namespace trdp {
+
+class CaptureController : public drogon::HttpController<CaptureController> {
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(CaptureController::startCapture, "/api/capture/start", drogon::Post);
+    ADD_METHOD_TO(CaptureController::stopCapture, "/api/capture/stop", drogon::Post);
+    ADD_METHOD_TO(CaptureController::getStatus, "/api/capture/status", drogon::Get);
+    METHOD_LIST_END
+
+    void startCapture(const drogon::HttpRequestPtr &req,
+                      std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void stopCapture(const drogon::HttpRequestPtr &req,
+                     std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getStatus(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+};
+
+} // namespace trdp
@@ -1,13 +1,25 @@
 #include "controllers/ConfigController.h"
 
+#include "realtime.h"
 #include "telegram_model.h"
 #include "trdp_engine.h"
+#include "workspace_manager.h"
 
 #include <drogon/drogon.h>
 
 namespace trdp {
 
 namespace {
+Json::Value jitterToJson(const CycleJitter::Snapshot &jitter) {
+    Json::Value json;
+    json["samples"] = static_cast<Json::UInt64>(jitter.samples);
+    json["meanUs"] = jitter.meanUs;
+    json["p99Us"] = jitter.p99Us;
+    json["maxUs"] = jitter.maxUs;
+    json["overruns"] = static_cast<Json::UInt64>(jitter.overruns);
+    return json;
+}
+
 Json::Value datasetToJson(const DatasetDef &dataset) {
     Json::Value json;
     json["name"] = dataset.name;
@@ -20,12 +32,17 @@ Json::Value datasetToJson(const DatasetDef &dataset) {
         f["size"] = static_cast<Json::UInt64>(field.size);
         f["bitOffset"] = static_cast<Json::UInt64>(field.bitOffset);
         f["arrayLength"] = static_cast<Json::UInt64>(field.arrayLength);
+        if (field.checksum != ChecksumKind::None) {
+            f["checksum"] = checksumKindToString(field.checksum);
+            f["checksumStart"] = static_cast<Json::UInt64>(field.checksumStart);
+            f["checksumLength"] = static_cast<Json::UInt64>(field.checksumLength);
+        }
         json["fields"].append(f);
     }
     return json;
 }
 
-Json::Value telegramToJson(const TelegramDef &telegram) {
+Json::Value telegramToJson(TrdpEngine &engine, const TelegramDef &telegram) {
     Json::Value json;
     json["comId"] = telegram.comId;
     json["name"] = telegram.name;
@@ -36,7 +53,7 @@ Json::Value telegramToJson(const TelegramDef &telegram) {
     json["replyTimeoutMs"] = static_cast<Json::UInt64>(telegram.replyTimeout.count());
     json["confirmTimeoutMs"] = static_cast<Json::UInt64>(telegram.confirmTimeout.count());
     if (telegram.direction == Direction::Tx && telegram.type == TelegramType::PD) {
-        json["txActive"] = TrdpEngine::instance().txPublishActive(telegram.comId).value_or(false);
+        json["txActive"] = engine.txPublishActive(telegram.comId).value_or(false);
     }
     return json;
 }
@@ -44,6 +61,12 @@ Json::Value telegramToJson(const TelegramDef &telegram) {
 
 void ConfigController::loadConfig(const drogon::HttpRequestPtr &req,
                                   std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
     auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
     const auto json = req->getJsonObject();
     if (!json || !(*json).isMember("path")) {
@@ -54,16 +77,42 @@ void ConfigController::loadConfig(const drogon::HttpRequestPtr &req,
     }
 
     const auto path = (*json)["path"].asString();
-    TrdpEngine::instance().stop();
-    setDefaultXmlConfig(path);
-    if (!loadFromTauXml(path)) {
+    // A running engine keeps its traffic up: the new configuration is loaded next to the old one and only the
+    // telegrams that differ are bound again. A file that fails to load leaves the old configuration in place.
+    bool loaded = false;
+    if (workspace->isDefault()) {
+        setDefaultXmlConfig(path);
+        loaded = loadFromTauXml(path);
+    } else {
+        loaded = loadFromTauXml(path, workspace->registry());
+    }
+    if (!loaded) {
         resp->setStatusCode(drogon::k500InternalServerError);
         (*resp->getJsonObject())["error"] = "Failed to load XML";
         callback(resp);
         return;
     }
 
-    if (!TrdpEngine::instance().start()) {
+    if (engine.isRunning()) {
+        const auto report = engine.applyRegistryChanges();
+        if (!report.applied) {
+            resp->setStatusCode(drogon::k500InternalServerError);
+            (*resp->getJsonObject())["error"] = "TRDP engine failed to apply the configuration";
+            callback(resp);
+            return;
+        }
+        Json::Value reload;
+        reload["added"] = static_cast<Json::UInt64>(report.added);
+        reload["removed"] = static_cast<Json::UInt64>(report.removed);
+        reload["changed"] = static_cast<Json::UInt64>(report.changed);
+        reload["readdressed"] = static_cast<Json::UInt64>(report.readdressed);
+        reload["unchanged"] = static_cast<Json::UInt64>(report.unchanged);
+        reload["restarted"] = report.restarted;
+        reload["pausedUs"] = static_cast<Json::Int64>(report.paused.count());
+        reload["applyUs"] = static_cast<Json::Int64>(report.apply.count());
+        (*resp->getJsonObject())["reload"] = reload;
+    } else if (!engine.start(engine.activeConfig())) {
+        // Keep the interface/transport selection the engine was started with.
         resp->setStatusCode(drogon::k500InternalServerError);
         (*resp->getJsonObject())["error"] = "TRDP engine failed to start";
         callback(resp);
@@ -74,9 +123,15 @@ void ConfigController::loadConfig(const drogon::HttpRequestPtr &req,
     callback(resp);
 }
 
-void ConfigController::listDatasets(const drogon::HttpRequestPtr &,
+void ConfigController::listDatasets(const drogon::HttpRequestPtr &req,
                                     std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
-    if (!ensureRegistryInitialized()) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &registry = workspace->registry();
+    if (!workspace->registryReady()) {
         auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
         resp->setStatusCode(drogon::k500InternalServerError);
         (*resp->getJsonObject())["error"] = "TRDP registry is not initialised";
@@ -85,15 +140,23 @@ void ConfigController::listDatasets(const drogon::HttpRequestPtr &,
     }
 
     Json::Value json;
-    for (const auto &dataset : TelegramRegistry::instance().listDatasets()) {
-        json.append(datasetToJson(dataset));
+    const auto contents = registry.snapshot();
+    for (const auto &[name, dataset] : contents->datasets) {
+        json.append(datasetToJson(*dataset));
     }
     callback(drogon::HttpResponse::newHttpJsonResponse(json));
 }
 
-void ConfigController::listTelegrams(const drogon::HttpRequestPtr &,
+void ConfigController::listTelegrams(const drogon::HttpRequestPtr &req,
                                      std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
-    if (!ensureRegistryInitialized()) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    auto &registry = workspace->registry();
+    if (!workspace->registryReady()) {
         auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
         resp->setStatusCode(drogon::k500InternalServerError);
         (*resp->getJsonObject())["error"] = "TRDP registry is not initialised";
@@ -102,8 +165,108 @@ void ConfigController::listTelegrams(const drogon::HttpRequestPtr &,
     }
 
     Json::Value json;
-    for (const auto &telegram : TelegramRegistry::instance().listTelegrams()) {
-        json.append(telegramToJson(telegram));
+    const auto contents = registry.snapshot();
+    for (const auto &[comId, telegram] : contents->telegrams) {
+        json.append(telegramToJson(engine, *telegram));
+    }
+    callback(drogon::HttpResponse::newHttpJsonResponse(json));
+}
+
+void ConfigController::getTransport(const drogon::HttpRequestPtr &req,
+                                    std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    const auto status = engine.transportStatus();
+    Json::Value json;
+    json["backend"] = status.backend;
+    json["ports"] = Json::Value(Json::arrayValue);
+    for (const auto port : status.ports) {
+        json["ports"].append(port);
+    }
+    Json::Value clock;
+    clock["mode"] = status.virtualTime ? "virtual" : "real";
+    clock["elapsedSeconds"] = status.clockSeconds;
+    clock["realSeconds"] = status.realSeconds;
+    json["clock"] = clock;
+    if (status.native) {
+        const auto &stats = *status.native;
+        Json::Value native;
+        native["framesSent"] = static_cast<Json::UInt64>(stats.framesSent);
+        native["bytesSent"] = static_cast<Json::UInt64>(stats.bytesSent);
+        native["sendCalls"] = static_cast<Json::UInt64>(stats.sendCalls);
+        native["sendErrors"] = static_cast<Json::UInt64>(stats.sendErrors);
+        native["framesReceived"] = static_cast<Json::UInt64>(stats.framesReceived);
+        native["bytesReceived"] = static_cast<Json::UInt64>(stats.bytesReceived);
+        native["recvCalls"] = static_cast<Json::UInt64>(stats.recvCalls);
+        native["headerErrors"] = static_cast<Json::UInt64>(stats.headerErrors);
+        native["crcErrors"] = static_cast<Json::UInt64>(stats.crcErrors);
+        native["topologyErrors"] = static_cast<Json::UInt64>(stats.topologyErrors);
+        json["native"] = native;
+    }
+    json["shards"] = Json::Value(Json::arrayValue);
+    for (const auto &shard : status.shards) {
+        Json::Value entry;
+        entry["index"] = static_cast<Json::UInt64>(shard.index);
+        entry["cpu"] = shard.cpu;
+        entry["ports"] = Json::Value(Json::arrayValue);
+        for (const auto port : shard.ports) {
+            entry["ports"].append(port);
+        }
+        entry["cyclicTelegrams"] = static_cast<Json::UInt64>(shard.cyclicTelegrams);
+        entry["framesSent"] = static_cast<Json::UInt64>(shard.framesSent);
+        if (shard.cpuSeconds) {
+            entry["cpuSeconds"] = *shard.cpuSeconds;
+        }
+        entry["jitter"] = jitterToJson(shard.jitter);
+        json["shards"].append(entry);
+    }
+    callback(drogon::HttpResponse::newHttpJsonResponse(json));
+}
+
+void ConfigController::getRealtime(const drogon::HttpRequestPtr &req,
+                                   std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    const auto config = engine.activeConfig();
+    const auto status = engine.transportStatus();
+    Json::Value json;
+    Json::Value worker;
+    worker["policy"] = schedPolicyToString(config.workerRealtime.policy);
+    worker["priority"] = config.workerRealtime.priority;
+    worker["cpu"] = config.workerRealtime.cpu;
+    worker["jitter"] = jitterToJson(status.workerJitter);
+    json["worker"] = worker;
+    json["shardCpus"] = Json::Value(Json::arrayValue);
+    for (const auto cpu : config.shardCpus) {
+        json["shardCpus"].append(cpu);
+    }
+    // Measured lateness of each shard's cyclic publications, next to the settings they ran with.
+    json["shards"] = Json::Value(Json::arrayValue);
+    for (const auto &shard : status.shards) {
+        Json::Value entry;
+        entry["index"] = static_cast<Json::UInt64>(shard.index);
+        entry["cpu"] = shard.cpu;
+        entry["jitter"] = jitterToJson(shard.jitter);
+        json["shards"].append(entry);
+    }
+    json["prefault"] = config.prefault;
+    // Process-wide: every workspace reports the same checks, labelled by thread.
+    json["checks"] = Json::Value(Json::arrayValue);
+    for (const auto &check : RealtimeReport::instance().checks()) {
+        Json::Value entry;
+        entry["setting"] = check.setting;
+        entry["requested"] = check.requested;
+        entry["applied"] = check.applied;
+        entry["detail"] = check.detail;
+        json["checks"].append(entry);
     }
     callback(drogon::HttpResponse::newHttpJsonResponse(json));
 }
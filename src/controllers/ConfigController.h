@@ -10,11 +10,15 @@ class ConfigController : public drogon::HttpController<ConfigController> {
     ADD_METHOD_TO(ConfigController::loadConfig, "/api/config/load", drogon::Post);
     ADD_METHOD_TO(ConfigController::listDatasets, "/api/config/datasets", drogon::Get);
     ADD_METHOD_TO(ConfigController::listTelegrams, "/api/config/telegrams", drogon::Get);
+    ADD_METHOD_TO(ConfigController::getTransport, "/api/config/transport", drogon::Get);
+    ADD_METHOD_TO(ConfigController::getRealtime, "/api/config/realtime", drogon::Get);
     METHOD_LIST_END
 
     void loadConfig(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
     void listDatasets(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
     void listTelegrams(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getTransport(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getRealtime(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
 };
 
 } // namespace trdp
@@ -0,0 +1,165 @@
+#include "controllers/GeneratorController.h"
+
+#include "traffic_generator.h"
+
+#include <drogon/drogon.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+namespace trdp {
+
+namespace {
+std::string ipToString(std::uint32_t ip) {
+    in_addr addr{};
+    addr.s_addr = htonl(ip);
+    return inet_ntoa(addr);
+}
+
+// Fill config from the request body; unknown keys are ignored, invalid values reported through error.
+bool applyGeneratorJson(const Json::Value &json, TrafficGenerator::Config &config, std::string &error) {
+    if (json.isMember("count")) {
+        config.count = json["count"].asUInt();
+    }
+    if (json.isMember("comIdBase")) {
+        config.comIdBase = json["comIdBase"].asUInt();
+    }
+    if (json.isMember("datasetBytes")) {
+        config.datasetBytes = json["datasetBytes"].asUInt();
+    }
+    if (json.isMember("cycleMs")) {
+        const auto &cycle = json["cycleMs"];
+        bool ok = false;
+        if (cycle.isUInt()) {
+            ok = TrafficGenerator::applyCycleSpec(std::to_string(cycle.asUInt()), config);
+        } else if (cycle.isArray() && !cycle.empty()) {
+            config.distribution = TrafficGenerator::CycleDistribution::Classes;
+            config.cycleClasses.clear();
+            ok = true;
+            for (const auto &entry : cycle) {
+                ok = ok && entry.isUInt() && entry.asUInt() > 0U;
+                config.cycleClasses.emplace_back(entry.asUInt());
+            }
+        } else if (cycle.isString()) {
+            ok = TrafficGenerator::applyCycleSpec(cycle.asString(), config);
+        }
+        if (!ok) {
+            error = "Invalid 'cycleMs'; use a number, \"min-max\" or a list of cycle classes";
+            return false;
+        }
+    }
+    if (json.isMember("pattern")) {
+        const auto pattern = TrafficGenerator::parsePattern(json["pattern"].asString());
+        if (!pattern) {
+            error = "Invalid 'pattern'; expected zeros, ramp, random, comid or prbs";
+            return false;
+        }
+        config.pattern = *pattern;
+    }
+    if (json.isMember("destIp")) {
+        in_addr addr{};
+        if (inet_aton(json["destIp"].asCString(), &addr) == 0) {
+            error = "Invalid 'destIp'";
+            return false;
+        }
+        config.destIp = ntohl(addr.s_addr);
+    }
+    if (json.isMember("port")) {
+        const auto port = json["port"].asUInt();
+        if (port == 0 || port > 65535U) {
+            error = "Invalid 'port'";
+            return false;
+        }
+        config.port = static_cast<std::uint16_t>(port);
+    }
+    if (json.isMember("replaceExisting")) {
+        config.replaceExisting = json["replaceExisting"].asBool();
+    }
+    if (json.isMember("quiet")) {
+        config.quiet = json["quiet"].asBool();
+    }
+    return true;
+}
+
+Json::Value statusToJson(const TrafficGenerator::Status &status) {
+    Json::Value json;
+    json["running"] = status.running;
+    json["telegrams"] = status.telegrams;
+    json["targetRate"] = status.targetRate;
+    json["achievedRate"] = status.achievedRate;
+    json["sent"] = static_cast<Json::UInt64>(status.sent);
+    json["failed"] = static_cast<Json::UInt64>(status.failed);
+    json["elapsedSeconds"] = status.elapsedSeconds;
+    json["cpuMicrosPerTelegram"] =
+        status.cpuMicrosPerTelegram ? Json::Value(*status.cpuMicrosPerTelegram) : Json::Value();
+    json["cpuUtilisation"] = status.cpuUtilisation ? Json::Value(*status.cpuUtilisation) : Json::Value();
+
+    const auto &config = status.config;
+    Json::Value cfg;
+    cfg["count"] = config.count;
+    cfg["comIdBase"] = config.comIdBase;
+    cfg["datasetBytes"] = static_cast<Json::UInt64>(config.datasetBytes);
+    cfg["distribution"] = TrafficGenerator::distributionToString(config.distribution);
+    cfg["cycleMinMs"] = static_cast<Json::Int64>(config.cycleMin.count());
+    cfg["cycleMaxMs"] = static_cast<Json::Int64>(config.cycleMax.count());
+    cfg["cycleClassesMs"] = Json::Value(Json::arrayValue);
+    for (const auto &cycle : config.cycleClasses) {
+        cfg["cycleClassesMs"].append(static_cast<Json::Int64>(cycle.count()));
+    }
+    cfg["pattern"] = TrafficGenerator::patternToString(config.pattern);
+    cfg["destIp"] = ipToString(config.destIp);
+    cfg["port"] = config.port;
+    cfg["replaceExisting"] = config.replaceExisting;
+    cfg["quiet"] = config.quiet;
+    json["config"] = cfg;
+    return json;
+}
+} // namespace
+
+void GeneratorController::startGenerator(const drogon::HttpRequestPtr &req,
+                                         std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    const auto json = req->getJsonObject();
+    if (!json || !(*json).isMember("count")) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = "Missing 'count' field";
+        callback(resp);
+        return;
+    }
+
+    TrafficGenerator::Config config{};
+    std::string error;
+    if (!applyGeneratorJson(*json, config, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    auto &generator = TrafficGenerator::instance();
+    if (!generator.start(config, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(generator.status())));
+}
+
+void GeneratorController::stopGenerator(const drogon::HttpRequestPtr &,
+                                        std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto &generator = TrafficGenerator::instance();
+    const auto finalStatus = generator.status();
+    generator.stop();
+    auto json = statusToJson(finalStatus);
+    json["running"] = false;
+    callback(drogon::HttpResponse::newHttpJsonResponse(json));
+}
+
+void GeneratorController::getStatus(const drogon::HttpRequestPtr &,
+                                    std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(TrafficGenerator::instance().status())));
+}
+
+} // namespace trdp
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+namespace trdp {
+
+class GeneratorController : public drogon::HttpController<GeneratorController> {
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(GeneratorController::startGenerator, "/api/generator/start", drogon::Post);
+    ADD_METHOD_TO(GeneratorController::stopGenerator, "/api/generator/stop", drogon::Post);
+    ADD_METHOD_TO(GeneratorController::getStatus, "/api/generator/status", drogon::Get);
+    METHOD_LIST_END
+
+    void startGenerator(const drogon::HttpRequestPtr &req,
+                        std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void stopGenerator(const drogon::HttpRequestPtr &req,
+                       std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getStatus(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+};
+
+} // namespace trdp
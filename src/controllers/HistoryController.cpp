@@ -0,0 +1,284 @@
+#include "controllers/HistoryController.h"
+
+#include "field_history.h"
+#include "history_downsample.h"
+#include "history_store.h"
+
+#include <drogon/drogon.h>
+
+#include <limits>
+
+namespace trdp {
+
+namespace {
+constexpr std::size_t kMaxBuckets = 10000U;
+
+bool applyHistoryJson(const Json::Value &json, FieldHistory::Config &config, std::string &error) {
+    if (json.isMember("budgetMiB")) {
+        if (!json["budgetMiB"].isUInt()) {
+            error = "Invalid 'budgetMiB'";
+            return false;
+        }
+        config.budgetBytes = static_cast<std::size_t>(json["budgetMiB"].asUInt()) * 1024U * 1024U;
+    }
+    if (json.isMember("fields")) {
+        if (!json["fields"].isArray()) {
+            error = "Invalid 'fields'";
+            return false;
+        }
+        config.fields.clear();
+        for (const auto &entry : json["fields"]) {
+            config.fields.push_back(entry.asString());
+        }
+    }
+    return true;
+}
+
+bool applyStoreJson(const Json::Value &json, HistoryStore::Config &config, std::string &error) {
+    if (json.isMember("directory")) {
+        config.directory = json["directory"].asString();
+    }
+    if (json.isMember("fields")) {
+        if (!json["fields"].isArray()) {
+            error = "Invalid 'fields'";
+            return false;
+        }
+        config.fields.clear();
+        for (const auto &entry : json["fields"]) {
+            config.fields.push_back(entry.asString());
+        }
+    }
+    if (json.isMember("chunkRows")) {
+        if (!json["chunkRows"].isUInt()) {
+            error = "Invalid 'chunkRows'";
+            return false;
+        }
+        config.chunkRows = json["chunkRows"].asUInt();
+    }
+    if (json.isMember("sealSeconds")) {
+        if (!json["sealSeconds"].isUInt()) {
+            error = "Invalid 'sealSeconds'";
+            return false;
+        }
+        config.sealAfter = std::chrono::seconds(json["sealSeconds"].asUInt());
+    }
+    if (json.isMember("queueMiB")) {
+        if (!json["queueMiB"].isUInt()) {
+            error = "Invalid 'queueMiB'";
+            return false;
+        }
+        config.queueBytes = static_cast<std::size_t>(json["queueMiB"].asUInt()) * 1024U * 1024U;
+    }
+    return true;
+}
+
+// Parse an optional non-negative integer query parameter; absent parameters keep value.
+template <typename T> bool readParameter(const drogon::HttpRequestPtr &req, const std::string &key, T &value) {
+    const auto &text = req->getParameter(key);
+    if (text.empty()) {
+        return true;
+    }
+    if (text.find_first_not_of("0123456789") != std::string::npos || text.size() > 15U) {
+        return false;
+    }
+    value = static_cast<T>(std::stoll(text));
+    return true;
+}
+
+Json::Value statusToJson(const FieldHistory::Status &status) {
+    Json::Value json;
+    json["enabled"] = !status.telegrams.empty();
+    json["budgetBytes"] = static_cast<Json::UInt64>(status.config.budgetBytes);
+    json["usedBytes"] = static_cast<Json::UInt64>(status.usedBytes);
+    json["samplesWritten"] = static_cast<Json::UInt64>(status.samplesWritten);
+    const auto cache = HistoryDownsampler::instance().cacheStats();
+    json["downsampleCache"]["entries"] = static_cast<Json::UInt64>(cache.entries);
+    json["downsampleCache"]["hits"] = static_cast<Json::UInt64>(cache.hits);
+    json["downsampleCache"]["misses"] = static_cast<Json::UInt64>(cache.misses);
+    json["selection"] = Json::Value(Json::arrayValue);
+    for (const auto &entry : status.config.fields) {
+        json["selection"].append(entry);
+    }
+    json["telegrams"] = Json::Value(Json::arrayValue);
+    for (const auto &telegram : status.telegrams) {
+        Json::Value entry;
+        entry["comId"] = telegram.comId;
+        entry["capacity"] = static_cast<Json::UInt64>(telegram.capacity);
+        entry["samples"] = static_cast<Json::UInt64>(telegram.samples);
+        entry["bytes"] = static_cast<Json::UInt64>(telegram.bytes);
+        entry["fields"] = Json::Value(Json::arrayValue);
+        for (const auto &field : telegram.fields) {
+            entry["fields"].append(field);
+        }
+        json["telegrams"].append(entry);
+    }
+    return json;
+}
+
+Json::Value storeStatusToJson(const HistoryStore::Status &status) {
+    Json::Value json;
+    json["running"] = status.running;
+    json["telegrams"] = static_cast<Json::UInt64>(status.telegrams);
+    json["dropped"] = static_cast<Json::UInt64>(status.dropped);
+    json["chunks"] = static_cast<Json::UInt64>(status.chunks);
+    json["rows"] = static_cast<Json::UInt64>(status.rows);
+    json["diskBytes"] = static_cast<Json::UInt64>(status.diskBytes);
+    json["rawBytes"] = static_cast<Json::UInt64>(status.rawBytes);
+    json["queuedBytes"] = static_cast<Json::UInt64>(status.queuedBytes);
+    json["comIds"] = Json::Value(Json::arrayValue);
+    for (const auto comId : status.comIds) {
+        json["comIds"].append(comId);
+    }
+    if (!status.error.empty()) {
+        json["error"] = status.error;
+    }
+
+    const auto &config = status.config;
+    Json::Value cfg;
+    cfg["directory"] = config.directory;
+    cfg["fields"] = Json::Value(Json::arrayValue);
+    for (const auto &entry : config.fields) {
+        cfg["fields"].append(entry);
+    }
+    cfg["chunkRows"] = config.chunkRows;
+    cfg["sealSeconds"] = static_cast<Json::Int64>(config.sealAfter.count());
+    cfg["queueBytes"] = static_cast<Json::UInt64>(config.queueBytes);
+    json["config"] = cfg;
+    return json;
+}
+
+Json::Value windowToJson(const FieldHistory::Window &window) {
+    constexpr double kNsPerMs = 1e6;
+    Json::Value json;
+    json["comId"] = window.comId;
+    json["field"] = window.field;
+    json["sourceSamples"] = static_cast<Json::UInt64>(window.sourceSamples);
+    json["fromMs"] = static_cast<double>(window.fromNs) / kNsPerMs;
+    json["toMs"] = static_cast<double>(window.toNs) / kNsPerMs;
+    if (!window.buckets.empty()) {
+        json["buckets"] = Json::Value(Json::arrayValue);
+        for (const auto &bucket : window.buckets) {
+            Json::Value entry;
+            entry["startMs"] = static_cast<double>(bucket.startNs) / kNsPerMs;
+            entry["endMs"] = static_cast<double>(bucket.endNs) / kNsPerMs;
+            entry["count"] = bucket.count;
+            if (bucket.count > 0U) {
+                entry["min"] = bucket.min;
+                entry["max"] = bucket.max;
+                entry["avg"] = bucket.avg;
+            }
+            json["buckets"].append(entry);
+        }
+        return json;
+    }
+    json["samples"] = Json::Value(Json::arrayValue);
+    for (std::size_t i = 0; i < window.values.size(); ++i) {
+        Json::Value sample(Json::arrayValue);
+        sample.append(static_cast<double>(window.timestamps[i]) / kNsPerMs);
+        sample.append(window.values[i]);
+        json["samples"].append(sample);
+    }
+    return json;
+}
+} // namespace
+
+void HistoryController::getStatus(const drogon::HttpRequestPtr &,
+                                  std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(FieldHistory::instance().status())));
+}
+
+void HistoryController::configure(const drogon::HttpRequestPtr &req,
+                                  std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    auto &history = FieldHistory::instance();
+    auto config = history.status().config;
+    std::string error;
+    const auto json = req->getJsonObject();
+    if (!json) {
+        error = "Expected a JSON body";
+    } else if (applyHistoryJson(*json, config, error) && history.configure(config, error)) {
+        callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(history.status())));
+        return;
+    }
+    resp->setStatusCode(drogon::k400BadRequest);
+    (*resp->getJsonObject())["error"] = error;
+    callback(resp);
+}
+
+void HistoryController::startStore(const drogon::HttpRequestPtr &req,
+                                   std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    HistoryStore::Config config{};
+    std::string error;
+    const auto json = req->getJsonObject();
+    if (!json) {
+        error = "Expected a JSON body";
+    } else if (applyStoreJson(*json, config, error) && HistoryStore::instance().start(config, error)) {
+        callback(drogon::HttpResponse::newHttpJsonResponse(storeStatusToJson(HistoryStore::instance().status())));
+        return;
+    }
+    resp->setStatusCode(drogon::k400BadRequest);
+    (*resp->getJsonObject())["error"] = error;
+    callback(resp);
+}
+
+void HistoryController::stopStore(const drogon::HttpRequestPtr &,
+                                  std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto &store = HistoryStore::instance();
+    store.stop();
+    callback(drogon::HttpResponse::newHttpJsonResponse(storeStatusToJson(store.status())));
+}
+
+void HistoryController::getStoreStatus(const drogon::HttpRequestPtr &,
+                                       std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    callback(drogon::HttpResponse::newHttpJsonResponse(storeStatusToJson(HistoryStore::instance().status())));
+}
+
+void HistoryController::getWindow(const drogon::HttpRequestPtr &req,
+                                  std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                                  std::uint32_t comId, std::string field) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    std::int64_t fromMs = 0;
+    std::int64_t toMs = -1;
+    std::size_t buckets = 0;
+    std::size_t points = 0;
+    const auto mode = HistoryDownsampler::parseMode(req->getParameter("mode"));
+    if (!readParameter(req, "from", fromMs) || !readParameter(req, "to", toMs) ||
+        !readParameter(req, "buckets", buckets) || buckets > kMaxBuckets || !readParameter(req, "points", points) ||
+        !mode || (buckets > 0U && points > 0U)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = "Invalid 'from', 'to', 'buckets', 'points' or 'mode'";
+        callback(resp);
+        return;
+    }
+
+    const auto fromNs = fromMs * 1000000;
+    const auto toNs = toMs < 0 ? std::numeric_limits<std::int64_t>::max() : toMs * 1000000;
+    const bool fromStore = req->getParameter("source") == "store";
+    std::string error;
+    std::optional<FieldHistory::Window> window;
+    if (points > 0U) {
+        HistoryDownsampler::Request request;
+        request.source = fromStore ? HistoryDownsampler::Source::Store : HistoryDownsampler::Source::Rings;
+        request.comId = comId;
+        request.field = field;
+        request.fromNs = fromNs;
+        request.toNs = toNs;
+        request.points = points;
+        request.mode = *mode;
+        window = HistoryDownsampler::instance().query(request, error);
+    } else if (fromStore) {
+        window = HistoryStore::instance().query(comId, field, fromNs, toNs, buckets, error);
+    } else {
+        window = FieldHistory::instance().query(comId, field, fromNs, toNs, buckets, error);
+    }
+    if (!window) {
+        resp->setStatusCode(drogon::k404NotFound);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+    callback(drogon::HttpResponse::newHttpJsonResponse(windowToJson(*window)));
+}
+
+} // namespace trdp
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+#include <string>
+
+namespace trdp {
+
+class HistoryController : public drogon::HttpController<HistoryController> {
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(HistoryController::getStatus, "/api/history/status", drogon::Get);
+    ADD_METHOD_TO(HistoryController::configure, "/api/history/config", drogon::Post);
+    ADD_METHOD_TO(HistoryController::startStore, "/api/history/store/start", drogon::Post);
+    ADD_METHOD_TO(HistoryController::stopStore, "/api/history/store/stop", drogon::Post);
+    ADD_METHOD_TO(HistoryController::getStoreStatus, "/api/history/store/status", drogon::Get);
+    ADD_METHOD_TO(HistoryController::getWindow, "/api/history/{1}/{2}", drogon::Get);
+    METHOD_LIST_END
+
+    void getStatus(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void configure(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void startStore(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void stopStore(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getStoreStatus(const drogon::HttpRequestPtr &req,
+                        std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+
+    // Query parameters: from/to (milliseconds since the epoch, default: everything retained), buckets (0 or
+    // absent returns raw samples), points + mode=lttb|minmax for a chart-sized view, and source=store to read
+    // the on-disk store instead of the in-memory rings.
+    void getWindow(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                   std::uint32_t comId, std::string field);
+};
+
+} // namespace trdp
@@ -0,0 +1,155 @@
+#include "controllers/ReplayController.h"
+
+#include "capture_replay.h"
+
+#include <drogon/drogon.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+namespace trdp {
+
+namespace {
+std::string ipToString(std::uint32_t ip) {
+    in_addr addr{};
+    addr.s_addr = htonl(ip);
+    return inet_ntoa(addr);
+}
+
+// Fill config from the request body; unknown keys are ignored, invalid values reported through error.
+bool applyReplayJson(const Json::Value &json, CaptureReplay::Config &config, std::string &error) {
+    config.path = json["path"].asString();
+    if (json.isMember("speed")) {
+        if (!json["speed"].isNumeric()) {
+            error = "Invalid 'speed'";
+            return false;
+        }
+        config.speed = json["speed"].asDouble();
+    }
+    if (json.isMember("loop")) {
+        config.loop = json["loop"].asBool();
+    }
+    if (json.isMember("target")) {
+        const auto target = CaptureReplay::parseTarget(json["target"].asString());
+        if (!target) {
+            error = "Invalid 'target'; expected wire or rx";
+            return false;
+        }
+        config.target = *target;
+    }
+    if (json.isMember("comIds")) {
+        const auto &comIds = json["comIds"];
+        if (!comIds.isArray()) {
+            error = "Invalid 'comIds'; expected a list of ComIds";
+            return false;
+        }
+        for (const auto &comId : comIds) {
+            if (!comId.isUInt()) {
+                error = "Invalid 'comIds'; expected a list of ComIds";
+                return false;
+            }
+            config.comIds.push_back(comId.asUInt());
+        }
+    }
+    if (json.isMember("destIp")) {
+        in_addr addr{};
+        if (inet_aton(json["destIp"].asCString(), &addr) == 0) {
+            error = "Invalid 'destIp'";
+            return false;
+        }
+        config.destIp = ntohl(addr.s_addr);
+    }
+    if (json.isMember("destPort")) {
+        const auto port = json["destPort"].asUInt();
+        if (port == 0 || port > 65535U) {
+            error = "Invalid 'destPort'";
+            return false;
+        }
+        config.destPort = static_cast<std::uint16_t>(port);
+    }
+    return true;
+}
+
+Json::Value statusToJson(const CaptureReplay::Status &status) {
+    Json::Value json;
+    json["running"] = status.running;
+    json["fileBytes"] = static_cast<Json::UInt64>(status.fileBytes);
+    json["position"] = static_cast<Json::UInt64>(status.position);
+    json["replayed"] = static_cast<Json::UInt64>(status.replayed);
+    json["filtered"] = static_cast<Json::UInt64>(status.filtered);
+    json["failed"] = static_cast<Json::UInt64>(status.failed);
+    json["skipped"] = static_cast<Json::UInt64>(status.skipped);
+    json["loops"] = static_cast<Json::UInt64>(status.loops);
+    json["captureSeconds"] = status.captureSeconds;
+    json["maxLateMs"] = status.maxLateMs;
+    json["error"] = status.error.empty() ? Json::Value() : Json::Value(status.error);
+    json["comIds"] = Json::Value(Json::arrayValue);
+    for (const auto &entry : status.comIds) {
+        Json::Value item;
+        item["comId"] = entry.comId;
+        item["telegrams"] = static_cast<Json::UInt64>(entry.telegrams);
+        item["bytes"] = static_cast<Json::UInt64>(entry.bytes);
+        json["comIds"].append(item);
+    }
+
+    const auto &config = status.config;
+    Json::Value cfg;
+    cfg["path"] = config.path;
+    cfg["speed"] = config.speed;
+    cfg["loop"] = config.loop;
+    cfg["target"] = CaptureReplay::targetToString(config.target);
+    cfg["comIds"] = Json::Value(Json::arrayValue);
+    for (const auto comId : config.comIds) {
+        cfg["comIds"].append(comId);
+    }
+    cfg["destIp"] = config.destIp != 0U ? Json::Value(ipToString(config.destIp)) : Json::Value();
+    cfg["destPort"] = config.destPort != 0U ? Json::Value(config.destPort) : Json::Value();
+    json["config"] = cfg;
+    return json;
+}
+} // namespace
+
+void ReplayController::startReplay(const drogon::HttpRequestPtr &req,
+                                   std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    const auto json = req->getJsonObject();
+    if (!json || !(*json).isMember("path")) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = "Missing 'path' field";
+        callback(resp);
+        return;
+    }
+
+    CaptureReplay::Config config{};
+    std::string error;
+    if (!applyReplayJson(*json, config, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    auto &replay = CaptureReplay::instance();
+    if (!replay.start(config, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(replay.status())));
+}
+
+void ReplayController::stopReplay(const drogon::HttpRequestPtr &,
+                                  std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto &replay = CaptureReplay::instance();
+    replay.stop();
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(replay.status())));
+}
+
+void ReplayController::getStatus(const drogon::HttpRequestPtr &,
+                                 std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(CaptureReplay::instance().status())));
+}
+
+} // namespace trdp
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+namespace trdp {
+
+class ReplayController : public drogon::HttpController<ReplayController> {
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(ReplayController::startReplay, "/api/replay/start", drogon::Post);
+    ADD_METHOD_TO(ReplayController::stopReplay, "/api/replay/stop", drogon::Post);
+    ADD_METHOD_TO(ReplayController::getStatus, "/api/replay/status", drogon::Get);
+    METHOD_LIST_END
+
+    void startReplay(const drogon::HttpRequestPtr &req,
+                     std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void stopReplay(const drogon::HttpRequestPtr &req,
+                    std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getStatus(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+};
+
+} // namespace trdp
@@ -0,0 +1,139 @@
+#include "controllers/RuleController.h"
+
+#include "rule_engine.h"
+
+#include <drogon/drogon.h>
+
+#include <iomanip>
+#include <sstream>
+
+namespace trdp {
+
+namespace {
+// Assignments accept an expression string or a plain number/boolean.
+bool expressionFromJson(const Json::Value &value, std::string &expression) {
+    if (value.isString()) {
+        expression = value.asString();
+    } else if (value.isBool()) {
+        expression = value.asBool() ? "true" : "false";
+    } else if (value.isInt64()) {
+        expression = std::to_string(value.asInt64());
+    } else if (value.isUInt64()) {
+        expression = std::to_string(value.asUInt64());
+    } else if (value.isDouble()) {
+        std::ostringstream text;
+        text << std::setprecision(17) << value.asDouble();
+        expression = text.str();
+    } else {
+        return false;
+    }
+    return !expression.empty();
+}
+
+bool rulesFromJson(const Json::Value &json, std::vector<RuleEngine::RuleDef> &rules, std::string &error) {
+    for (const auto &entry : json) {
+        RuleEngine::RuleDef rule;
+        rule.name = entry["name"].asString();
+        rule.condition = entry["when"].asString();
+        const auto trigger = RuleEngine::parseTrigger(entry["trigger"].asString());
+        if (!trigger) {
+            error = "Invalid 'trigger' in rule '" + rule.name + "'; expected rising or always";
+            return false;
+        }
+        rule.trigger = *trigger;
+        if (entry.isMember("actions") && !entry["actions"].isArray()) {
+            error = "Invalid 'actions' in rule '" + rule.name + "'";
+            return false;
+        }
+        for (const auto &actionJson : entry["actions"]) {
+            RuleEngine::ActionDef action;
+            action.telegram = actionJson["telegram"].isUInt() ? std::to_string(actionJson["telegram"].asUInt())
+                                                              : actionJson["telegram"].asString();
+            const auto &set = actionJson["set"];
+            if (!set.isNull() && !set.isObject()) {
+                error = "Invalid 'set' in rule '" + rule.name + "'";
+                return false;
+            }
+            for (const auto &field : set.getMemberNames()) {
+                RuleEngine::Assignment assignment;
+                assignment.field = field;
+                if (!expressionFromJson(set[field], assignment.expression)) {
+                    error = "Invalid value for '" + field + "' in rule '" + rule.name + "'";
+                    return false;
+                }
+                action.assignments.push_back(std::move(assignment));
+            }
+            rule.actions.push_back(std::move(action));
+        }
+        rules.push_back(std::move(rule));
+    }
+    return true;
+}
+
+Json::Value rulesToJson() {
+    auto &engine = RuleEngine::instance();
+    const auto defs = engine.rules();
+    const auto stats = engine.stats();
+    Json::Value json;
+    json["rules"] = Json::Value(Json::arrayValue);
+    for (std::size_t i = 0; i < defs.size() && i < stats.size(); ++i) {
+        const auto &def = defs[i];
+        const auto &stat = stats[i];
+        Json::Value rule;
+        rule["name"] = def.name;
+        rule["when"] = def.condition;
+        rule["trigger"] = RuleEngine::triggerToString(def.trigger);
+        rule["actions"] = Json::Value(Json::arrayValue);
+        for (const auto &action : def.actions) {
+            Json::Value actionJson;
+            actionJson["telegram"] = action.telegram;
+            actionJson["set"] = Json::Value(Json::objectValue);
+            for (const auto &assignment : action.assignments) {
+                actionJson["set"][assignment.field] = assignment.expression;
+            }
+            rule["actions"].append(actionJson);
+        }
+        rule["compiled"] = stat.compiled;
+        if (!stat.error.empty()) {
+            rule["error"] = stat.error;
+        }
+        rule["state"] = stat.state;
+        rule["evaluations"] = static_cast<Json::UInt64>(stat.evaluations);
+        rule["fires"] = static_cast<Json::UInt64>(stat.fires);
+        rule["failures"] = static_cast<Json::UInt64>(stat.failures);
+        rule["lastReactionUs"] = static_cast<double>(stat.lastReaction.count()) / 1000.0;
+        rule["maxReactionUs"] = static_cast<double>(stat.maxReaction.count()) / 1000.0;
+        json["rules"].append(rule);
+    }
+    return json;
+}
+} // namespace
+
+void RuleController::getRules(const drogon::HttpRequestPtr &,
+                              std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    callback(drogon::HttpResponse::newHttpJsonResponse(rulesToJson()));
+}
+
+void RuleController::setRules(const drogon::HttpRequestPtr &req,
+                              std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    const auto json = req->getJsonObject();
+    if (!json || !(*json)["rules"].isArray()) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = "Missing 'rules' array";
+        callback(resp);
+        return;
+    }
+
+    std::vector<RuleEngine::RuleDef> rules;
+    std::string error;
+    if (!rulesFromJson((*json)["rules"], rules, error) || !RuleEngine::instance().configure(rules, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+    callback(drogon::HttpResponse::newHttpJsonResponse(rulesToJson()));
+}
+
+} // namespace trdp
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+namespace trdp {
+
+class RuleController : public drogon::HttpController<RuleController> {
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(RuleController::getRules, "/api/rules", drogon::Get);
+    ADD_METHOD_TO(RuleController::setRules, "/api/rules", drogon::Post);
+    METHOD_LIST_END
+
+    void getRules(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    // Replaces the whole rule set; an empty "rules" array removes every rule.
+    void setRules(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+};
+
+} // namespace trdp
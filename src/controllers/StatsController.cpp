@@ -0,0 +1,74 @@
+#include "controllers/StatsController.h"
+
+#include "field_history.h"
+#include "history_store.h"
+#include "telegram_model.h"
+#include "trdp_engine.h"
+#include "workspace_manager.h"
+
+#include <drogon/drogon.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+namespace trdp {
+
+namespace {
+// Resident set size from /proc/self/status, in bytes; 0 when unavailable.
+std::uint64_t residentBytes() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024U;
+        }
+    }
+    return 0U;
+}
+
+Json::Value countAndBytes(std::size_t count, std::size_t bytes) {
+    Json::Value json;
+    json["count"] = static_cast<Json::UInt64>(count);
+    json["bytes"] = static_cast<Json::UInt64>(bytes);
+    return json;
+}
+} // namespace
+
+void StatsController::getMemory(const drogon::HttpRequestPtr &req,
+                                std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    const auto registry = workspace->registry().memoryUsage();
+    const auto engine = workspace->engine().memoryUsage();
+    const auto fieldHistory = FieldHistory::instance().status();
+    const auto historyStore = HistoryStore::instance().status();
+
+    Json::Value json;
+    json["workspace"] = workspace->name();
+    Json::Value definitions;
+    definitions["datasets"] = countAndBytes(registry.datasets, registry.datasetBytes);
+    definitions["telegrams"] = countAndBytes(registry.telegrams, registry.telegramBytes);
+    json["registry"] = definitions;
+    json["runtimes"] = countAndBytes(registry.runtimes, registry.runtimeBytes);
+    json["runtimes"]["bufferBytes"] = static_cast<Json::UInt64>(registry.bufferBytes);
+    json["endpoints"] = countAndBytes(engine.endpoints, engine.endpointBytes);
+    json["mdSessions"] = countAndBytes(engine.mdSessions, engine.mdSessionBytes);
+    Json::Value caches;
+    caches["dnr"] = countAndBytes(engine.cacheEntries, engine.cacheBytes);
+    // Process-wide, shared by every workspace.
+    caches["fieldHistoryBytes"] = static_cast<Json::UInt64>(fieldHistory.usedBytes);
+    caches["historyStoreQueueBytes"] = static_cast<Json::UInt64>(historyStore.queuedBytes);
+    json["caches"] = caches;
+    json["stackHeapBytes"] = static_cast<Json::UInt64>(engine.stackHeapBytes);
+    json["totalBytes"] = static_cast<Json::UInt64>(
+        registry.datasetBytes + registry.telegramBytes + registry.runtimeBytes + registry.bufferBytes +
+        engine.endpointBytes + engine.mdSessionBytes + engine.cacheBytes + engine.stackHeapBytes);
+    json["processResidentBytes"] = static_cast<Json::UInt64>(residentBytes());
+    callback(drogon::HttpResponse::newHttpJsonResponse(json));
+}
+
+} // namespace trdp
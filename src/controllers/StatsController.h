@@ -0,0 +1,16 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+namespace trdp {
+
+class StatsController : public drogon::HttpController<StatsController> {
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(StatsController::getMemory, "/api/stats/memory", drogon::Get);
+    METHOD_LIST_END
+
+    void getMemory(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+};
+
+} // namespace trdp
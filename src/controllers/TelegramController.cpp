@@ -3,6 +3,7 @@
 #include "plugins/TelegramHub.h"
 #include "telegram_model.h"
 #include "trdp_engine.h"
+#include "workspace_manager.h"
 
 #include <drogon/drogon.h>
 
@@ -147,7 +148,216 @@ MdMode parseMdMode(const Json::Value &json)
     return MdMode::Notify;
 }
 
-Json::Value telegramToJson(const TelegramDef &telegram, const std::shared_ptr<TelegramRuntime> &runtime) {
+const char *replySourceToString(ReplyFieldSource source)
+{
+    switch (source) {
+    case ReplyFieldSource::Template:
+        return "template";
+    case ReplyFieldSource::Echo:
+        return "echo";
+    case ReplyFieldSource::Counter:
+        return "counter";
+    case ReplyFieldSource::Crc16:
+        return "crc16";
+    }
+    return "template";
+}
+
+ReplyFieldSource parseReplySource(const std::string &source)
+{
+    if (source == "echo") {
+        return ReplyFieldSource::Echo;
+    }
+    if (source == "counter") {
+        return ReplyFieldSource::Counter;
+    }
+    if (source == "crc16") {
+        return ReplyFieldSource::Crc16;
+    }
+    return ReplyFieldSource::Template;
+}
+
+void applyReplierJson(const Json::Value &json, MdReplierDef &def)
+{
+    def.enabled = json.get("enabled", true).asBool();
+    if (json.isMember("replyComId")) {
+        def.replyComId = json["replyComId"].asUInt();
+    }
+    if (json.isMember("replyDataset")) {
+        def.replyDataset = json["replyDataset"].asString();
+    }
+    if (json.isMember("delayMs")) {
+        def.delay = std::chrono::milliseconds(json["delayMs"].asUInt64());
+    }
+    if (json.isMember("maxRepliesPerSecond")) {
+        def.maxRepliesPerSecond = json["maxRepliesPerSecond"].asUInt();
+    }
+    if (json.isMember("requireConfirm")) {
+        def.requireConfirm = json["requireConfirm"].asBool();
+    }
+    if (json.isMember("confirmTimeoutMs")) {
+        def.confirmTimeout = std::chrono::milliseconds(json["confirmTimeoutMs"].asUInt64());
+    }
+    if (json.isMember("userStatus")) {
+        def.userStatus = static_cast<std::uint16_t>(json["userStatus"].asUInt());
+    }
+    if (json.isMember("fields") && json["fields"].isArray()) {
+        def.fields.clear();
+        for (const auto &entry : json["fields"]) {
+            ReplyFieldRule rule;
+            rule.field = entry["field"].asString();
+            rule.source = parseReplySource(entry.get("source", "template").asString());
+            rule.requestField = entry.get("from", "").asString();
+            rule.crcStart = entry.get("start", 0U).asUInt64();
+            rule.crcLength = entry.get("length", 0U).asUInt64();
+            def.fields.push_back(rule);
+        }
+    }
+}
+
+Json::Value replierToJson(const TrdpEngine::MdReplierStats &stats)
+{
+    const auto &def = stats.config;
+    Json::Value json;
+    json["enabled"] = stats.enabled;
+    json["replyComId"] = stats.replyComId;
+    json["replyBytes"] = static_cast<Json::UInt64>(stats.replyBytes);
+    json["delayMs"] = static_cast<Json::UInt64>(def.delay.count());
+    json["maxRepliesPerSecond"] = def.maxRepliesPerSecond;
+    json["requireConfirm"] = def.requireConfirm;
+    json["confirmTimeoutMs"] = static_cast<Json::UInt64>(def.confirmTimeout.count());
+    json["userStatus"] = def.userStatus;
+    Json::Value fields(Json::arrayValue);
+    for (const auto &rule : def.fields) {
+        Json::Value f;
+        f["field"] = rule.field;
+        f["source"] = replySourceToString(rule.source);
+        if (!rule.requestField.empty()) {
+            f["from"] = rule.requestField;
+        }
+        if (rule.source == ReplyFieldSource::Crc16) {
+            f["start"] = static_cast<Json::UInt64>(rule.crcStart);
+            f["length"] = static_cast<Json::UInt64>(rule.crcLength);
+        }
+        fields.append(f);
+    }
+    json["fields"] = fields;
+    Json::Value counters;
+    counters["requests"] = static_cast<Json::UInt64>(stats.requests);
+    counters["replies"] = static_cast<Json::UInt64>(stats.replies);
+    counters["throttled"] = static_cast<Json::UInt64>(stats.throttled);
+    counters["failed"] = static_cast<Json::UInt64>(stats.failed);
+    counters["confirms"] = static_cast<Json::UInt64>(stats.confirms);
+    counters["confirmTimeouts"] = static_cast<Json::UInt64>(stats.confirmTimeouts);
+    counters["pending"] = static_cast<Json::UInt64>(stats.pending);
+    json["stats"] = counters;
+    return json;
+}
+
+bool applyGeneratorsJson(const Json::Value &json, std::vector<FieldGeneratorDef> &defs, std::string &error)
+{
+    for (const auto &entry : json) {
+        FieldGeneratorDef def;
+        def.field = entry["field"].asString();
+        const auto kind = parseFieldGeneratorKind(entry.get("kind", "counter").asString());
+        if (!kind) {
+            error = "Invalid 'kind' for field '" + def.field +
+                    "'; expected counter, ramp, sine, square, sawtooth, randomwalk or prbs";
+            return false;
+        }
+        def.kind = *kind;
+        def.min = entry.get("min", def.min).asDouble();
+        def.max = entry.get("max", def.max).asDouble();
+        def.step = entry.get("step", def.step).asDouble();
+        def.period = std::chrono::milliseconds(entry.get("periodMs", 1000U).asUInt64());
+        def.order = entry.get("order", def.order).asUInt();
+        def.seed = entry.get("seed", def.seed).asUInt();
+        defs.push_back(def);
+    }
+    return true;
+}
+
+Json::Value generatorsToJson(const TrdpEngine::TxGeneratorStats &stats)
+{
+    Json::Value json;
+    json["active"] = stats.active;
+    json["cycles"] = static_cast<Json::UInt64>(stats.cycles);
+    Json::Value generators(Json::arrayValue);
+    for (const auto &def : stats.config) {
+        Json::Value g;
+        g["field"] = def.field;
+        g["kind"] = fieldGeneratorKindToString(def.kind);
+        if (def.kind == FieldGeneratorKind::Prbs) {
+            g["order"] = def.order;
+        } else {
+            g["min"] = def.min;
+            g["max"] = def.max;
+            g["step"] = def.step;
+            g["periodMs"] = static_cast<Json::UInt64>(def.period.count());
+        }
+        g["seed"] = def.seed;
+        generators.append(g);
+    }
+    json["generators"] = generators;
+    return json;
+}
+
+bool applySdtJson(const Json::Value &json, SdtDef &def, std::string &error)
+{
+    def.enabled = json.get("enabled", true).asBool();
+    def.smi = json.get("smi", def.smi).asUInt();
+    def.userDataVersion = static_cast<std::uint16_t>(json.get("udv", def.userDataVersion).asUInt());
+    def.safeTopoCount = json.get("safeTopoCount", def.safeTopoCount).asUInt();
+    if (json.isMember("consistId")) {
+        const auto consistId = parseConsistId(json["consistId"].asString());
+        if (!consistId) {
+            error = "Invalid 'consistId'; expected 32 hex digits";
+            return false;
+        }
+        def.consistId = *consistId;
+    }
+    def.txPeriod = std::chrono::milliseconds(json.get("txPeriodMs", static_cast<Json::UInt64>(def.txPeriod.count())).asUInt64());
+    def.rxPeriod = std::chrono::milliseconds(json.get("rxPeriodMs", static_cast<Json::UInt64>(def.rxPeriod.count())).asUInt64());
+    def.nRxSafe = json.get("nRxSafe", def.nRxSafe).asUInt();
+    def.lmiMax = json.get("lmiMax", def.lmiMax).asUInt();
+    return true;
+}
+
+Json::Value sdtToJson(const SdtChannel::Stats &stats)
+{
+    Json::Value json;
+    const auto &def = stats.config;
+    json["enabled"] = def.enabled;
+    json["smi"] = def.smi;
+    json["udv"] = def.userDataVersion;
+    json["consistId"] = consistIdToString(def.consistId);
+    json["safeTopoCount"] = def.safeTopoCount;
+    json["txPeriodMs"] = static_cast<Json::UInt64>(def.txPeriod.count());
+    json["rxPeriodMs"] = static_cast<Json::UInt64>(def.rxPeriod.count());
+    json["nRxSafe"] = def.nRxSafe;
+    json["lmiMax"] = def.lmiMax;
+    if (!def.enabled) {
+        return json;
+    }
+    json["sid"] = stats.sid;
+    json["valid"] = stats.valid;
+    json["ssc"] = stats.ssc;
+    Json::Value counters;
+    counters["sealed"] = static_cast<Json::UInt64>(stats.sealed);
+    counters["received"] = static_cast<Json::UInt64>(stats.received);
+    counters["accepted"] = static_cast<Json::UInt64>(stats.accepted);
+    counters["scErrors"] = static_cast<Json::UInt64>(stats.scErrors);
+    counters["udvErrors"] = static_cast<Json::UInt64>(stats.udvErrors);
+    counters["oldSsc"] = static_cast<Json::UInt64>(stats.oldSsc);
+    counters["lostSsc"] = static_cast<Json::UInt64>(stats.lostSsc);
+    counters["latencyErrors"] = static_cast<Json::UInt64>(stats.latencyErrors);
+    counters["freshnessErrors"] = static_cast<Json::UInt64>(stats.freshnessErrors);
+    json["stats"] = counters;
+    return json;
+}
+
+Json::Value telegramToJson(TrdpEngine &engine, const TelegramDef &telegram,
+                           const std::shared_ptr<TelegramRuntime> &runtime) {
     Json::Value json;
     json["comId"] = telegram.comId;
     json["name"] = telegram.name;
@@ -158,7 +368,22 @@ Json::Value telegramToJson(const TelegramDef &telegram, const std::shared_ptr<Te
     json["replyTimeoutMs"] = static_cast<Json::UInt64>(telegram.replyTimeout.count());
     json["confirmTimeoutMs"] = static_cast<Json::UInt64>(telegram.confirmTimeout.count());
     if (telegram.direction == Direction::Tx && telegram.type == TelegramType::PD) {
-        json["txActive"] = TrdpEngine::instance().txPublishActive(telegram.comId).value_or(false);
+        json["txActive"] = engine.txPublishActive(telegram.comId).value_or(false);
+    }
+    if (const auto checksums = engine.checksumStats(telegram.comId)) {
+        Json::Value block;
+        block["checked"] = static_cast<Json::UInt64>(checksums->checked);
+        block["mismatches"] = static_cast<Json::UInt64>(checksums->mismatches);
+        block["fields"] = Json::Value(Json::arrayValue);
+        for (const auto &field : checksums->fields) {
+            Json::Value entry;
+            entry["field"] = field.field;
+            entry["algorithm"] = checksumKindToString(field.kind);
+            entry["start"] = static_cast<Json::UInt64>(field.start);
+            entry["length"] = static_cast<Json::UInt64>(field.length);
+            block["fields"].append(entry);
+        }
+        json["checksums"] = block;
     }
     if (runtime) {
         json["fields"] = fieldsToJson(runtime->snapshotFields());
@@ -167,9 +392,16 @@ Json::Value telegramToJson(const TelegramDef &telegram, const std::shared_ptr<Te
 }
 } // namespace
 
-void TelegramController::getTelegram(const drogon::HttpRequestPtr &,
+void TelegramController::getTelegram(const drogon::HttpRequestPtr &req,
                                      std::function<void(const drogon::HttpResponsePtr &)> &&callback, std::uint32_t comId) {
-    if (!ensureRegistryInitialized()) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    auto &registry = workspace->registry();
+    if (!workspace->registryReady()) {
         auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
         resp->setStatusCode(drogon::k500InternalServerError);
         (*resp->getJsonObject())["error"] = "TRDP registry is not initialised";
@@ -177,19 +409,26 @@ void TelegramController::getTelegram(const drogon::HttpRequestPtr &,
         return;
     }
 
-    const auto telegram = TelegramRegistry::instance().getTelegramCopy(comId);
-    if (!telegram.has_value()) {
+    const auto contents = registry.snapshot();
+    const auto *telegram = contents->findTelegram(comId);
+    if (telegram == nullptr) {
         callback(drogon::HttpResponse::newNotFoundResponse());
         return;
     }
-    const auto runtime = TelegramRegistry::instance().getOrCreateRuntime(comId);
-    callback(drogon::HttpResponse::newHttpJsonResponse(telegramToJson(*telegram, runtime)));
+    const auto runtime = registry.getOrCreateRuntime(comId);
+    callback(drogon::HttpResponse::newHttpJsonResponse(telegramToJson(engine, *telegram, runtime)));
 }
 
 void TelegramController::updateFields(const drogon::HttpRequestPtr &req,
                                       std::function<void(const drogon::HttpResponsePtr &)> &&callback,
                                       std::uint32_t comId) {
-    if (!ensureRegistryInitialized()) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &registry = workspace->registry();
+    if (!workspace->registryReady()) {
         auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
         resp->setStatusCode(drogon::k500InternalServerError);
         (*resp->getJsonObject())["error"] = "TRDP registry is not initialised";
@@ -197,14 +436,15 @@ void TelegramController::updateFields(const drogon::HttpRequestPtr &req,
         return;
     }
 
-    const auto telegram = TelegramRegistry::instance().getTelegramCopy(comId);
-    if (!telegram.has_value()) {
+    const auto contents = registry.snapshot();
+    const auto *telegram = contents->findTelegram(comId);
+    if (telegram == nullptr) {
         callback(drogon::HttpResponse::newNotFoundResponse());
         return;
     }
 
-    const auto dataset = TelegramRegistry::instance().getDatasetCopy(telegram->datasetName);
-    if (!dataset.has_value()) {
+    const auto *dataset = contents->findDataset(telegram->datasetName);
+    if (dataset == nullptr) {
         callback(drogon::HttpResponse::newNotFoundResponse());
         return;
     }
@@ -215,7 +455,7 @@ void TelegramController::updateFields(const drogon::HttpRequestPtr &req,
         return;
     }
 
-    auto runtime = TelegramRegistry::instance().getOrCreateRuntime(comId);
+    auto runtime = registry.getOrCreateRuntime(comId);
     if (!runtime) {
         callback(drogon::HttpResponse::newHttpResponse());
         return;
@@ -240,7 +480,7 @@ void TelegramController::updateFields(const drogon::HttpRequestPtr &req,
         runtime->setFieldValue(memberName, parsed.value());
     }
 
-    runtime->overwriteBuffer(encodeFieldsToBuffer(*runtime, runtime->snapshotFields()));
+    runtime->overwriteBuffer(workspace->engine().encodeTxBuffer(comId, *runtime, runtime->snapshotFields()));
 
     callback(drogon::HttpResponse::newHttpJsonResponse(fieldsToJson(runtime->snapshotFields())));
 }
@@ -248,7 +488,14 @@ void TelegramController::updateFields(const drogon::HttpRequestPtr &req,
 void TelegramController::sendTelegram(const drogon::HttpRequestPtr &req,
                                       std::function<void(const drogon::HttpResponsePtr &)> &&callback,
                                       std::uint32_t comId) {
-    if (!ensureRegistryInitialized()) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    auto &registry = workspace->registry();
+    if (!workspace->registryReady()) {
         auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
         resp->setStatusCode(drogon::k500InternalServerError);
         (*resp->getJsonObject())["error"] = "TRDP registry is not initialised";
@@ -256,14 +503,15 @@ void TelegramController::sendTelegram(const drogon::HttpRequestPtr &req,
         return;
     }
 
-    const auto telegram = TelegramRegistry::instance().getTelegramCopy(comId);
-    if (!telegram.has_value()) {
+    const auto contents = registry.snapshot();
+    const auto *telegram = contents->findTelegram(comId);
+    if (telegram == nullptr) {
         callback(drogon::HttpResponse::newNotFoundResponse());
         return;
     }
 
-    const auto dataset = TelegramRegistry::instance().getDatasetCopy(telegram->datasetName);
-    if (!dataset.has_value()) {
+    const auto *dataset = contents->findDataset(telegram->datasetName);
+    if (dataset == nullptr) {
         callback(drogon::HttpResponse::newNotFoundResponse());
         return;
     }
@@ -331,11 +579,11 @@ void TelegramController::sendTelegram(const drogon::HttpRequestPtr &req,
         }
     }
 
-    const bool success = TrdpEngine::instance().sendTxTelegram(comId, overrides, mdOptions);
+    const bool success = engine.sendTxTelegram(comId, overrides, mdOptions);
     auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
     (*resp->getJsonObject())["ok"] = success;
     if (telegram->direction == Direction::Tx && telegram->type == TelegramType::PD) {
-        (*resp->getJsonObject())["txActive"] = TrdpEngine::instance().txPublishActive(comId).value_or(false);
+        (*resp->getJsonObject())["txActive"] = engine.txPublishActive(comId).value_or(false);
     }
     if (!success) {
         resp->setStatusCode(drogon::k500InternalServerError);
@@ -343,10 +591,17 @@ void TelegramController::sendTelegram(const drogon::HttpRequestPtr &req,
     callback(resp);
 }
 
-void TelegramController::stopTelegram(const drogon::HttpRequestPtr &,
+void TelegramController::stopTelegram(const drogon::HttpRequestPtr &req,
                                       std::function<void(const drogon::HttpResponsePtr &)> &&callback,
                                       std::uint32_t comId) {
-    if (!ensureRegistryInitialized()) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    auto &registry = workspace->registry();
+    if (!workspace->registryReady()) {
         auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
         resp->setStatusCode(drogon::k500InternalServerError);
         (*resp->getJsonObject())["error"] = "TRDP registry is not initialised";
@@ -354,8 +609,9 @@ void TelegramController::stopTelegram(const drogon::HttpRequestPtr &,
         return;
     }
 
-    const auto telegram = TelegramRegistry::instance().getTelegramCopy(comId);
-    if (!telegram.has_value()) {
+    const auto contents = registry.snapshot();
+    const auto *telegram = contents->findTelegram(comId);
+    if (telegram == nullptr) {
         callback(drogon::HttpResponse::newNotFoundResponse());
         return;
     }
@@ -369,10 +625,10 @@ void TelegramController::stopTelegram(const drogon::HttpRequestPtr &,
         return;
     }
 
-    const bool success = TrdpEngine::instance().stopTxTelegram(comId);
+    const bool success = engine.stopTxTelegram(comId);
     (*resp->getJsonObject())["ok"] = success;
     if (telegram->direction == Direction::Tx && telegram->type == TelegramType::PD) {
-        (*resp->getJsonObject())["txActive"] = TrdpEngine::instance().txPublishActive(comId).value_or(false);
+        (*resp->getJsonObject())["txActive"] = engine.txPublishActive(comId).value_or(false);
     }
     if (!success) {
         resp->setStatusCode(drogon::k400BadRequest);
@@ -383,6 +639,12 @@ void TelegramController::stopTelegram(const drogon::HttpRequestPtr &,
 void TelegramController::simulateMd(const drogon::HttpRequestPtr &req,
                                     std::function<void(const drogon::HttpResponsePtr &)> &&callback,
                                     std::uint32_t comId) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
     const auto json = req->getJsonObject();
     if (!json) {
         callback(drogon::HttpResponse::newHttpResponse());
@@ -396,9 +658,180 @@ void TelegramController::simulateMd(const drogon::HttpRequestPtr &req,
             payload.push_back(static_cast<std::uint8_t>(b.asUInt()));
         }
     }
-    TrdpEngine::instance().simulateMdEvent(comId, sessionId, event, payload);
+    engine.simulateMdEvent(comId, sessionId, event, payload);
     callback(drogon::HttpResponse::newHttpJsonResponse(Json::Value()));
 }
 
-} // namespace trdp
+void TelegramController::getMdReplier(const drogon::HttpRequestPtr &req,
+                                      std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                                      std::uint32_t comId) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    const auto stats = engine.mdReplierStats(comId);
+    if (!stats.has_value()) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    callback(drogon::HttpResponse::newHttpJsonResponse(replierToJson(*stats)));
+}
 
+void TelegramController::configureMdReplier(const drogon::HttpRequestPtr &req,
+                                            std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                                            std::uint32_t comId) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    const auto current = engine.mdReplierStats(comId);
+    if (!current.has_value()) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    const auto json = req->getJsonObject();
+    if (!json) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = "Expected a JSON body";
+        callback(resp);
+        return;
+    }
+
+    MdReplierDef def = current->config;
+    applyReplierJson(*json, def);
+    std::string error;
+    if (!engine.configureMdReplier(comId, def, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["ok"] = false;
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    const auto stats = engine.mdReplierStats(comId);
+    auto body = replierToJson(stats.value_or(TrdpEngine::MdReplierStats{}));
+    body["ok"] = true;
+    callback(drogon::HttpResponse::newHttpJsonResponse(body));
+}
+
+void TelegramController::getGenerators(const drogon::HttpRequestPtr &req,
+                                       std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                                       std::uint32_t comId) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    const auto stats = engine.txGeneratorStats(comId);
+    if (!stats.has_value()) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    callback(drogon::HttpResponse::newHttpJsonResponse(generatorsToJson(*stats)));
+}
+
+void TelegramController::configureGenerators(const drogon::HttpRequestPtr &req,
+                                             std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                                             std::uint32_t comId) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    if (!engine.txGeneratorStats(comId).has_value()) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    const auto json = req->getJsonObject();
+    if (!json || !(*json)["generators"].isArray()) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = "Missing 'generators' array";
+        callback(resp);
+        return;
+    }
+
+    std::vector<FieldGeneratorDef> defs;
+    std::string error;
+    if (!applyGeneratorsJson((*json)["generators"], defs, error) ||
+        !engine.configureTxGenerators(comId, defs, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["ok"] = false;
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    const auto stats = engine.txGeneratorStats(comId);
+    auto body = generatorsToJson(stats.value_or(TrdpEngine::TxGeneratorStats{}));
+    body["ok"] = true;
+    callback(drogon::HttpResponse::newHttpJsonResponse(body));
+}
+
+void TelegramController::getSdt(const drogon::HttpRequestPtr &req,
+                                std::function<void(const drogon::HttpResponsePtr &)> &&callback, std::uint32_t comId) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    const auto stats = engine.sdtStats(comId);
+    if (!stats.has_value()) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    callback(drogon::HttpResponse::newHttpJsonResponse(sdtToJson(*stats)));
+}
+
+void TelegramController::configureSdt(const drogon::HttpRequestPtr &req,
+                                      std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                                      std::uint32_t comId) {
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto &engine = workspace->engine();
+    const auto current = engine.sdtStats(comId);
+    if (!current.has_value()) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    const auto json = req->getJsonObject();
+    if (!json) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = "Missing JSON body";
+        callback(resp);
+        return;
+    }
+
+    // Start from the current parameters so a body can change a single value.
+    auto def = current->config;
+    std::string error;
+    if (!applySdtJson(*json, def, error) || !engine.configureSdt(comId, def, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["ok"] = false;
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    const auto stats = engine.sdtStats(comId);
+    auto body = sdtToJson(stats.value_or(SdtChannel::Stats{}));
+    body["ok"] = true;
+    callback(drogon::HttpResponse::newHttpJsonResponse(body));
+}
+
+} // namespace trdp
@@ -12,6 +12,12 @@ class TelegramController : public drogon::HttpController<TelegramController> {
     ADD_METHOD_TO(TelegramController::sendTelegram, "/api/telegrams/{1}/send", drogon::Post);
     ADD_METHOD_TO(TelegramController::stopTelegram, "/api/telegrams/{1}/stop", drogon::Post);
     ADD_METHOD_TO(TelegramController::simulateMd, "/api/telegrams/{1}/md/simulate", drogon::Post);
+    ADD_METHOD_TO(TelegramController::getMdReplier, "/api/telegrams/{1}/md/replier", drogon::Get);
+    ADD_METHOD_TO(TelegramController::configureMdReplier, "/api/telegrams/{1}/md/replier", drogon::Post);
+    ADD_METHOD_TO(TelegramController::getGenerators, "/api/telegrams/{1}/generators", drogon::Get);
+    ADD_METHOD_TO(TelegramController::configureGenerators, "/api/telegrams/{1}/generators", drogon::Post);
+    ADD_METHOD_TO(TelegramController::getSdt, "/api/telegrams/{1}/sdt", drogon::Get);
+    ADD_METHOD_TO(TelegramController::configureSdt, "/api/telegrams/{1}/sdt", drogon::Post);
     METHOD_LIST_END
 
     void getTelegram(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback,
@@ -28,6 +34,25 @@ class TelegramController : public drogon::HttpController<TelegramController> {
 
     void simulateMd(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback,
                     std::uint32_t comId);
+
+    void getMdReplier(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                      std::uint32_t comId);
+
+    void configureMdReplier(const drogon::HttpRequestPtr &req,
+                            std::function<void(const drogon::HttpResponsePtr &)> &&callback, std::uint32_t comId);
+
+    void getGenerators(const drogon::HttpRequestPtr &req,
+                       std::function<void(const drogon::HttpResponsePtr &)> &&callback, std::uint32_t comId);
+
+    // Replaces every generator of the telegram; an empty "generators" array removes them.
+    void configureGenerators(const drogon::HttpRequestPtr &req,
+                             std::function<void(const drogon::HttpResponsePtr &)> &&callback, std::uint32_t comId);
+
+    void getSdt(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                std::uint32_t comId);
+
+    void configureSdt(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                      std::uint32_t comId);
 };
 
 } // namespace trdp
@@ -0,0 +1,111 @@
+#include "controllers/VerifyController.h"
+
+#include "payload_verifier.h"
+
+#include <drogon/drogon.h>
+
+namespace trdp {
+
+namespace {
+// Fill config from the request body; unknown keys are ignored, invalid values reported through error.
+bool applyVerifyJson(const Json::Value &json, PayloadVerifier::Config &config, std::string &error) {
+    if (json.isMember("comIds")) {
+        const auto &comIds = json["comIds"];
+        if (!comIds.isArray()) {
+            error = "Invalid 'comIds'; expected a list of ComIds";
+            return false;
+        }
+        for (const auto &comId : comIds) {
+            if (!comId.isUInt() || comId.asUInt() == 0U) {
+                error = "Invalid 'comIds'; expected a list of ComIds";
+                return false;
+            }
+            config.comIds.push_back(comId.asUInt());
+        }
+    }
+    if (json.isMember("sequenceOffset")) {
+        config.sequenceOffset = json["sequenceOffset"].asUInt();
+    }
+    if (json.isMember("payloadOffset")) {
+        config.payloadOffset = json["payloadOffset"].asUInt();
+    }
+    if (json.isMember("prbsOrder")) {
+        config.prbsOrder = json["prbsOrder"].asUInt();
+    }
+    if (json.isMember("crc")) {
+        config.crc = json["crc"].asBool();
+    }
+    return true;
+}
+
+Json::Value countersToJson(const PayloadVerifier::Counters &counters) {
+    Json::Value json;
+    json["received"] = static_cast<Json::UInt64>(counters.received);
+    json["lost"] = static_cast<Json::UInt64>(counters.lost);
+    json["duplicated"] = static_cast<Json::UInt64>(counters.duplicated);
+    json["reordered"] = static_cast<Json::UInt64>(counters.reordered);
+    json["corrupted"] = static_cast<Json::UInt64>(counters.corrupted);
+    json["crcErrors"] = static_cast<Json::UInt64>(counters.crcErrors);
+    json["prbsErrors"] = static_cast<Json::UInt64>(counters.prbsErrors);
+    json["truncated"] = static_cast<Json::UInt64>(counters.truncated);
+    json["resyncs"] = static_cast<Json::UInt64>(counters.resyncs);
+    return json;
+}
+
+Json::Value statusToJson(const PayloadVerifier::Status &status) {
+    Json::Value json;
+    json["running"] = status.running;
+    json["elapsedSeconds"] = status.elapsedSeconds;
+    json["total"] = countersToJson(status.total);
+    json["telegrams"] = Json::Value(Json::arrayValue);
+    for (const auto &counters : status.telegrams) {
+        auto entry = countersToJson(counters);
+        entry["comId"] = counters.comId;
+        entry["lastSequence"] = counters.lastSequence;
+        json["telegrams"].append(entry);
+    }
+
+    const auto &config = status.config;
+    Json::Value cfg;
+    cfg["comIds"] = Json::Value(Json::arrayValue);
+    for (const auto comId : config.comIds) {
+        cfg["comIds"].append(comId);
+    }
+    cfg["sequenceOffset"] = static_cast<Json::UInt64>(config.sequenceOffset);
+    cfg["payloadOffset"] = static_cast<Json::UInt64>(config.payloadOffset);
+    cfg["prbsOrder"] = config.prbsOrder;
+    cfg["crc"] = config.crc;
+    json["config"] = cfg;
+    return json;
+}
+} // namespace
+
+void VerifyController::startVerifier(const drogon::HttpRequestPtr &req,
+                                     std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    PayloadVerifier::Config config{};
+    std::string error;
+    const auto json = req->getJsonObject();
+    if ((json && !applyVerifyJson(*json, config, error)) || !PayloadVerifier::instance().start(config, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(PayloadVerifier::instance().status())));
+}
+
+void VerifyController::stopVerifier(const drogon::HttpRequestPtr &,
+                                    std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto &verifier = PayloadVerifier::instance();
+    verifier.stop();
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(verifier.status())));
+}
+
+void VerifyController::getStatus(const drogon::HttpRequestPtr &,
+                                 std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    callback(drogon::HttpResponse::newHttpJsonResponse(statusToJson(PayloadVerifier::instance().status())));
+}
+
+} // namespace trdp
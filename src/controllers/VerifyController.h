@@ -0,0 +1,22 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+namespace trdp {
+
+class VerifyController : public drogon::HttpController<VerifyController> {
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(VerifyController::startVerifier, "/api/verify/start", drogon::Post);
+    ADD_METHOD_TO(VerifyController::stopVerifier, "/api/verify/stop", drogon::Post);
+    ADD_METHOD_TO(VerifyController::getStatus, "/api/verify/status", drogon::Get);
+    METHOD_LIST_END
+
+    void startVerifier(const drogon::HttpRequestPtr &req,
+                       std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void stopVerifier(const drogon::HttpRequestPtr &req,
+                      std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void getStatus(const drogon::HttpRequestPtr &req, std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+};
+
+} // namespace trdp
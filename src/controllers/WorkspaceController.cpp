@@ -0,0 +1,95 @@
+#include "controllers/WorkspaceController.h"
+
+#include "workspace_manager.h"
+
+#include <drogon/drogon.h>
+
+namespace trdp {
+
+namespace {
+Json::Value workspaceToJson(const Workspace &workspace) {
+    auto &engine = workspace.engine();
+    const auto config = engine.activeConfig();
+    const auto transport = engine.transportStatus();
+    Json::Value json;
+    json["name"] = workspace.name();
+    json["default"] = workspace.isDefault();
+    json["xml"] = workspace.xmlPath();
+    json["running"] = engine.isRunning();
+    json["telegrams"] = static_cast<Json::UInt64>(workspace.registry().snapshot()->telegrams.size());
+    json["backend"] = transport.backend;
+    json["hostIp"] = config.hostIp;
+    json["rxInterface"] = config.rxInterface;
+    json["txInterface"] = config.txInterface;
+    json["virtualTime"] = transport.virtualTime;
+    json["ports"] = Json::Value(Json::arrayValue);
+    for (const auto port : transport.ports) {
+        json["ports"].append(port);
+    }
+    return json;
+}
+} // namespace
+
+void WorkspaceController::listWorkspaces(const drogon::HttpRequestPtr &,
+                                         std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    Json::Value json(Json::arrayValue);
+    for (const auto &workspace : WorkspaceManager::instance().list()) {
+        json.append(workspaceToJson(*workspace));
+    }
+    callback(drogon::HttpResponse::newHttpJsonResponse(json));
+}
+
+void WorkspaceController::createWorkspace(const drogon::HttpRequestPtr &req,
+                                          std::function<void(const drogon::HttpResponsePtr &)> &&callback) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    const auto json = req->getJsonObject();
+    if (!json) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = "Missing JSON body";
+        callback(resp);
+        return;
+    }
+
+    WorkspaceManager::Config config{};
+    config.name = (*json)["name"].asString();
+    config.xmlPath = (*json)["xml"].asString();
+    config.trdp.transport = TrdpEngine::Transport::Native;
+    config.trdp.hostIp = (*json)["hostIp"].asString();
+    config.trdp.rxInterface = (*json)["rxInterface"].asString();
+    config.trdp.txInterface = (*json)["txInterface"].asString();
+    config.trdp.virtualTime = (*json)["virtualTime"].asBool();
+    if (json->isMember("idleIntervalMs")) {
+        config.trdp.idleInterval = std::chrono::milliseconds((*json)["idleIntervalMs"].asUInt());
+    }
+
+    std::string error;
+    const auto workspace = WorkspaceManager::instance().create(config, error);
+    if (!workspace) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+    callback(drogon::HttpResponse::newHttpJsonResponse(workspaceToJson(*workspace)));
+}
+
+void WorkspaceController::removeWorkspace(const drogon::HttpRequestPtr &,
+                                          std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                                          const std::string &name) {
+    if (name != WorkspaceManager::kDefaultName && !WorkspaceManager::instance().find(name)) {
+        callback(drogon::HttpResponse::newNotFoundResponse());
+        return;
+    }
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value());
+    std::string error;
+    if (!WorkspaceManager::instance().remove(name, error)) {
+        resp->setStatusCode(drogon::k400BadRequest);
+        (*resp->getJsonObject())["error"] = error;
+        callback(resp);
+        return;
+    }
+    (*resp->getJsonObject())["ok"] = true;
+    callback(resp);
+}
+
+} // namespace trdp
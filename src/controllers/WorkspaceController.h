@@ -0,0 +1,24 @@
+#pragma once
+
+#include <drogon/HttpController.h>
+
+namespace trdp {
+
+class WorkspaceController : public drogon::HttpController<WorkspaceController> {
+  public:
+    METHOD_LIST_BEGIN
+    ADD_METHOD_TO(WorkspaceController::listWorkspaces, "/api/workspaces", drogon::Get);
+    ADD_METHOD_TO(WorkspaceController::createWorkspace, "/api/workspaces", drogon::Post);
+    ADD_METHOD_TO(WorkspaceController::removeWorkspace, "/api/workspaces/{1}", drogon::Delete);
+    METHOD_LIST_END
+
+    void listWorkspaces(const drogon::HttpRequestPtr &req,
+                        std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    // Body: {"name", "xml", "hostIp", "rxInterface", "txInterface", "virtualTime", "idleIntervalMs"}.
+    void createWorkspace(const drogon::HttpRequestPtr &req,
+                         std::function<void(const drogon::HttpResponsePtr &)> &&callback);
+    void removeWorkspace(const drogon::HttpRequestPtr &req,
+                         std::function<void(const drogon::HttpResponsePtr &)> &&callback, const std::string &name);
+};
+
+} // namespace trdp
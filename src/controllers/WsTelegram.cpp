@@ -1,19 +1,32 @@
 #include "controllers/WsTelegram.h"
 
 #include "plugins/TelegramHub.h"
+#include "workspace_manager.h"
 
 namespace trdp {
 
-void WsTelegram::handleNewConnection(const drogon::HttpRequestPtr &, const drogon::WebSocketConnectionPtr &conn) {
-    if (auto *hub = TelegramHub::instance()) {
+void WsTelegram::handleNewConnection(const drogon::HttpRequestPtr &req, const drogon::WebSocketConnectionPtr &conn) {
+    // "/ws/telegrams?workspace=<name>" follows one workspace; the default workspace otherwise.
+    const auto workspace = WorkspaceManager::instance().resolve(req);
+    if (!workspace) {
+        conn->forceClose();
+        return;
+    }
+    conn->setContext(workspace);
+    if (auto *hub = workspace->hub()) {
         hub->subscribe(conn);
     }
 }
 
 void WsTelegram::handleConnectionClosed(const drogon::WebSocketConnectionPtr &conn) {
-    if (auto *hub = TelegramHub::instance()) {
+    const auto workspace = conn->getContext<Workspace>();
+    if (!workspace) {
+        return;
+    }
+    if (auto *hub = workspace->hub()) {
         hub->unsubscribe(conn);
     }
+    conn->clearContext();
 }
 
 void WsTelegram::handleNewMessage(const drogon::WebSocketConnectionPtr &conn, std::string &&message,
@@ -25,4 +38,3 @@ void WsTelegram::handleNewMessage(const drogon::WebSocketConnectionPtr &conn, st
 }
 
 } // namespace trdp
-
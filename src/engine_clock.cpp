@@ -0,0 +1,67 @@
+#include "engine_clock.h"
+
+namespace trdp {
+
+namespace {
+std::int64_t realNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct WallAnchor {
+    std::int64_t steadyNs;
+    std::int64_t wallNs;
+};
+
+const WallAnchor &wallAnchor() {
+    static const WallAnchor anchor{
+        realNs(), std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count()};
+    return anchor;
+}
+} // namespace
+
+EngineClock::time_point EngineClock::now() const noexcept {
+    if (!virtualMode.load(std::memory_order_acquire)) {
+        return std::chrono::steady_clock::now();
+    }
+    return time_point(std::chrono::duration_cast<time_point::duration>(
+        std::chrono::nanoseconds(virtualNs.load(std::memory_order_acquire))));
+}
+
+void EngineClock::setVirtual(bool enabled) {
+    const auto start = realNs();
+    virtualNs.store(start, std::memory_order_release);
+    startNs.store(start, std::memory_order_relaxed);
+    realStartNs.store(start, std::memory_order_relaxed);
+    virtualMode.store(enabled, std::memory_order_release);
+}
+
+void EngineClock::advanceTo(time_point target) noexcept {
+    if (!virtualMode.load(std::memory_order_acquire)) {
+        return;
+    }
+    const auto targetNs = std::chrono::duration_cast<std::chrono::nanoseconds>(target.time_since_epoch()).count();
+    auto current = virtualNs.load(std::memory_order_relaxed);
+    while (targetNs > current &&
+           !virtualNs.compare_exchange_weak(current, targetNs, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+std::int64_t EngineClock::wallNs(time_point t) const noexcept {
+    const auto &anchor = wallAnchor();
+    return anchor.wallNs +
+           (std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count() - anchor.steadyNs);
+}
+
+std::chrono::nanoseconds EngineClock::elapsed() const noexcept {
+    const auto current = std::chrono::duration_cast<std::chrono::nanoseconds>(now().time_since_epoch()).count();
+    return std::chrono::nanoseconds(current - startNs.load(std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds EngineClock::realElapsed() const noexcept {
+    return std::chrono::nanoseconds(realNs() - realStartNs.load(std::memory_order_relaxed));
+}
+
+} // namespace trdp
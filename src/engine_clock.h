@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace trdp {
+
+/**
+ * Time source of the TRDP engine: cyclic schedules, MD deadlines, delayed replies and ECSP polling all read now()
+ * from here instead of steady_clock.
+ *
+ * In real mode now() is steady_clock::now(). In virtual mode time only moves when the processing loop calls
+ * advanceTo() with its next deadline, so a long scenario runs as fast as the loop can process it and every timer
+ * fires at exactly the instant it was scheduled for. Virtual time starts at the real time it was enabled, so
+ * time points taken before and after switching stay comparable.
+ */
+class EngineClock {
+  public:
+    using time_point = std::chrono::steady_clock::time_point;
+
+    [[nodiscard]] time_point now() const noexcept;
+    [[nodiscard]] bool isVirtual() const noexcept { return virtualMode.load(std::memory_order_relaxed); }
+
+    void setVirtual(bool enabled);
+    // Virtual mode only: move time forward to target; earlier targets are ignored.
+    void advanceTo(time_point target) noexcept;
+
+    // Nanoseconds since the epoch for t: the system clock read once per process, advanced by this clock. History
+    // rows and captured packets carry it, so they follow virtual time and never step back with the system clock.
+    [[nodiscard]] std::int64_t wallNs(time_point t) const noexcept;
+    [[nodiscard]] std::int64_t wallNowNs() const noexcept { return wallNs(now()); }
+
+    // Time elapsed on this clock and in real time since setVirtual() was last called.
+    [[nodiscard]] std::chrono::nanoseconds elapsed() const noexcept;
+    [[nodiscard]] std::chrono::nanoseconds realElapsed() const noexcept;
+
+  private:
+    std::atomic<bool> virtualMode{false};
+    std::atomic<std::int64_t> virtualNs{0};
+    std::atomic<std::int64_t> startNs{0};
+    std::atomic<std::int64_t> realStartNs{0};
+};
+
+} // namespace trdp
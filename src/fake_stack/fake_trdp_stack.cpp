@@ -0,0 +1,972 @@
+#include "fake_stack/fake_trdp_stack.h"
+
+#include <trdp/api/iec61375-2-3.h>
+#include <trdp/api/trdp_if_light.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Virtual time in nanoseconds since the last reset.
+using VirtualTime = std::uint64_t;
+using SessionKey = std::array<UINT8, 16>;
+
+constexpr UINT16 kProtocolVersion = 0x0100U;
+constexpr VirtualTime kNanosPerMicro = 1000U;
+
+// A callback invocation queued for the session whose tlc_process hands it out.
+struct Delivery {
+    TRDP_PD_CALLBACK_T pdCallback{nullptr};
+    TRDP_MD_CALLBACK_T mdCallback{nullptr};
+    void *userRef{nullptr};
+    TRDP_PD_INFO_T pdInfo{};
+    TRDP_MD_INFO_T mdInfo{};
+    std::vector<UINT8> data;
+};
+
+} // namespace
+
+// The API only forward-declares the handle types, so the fake is free to define them.
+struct TRDP_SESSION {
+    TRDP_IP_ADDR_T ownIp{0};
+    UINT32 etbTopoCnt{0};
+    UINT32 opTrnTopoCnt{0};
+    UINT32 mdReplyTimeoutUs{TRDP_MD_DEFAULT_REPLY_TIMEOUT};
+    std::vector<Delivery> inbox;
+};
+
+struct PD_ELE {
+    std::uint64_t id{0};
+    TRDP_APP_SESSION_T session{nullptr};
+    bool publisher{false};
+    void *userRef{nullptr};
+    TRDP_PD_CALLBACK_T callback{nullptr};
+    UINT32 comId{0};
+    TRDP_IP_ADDR_T srcIp{0};
+    TRDP_IP_ADDR_T destIp{0};
+    VirtualTime interval{0};
+    TRDP_FLAGS_T flags{TRDP_FLAGS_DEFAULT};
+    UINT32 seqCount{0};
+    bool hasData{false};
+    std::vector<UINT8> data;
+};
+
+struct MD_LIS_ELE {
+    TRDP_APP_SESSION_T session{nullptr};
+    void *userRef{nullptr};
+    TRDP_MD_CALLBACK_T callback{nullptr};
+    UINT32 comId{0};
+};
+
+namespace {
+
+enum class EventKind { Publish, Stream, ReplyTimeout };
+
+struct Event {
+    VirtualTime due{0};
+    // Insertion order breaks ties so equal deadlines always fire in the same sequence.
+    std::uint64_t order{0};
+    EventKind kind{EventKind::Publish};
+    std::uint64_t id{0};
+
+    bool operator>(const Event &other) const {
+        return due != other.due ? due > other.due : order > other.order;
+    }
+};
+
+struct Stream {
+    trdp::FakeTrdpStack::RxStream def;
+    VirtualTime period{0};
+    UINT32 seqCount{0};
+};
+
+// An outstanding MD request (or notification-less injected request) waiting for replies.
+struct PendingRequest {
+    SessionKey key{};
+    TRDP_APP_SESSION_T requester{nullptr};
+    TRDP_MD_CALLBACK_T callback{nullptr};
+    void *userRef{nullptr};
+    UINT32 comId{0};
+    UINT32 expectedReplies{0};
+    UINT32 replies{0};
+};
+
+struct FakeState {
+    std::mutex mtx;
+    trdp::FakeTrdpStack::Config config;
+    bool initialised{false};
+    VirtualTime now{0};
+    std::uint64_t nextId{1};
+    std::uint64_t eventOrder{0};
+    std::uint64_t sessionCounter{0};
+
+    std::vector<std::unique_ptr<TRDP_SESSION>> sessions;
+    std::unordered_map<std::uint64_t, std::unique_ptr<PD_ELE>> pdElements;
+    std::unordered_map<UINT32, std::vector<PD_ELE *>> subscribers;
+    std::vector<std::unique_ptr<MD_LIS_ELE>> listeners;
+    std::unordered_map<std::uint64_t, Stream> streams;
+    std::unordered_map<std::uint64_t, PendingRequest> pending;
+    std::map<SessionKey, std::uint64_t> pendingByKey;
+    std::priority_queue<Event, std::vector<Event>, std::greater<>> events;
+    // Deliveries sitting in session inboxes; the clock never jumps past undelivered traffic.
+    std::size_t queued{0};
+
+    trdp::FakeTrdpStack::Stats stats;
+};
+
+FakeState &fakeState() {
+    static FakeState state;
+    return state;
+}
+
+bool knownSession(const FakeState &state, TRDP_APP_SESSION_T session) {
+    return session != nullptr &&
+           std::any_of(state.sessions.begin(), state.sessions.end(),
+                       [session](const auto &candidate) { return candidate.get() == session; });
+}
+
+PD_ELE *findElement(FakeState &state, const PD_ELE *handle) {
+    if (handle == nullptr) {
+        return nullptr;
+    }
+    const auto it = state.pdElements.find(handle->id);
+    return (it != state.pdElements.end() && it->second.get() == handle) ? it->second.get() : nullptr;
+}
+
+void schedule(FakeState &state, VirtualTime due, EventKind kind, std::uint64_t id) {
+    state.events.push(Event{due, state.eventOrder++, kind, id});
+}
+
+void enqueue(FakeState &state, TRDP_APP_SESSION_T session, Delivery delivery) {
+    session->inbox.push_back(std::move(delivery));
+    ++state.queued;
+}
+
+VirtualTime micros(UINT32 value) {
+    return static_cast<VirtualTime>(value) * kNanosPerMicro;
+}
+
+SessionKey nextSessionKey(FakeState &state) {
+    // Deterministic ids keep runs reproducible; the "FAKE" prefix makes them easy to spot in logs.
+    SessionKey key{'F', 'A', 'K', 'E'};
+    const auto counter = ++state.sessionCounter;
+    for (std::size_t i = 0; i < 8U; ++i) {
+        key[15U - i] = static_cast<UINT8>(counter >> (8U * i));
+    }
+    return key;
+}
+
+void deliverPd(FakeState &state, UINT32 comId, TRDP_IP_ADDR_T srcIp, TRDP_IP_ADDR_T destIp, UINT32 seqCount,
+               const TRDP_SESSION *origin, const std::vector<UINT8> &data) {
+    const auto it = state.subscribers.find(comId);
+    if (it == state.subscribers.end()) {
+        return;
+    }
+    // Source filters are ignored so a single process can feed its own subscriptions.
+    for (auto *subscriber : it->second) {
+        Delivery delivery;
+        delivery.pdCallback = subscriber->callback;
+        delivery.userRef = subscriber->userRef;
+        auto &info = delivery.pdInfo;
+        info.srcIpAddr = srcIp;
+        info.destIpAddr = destIp;
+        info.seqCount = seqCount;
+        info.protVersion = kProtocolVersion;
+        info.msgType = TRDP_MSG_PD;
+        info.comId = comId;
+        info.etbTopoCnt = origin != nullptr ? origin->etbTopoCnt : 0U;
+        info.opTrnTopoCnt = origin != nullptr ? origin->opTrnTopoCnt : 0U;
+        info.pUserRef = subscriber->userRef;
+        info.resultCode = TRDP_NO_ERR;
+        delivery.data = data;
+        enqueue(state, subscriber->session, std::move(delivery));
+        ++state.stats.pdDelivered;
+    }
+}
+
+void publish(FakeState &state, PD_ELE &element) {
+    ++element.seqCount;
+    ++state.stats.pdPublished;
+    if (element.callback != nullptr && (element.flags & TRDP_FLAGS_CALLBACK) != 0U) {
+        // TCNopen calls a publisher's callback before every send; here it arrives on the next tlc_process.
+        Delivery delivery;
+        delivery.pdCallback = element.callback;
+        delivery.userRef = element.userRef;
+        auto &info = delivery.pdInfo;
+        info.srcIpAddr = element.srcIp != 0U ? element.srcIp : element.session->ownIp;
+        info.destIpAddr = element.destIp;
+        info.seqCount = element.seqCount;
+        info.protVersion = kProtocolVersion;
+        info.msgType = TRDP_MSG_PD;
+        info.comId = element.comId;
+        info.etbTopoCnt = element.session->etbTopoCnt;
+        info.opTrnTopoCnt = element.session->opTrnTopoCnt;
+        info.pUserRef = element.userRef;
+        info.resultCode = TRDP_NO_ERR;
+        delivery.data = element.data;
+        enqueue(state, element.session, std::move(delivery));
+    }
+    deliverPd(state, element.comId, element.srcIp != 0U ? element.srcIp : element.session->ownIp, element.destIp,
+              element.seqCount, element.session, element.data);
+}
+
+TRDP_MD_INFO_T makeMdInfo(TRDP_MSG_T msgType, UINT32 comId, const SessionKey &key, const TRDP_SESSION *origin,
+                          void *userRef) {
+    TRDP_MD_INFO_T info{};
+    info.srcIpAddr = origin != nullptr ? origin->ownIp : 0U;
+    info.protVersion = kProtocolVersion;
+    info.msgType = msgType;
+    info.comId = comId;
+    info.etbTopoCnt = origin != nullptr ? origin->etbTopoCnt : 0U;
+    info.opTrnTopoCnt = origin != nullptr ? origin->opTrnTopoCnt : 0U;
+    std::memcpy(&info.sessionId, key.data(), key.size());
+    info.pUserRef = userRef;
+    info.resultCode = TRDP_NO_ERR;
+    return info;
+}
+
+// Hand an Mn/Mr to every listener of comId. Returns the number of listeners reached.
+std::size_t deliverMdToListeners(FakeState &state, TRDP_MSG_T msgType, UINT32 comId, const SessionKey &key,
+                                 const TRDP_SESSION *origin, TRDP_IP_ADDR_T srcIp, UINT32 replyTimeoutUs,
+                                 UINT32 expectedReplies, const UINT8 *data, UINT32 size) {
+    std::size_t reached = 0;
+    for (const auto &listener : state.listeners) {
+        if (listener->comId != comId) {
+            continue;
+        }
+        Delivery delivery;
+        delivery.mdCallback = listener->callback;
+        delivery.userRef = listener->userRef;
+        delivery.mdInfo = makeMdInfo(msgType, comId, key, origin, listener->userRef);
+        if (srcIp != 0U) {
+            delivery.mdInfo.srcIpAddr = srcIp;
+        }
+        delivery.mdInfo.destIpAddr = listener->session->ownIp;
+        delivery.mdInfo.replyTimeout = replyTimeoutUs;
+        delivery.mdInfo.numExpReplies = expectedReplies;
+        if (data != nullptr && size > 0U) {
+            delivery.data.assign(data, data + size);
+        }
+        enqueue(state, listener->session, std::move(delivery));
+        ++state.stats.mdDelivered;
+        ++reached;
+    }
+    return reached;
+}
+
+std::uint64_t addPending(FakeState &state, PendingRequest request, UINT32 replyTimeoutUs) {
+    const auto id = state.nextId++;
+    state.pendingByKey[request.key] = id;
+    state.pending.emplace(id, std::move(request));
+    schedule(state, state.now + micros(replyTimeoutUs), EventKind::ReplyTimeout, id);
+    return id;
+}
+
+void erasePending(FakeState &state, std::unordered_map<std::uint64_t, PendingRequest>::iterator it) {
+    state.pendingByKey.erase(it->second.key);
+    state.pending.erase(it);
+}
+
+TRDP_ERR_T reply(TRDP_APP_SESSION_T appHandle, const TRDP_UUID_T *pSessionId, UINT32 comId, UINT32 userStatus,
+                 TRDP_MSG_T msgType, const UINT8 *pData, UINT32 dataSize) {
+    if (pSessionId == nullptr || dataSize > TRDP_MAX_MD_DATA_SIZE) {
+        return TRDP_PARAM_ERR;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    SessionKey key{};
+    std::memcpy(key.data(), pSessionId, key.size());
+    const auto keyIt = state.pendingByKey.find(key);
+    if (keyIt == state.pendingByKey.end()) {
+        return TRDP_NOSESSION_ERR;
+    }
+    auto it = state.pending.find(keyIt->second);
+    auto &request = it->second;
+    ++request.replies;
+    ++state.stats.mdSent;
+
+    if (request.requester != nullptr) {
+        Delivery delivery;
+        delivery.mdCallback = request.callback;
+        delivery.userRef = request.userRef;
+        delivery.mdInfo = makeMdInfo(msgType, comId, key, appHandle, request.userRef);
+        delivery.mdInfo.destIpAddr = request.requester->ownIp;
+        delivery.mdInfo.userStatus = static_cast<UINT16>(userStatus);
+        delivery.mdInfo.numExpReplies = request.expectedReplies;
+        delivery.mdInfo.numReplies = request.replies;
+        if (pData != nullptr && dataSize > 0U) {
+            delivery.data.assign(pData, pData + dataSize);
+        }
+        enqueue(state, request.requester, std::move(delivery));
+        ++state.stats.mdDelivered;
+    }
+
+    if (msgType == TRDP_MSG_MQ) {
+        // Stand in for the requester's confirmation so the replier's session completes.
+        for (const auto &listener : state.listeners) {
+            if (listener->session != appHandle || listener->comId != request.comId) {
+                continue;
+            }
+            Delivery confirm;
+            confirm.mdCallback = listener->callback;
+            confirm.userRef = listener->userRef;
+            confirm.mdInfo = makeMdInfo(TRDP_MSG_MC, request.comId, key, request.requester, listener->userRef);
+            enqueue(state, appHandle, std::move(confirm));
+            ++state.stats.mdDelivered;
+            break;
+        }
+    }
+
+    if (request.expectedReplies != 0U && request.replies >= request.expectedReplies) {
+        erasePending(state, it);
+    }
+    return TRDP_NO_ERR;
+}
+
+void handleEvent(FakeState &state, const Event &event) {
+    switch (event.kind) {
+    case EventKind::Publish: {
+        const auto it = state.pdElements.find(event.id);
+        if (it == state.pdElements.end() || it->second->interval == 0U) {
+            return;
+        }
+        auto &element = *it->second;
+        if (element.hasData) {
+            publish(state, element);
+        }
+        schedule(state, event.due + element.interval, EventKind::Publish, element.id);
+        return;
+    }
+    case EventKind::Stream: {
+        const auto it = state.streams.find(event.id);
+        if (it == state.streams.end()) {
+            return;
+        }
+        auto &stream = it->second;
+        const auto &def = stream.def;
+        ++stream.seqCount;
+        if (def.kind == trdp::FakeTrdpStack::MsgKind::Pd) {
+            ++state.stats.pdInjected;
+            deliverPd(state, def.comId, def.srcIp, 0U, stream.seqCount, nullptr, def.payload);
+        } else {
+            ++state.stats.mdInjected;
+            const bool request = def.kind == trdp::FakeTrdpStack::MsgKind::MdRequest;
+            const auto key = nextSessionKey(state);
+            const auto size = static_cast<UINT32>(def.payload.size());
+            const auto reached =
+                deliverMdToListeners(state, request ? TRDP_MSG_MR : TRDP_MSG_MN, def.comId, key, nullptr, def.srcIp,
+                                     TRDP_MD_DEFAULT_REPLY_TIMEOUT, request ? 1U : 0U, def.payload.data(), size);
+            if (request && reached > 0U) {
+                PendingRequest pendingRequest;
+                pendingRequest.key = key;
+                pendingRequest.comId = def.comId;
+                pendingRequest.expectedReplies = 1U;
+                addPending(state, pendingRequest, TRDP_MD_DEFAULT_REPLY_TIMEOUT);
+            }
+        }
+        schedule(state, event.due + stream.period, EventKind::Stream, event.id);
+        return;
+    }
+    case EventKind::ReplyTimeout: {
+        const auto it = state.pending.find(event.id);
+        if (it == state.pending.end()) {
+            return;
+        }
+        const auto &request = it->second;
+        const bool unanswered = request.replies == 0U ||
+                                (request.expectedReplies != 0U && request.replies < request.expectedReplies);
+        if (unanswered) {
+            ++state.stats.mdReplyTimeouts;
+            if (request.requester != nullptr && request.callback != nullptr) {
+                Delivery delivery;
+                delivery.mdCallback = request.callback;
+                delivery.userRef = request.userRef;
+                delivery.mdInfo = makeMdInfo(TRDP_MSG_MR, request.comId, request.key, nullptr, request.userRef);
+                delivery.mdInfo.numExpReplies = request.expectedReplies;
+                delivery.mdInfo.numReplies = request.replies;
+                delivery.mdInfo.resultCode = TRDP_REPLYTO_ERR;
+                enqueue(state, request.requester, std::move(delivery));
+            }
+        }
+        erasePending(state, it);
+        return;
+    }
+    }
+}
+
+void fireDueEvents(FakeState &state) {
+    while (!state.events.empty() && state.events.top().due <= state.now) {
+        const auto event = state.events.top();
+        state.events.pop();
+        handleEvent(state, event);
+    }
+}
+
+void reportInterval(const FakeState &state, TRDP_TIME_T *pInterval, TRDP_FDS_T *pFileDesc, TRDP_SOCK_T *pNoDesc) {
+    const auto interval = state.config.reportedInterval.count();
+    pInterval->tv_sec = static_cast<decltype(pInterval->tv_sec)>(interval / 1000000);
+    pInterval->tv_usec = static_cast<decltype(pInterval->tv_usec)>(interval % 1000000);
+    if (pFileDesc != nullptr) {
+        FD_ZERO(pFileDesc);
+    }
+    if (pNoDesc != nullptr) {
+        // No sockets: select() only serves as the sleep.
+        *pNoDesc = -1;
+    }
+}
+
+} // namespace
+
+namespace trdp {
+
+FakeTrdpStack &FakeTrdpStack::instance() {
+    static FakeTrdpStack stack;
+    return stack;
+}
+
+void FakeTrdpStack::setConfig(const Config &config) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    state.config = config;
+}
+
+FakeTrdpStack::Config FakeTrdpStack::config() {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    return state.config;
+}
+
+std::uint64_t FakeTrdpStack::addRxStream(const RxStream &stream) {
+    if (stream.comId == 0U || !(stream.ratePerSecond > 0.0) || stream.phase.count() < 0) {
+        return 0;
+    }
+    const auto limit = stream.kind == MsgKind::Pd ? TRDP_MAX_PD_DATA_SIZE : TRDP_MAX_MD_DATA_SIZE;
+    if (stream.payload.size() > limit) {
+        return 0;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    const auto id = state.nextId++;
+    Stream entry;
+    entry.def = stream;
+    entry.period = std::max<VirtualTime>(1U, static_cast<VirtualTime>(std::llround(1e9 / stream.ratePerSecond)));
+    state.streams.emplace(id, std::move(entry));
+    schedule(state, state.now + static_cast<VirtualTime>(stream.phase.count()), EventKind::Stream, id);
+    return id;
+}
+
+void FakeTrdpStack::removeRxStream(std::uint64_t id) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    state.streams.erase(id);
+}
+
+void FakeTrdpStack::clearRxStreams() {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    state.streams.clear();
+}
+
+std::chrono::nanoseconds FakeTrdpStack::now() {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    return std::chrono::nanoseconds(state.now);
+}
+
+void FakeTrdpStack::advance(std::chrono::nanoseconds delta) {
+    if (delta.count() <= 0) {
+        return;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    state.now += static_cast<VirtualTime>(delta.count());
+}
+
+void FakeTrdpStack::advanceTo(std::chrono::nanoseconds time) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (time.count() > 0) {
+        state.now = std::max(state.now, static_cast<VirtualTime>(time.count()));
+    }
+}
+
+std::optional<std::chrono::nanoseconds> FakeTrdpStack::nextEvent() {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (state.events.empty()) {
+        return std::nullopt;
+    }
+    return std::chrono::nanoseconds(state.events.top().due);
+}
+
+FakeTrdpStack::Stats FakeTrdpStack::stats() {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    auto stats = state.stats;
+    stats.virtualTime = std::chrono::nanoseconds(state.now);
+    return stats;
+}
+
+void FakeTrdpStack::reset() {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    state.now = 0;
+    state.stats = Stats{};
+    state.streams.clear();
+    state.pending.clear();
+    state.pendingByKey.clear();
+    state.events = {};
+    for (const auto &session : state.sessions) {
+        session->inbox.clear();
+    }
+    state.queued = 0;
+    for (const auto &[id, element] : state.pdElements) {
+        if (element->publisher && element->interval != 0U) {
+            schedule(state, element->interval, EventKind::Publish, id);
+        }
+    }
+}
+
+} // namespace trdp
+
+// --- TRDP light API -------------------------------------------------------------------------------------------
+
+TRDP_ERR_T tlc_init(const TRDP_PRINT_DBG_T /*pPrintDebugString*/, void * /*pRefCon*/,
+                    const TRDP_MEM_CONFIG_T * /*pMemConfig*/) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    state.initialised = true;
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlc_terminate(void) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!state.initialised) {
+        return TRDP_NOINIT_ERR;
+    }
+    state.subscribers.clear();
+    state.pdElements.clear();
+    state.listeners.clear();
+    state.pending.clear();
+    state.pendingByKey.clear();
+    state.sessions.clear();
+    state.queued = 0;
+    state.initialised = false;
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlc_openSession(TRDP_APP_SESSION_T *pAppHandle, TRDP_IP_ADDR_T ownIpAddr, TRDP_IP_ADDR_T /*leaderIpAddr*/,
+                           const TRDP_MARSHALL_CONFIG_T * /*pMarshall*/, const TRDP_PD_CONFIG_T * /*pPdDefault*/,
+                           const TRDP_MD_CONFIG_T *pMdDefault, const TRDP_PROCESS_CONFIG_T * /*pProcessConfig*/) {
+    if (pAppHandle == nullptr) {
+        return TRDP_PARAM_ERR;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!state.initialised) {
+        return TRDP_INIT_ERR;
+    }
+    auto session = std::make_unique<TRDP_SESSION>();
+    session->ownIp = ownIpAddr;
+    if (pMdDefault != nullptr && pMdDefault->replyTimeout != 0U) {
+        session->mdReplyTimeoutUs = pMdDefault->replyTimeout;
+    }
+    *pAppHandle = session.get();
+    state.sessions.push_back(std::move(session));
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlc_closeSession(TRDP_APP_SESSION_T appHandle) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    for (auto &[comId, list] : state.subscribers) {
+        (void)comId;
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [appHandle](const PD_ELE *element) { return element->session == appHandle; }),
+                   list.end());
+    }
+    for (auto it = state.pdElements.begin(); it != state.pdElements.end();) {
+        it = it->second->session == appHandle ? state.pdElements.erase(it) : std::next(it);
+    }
+    state.listeners.erase(std::remove_if(state.listeners.begin(), state.listeners.end(),
+                                         [appHandle](const auto &listener) { return listener->session == appHandle; }),
+                          state.listeners.end());
+    for (auto it = state.pending.begin(); it != state.pending.end();) {
+        if (it->second.requester == appHandle) {
+            state.pendingByKey.erase(it->second.key);
+            it = state.pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    state.queued -= appHandle->inbox.size();
+    state.sessions.erase(std::remove_if(state.sessions.begin(), state.sessions.end(),
+                                        [appHandle](const auto &session) { return session.get() == appHandle; }),
+                         state.sessions.end());
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlc_configSession(TRDP_APP_SESSION_T appHandle, const TRDP_MARSHALL_CONFIG_T * /*pMarshall*/,
+                             const TRDP_PD_CONFIG_T * /*pPdDefault*/, const TRDP_MD_CONFIG_T *pMdDefault,
+                             const TRDP_PROCESS_CONFIG_T * /*pProcessConfig*/) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    if (pMdDefault != nullptr && pMdDefault->replyTimeout != 0U) {
+        appHandle->mdReplyTimeoutUs = pMdDefault->replyTimeout;
+    }
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlc_updateSession(TRDP_APP_SESSION_T appHandle) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    return knownSession(state, appHandle) ? TRDP_NO_ERR : TRDP_NOINIT_ERR;
+}
+
+TRDP_ERR_T tlc_setETBTopoCount(TRDP_APP_SESSION_T appHandle, UINT32 etbTopoCnt) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    appHandle->etbTopoCnt = etbTopoCnt;
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlc_setOpTrainTopoCount(TRDP_APP_SESSION_T appHandle, UINT32 opTrnTopoCnt) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    appHandle->opTrnTopoCnt = opTrnTopoCnt;
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlc_getInterval(TRDP_APP_SESSION_T appHandle, TRDP_TIME_T *pInterval, TRDP_FDS_T *pFileDesc,
+                           TRDP_SOCK_T *pNoDesc) {
+    if (pInterval == nullptr) {
+        return TRDP_PARAM_ERR;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    reportInterval(state, pInterval, pFileDesc, pNoDesc);
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlp_getInterval(TRDP_APP_SESSION_T appHandle, TRDP_TIME_T *pInterval, TRDP_FDS_T *pFileDesc,
+                           TRDP_SOCK_T *pNoDesc) {
+    return tlc_getInterval(appHandle, pInterval, pFileDesc, pNoDesc);
+}
+
+TRDP_ERR_T tlc_process(TRDP_APP_SESSION_T appHandle, TRDP_FDS_T * /*pRfds*/, INT32 * /*pCount*/) {
+    auto &state = fakeState();
+    std::vector<Delivery> deliveries;
+    {
+        std::lock_guard lock(state.mtx);
+        if (!knownSession(state, appHandle)) {
+            return TRDP_NOINIT_ERR;
+        }
+        ++state.stats.processCalls;
+        if (state.config.autoAdvance && state.queued == 0U && !state.events.empty() &&
+            state.events.top().due > state.now) {
+            state.now = state.events.top().due;
+        }
+        fireDueEvents(state);
+        deliveries.swap(appHandle->inbox);
+        state.queued -= deliveries.size();
+        state.stats.callbacks += deliveries.size();
+    }
+
+    // Callbacks run unlocked: the engine replies to MD requests from inside them.
+    for (auto &delivery : deliveries) {
+        auto *data = delivery.data.empty() ? nullptr : delivery.data.data();
+        const auto size = static_cast<UINT32>(delivery.data.size());
+        if (delivery.pdCallback != nullptr) {
+            delivery.pdCallback(delivery.userRef, appHandle, &delivery.pdInfo, data, size);
+        } else if (delivery.mdCallback != nullptr) {
+            delivery.mdCallback(delivery.userRef, appHandle, &delivery.mdInfo, data, size);
+        }
+    }
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlp_publish(TRDP_APP_SESSION_T appHandle, TRDP_PUB_T *pPubHandle, void *pUserRef,
+                       TRDP_PD_CALLBACK_T pfCbFunction, UINT32 /*serviceId*/, UINT32 comId, UINT32 /*etbTopoCnt*/,
+                       UINT32 /*opTrnTopoCnt*/, TRDP_IP_ADDR_T srcIpAddr, TRDP_IP_ADDR_T destIpAddr, UINT32 interval,
+                       UINT32 /*redId*/, TRDP_FLAGS_T pktFlags, const TRDP_SEND_PARAM_T * /*pSendParam*/,
+                       const UINT8 *pData, UINT32 dataSize) {
+    if (pPubHandle == nullptr || dataSize > TRDP_MAX_PD_DATA_SIZE) {
+        return TRDP_PARAM_ERR;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    auto element = std::make_unique<PD_ELE>();
+    element->id = state.nextId++;
+    element->session = appHandle;
+    element->publisher = true;
+    element->userRef = pUserRef;
+    element->callback = pfCbFunction;
+    element->comId = comId;
+    element->srcIp = srcIpAddr;
+    element->destIp = destIpAddr;
+    element->interval = micros(interval);
+    element->flags = pktFlags;
+    element->hasData = pData != nullptr;
+    if (pData != nullptr) {
+        element->data.assign(pData, pData + dataSize);
+    }
+    if (element->interval != 0U) {
+        schedule(state, state.now + element->interval, EventKind::Publish, element->id);
+    }
+    *pPubHandle = element.get();
+    state.pdElements.emplace(element->id, std::move(element));
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlp_unpublish(TRDP_APP_SESSION_T appHandle, TRDP_PUB_T pubHandle) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    auto *element = findElement(state, pubHandle);
+    if (element == nullptr || !element->publisher) {
+        return TRDP_NOPUB_ERR;
+    }
+    state.pdElements.erase(element->id);
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlp_republish(TRDP_APP_SESSION_T appHandle, TRDP_PUB_T pubHandle, UINT32 /*etbTopoCnt*/,
+                         UINT32 /*opTrnTopoCnt*/, TRDP_IP_ADDR_T srcIpAddr, TRDP_IP_ADDR_T destIpAddr) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    auto *element = findElement(state, pubHandle);
+    if (element == nullptr || !element->publisher) {
+        return TRDP_NOPUB_ERR;
+    }
+    element->srcIp = srcIpAddr;
+    element->destIp = destIpAddr;
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlp_put(TRDP_APP_SESSION_T appHandle, TRDP_PUB_T pubHandle, const UINT8 *pData, UINT32 dataSize) {
+    if (dataSize > TRDP_MAX_PD_DATA_SIZE) {
+        return TRDP_PARAM_ERR;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    auto *element = findElement(state, pubHandle);
+    if (element == nullptr || !element->publisher) {
+        return TRDP_NOPUB_ERR;
+    }
+    ++state.stats.pdPuts;
+    element->hasData = true;
+    if (pData != nullptr) {
+        element->data.assign(pData, pData + dataSize);
+    } else {
+        element->data.clear();
+    }
+    // Acyclic publishers go out on every put; cyclic ones on their next virtual cycle.
+    if (element->interval == 0U) {
+        publish(state, *element);
+    }
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlp_subscribe(TRDP_APP_SESSION_T appHandle, TRDP_SUB_T *pSubHandle, void *pUserRef,
+                         TRDP_PD_CALLBACK_T pfCbFunction, UINT32 /*serviceId*/, UINT32 comId, UINT32 /*etbTopoCnt*/,
+                         UINT32 /*opTrnTopoCnt*/, TRDP_IP_ADDR_T srcIpAddr1, TRDP_IP_ADDR_T /*srcIpAddr2*/,
+                         TRDP_IP_ADDR_T destIpAddr, TRDP_FLAGS_T /*pktFlags*/,
+                         const TRDP_COM_PARAM_T * /*pRecParams*/, UINT32 /*timeout*/,
+                         TRDP_TO_BEHAVIOR_T /*toBehavior*/) {
+    if (pSubHandle == nullptr) {
+        return TRDP_PARAM_ERR;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    auto element = std::make_unique<PD_ELE>();
+    element->id = state.nextId++;
+    element->session = appHandle;
+    element->userRef = pUserRef;
+    element->callback = pfCbFunction;
+    element->comId = comId;
+    element->srcIp = srcIpAddr1;
+    element->destIp = destIpAddr;
+    *pSubHandle = element.get();
+    state.subscribers[comId].push_back(element.get());
+    state.pdElements.emplace(element->id, std::move(element));
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlp_unsubscribe(TRDP_APP_SESSION_T appHandle, TRDP_SUB_T subHandle) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    auto *element = findElement(state, subHandle);
+    if (element == nullptr || element->publisher) {
+        return TRDP_NOSUB_ERR;
+    }
+    auto &list = state.subscribers[element->comId];
+    list.erase(std::remove(list.begin(), list.end(), element), list.end());
+    state.pdElements.erase(element->id);
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlp_resubscribe(TRDP_APP_SESSION_T appHandle, TRDP_SUB_T subHandle, UINT32 /*etbTopoCnt*/,
+                           UINT32 /*opTrnTopoCnt*/, TRDP_IP_ADDR_T srcIpAddr1, TRDP_IP_ADDR_T /*srcIpAddr2*/,
+                           TRDP_IP_ADDR_T destIpAddr) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    auto *element = findElement(state, subHandle);
+    if (element == nullptr || element->publisher) {
+        return TRDP_NOSUB_ERR;
+    }
+    element->srcIp = srcIpAddr1;
+    element->destIp = destIpAddr;
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlm_addListener(TRDP_APP_SESSION_T appHandle, TRDP_LIS_T *pListenHandle, void *pUserRef,
+                           TRDP_MD_CALLBACK_T pfCbFunction, BOOL8 /*comIdListener*/, UINT32 comId,
+                           UINT32 /*etbTopoCnt*/, UINT32 /*opTrnTopoCnt*/, TRDP_IP_ADDR_T /*srcIpAddr1*/,
+                           TRDP_IP_ADDR_T /*srcIpAddr2*/, TRDP_IP_ADDR_T /*mcDestIpAddr*/, TRDP_FLAGS_T /*pktFlags*/,
+                           const TRDP_URI_USER_T /*srcURI*/, const TRDP_URI_USER_T /*destURI*/) {
+    if (pListenHandle == nullptr) {
+        return TRDP_PARAM_ERR;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    auto listener = std::make_unique<MD_LIS_ELE>();
+    listener->session = appHandle;
+    listener->userRef = pUserRef;
+    listener->callback = pfCbFunction;
+    listener->comId = comId;
+    *pListenHandle = listener.get();
+    state.listeners.push_back(std::move(listener));
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlm_delListener(TRDP_APP_SESSION_T appHandle, TRDP_LIS_T listenHandle) {
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    const auto it = std::find_if(state.listeners.begin(), state.listeners.end(),
+                                 [listenHandle](const auto &listener) { return listener.get() == listenHandle; });
+    if (it == state.listeners.end()) {
+        return TRDP_NOLIST_ERR;
+    }
+    state.listeners.erase(it);
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlm_notify(TRDP_APP_SESSION_T appHandle, void * /*pUserRef*/, TRDP_MD_CALLBACK_T /*pfCbFunction*/,
+                      UINT32 comId, UINT32 /*etbTopoCnt*/, UINT32 /*opTrnTopoCnt*/, TRDP_IP_ADDR_T srcIpAddr,
+                      TRDP_IP_ADDR_T /*destIpAddr*/, TRDP_FLAGS_T /*pktFlags*/,
+                      const TRDP_SEND_PARAM_T * /*pSendParam*/, const UINT8 *pData, UINT32 dataSize,
+                      const TRDP_URI_USER_T /*srcURI*/, const TRDP_URI_USER_T /*destURI*/) {
+    if (dataSize > TRDP_MAX_MD_DATA_SIZE) {
+        return TRDP_PARAM_ERR;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    ++state.stats.mdSent;
+    deliverMdToListeners(state, TRDP_MSG_MN, comId, nextSessionKey(state), appHandle, srcIpAddr, 0U, 0U, pData,
+                         dataSize);
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlm_request(TRDP_APP_SESSION_T appHandle, void *pUserRef, TRDP_MD_CALLBACK_T pfCbFunction,
+                       TRDP_UUID_T *pSessionId, UINT32 comId, UINT32 /*etbTopoCnt*/, UINT32 /*opTrnTopoCnt*/,
+                       TRDP_IP_ADDR_T srcIpAddr, TRDP_IP_ADDR_T /*destIpAddr*/, TRDP_FLAGS_T /*pktFlags*/,
+                       UINT32 numReplies, UINT32 replyTimeout, const TRDP_SEND_PARAM_T * /*pSendParam*/,
+                       const UINT8 *pData, UINT32 dataSize, const TRDP_URI_USER_T /*srcURI*/,
+                       const TRDP_URI_USER_T /*destURI*/) {
+    if (dataSize > TRDP_MAX_MD_DATA_SIZE) {
+        return TRDP_PARAM_ERR;
+    }
+    auto &state = fakeState();
+    std::lock_guard lock(state.mtx);
+    if (!knownSession(state, appHandle)) {
+        return TRDP_NOINIT_ERR;
+    }
+    const auto key = nextSessionKey(state);
+    if (pSessionId != nullptr) {
+        std::memcpy(pSessionId, key.data(), key.size());
+    }
+    const auto timeoutUs = replyTimeout != 0U ? replyTimeout : appHandle->mdReplyTimeoutUs;
+    ++state.stats.mdSent;
+    deliverMdToListeners(state, TRDP_MSG_MR, comId, key, appHandle, srcIpAddr, timeoutUs, numReplies, pData,
+                         dataSize);
+
+    PendingRequest request;
+    request.key = key;
+    request.requester = appHandle;
+    request.callback = pfCbFunction;
+    request.userRef = pUserRef;
+    request.comId = comId;
+    request.expectedReplies = numReplies;
+    addPending(state, request, timeoutUs);
+    return TRDP_NO_ERR;
+}
+
+TRDP_ERR_T tlm_reply(TRDP_APP_SESSION_T appHandle, const TRDP_UUID_T *pSessionId, UINT32 comId, UINT32 userStatus,
+                     const TRDP_SEND_PARAM_T * /*pSendParam*/, const UINT8 *pData, UINT32 dataSize,
+                     const CHAR8 * /*srcURI*/) {
+    return reply(appHandle, pSessionId, comId, userStatus, TRDP_MSG_MP, pData, dataSize);
+}
+
+TRDP_ERR_T tlm_replyQuery(TRDP_APP_SESSION_T appHandle, const TRDP_UUID_T *pSessionId, UINT32 comId,
+                          UINT32 userStatus, UINT32 /*confirmTimeout*/, const TRDP_SEND_PARAM_T * /*pSendParam*/,
+                          const UINT8 *pData, UINT32 dataSize, const CHAR8 * /*srcURI*/) {
+    return reply(appHandle, pSessionId, comId, userStatus, TRDP_MSG_MQ, pData, dataSize);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * Control surface of the in-process fake TRDP stack (target trdp_fake_stack).
+ *
+ * The fake implements the tlc_/tlp_/tlm_ calls the engine makes against the TCNopen API, without sockets.
+ * Publications are looped back in memory to every subscription of the same ComId, MD requests/notifications
+ * to the listeners of that ComId and replies to the requester. Synthetic RX streams can be injected at a
+ * fixed rate. Everything runs on a virtual clock: cyclic publishes, injected traffic and MD reply timeouts
+ * fall due in virtual time, so a run is reproducible regardless of host load.
+ *
+ * Link trdp_engine_fake (the engine built against this library) instead of trdp_engine to use it.
+ */
+class FakeTrdpStack {
+  public:
+    enum class MsgKind { Pd, MdNotify, MdRequest };
+
+    struct Config {
+        // Jump the clock to the next pending event whenever tlc_process finds nothing due. When false the clock
+        // only moves through advance().
+        bool autoAdvance{true};
+        // Interval reported by tlc_getInterval; zero lets the engine loop run back to back.
+        std::chrono::microseconds reportedInterval{0};
+    };
+
+    // Synthetic RX traffic delivered to the subscribers (PD) or listeners (MD) of comId.
+    struct RxStream {
+        std::uint32_t comId{0};
+        MsgKind kind{MsgKind::Pd};
+        double ratePerSecond{0.0};
+        std::vector<std::uint8_t> payload;
+        std::uint32_t srcIp{0x0A000001U};
+        // Start offset from the time the stream is added.
+        std::chrono::nanoseconds phase{0};
+    };
+
+    struct Stats {
+        std::chrono::nanoseconds virtualTime{0};
+        std::uint64_t processCalls{0};
+        std::uint64_t pdPuts{0};
+        std::uint64_t pdPublished{0};
+        std::uint64_t pdInjected{0};
+        std::uint64_t pdDelivered{0};
+        std::uint64_t mdSent{0};
+        std::uint64_t mdInjected{0};
+        std::uint64_t mdDelivered{0};
+        std::uint64_t mdReplyTimeouts{0};
+        std::uint64_t callbacks{0};
+    };
+
+    static FakeTrdpStack &instance();
+
+    void setConfig(const Config &config);
+    [[nodiscard]] Config config();
+
+    // Returns an id for removeRxStream, or 0 when the stream is invalid (no ComId or a non-positive rate).
+    std::uint64_t addRxStream(const RxStream &stream);
+    void removeRxStream(std::uint64_t id);
+    void clearRxStreams();
+
+    [[nodiscard]] std::chrono::nanoseconds now();
+    // Move the virtual clock forward; due events are handed out on the next tlc_process.
+    void advance(std::chrono::nanoseconds delta);
+    // Move the clock forward to an absolute time (earlier times are ignored), e.g. to follow another clock.
+    void advanceTo(std::chrono::nanoseconds time);
+    // Virtual time of the earliest pending publish, stream injection or MD reply timeout.
+    [[nodiscard]] std::optional<std::chrono::nanoseconds> nextEvent();
+
+    [[nodiscard]] Stats stats();
+    // Zero the counters and the clock and drop RX streams. Open sessions are kept.
+    void reset();
+
+  private:
+    FakeTrdpStack() = default;
+};
+
+} // namespace trdp
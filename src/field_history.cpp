@@ -0,0 +1,469 @@
+#include "field_history.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+
+namespace trdp {
+
+namespace {
+
+constexpr std::size_t kMinCapacity = 16U;
+constexpr unsigned kVersionEpochShift = 40U;
+
+bool isTrackable(const FieldDef &field) {
+    if (field.arrayLength != 1U) {
+        return false;
+    }
+    switch (field.type) {
+    case FieldType::BOOL:
+    case FieldType::INT8:
+    case FieldType::UINT8:
+    case FieldType::INT16:
+    case FieldType::UINT16:
+    case FieldType::INT32:
+    case FieldType::UINT32:
+    case FieldType::FLOAT:
+    case FieldType::DOUBLE:
+        return true;
+    case FieldType::STRING:
+    case FieldType::BYTES:
+        return false;
+    }
+    return false;
+}
+
+std::size_t scalarWidth(FieldType type) {
+    switch (type) {
+    case FieldType::INT16:
+    case FieldType::UINT16:
+        return 2U;
+    case FieldType::INT32:
+    case FieldType::UINT32:
+    case FieldType::FLOAT:
+        return 4U;
+    case FieldType::DOUBLE:
+        return 8U;
+    default:
+        return 1U;
+    }
+}
+
+// Same byte layout as the engine's field codec.
+template <typename T> double load(const std::uint8_t *src) {
+    T value{};
+    std::memcpy(&value, src, sizeof(T));
+    return static_cast<double>(value);
+}
+
+// "<comId>" or "<comId>.<field>"; an empty field name selects every numeric field.
+bool parseSelection(const std::string &entry, std::uint32_t &comId, std::string &field) {
+    const auto dot = entry.find('.');
+    const auto idText = entry.substr(0, dot);
+    if (idText.empty() || idText.find_first_not_of("0123456789") != std::string::npos || idText.size() > 10U) {
+        return false;
+    }
+    const auto parsed = std::stoull(idText);
+    if (parsed > std::numeric_limits<std::uint32_t>::max()) {
+        return false;
+    }
+    comId = static_cast<std::uint32_t>(parsed);
+    field = dot == std::string::npos ? std::string() : entry.substr(dot + 1U);
+    return dot == std::string::npos || !field.empty();
+}
+
+struct Accumulator {
+    double min{std::numeric_limits<double>::infinity()};
+    double max{-std::numeric_limits<double>::infinity()};
+    double sum{0.0};
+    std::size_t count{0};
+};
+
+// Min/max/sum over a contiguous run of samples. Four independent lanes let the compiler keep the loop in SIMD
+// registers without relying on -ffast-math to reassociate a single accumulator.
+void reduceSpan(const double *values, std::size_t n, Accumulator &acc) {
+    double lo[4] = {acc.min, acc.min, acc.min, acc.min};
+    double hi[4] = {acc.max, acc.max, acc.max, acc.max};
+    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    std::size_t i = 0;
+    for (; i + 4U <= n; i += 4U) {
+        for (std::size_t lane = 0; lane < 4U; ++lane) {
+            const double v = values[i + lane];
+            lo[lane] = v < lo[lane] ? v : lo[lane];
+            hi[lane] = v > hi[lane] ? v : hi[lane];
+            sum[lane] += v;
+        }
+    }
+    for (; i < n; ++i) {
+        lo[0] = values[i] < lo[0] ? values[i] : lo[0];
+        hi[0] = values[i] > hi[0] ? values[i] : hi[0];
+        sum[0] += values[i];
+    }
+    acc.min = std::min(std::min(lo[0], lo[1]), std::min(lo[2], lo[3]));
+    acc.max = std::max(std::max(hi[0], hi[1]), std::max(hi[2], hi[3]));
+    acc.sum += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    acc.count += n;
+}
+
+} // namespace
+
+FieldHistory &FieldHistory::instance() {
+    static FieldHistory history;
+    return history;
+}
+
+bool FieldHistory::validateSelection(const std::vector<std::string> &fields, std::string &error) {
+    for (const auto &entry : fields) {
+        std::uint32_t comId = 0;
+        std::string field;
+        if (!parseSelection(entry, comId, field)) {
+            error = "Invalid field selection '" + entry + "'; expected <comId> or <comId>.<field>";
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<FieldHistory::TelegramColumns> FieldHistory::resolveSelection(const std::vector<std::string> &fields) {
+    // An empty field set selects every numeric field of the telegram.
+    std::map<std::uint32_t, std::set<std::string>> selection;
+    std::set<std::uint32_t> wholeTelegrams;
+    for (const auto &entry : fields) {
+        std::uint32_t comId = 0;
+        std::string field;
+        if (!parseSelection(entry, comId, field)) {
+            continue;
+        }
+        auto &names = selection[comId];
+        if (field.empty()) {
+            wholeTelegrams.insert(comId);
+        }
+        if (wholeTelegrams.count(comId) != 0U) {
+            names.clear();
+        } else {
+            names.insert(field);
+        }
+    }
+
+    std::vector<TelegramColumns> resolved;
+    const auto contents = TelegramRegistry::instance().snapshot();
+    for (const auto &[comId, telegram] : contents->telegrams) {
+        const auto selected = selection.find(comId);
+        if (!selection.empty() && selected == selection.end()) {
+            continue;
+        }
+        const auto *dataset = contents->findDataset(telegram->datasetName);
+        if (dataset == nullptr) {
+            continue;
+        }
+        TelegramColumns entry;
+        entry.comId = comId;
+        for (const auto &field : dataset->fields) {
+            if (!isTrackable(field)) {
+                continue;
+            }
+            if (selected != selection.end() && !selected->second.empty() &&
+                selected->second.count(field.name) == 0U) {
+                continue;
+            }
+            entry.columns.push_back(Column{field.name, field.type, field.offset});
+            entry.minPayload = std::max(entry.minPayload, field.offset + scalarWidth(field.type));
+        }
+        if (!entry.columns.empty()) {
+            resolved.push_back(std::move(entry));
+        }
+    }
+    return resolved;
+}
+
+double FieldHistory::readScalar(FieldType type, const std::uint8_t *src) {
+    switch (type) {
+    case FieldType::BOOL:
+        return *src != 0U ? 1.0 : 0.0;
+    case FieldType::INT8:
+        return load<std::int8_t>(src);
+    case FieldType::UINT8:
+        return load<std::uint8_t>(src);
+    case FieldType::INT16:
+        return load<std::int16_t>(src);
+    case FieldType::UINT16:
+        return load<std::uint16_t>(src);
+    case FieldType::INT32:
+        return load<std::int32_t>(src);
+    case FieldType::UINT32:
+        return load<std::uint32_t>(src);
+    case FieldType::FLOAT:
+        return load<float>(src);
+    case FieldType::DOUBLE:
+        return load<double>(src);
+    case FieldType::STRING:
+    case FieldType::BYTES:
+        break;
+    }
+    return 0.0;
+}
+
+std::vector<FieldHistory::Bucket> FieldHistory::makeBuckets(std::int64_t fromNs, std::int64_t toNs,
+                                                            std::size_t bucketCount) {
+    std::vector<Bucket> buckets(bucketCount);
+    const auto span = static_cast<long double>(toNs - fromNs) + 1.0L;
+    for (std::size_t b = 0; b < bucketCount; ++b) {
+        buckets[b].startNs = fromNs + static_cast<std::int64_t>(span * b / bucketCount);
+        buckets[b].endNs = fromNs + static_cast<std::int64_t>(span * (b + 1U) / bucketCount);
+    }
+    return buckets;
+}
+
+void FieldHistory::accumulate(std::vector<Bucket> &buckets, const std::int64_t *timestamps, const double *values,
+                              std::size_t n) {
+    if (buckets.empty() || n == 0U) {
+        return;
+    }
+    // Skip samples before the first bucket, then hand each bucket its contiguous run of the input.
+    std::size_t first = static_cast<std::size_t>(
+        std::lower_bound(timestamps, timestamps + n, buckets.front().startNs) - timestamps);
+    auto bucket = std::upper_bound(buckets.begin(), buckets.end(), first < n ? timestamps[first] : 0,
+                                   [](std::int64_t ns, const Bucket &entry) { return ns < entry.endNs; });
+    for (; bucket != buckets.end() && first < n; ++bucket) {
+        const auto last = static_cast<std::size_t>(
+            std::lower_bound(timestamps + first, timestamps + n, bucket->endNs) - timestamps);
+        if (last == first) {
+            continue;
+        }
+        Accumulator acc;
+        if (bucket->count > 0U) {
+            acc.min = bucket->min;
+            acc.max = bucket->max;
+            acc.sum = bucket->avg * bucket->count;
+            acc.count = bucket->count;
+        }
+        reduceSpan(values + first, last - first, acc);
+        bucket->count = static_cast<std::uint32_t>(acc.count);
+        bucket->min = acc.min;
+        bucket->max = acc.max;
+        bucket->avg = acc.sum / static_cast<double>(acc.count);
+        first = last;
+    }
+}
+
+bool FieldHistory::configure(const Config &config, std::string &error) {
+    if (!validateSelection(config.fields, error)) {
+        return false;
+    }
+
+    std::unique_lock layout(layoutMtx);
+    activeConfig = config;
+    rebuildLocked();
+    if (config.budgetBytes > 0U && rings.empty()) {
+        error = "No numeric fields selected or the budget is too small for " + std::to_string(kMinCapacity) +
+                " samples per telegram";
+        return false;
+    }
+    return true;
+}
+
+void FieldHistory::rebuild() {
+    std::unique_lock layout(layoutMtx);
+    rebuildLocked();
+}
+
+void FieldHistory::rebuildLocked() {
+    ++rebuilds;
+    rings.clear();
+    usedBytes = 0;
+    active.store(false, std::memory_order_relaxed);
+    if (activeConfig.budgetBytes == 0U) {
+        return;
+    }
+
+    const auto telegrams = resolveSelection(activeConfig.fields);
+    if (telegrams.empty()) {
+        return;
+    }
+    std::size_t rowBytes = 0;
+    for (const auto &telegram : telegrams) {
+        rowBytes += sizeof(std::int64_t) + telegram.columns.size() * sizeof(double);
+    }
+    const auto capacity = activeConfig.budgetBytes / rowBytes;
+    if (capacity < kMinCapacity) {
+        std::cerr << "[TRDP] Field history budget of " << activeConfig.budgetBytes << " bytes is too small for "
+                  << telegrams.size() << " telegrams; history disabled" << std::endl;
+        return;
+    }
+
+    for (const auto &telegram : telegrams) {
+        auto ring = std::make_unique<Ring>();
+        ring->comId = telegram.comId;
+        ring->columns = telegram.columns;
+        ring->minPayload = telegram.minPayload;
+        ring->capacity = capacity;
+        ring->version = rebuilds << kVersionEpochShift;
+        const auto bytes = capacity * (sizeof(std::int64_t) + ring->columns.size() * sizeof(double));
+        ring->storage.reset(new unsigned char[bytes]);
+        ring->timestamps = reinterpret_cast<std::int64_t *>(ring->storage.get());
+        ring->values = reinterpret_cast<double *>(ring->storage.get() + capacity * sizeof(std::int64_t));
+        std::uninitialized_value_construct_n(ring->timestamps, capacity);
+        std::uninitialized_value_construct_n(ring->values, capacity * ring->columns.size());
+        usedBytes += bytes;
+        rings.emplace(telegram.comId, std::move(ring));
+    }
+    active.store(true, std::memory_order_relaxed);
+    std::cout << "[TRDP] Field history tracking " << rings.size() << " telegrams, " << capacity
+              << " samples each (" << usedBytes / 1024U << " KiB)" << std::endl;
+}
+
+void FieldHistory::record(std::uint32_t comId, const std::uint8_t *payload, std::size_t size,
+                          std::int64_t timestampNs) {
+    if (!active.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::shared_lock layout(layoutMtx);
+    const auto it = rings.find(comId);
+    if (it == rings.end() || size < it->second->minPayload) {
+        return;
+    }
+    auto &ring = *it->second;
+    std::lock_guard lock(ring.mtx);
+    const auto row = ring.head;
+    // Rows are binary-searched by timestamp; a writer that read the clock just before another must not reorder them.
+    const auto previous = ring.count > 0U ? ring.timestamps[(row + ring.capacity - 1U) % ring.capacity] : timestampNs;
+    ring.timestamps[row] = std::max(timestampNs, previous);
+    for (std::size_t c = 0; c < ring.columns.size(); ++c) {
+        const auto &column = ring.columns[c];
+        ring.column(c)[row] = readScalar(column.type, payload + column.offset);
+    }
+    ring.head = (row + 1U) % ring.capacity;
+    ring.count = std::min(ring.count + 1U, ring.capacity);
+    ++ring.version;
+    samplesWritten.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::optional<FieldHistory::Window> FieldHistory::query(std::uint32_t comId, const std::string &field,
+                                                        std::int64_t fromNs, std::int64_t toNs,
+                                                        std::size_t bucketCount, std::string &error) {
+    std::shared_lock layout(layoutMtx);
+    const auto it = rings.find(comId);
+    if (it == rings.end()) {
+        error = "ComId " + std::to_string(comId) + " has no field history";
+        return std::nullopt;
+    }
+    auto &ring = *it->second;
+    const auto column = std::find_if(ring.columns.begin(), ring.columns.end(),
+                                     [&](const Column &entry) { return entry.name == field; });
+    if (column == ring.columns.end()) {
+        error = "Field '" + field + "' of ComId " + std::to_string(comId) + " is not tracked";
+        return std::nullopt;
+    }
+    const auto *values = ring.column(static_cast<std::size_t>(column - ring.columns.begin()));
+
+    Window window;
+    window.comId = comId;
+    window.field = field;
+    window.fromNs = fromNs;
+    window.toNs = toNs;
+
+    std::lock_guard lock(ring.mtx);
+    if (ring.count == 0U || fromNs > toNs) {
+        return window;
+    }
+    const auto capacity = ring.capacity;
+    const auto oldest = (ring.head + capacity - ring.count) % capacity;
+    const auto physical = [&](std::size_t logical) { return (oldest + logical) % capacity; };
+    window.fromNs = std::max(fromNs, ring.timestamps[oldest]);
+    window.toNs = std::min(toNs, ring.timestamps[physical(ring.count - 1U)]);
+    if (window.fromNs > window.toNs) {
+        return window;
+    }
+
+    // The logical range wraps at most once; each physical segment is sorted by time.
+    const auto straight = std::min(ring.count, capacity - oldest);
+    const std::pair<std::size_t, std::size_t> segments[2] = {{oldest, straight}, {0U, ring.count - straight}};
+
+    if (bucketCount > 0U) {
+        window.buckets = makeBuckets(window.fromNs, window.toNs, bucketCount);
+        for (const auto &[start, length] : segments) {
+            accumulate(window.buckets, ring.timestamps + start, values + start, length);
+        }
+        for (const auto &bucket : window.buckets) {
+            window.sourceSamples += bucket.count;
+        }
+        return window;
+    }
+
+    for (const auto &[start, length] : segments) {
+        const auto *ts = ring.timestamps + start;
+        const auto first = std::lower_bound(ts, ts + length, window.fromNs) - ts;
+        const auto last = std::upper_bound(ts, ts + length, window.toNs) - ts;
+        window.timestamps.insert(window.timestamps.end(), ts + first, ts + last);
+        window.values.insert(window.values.end(), values + start + first, values + start + last);
+    }
+    window.sourceSamples = window.values.size();
+    return window;
+}
+
+std::optional<FieldHistory::Span> FieldHistory::span(std::uint32_t comId, std::int64_t fromNs, std::int64_t toNs) {
+    std::shared_lock layout(layoutMtx);
+    const auto it = rings.find(comId);
+    if (it == rings.end()) {
+        return std::nullopt;
+    }
+    auto &ring = *it->second;
+    std::lock_guard lock(ring.mtx);
+    Span result;
+    result.epoch = ring.version >> kVersionEpochShift;
+    const auto capacity = ring.capacity;
+    const auto oldest = (ring.head + capacity - ring.count) % capacity;
+    const auto straight = std::min(ring.count, capacity - oldest);
+    const std::pair<std::size_t, std::size_t> segments[2] = {{oldest, straight}, {0U, ring.count - straight}};
+    for (const auto &[start, length] : segments) {
+        const auto *ts = ring.timestamps + start;
+        const auto *first = std::lower_bound(ts, ts + length, fromNs);
+        const auto *last = std::upper_bound(ts, ts + length, toNs);
+        if (first >= last) {
+            continue;
+        }
+        result.firstNs = result.samples == 0U ? *first : result.firstNs;
+        result.lastNs = *(last - 1);
+        result.samples += static_cast<std::size_t>(last - first);
+    }
+    return result;
+}
+
+std::uint64_t FieldHistory::version(std::uint32_t comId) {
+    std::shared_lock layout(layoutMtx);
+    const auto it = rings.find(comId);
+    if (it == rings.end()) {
+        return 0;
+    }
+    std::lock_guard lock(it->second->mtx);
+    return it->second->version;
+}
+
+FieldHistory::Status FieldHistory::status() {
+    std::shared_lock layout(layoutMtx);
+    Status status;
+    status.config = activeConfig;
+    status.usedBytes = usedBytes;
+    status.samplesWritten = samplesWritten.load(std::memory_order_relaxed);
+    for (const auto &[comId, ring] : rings) {
+        TelegramStatus entry;
+        entry.comId = comId;
+        for (const auto &column : ring->columns) {
+            entry.fields.push_back(column.name);
+        }
+        entry.capacity = ring->capacity;
+        entry.bytes = ring->capacity * (sizeof(std::int64_t) + ring->columns.size() * sizeof(double));
+        std::lock_guard lock(ring->mtx);
+        entry.samples = ring->count;
+        status.telegrams.push_back(std::move(entry));
+    }
+    std::sort(status.telegrams.begin(), status.telegrams.end(),
+              [](const TelegramStatus &lhs, const TelegramStatus &rhs) { return lhs.comId < rhs.comId; });
+    return status;
+}
+
+} // namespace trdp
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "telegram_model.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * Fixed-memory time-series history of numeric telegram fields.
+ *
+ * Every tracked telegram owns one contiguous block laid out as struct-of-arrays: a timestamp column followed by
+ * one double column per tracked field, all with the same capacity. Each decoded RX payload and encoded TX
+ * buffer appends one row straight from the payload bytes (no FieldValue, no allocation). The global byte budget
+ * is split so every tracked telegram keeps the same number of samples; when a ring is full the oldest row is
+ * overwritten. Window queries reduce the value columns directly, which keeps bucketing a tight loop over
+ * doubles instead of a walk over variants.
+ *
+ * BOOL, integer, FLOAT and DOUBLE fields with an array length of one can be tracked. History is disabled until
+ * configure() is called with a non-zero budget.
+ */
+class FieldHistory {
+  public:
+    struct Config {
+        std::size_t budgetBytes{0};
+        // "<comId>" tracks every numeric field of a telegram, "<comId>.<field>" a single field. Empty tracks every
+        // numeric field of every registered telegram.
+        std::vector<std::string> fields;
+    };
+
+    struct Bucket {
+        std::int64_t startNs{0};
+        std::int64_t endNs{0};
+        std::uint32_t count{0};
+        double min{0.0};
+        double max{0.0};
+        double avg{0.0};
+    };
+
+    struct Window {
+        std::uint32_t comId{0};
+        std::string field;
+        std::int64_t fromNs{0};
+        std::int64_t toNs{0};
+        // Raw samples (bucketCount == 0), oldest first.
+        std::vector<std::int64_t> timestamps;
+        std::vector<double> values;
+        // Aggregated samples (bucketCount > 0); empty buckets have count 0.
+        std::vector<Bucket> buckets;
+        // Samples in the window before downsampling; equals values.size() for raw windows.
+        std::size_t sourceSamples{0};
+    };
+
+    struct TelegramStatus {
+        std::uint32_t comId{0};
+        std::vector<std::string> fields;
+        std::size_t capacity{0};
+        std::size_t samples{0};
+        std::size_t bytes{0};
+    };
+
+    struct Status {
+        Config config;
+        std::size_t usedBytes{0};
+        std::uint64_t samplesWritten{0};
+        std::vector<TelegramStatus> telegrams;
+    };
+
+    // One tracked numeric field: where it sits in the dataset payload and how to decode it.
+    struct Column {
+        std::string name;
+        FieldType type{FieldType::UINT8};
+        std::size_t offset{0};
+    };
+
+    struct TelegramColumns {
+        std::uint32_t comId{0};
+        std::vector<Column> columns;
+        // Smallest payload that holds every column.
+        std::size_t minPayload{0};
+    };
+
+    static FieldHistory &instance();
+
+    // Field selection helpers shared with the on-disk history store (see Config::fields for the syntax).
+    static bool validateSelection(const std::vector<std::string> &fields, std::string &error);
+    static std::vector<TelegramColumns> resolveSelection(const std::vector<std::string> &fields);
+    static double readScalar(FieldType type, const std::uint8_t *src);
+
+    // bucketCount equal-width buckets covering [fromNs, toNs], and a min/max/avg fold of time-ordered samples
+    // into them. accumulate() can be called repeatedly to merge several sorted runs.
+    static std::vector<Bucket> makeBuckets(std::int64_t fromNs, std::int64_t toNs, std::size_t bucketCount);
+    static void accumulate(std::vector<Bucket> &buckets, const std::int64_t *timestamps, const double *values,
+                           std::size_t n);
+
+    // Apply a new budget/field selection and rebuild the rings from the registry. Existing samples are dropped.
+    bool configure(const Config &config, std::string &error);
+    // Rebuild the rings for the current registry contents (called when the engine (re)builds its endpoints).
+    void rebuild();
+
+    // Append one sample row for comId decoded from a dataset payload, stamped with the engine's wall time
+    // (EngineClock::wallNs). Cheap no-op for untracked telegrams.
+    void record(std::uint32_t comId, const std::uint8_t *payload, std::size_t size, std::int64_t timestampNs);
+
+    // Samples of comId.field between fromNs and toNs (nanoseconds since the epoch, on the engine clock), either raw
+    // or reduced into bucketCount equal-width buckets. Returns nullopt with a reason when the field is not tracked.
+    std::optional<Window> query(std::uint32_t comId, const std::string &field, std::int64_t fromNs,
+                                std::int64_t toNs, std::size_t bucketCount, std::string &error);
+
+    Status status();
+
+    // Changes whenever the samples of comId change (a new row or a rebuild); 0 when comId is not tracked.
+    std::uint64_t version(std::uint32_t comId);
+
+    // First and last sample of comId between fromNs and toNs, and the ring's rebuild epoch. Rows only enter at the
+    // newest end and leave at the oldest, so these change exactly when the window's contents do.
+    struct Span {
+        std::uint64_t epoch{0};
+        std::size_t samples{0};
+        std::int64_t firstNs{0};
+        std::int64_t lastNs{0};
+    };
+    std::optional<Span> span(std::uint32_t comId, std::int64_t fromNs, std::int64_t toNs);
+
+    [[nodiscard]] bool enabled() const noexcept { return active.load(std::memory_order_relaxed); }
+
+  private:
+    struct Ring {
+        std::uint32_t comId{0};
+        std::vector<Column> columns;
+        std::size_t capacity{0};
+        // Next row to write and number of valid rows.
+        std::size_t head{0};
+        std::size_t count{0};
+        std::size_t minPayload{0};
+        // Rebuild epoch in the upper bits, rows written in the lower ones.
+        std::uint64_t version{0};
+        // One allocation: capacity timestamps, then one value column of capacity doubles per field.
+        std::unique_ptr<unsigned char[]> storage;
+        std::int64_t *timestamps{nullptr};
+        double *values{nullptr};
+        std::mutex mtx;
+
+        double *column(std::size_t index) const { return values + index * capacity; }
+    };
+
+    FieldHistory() = default;
+    FieldHistory(const FieldHistory &) = delete;
+    FieldHistory &operator=(const FieldHistory &) = delete;
+
+    void rebuildLocked();
+
+    // Layout changes take the exclusive lock; writers and queries share it and lock the individual ring.
+    std::shared_mutex layoutMtx;
+    Config activeConfig;
+    std::unordered_map<std::uint32_t, std::unique_ptr<Ring>> rings;
+    std::size_t usedBytes{0};
+    std::uint64_t rebuilds{0};
+    std::atomic<bool> active{false};
+    std::atomic<std::uint64_t> samplesWritten{0};
+};
+
+} // namespace trdp
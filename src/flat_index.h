@@ -0,0 +1,281 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace trdp {
+
+namespace detail {
+
+// Fibonacci hashing: the top bits of comId * 2^32/phi, which spreads consecutive ComIds across the table.
+inline std::size_t comIdSlot(std::uint32_t comId, unsigned bits) {
+    return bits == 0U ? 0U : static_cast<std::size_t>((comId * 2654435769U) >> (32U - bits));
+}
+
+inline unsigned tableBits(std::size_t count) {
+    // At most half full, so probe sequences stay short.
+    unsigned bits = 1U;
+    while ((std::size_t{1} << bits) < count * 2U) {
+        ++bits;
+    }
+    return bits;
+}
+
+} // namespace detail
+
+/**
+ * Read-only index from ComId to a value, built once from the complete key set. Keys spanning a range no wider
+ * than twice their count are stored as a dense array indexed by comId - base; other key sets go into a
+ * linear-probing table at most half full. Either way a lookup touches one or two adjacent slots.
+ */
+template <typename V> class ComIdIndex {
+  public:
+    // Later duplicates of a ComId are ignored.
+    void build(const std::vector<std::pair<std::uint32_t, V>> &entries) {
+        clear();
+        if (entries.empty()) {
+            return;
+        }
+        std::uint32_t low = entries.front().first;
+        std::uint32_t high = low;
+        for (const auto &entry : entries) {
+            low = entry.first < low ? entry.first : low;
+            high = entry.first > high ? entry.first : high;
+        }
+        const std::uint64_t span = std::uint64_t{high} - low + 1U;
+        dense = span <= entries.size() * 2U;
+        if (dense) {
+            base = low;
+            slots.resize(static_cast<std::size_t>(span));
+        } else {
+            bits = detail::tableBits(entries.size());
+            slots.resize(std::size_t{1} << bits);
+        }
+        for (const auto &entry : entries) {
+            if (Slot *slot = claim(entry.first)) {
+                slot->value = entry.second;
+                ++count;
+            }
+        }
+    }
+
+    void clear() {
+        slots.clear();
+        base = 0;
+        bits = 0;
+        count = 0;
+        dense = false;
+    }
+
+    [[nodiscard]] const V *find(std::uint32_t comId) const {
+        if (slots.empty()) {
+            return nullptr;
+        }
+        if (dense) {
+            const auto offset = static_cast<std::uint64_t>(comId) - base;
+            if (comId < base || offset >= slots.size() || !slots[offset].used) {
+                return nullptr;
+            }
+            return &slots[offset].value;
+        }
+        const std::size_t mask = slots.size() - 1U;
+        for (std::size_t i = detail::comIdSlot(comId, bits);; i = (i + 1U) & mask) {
+            const auto &slot = slots[i];
+            if (!slot.used) {
+                return nullptr;
+            }
+            if (slot.key == comId) {
+                return &slot.value;
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return count; }
+    [[nodiscard]] bool isDense() const noexcept { return dense; }
+    // Bytes held by the slot array.
+    [[nodiscard]] std::size_t footprint() const noexcept { return slots.size() * sizeof(Slot); }
+
+  private:
+    struct Slot {
+        std::uint32_t key{0};
+        bool used{false};
+        V value{};
+    };
+
+    // Slot for a new key; nullptr when the key is already present.
+    Slot *claim(std::uint32_t comId) {
+        if (dense) {
+            auto &slot = slots[comId - base];
+            if (slot.used) {
+                return nullptr;
+            }
+            slot.used = true;
+            slot.key = comId;
+            return &slot;
+        }
+        const std::size_t mask = slots.size() - 1U;
+        for (std::size_t i = detail::comIdSlot(comId, bits);; i = (i + 1U) & mask) {
+            auto &slot = slots[i];
+            if (!slot.used) {
+                slot.used = true;
+                slot.key = comId;
+                return &slot;
+            }
+            if (slot.key == comId) {
+                return nullptr;
+            }
+        }
+    }
+
+    std::vector<Slot> slots;
+    std::uint32_t base{0};
+    unsigned bits{0};
+    std::size_t count{0};
+    bool dense{false};
+};
+
+/**
+ * Mutable ComId map with open addressing: entries live in one vector (so iteration is a linear walk) and a
+ * linear-probing table of positions, at most half full, finds them. Erasing moves the last entry into the gap,
+ * so references are invalidated by erase as well as by insertion.
+ */
+template <typename V> class FlatComIdMap {
+  public:
+    using Entry = std::pair<std::uint32_t, V>;
+
+    [[nodiscard]] V *find(std::uint32_t comId) {
+        const auto position = locate(comId);
+        return position == kEmpty ? nullptr : &entries[position].second;
+    }
+
+    [[nodiscard]] const V *find(std::uint32_t comId) const {
+        const auto position = locate(comId);
+        return position == kEmpty ? nullptr : &entries[position].second;
+    }
+
+    // Value for comId, inserted default-constructed when missing.
+    V &operator[](std::uint32_t comId) {
+        if (auto *value = find(comId)) {
+            return *value;
+        }
+        if ((entries.size() + 1U) * 2U > table.size()) {
+            rehash(detail::tableBits(entries.size() + 1U));
+        }
+        entries.emplace_back(comId, V{});
+        insertPosition(comId, static_cast<std::uint32_t>(entries.size() - 1U));
+        return entries.back().second;
+    }
+
+    bool erase(std::uint32_t comId) {
+        if (table.empty()) {
+            return false;
+        }
+        const std::size_t mask = table.size() - 1U;
+        std::size_t i = detail::comIdSlot(comId, bits);
+        while (table[i] != kEmpty && entries[table[i]].first != comId) {
+            i = (i + 1U) & mask;
+        }
+        if (table[i] == kEmpty) {
+            return false;
+        }
+        const auto position = table[i];
+        removeSlot(i);
+        const auto last = static_cast<std::uint32_t>(entries.size() - 1U);
+        if (position != last) {
+            // The last entry takes the erased entry's place; repoint its slot.
+            std::size_t j = detail::comIdSlot(entries[last].first, bits);
+            while (table[j] != last) {
+                j = (j + 1U) & mask;
+            }
+            table[j] = position;
+            entries[position] = std::move(entries[last]);
+        }
+        entries.pop_back();
+        return true;
+    }
+
+    // Erase every entry for which pred(comId, value) is true.
+    template <typename Pred> void eraseIf(Pred pred) {
+        for (std::size_t i = 0; i < entries.size();) {
+            if (pred(entries[i].first, entries[i].second)) {
+                erase(entries[i].first);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    void clear() {
+        entries.clear();
+        table.clear();
+        bits = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return entries.size(); }
+    [[nodiscard]] bool empty() const noexcept { return entries.empty(); }
+
+    auto begin() { return entries.begin(); }
+    auto end() { return entries.end(); }
+    auto begin() const { return entries.begin(); }
+    auto end() const { return entries.end(); }
+
+  private:
+    static constexpr std::uint32_t kEmpty = 0xFFFFFFFFU;
+
+    std::uint32_t locate(std::uint32_t comId) const {
+        if (table.empty()) {
+            return kEmpty;
+        }
+        const std::size_t mask = table.size() - 1U;
+        for (std::size_t i = detail::comIdSlot(comId, bits);; i = (i + 1U) & mask) {
+            if (table[i] == kEmpty || entries[table[i]].first == comId) {
+                return table[i];
+            }
+        }
+    }
+
+    void insertPosition(std::uint32_t comId, std::uint32_t position) {
+        const std::size_t mask = table.size() - 1U;
+        std::size_t i = detail::comIdSlot(comId, bits);
+        while (table[i] != kEmpty) {
+            i = (i + 1U) & mask;
+        }
+        table[i] = position;
+    }
+
+    // Backward-shift deletion: later members of the probe run move up so no tombstones are needed.
+    void removeSlot(std::size_t hole) {
+        const std::size_t mask = table.size() - 1U;
+        std::size_t i = hole;
+        for (;;) {
+            i = (i + 1U) & mask;
+            if (table[i] == kEmpty) {
+                break;
+            }
+            const auto home = detail::comIdSlot(entries[table[i]].first, bits);
+            // Move the slot unless its home lies cyclically in (hole, i].
+            const bool stays = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+            if (!stays) {
+                table[hole] = table[i];
+                hole = i;
+            }
+        }
+        table[hole] = kEmpty;
+    }
+
+    void rehash(unsigned newBits) {
+        bits = newBits;
+        table.assign(std::size_t{1} << bits, kEmpty);
+        for (std::size_t position = 0; position < entries.size(); ++position) {
+            insertPosition(entries[position].first, static_cast<std::uint32_t>(position));
+        }
+    }
+
+    std::vector<Entry> entries;
+    std::vector<std::uint32_t> table;
+    unsigned bits{0};
+};
+
+} // namespace trdp
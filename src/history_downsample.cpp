@@ -0,0 +1,395 @@
+#include "history_downsample.h"
+
+#include "history_store.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace trdp {
+
+namespace {
+
+// Sum of a contiguous run; four accumulators keep the adds independent so the loop vectorizes.
+double sumSpan(const double *values, std::size_t n) {
+    double sum[4] = {0.0, 0.0, 0.0, 0.0};
+    std::size_t i = 0;
+    for (; i + 4U <= n; i += 4U) {
+        for (std::size_t lane = 0; lane < 4U; ++lane) {
+            sum[lane] += values[i + lane];
+        }
+    }
+    for (; i < n; ++i) {
+        sum[0] += values[i];
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+// Index of the sample in [first, last) that spans the largest triangle with (ax, ay) and (bx, by). The doubled
+// area |(x - ax) * (by - ay) - (bx - ax) * (y - ay)| is evaluated in four lanes.
+std::size_t largestTriangle(const double *x, const double *y, std::size_t first, std::size_t last, double ax,
+                            double ay, double bx, double by) {
+    const double dx = bx - ax;
+    const double dy = by - ay;
+    double best[4] = {-1.0, -1.0, -1.0, -1.0};
+    std::size_t bestIndex[4] = {first, first, first, first};
+    std::size_t i = first;
+    for (; i + 4U <= last; i += 4U) {
+        for (std::size_t lane = 0; lane < 4U; ++lane) {
+            const auto j = i + lane;
+            const double area = std::fabs((x[j] - ax) * dy - dx * (y[j] - ay));
+            const bool larger = area > best[lane];
+            best[lane] = larger ? area : best[lane];
+            bestIndex[lane] = larger ? j : bestIndex[lane];
+        }
+    }
+    for (; i < last; ++i) {
+        const double area = std::fabs((x[i] - ax) * dy - dx * (y[i] - ay));
+        if (area > best[0]) {
+            best[0] = area;
+            bestIndex[0] = i;
+        }
+    }
+    std::size_t lane = 0;
+    for (std::size_t candidate = 1; candidate < 4U; ++candidate) {
+        // Prefer the earlier sample on ties so the result does not depend on the lane split.
+        if (best[candidate] > best[lane] ||
+            (best[candidate] == best[lane] && bestIndex[candidate] < bestIndex[lane])) {
+            lane = candidate;
+        }
+    }
+    return bestIndex[lane];
+}
+
+// LTTB over samples fed in time order; total, the number of samples that will be fed, fixes the buckets up front
+// exactly as for a stored window. Only the bucket being decided and the one after it (whose average is the third
+// triangle corner) are buffered. Samples beyond total are ignored.
+class LttbStream {
+  public:
+    LttbStream(std::size_t total, std::size_t points, std::vector<std::int64_t> &outTimestamps,
+               std::vector<double> &outValues)
+        : total(total), points(points), outTimestamps(outTimestamps), outValues(outValues),
+          every(total > points && points >= 3U ? static_cast<double>(total - 2U) / static_cast<double>(points - 2U)
+                                                : 0.0) {
+        outTimestamps.clear();
+        outValues.clear();
+        outTimestamps.reserve(std::min(total, points));
+        outValues.reserve(std::min(total, points));
+    }
+
+    void push(const std::int64_t *timestamps, const double *values, std::size_t n) {
+        for (std::size_t i = 0; i < n && seen < total; ++i, ++seen) {
+            lastTimestamp = timestamps[i];
+            lastValue = values[i];
+            if (every == 0.0) {
+                // Nothing to reduce: pass the first points samples through.
+                if (outValues.size() < points) {
+                    emit(timestamps[i], values[i]);
+                }
+                continue;
+            }
+            if (seen == 0U) {
+                origin = timestamps[i];
+                ay = values[i];
+                emit(timestamps[i], values[i]);
+                continue;
+            }
+            bufferTimestamps.push_back(timestamps[i]);
+            bufferX.push_back(static_cast<double>(timestamps[i] - origin));
+            bufferY.push_back(values[i]);
+            decideReadyBuckets();
+        }
+    }
+
+    void finish() {
+        if (every != 0.0 && seen > 1U) {
+            emit(lastTimestamp, lastValue);
+        }
+    }
+
+  private:
+    std::size_t boundary(std::size_t bucket) const {
+        return static_cast<std::size_t>(std::floor(static_cast<double>(bucket) * every)) + 1U;
+    }
+
+    // Bucket b covers [boundary(b), boundary(b + 1)) and is decided once the next bucket has been seen in full.
+    void decideReadyBuckets() {
+        while (bucket + 2U < points) {
+            const auto last = std::min(boundary(bucket + 1U), total - 1U);
+            const auto nextLast = std::min(boundary(bucket + 2U), total);
+            if (seen + 1U < nextLast) {
+                return;
+            }
+            const auto first = base;
+            const auto nextCount = static_cast<double>(nextLast - last);
+            const double bx = sumSpan(bufferX.data() + (last - base), nextLast - last) / nextCount;
+            const double by = sumSpan(bufferY.data() + (last - base), nextLast - last) / nextCount;
+            const auto chosen =
+                largestTriangle(bufferX.data(), bufferY.data(), first - base, last - base, ax, ay, bx, by);
+            ax = bufferX[chosen];
+            ay = bufferY[chosen];
+            emit(bufferTimestamps[chosen], bufferY[chosen]);
+            const auto done = static_cast<std::ptrdiff_t>(last - base);
+            bufferTimestamps.erase(bufferTimestamps.begin(), bufferTimestamps.begin() + done);
+            bufferX.erase(bufferX.begin(), bufferX.begin() + done);
+            bufferY.erase(bufferY.begin(), bufferY.begin() + done);
+            base = last;
+            ++bucket;
+        }
+    }
+
+    void emit(std::int64_t timestamp, double value) {
+        outTimestamps.push_back(timestamp);
+        outValues.push_back(value);
+    }
+
+    const std::size_t total;
+    const std::size_t points;
+    std::vector<std::int64_t> &outTimestamps;
+    std::vector<double> &outValues;
+    // Samples per bucket; 0 when the stream is passed through unreduced.
+    const double every;
+    std::size_t seen{0};
+    std::size_t bucket{0};
+    // Stream position of the first buffered sample.
+    std::size_t base{1};
+    std::int64_t origin{0};
+    // Offsets from the first sample keep nanosecond timestamps exact enough as doubles.
+    std::vector<std::int64_t> bufferTimestamps;
+    std::vector<double> bufferX;
+    std::vector<double> bufferY;
+    // Previously chosen point, the first corner of the next triangle.
+    double ax{0.0};
+    double ay{0.0};
+    std::int64_t lastTimestamp{0};
+    double lastValue{0.0};
+};
+
+// Min/max decimation over samples fed in time order between firstNs and lastNs: one pixel column per two output
+// points, equal width in time, each contributing its min and max in time order. Keeps one column's extremes.
+class MinMaxStream {
+  public:
+    MinMaxStream(std::size_t total, std::int64_t firstNs, std::int64_t lastNs, std::size_t points,
+                 std::vector<std::int64_t> &outTimestamps, std::vector<double> &outValues)
+        : points(points), reduce(total > points && points >= 2U), outTimestamps(outTimestamps), outValues(outValues) {
+        outTimestamps.clear();
+        outValues.clear();
+        if (reduce) {
+            columns = FieldHistory::makeBuckets(firstNs, lastNs, points / 2U);
+        }
+    }
+
+    void push(const std::int64_t *timestamps, const double *values, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i, ++position) {
+            if (!reduce) {
+                if (outValues.size() < points) {
+                    emit(timestamps[i], values[i]);
+                }
+                continue;
+            }
+            while (column < columns.size() && timestamps[i] >= columns[column].endNs) {
+                flush();
+                ++column;
+            }
+            if (column == columns.size()) {
+                return;
+            }
+            // Strict comparisons keep the earliest of equal extremes.
+            if (!filled || values[i] < low.value) {
+                low = Sample{position, timestamps[i], values[i]};
+            }
+            if (!filled || values[i] > high.value) {
+                high = Sample{position, timestamps[i], values[i]};
+            }
+            filled = true;
+        }
+    }
+
+    void finish() { flush(); }
+
+  private:
+    struct Sample {
+        std::size_t position{0};
+        std::int64_t timestamp{0};
+        double value{0.0};
+    };
+
+    void flush() {
+        if (!filled) {
+            return;
+        }
+        const auto &earlier = low.position <= high.position ? low : high;
+        const auto &later = low.position <= high.position ? high : low;
+        emit(earlier.timestamp, earlier.value);
+        if (later.position != earlier.position) {
+            emit(later.timestamp, later.value);
+        }
+        filled = false;
+    }
+
+    void emit(std::int64_t timestamp, double value) {
+        outTimestamps.push_back(timestamp);
+        outValues.push_back(value);
+    }
+
+    const std::size_t points;
+    const bool reduce;
+    std::vector<std::int64_t> &outTimestamps;
+    std::vector<double> &outValues;
+    std::vector<FieldHistory::Bucket> columns;
+    std::size_t column{0};
+    std::size_t position{0};
+    bool filled{false};
+    Sample low;
+    Sample high;
+};
+
+} // namespace
+
+HistoryDownsampler &HistoryDownsampler::instance() {
+    static HistoryDownsampler downsampler;
+    return downsampler;
+}
+
+std::optional<HistoryDownsampler::Mode> HistoryDownsampler::parseMode(const std::string &value) {
+    if (value.empty() || value == "lttb") {
+        return Mode::Lttb;
+    }
+    if (value == "minmax") {
+        return Mode::MinMax;
+    }
+    return std::nullopt;
+}
+
+std::string HistoryDownsampler::modeToString(Mode mode) { return mode == Mode::MinMax ? "minmax" : "lttb"; }
+
+void HistoryDownsampler::lttb(const std::vector<std::int64_t> &timestamps, const std::vector<double> &values,
+                              std::size_t points, std::vector<std::int64_t> &outTimestamps,
+                              std::vector<double> &outValues) {
+    LttbStream stream(values.size(), points, outTimestamps, outValues);
+    stream.push(timestamps.data(), values.data(), values.size());
+    stream.finish();
+}
+
+void HistoryDownsampler::minMax(const std::vector<std::int64_t> &timestamps, const std::vector<double> &values,
+                                std::size_t points, std::vector<std::int64_t> &outTimestamps,
+                                std::vector<double> &outValues) {
+    MinMaxStream stream(values.size(), timestamps.empty() ? 0 : timestamps.front(),
+                        timestamps.empty() ? 0 : timestamps.back(), points, outTimestamps, outValues);
+    stream.push(timestamps.data(), values.data(), values.size());
+    stream.finish();
+}
+
+std::optional<FieldHistory::Window> HistoryDownsampler::query(const Request &request, std::string &error) {
+    if (request.points < 3U || request.points > kMaxPoints) {
+        error = "points must be between 3 and " + std::to_string(kMaxPoints);
+        return std::nullopt;
+    }
+    auto key = std::to_string(static_cast<int>(request.source)) + '/' + std::to_string(request.comId) + '/' +
+               request.field + '/' + std::to_string(request.fromNs) + '/' + std::to_string(request.toNs) + '/' +
+               std::to_string(request.points) + '/' + modeToString(request.mode);
+    // Rings gain a row with every sample, so their entries are told apart by what falls inside the window; the
+    // store's version only moves when a chunk is sealed. Either is read before the data: a concurrent update then
+    // only makes the entry look older than it is.
+    std::uint64_t version = 0;
+    if (request.source == Source::Store) {
+        version = HistoryStore::instance().version(request.comId);
+    } else if (const auto span = FieldHistory::instance().span(request.comId, request.fromNs, request.toNs)) {
+        key += '/' + std::to_string(span->epoch) + '/' + std::to_string(span->samples) + '/' +
+               std::to_string(span->firstNs) + '/' + std::to_string(span->lastNs);
+    }
+    {
+        std::lock_guard lock(mtx);
+        const auto it = cache.find(key);
+        if (it != cache.end() && it->second->version == version) {
+            lru.splice(lru.begin(), lru, it->second);
+            ++hits;
+            return it->second->window;
+        }
+    }
+
+    auto window = request.source == Source::Store ? reduceStored(request, error) : reduceRings(request, error);
+    if (!window) {
+        return std::nullopt;
+    }
+
+    std::lock_guard lock(mtx);
+    ++misses;
+    if (const auto it = cache.find(key); it != cache.end()) {
+        lru.erase(it->second);
+        cache.erase(it);
+    }
+    lru.push_front(CacheEntry{key, version, *window});
+    cache.emplace(key, lru.begin());
+    if (lru.size() > kCacheEntries) {
+        cache.erase(lru.back().key);
+        lru.pop_back();
+    }
+    return window;
+}
+
+std::optional<FieldHistory::Window> HistoryDownsampler::reduceRings(const Request &request, std::string &error) {
+    auto window =
+        FieldHistory::instance().query(request.comId, request.field, request.fromNs, request.toNs, 0U, error);
+    if (!window) {
+        return std::nullopt;
+    }
+    std::vector<std::int64_t> timestamps;
+    std::vector<double> values;
+    if (request.mode == Mode::MinMax) {
+        minMax(window->timestamps, window->values, request.points, timestamps, values);
+    } else {
+        lttb(window->timestamps, window->values, request.points, timestamps, values);
+    }
+    window->timestamps.swap(timestamps);
+    window->values.swap(values);
+    return window;
+}
+
+std::optional<FieldHistory::Window> HistoryDownsampler::reduceStored(const Request &request, std::string &error) {
+    auto &store = HistoryStore::instance();
+    // Counting first fixes the LTTB buckets; the scan is bounded by the last counted sample so chunks sealed in
+    // between do not join the stream.
+    const auto extent = store.extent(request.comId, request.field, request.fromNs, request.toNs, error);
+    if (!extent) {
+        return std::nullopt;
+    }
+    FieldHistory::Window window;
+    window.comId = request.comId;
+    window.field = request.field;
+    window.fromNs = extent->samples > 0U ? extent->firstNs : request.fromNs;
+    window.toNs = extent->samples > 0U ? extent->lastNs : request.toNs;
+    window.sourceSamples = extent->samples;
+    if (extent->samples == 0U) {
+        return window;
+    }
+    bool scanned = false;
+    if (request.mode == Mode::MinMax) {
+        MinMaxStream stream(extent->samples, extent->firstNs, extent->lastNs, request.points, window.timestamps,
+                            window.values);
+        scanned = store.scan(request.comId, request.field, extent->firstNs, extent->lastNs,
+                             [&stream](const std::int64_t *timestamps, const double *values, std::size_t n) {
+                                 stream.push(timestamps, values, n);
+                             },
+                             error);
+        stream.finish();
+    } else {
+        LttbStream stream(extent->samples, request.points, window.timestamps, window.values);
+        scanned = store.scan(request.comId, request.field, extent->firstNs, extent->lastNs,
+                             [&stream](const std::int64_t *timestamps, const double *values, std::size_t n) {
+                                 stream.push(timestamps, values, n);
+                             },
+                             error);
+        stream.finish();
+    }
+    if (!scanned) {
+        return std::nullopt;
+    }
+    return window;
+}
+
+HistoryDownsampler::CacheStats HistoryDownsampler::cacheStats() {
+    std::lock_guard lock(mtx);
+    return CacheStats{lru.size(), hits, misses};
+}
+
+} // namespace trdp
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "field_history.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * Chart-sized views of field history.
+ *
+ * A window is reduced to at most `points` samples, either with Largest-Triangle-Three-Buckets (keeps the visual
+ * shape) or per-pixel min/max decimation (keeps every extreme). Both consume samples as a stream in time order and
+ * buffer at most two LTTB buckets, so a window of the on-disk store is reduced chunk by chunk as it is decoded,
+ * however many samples it holds; ring windows are fetched raw first. The bucket scans run in four-lane loops.
+ *
+ * Results are kept in a small LRU cache keyed by source, field, requested window, resolution and mode. Ring
+ * entries also carry the first and last sample inside the window, so a chart of a past window keeps hitting
+ * while the telegram is still being recorded; store entries carry the store's version, which only changes when
+ * a chunk is sealed.
+ */
+class HistoryDownsampler {
+  public:
+    enum class Mode { Lttb, MinMax };
+    enum class Source { Rings, Store };
+
+    static constexpr std::size_t kMaxPoints = 100000U;
+
+    struct Request {
+        Source source{Source::Rings};
+        std::uint32_t comId{0};
+        std::string field;
+        std::int64_t fromNs{0};
+        std::int64_t toNs{0};
+        std::size_t points{0};
+        Mode mode{Mode::Lttb};
+    };
+
+    struct CacheStats {
+        std::size_t entries{0};
+        std::uint64_t hits{0};
+        std::uint64_t misses{0};
+    };
+
+    static HistoryDownsampler &instance();
+
+    // Raw window reduced to at most request.points samples. Returns nullopt with a reason when the field is unknown
+    // to the source.
+    std::optional<FieldHistory::Window> query(const Request &request, std::string &error);
+    CacheStats cacheStats();
+
+    // Reduce time-ordered samples to at most points samples (in time order) into outTimestamps/outValues.
+    static void lttb(const std::vector<std::int64_t> &timestamps, const std::vector<double> &values,
+                     std::size_t points, std::vector<std::int64_t> &outTimestamps, std::vector<double> &outValues);
+    static void minMax(const std::vector<std::int64_t> &timestamps, const std::vector<double> &values,
+                       std::size_t points, std::vector<std::int64_t> &outTimestamps, std::vector<double> &outValues);
+
+    static std::optional<Mode> parseMode(const std::string &value);
+    static std::string modeToString(Mode mode);
+
+  private:
+    static constexpr std::size_t kCacheEntries = 64U;
+
+    struct CacheEntry {
+        std::string key;
+        std::uint64_t version{0};
+        FieldHistory::Window window;
+    };
+
+    HistoryDownsampler() = default;
+
+    // Ring windows are fetched raw and then reduced; store windows are reduced while their chunks are decoded.
+    static std::optional<FieldHistory::Window> reduceRings(const Request &request, std::string &error);
+    static std::optional<FieldHistory::Window> reduceStored(const Request &request, std::string &error);
+    HistoryDownsampler(const HistoryDownsampler &) = delete;
+    HistoryDownsampler &operator=(const HistoryDownsampler &) = delete;
+
+    std::mutex mtx;
+    // Most recently used first.
+    std::list<CacheEntry> lru;
+    std::unordered_map<std::string, std::list<CacheEntry>::iterator> cache;
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};
+};
+
+} // namespace trdp
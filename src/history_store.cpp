@@ -0,0 +1,991 @@
+#include "history_store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace trdp {
+
+namespace {
+
+constexpr std::uint32_t kSchemaMagic = 0x53485254U; // "TRHS"
+constexpr std::uint32_t kChunkMagic = 0x43485254U;  // "TRHC"
+constexpr std::uint32_t kKindSchema = 1U;
+constexpr std::uint32_t kKindChunk = 2U;
+constexpr std::size_t kGrowBytes = 64U * 1024U * 1024U;
+constexpr std::size_t kRecordHeader = 16U;
+constexpr std::size_t kMaxRawSamples = 2000000U;
+constexpr auto kWriterPoll = std::chrono::milliseconds(50);
+constexpr unsigned kVersionEpochShift = 40U;
+
+struct SchemaHeader {
+    std::uint32_t magic;
+    std::uint32_t bytes;
+    std::uint32_t comId;
+    std::uint32_t schemaId;
+    std::uint32_t columns;
+    std::uint32_t reserved;
+};
+
+struct ChunkHeader {
+    std::uint32_t magic;
+    std::uint32_t bytes;
+    std::uint32_t comId;
+    std::uint32_t schemaId;
+    std::uint32_t rows;
+    std::uint32_t columns;
+    std::int64_t firstNs;
+    std::int64_t lastNs;
+};
+
+// Location of one encoded column inside a chunk, relative to the chunk start.
+struct ColumnRef {
+    std::uint32_t offset;
+    std::uint32_t words;
+};
+
+static_assert(sizeof(SchemaHeader) == 24U && sizeof(ChunkHeader) == 40U && sizeof(ColumnRef) == 8U,
+              "history store records must not contain padding");
+
+std::size_t roundUp(std::size_t value, std::size_t multiple) { return (value + multiple - 1U) / multiple * multiple; }
+
+// MSB-first bit stream packed into 64-bit words.
+class BitWriter {
+  public:
+    void clear() {
+        words.clear();
+        used = 64U;
+    }
+
+    void write(std::uint64_t value, unsigned bits) {
+        while (bits > 0U) {
+            if (used == 64U) {
+                words.push_back(0U);
+                used = 0U;
+            }
+            const unsigned take = std::min(bits, 64U - used);
+            std::uint64_t part = value >> (bits - take);
+            if (take < 64U) {
+                part &= (std::uint64_t{1} << take) - 1U;
+            }
+            words.back() |= take == 64U ? part : part << (64U - used - take);
+            used += take;
+            bits -= take;
+        }
+    }
+
+    const std::vector<std::uint64_t> &data() const { return words; }
+
+  private:
+    std::vector<std::uint64_t> words;
+    unsigned used{64U};
+};
+
+class BitReader {
+  public:
+    BitReader(const std::uint8_t *data, std::size_t wordCount) : base(data), bitCount(wordCount * 64U) {}
+
+    std::uint64_t read(unsigned bits) {
+        std::uint64_t result = 0;
+        while (bits > 0U) {
+            if (pos >= bitCount) {
+                exhausted = true;
+                return result;
+            }
+            std::uint64_t word = 0;
+            std::memcpy(&word, base + (pos / 64U) * 8U, sizeof(word));
+            const auto offset = static_cast<unsigned>(pos % 64U);
+            const unsigned take = std::min(bits, 64U - offset);
+            const std::uint64_t part = (word << offset) >> (64U - take);
+            result = take == 64U ? part : (result << take) | part;
+            pos += take;
+            bits -= take;
+        }
+        return result;
+    }
+
+    bool failed() const { return exhausted; }
+
+  private:
+    const std::uint8_t *base;
+    std::size_t bitCount;
+    std::size_t pos{0};
+    bool exhausted{false};
+};
+
+std::int64_t signExtend(std::uint64_t value, unsigned bits) {
+    const auto shift = 64U - bits;
+    return static_cast<std::int64_t>(value << shift) >> shift;
+}
+
+// Delta-of-delta timestamps. Gorilla's bucket widths target second-resolution timestamps; these are widened for
+// nanoseconds, where cycle jitter alone spans thousands of ticks.
+class TimestampEncoder {
+  public:
+    void clear() {
+        out.clear();
+        rows = 0;
+        prevDelta = 0;
+    }
+
+    void append(std::int64_t ns) {
+        if (rows++ == 0U) {
+            out.write(static_cast<std::uint64_t>(ns), 64U);
+            prev = ns;
+            return;
+        }
+        const auto delta = ns - prev;
+        const auto dod = delta - prevDelta;
+        prev = ns;
+        prevDelta = delta;
+        if (dod == 0) {
+            out.write(0b0U, 1U);
+        } else if (dod >= -(1LL << 15) && dod < (1LL << 15)) {
+            out.write(0b10U, 2U);
+            out.write(static_cast<std::uint64_t>(dod), 16U);
+        } else if (dod >= -(1LL << 23) && dod < (1LL << 23)) {
+            out.write(0b110U, 3U);
+            out.write(static_cast<std::uint64_t>(dod), 24U);
+        } else if (dod >= -(1LL << 31) && dod < (1LL << 31)) {
+            out.write(0b1110U, 4U);
+            out.write(static_cast<std::uint64_t>(dod), 32U);
+        } else {
+            out.write(0b1111U, 4U);
+            out.write(static_cast<std::uint64_t>(dod), 64U);
+        }
+    }
+
+    BitWriter out;
+
+  private:
+    std::uint32_t rows{0};
+    std::int64_t prev{0};
+    std::int64_t prevDelta{0};
+};
+
+bool decodeTimestamps(BitReader &in, std::uint32_t rows, std::vector<std::int64_t> &out) {
+    out.resize(rows);
+    std::int64_t prev = 0;
+    std::int64_t delta = 0;
+    for (std::uint32_t row = 0; row < rows; ++row) {
+        if (row == 0U) {
+            prev = static_cast<std::int64_t>(in.read(64U));
+            out[row] = prev;
+            continue;
+        }
+        std::int64_t dod = 0;
+        if (in.read(1U) != 0U) {
+            if (in.read(1U) == 0U) {
+                dod = signExtend(in.read(16U), 16U);
+            } else if (in.read(1U) == 0U) {
+                dod = signExtend(in.read(24U), 24U);
+            } else if (in.read(1U) == 0U) {
+                dod = signExtend(in.read(32U), 32U);
+            } else {
+                dod = static_cast<std::int64_t>(in.read(64U));
+            }
+        }
+        delta += dod;
+        prev += delta;
+        out[row] = prev;
+    }
+    return !in.failed();
+}
+
+// Gorilla XOR compression of doubles: identical values cost one bit, slowly changing ones only their
+// meaningful (non-zero) XOR bits.
+class ValueEncoder {
+  public:
+    void clear() {
+        out.clear();
+        rows = 0;
+        leading = kNoWindow;
+        trailing = 0U;
+    }
+
+    void append(double value) {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        if (rows++ == 0U) {
+            out.write(bits, 64U);
+            prev = bits;
+            return;
+        }
+        const auto diff = bits ^ prev;
+        prev = bits;
+        if (diff == 0U) {
+            out.write(0b0U, 1U);
+            return;
+        }
+        const auto lead = static_cast<unsigned>(__builtin_clzll(diff));
+        const auto trail = static_cast<unsigned>(__builtin_ctzll(diff));
+        if (leading != kNoWindow && lead >= leading && trail >= trailing) {
+            out.write(0b10U, 2U);
+            out.write(diff >> trailing, 64U - leading - trailing);
+            return;
+        }
+        leading = lead;
+        trailing = trail;
+        const auto meaningful = 64U - leading - trailing;
+        out.write(0b11U, 2U);
+        out.write(leading, 6U);
+        out.write(meaningful - 1U, 6U);
+        out.write(diff >> trailing, meaningful);
+    }
+
+    BitWriter out;
+
+  private:
+    std::uint32_t rows{0};
+    std::uint64_t prev{0};
+    static constexpr unsigned kNoWindow = 65U;
+    unsigned leading{kNoWindow};
+    unsigned trailing{0U};
+};
+
+bool decodeValues(BitReader &in, std::uint32_t rows, std::vector<double> &out) {
+    out.resize(rows);
+    std::uint64_t prev = 0;
+    unsigned leading = 0;
+    unsigned trailing = 0;
+    for (std::uint32_t row = 0; row < rows; ++row) {
+        if (row == 0U) {
+            prev = in.read(64U);
+        } else if (in.read(1U) != 0U) {
+            if (in.read(1U) != 0U) {
+                leading = static_cast<unsigned>(in.read(6U));
+                const auto meaningful = static_cast<unsigned>(in.read(6U)) + 1U;
+                if (leading + meaningful > 64U) {
+                    return false;
+                }
+                trailing = 64U - leading - meaningful;
+            }
+            prev ^= in.read(64U - leading - trailing) << trailing;
+        }
+        std::memcpy(&out[row], &prev, sizeof(double));
+    }
+    return !in.failed();
+}
+
+} // namespace
+
+struct HistoryStore::ChunkBuilder {
+    std::uint32_t comId{0};
+    std::uint32_t schemaId{0};
+    std::vector<FieldHistory::Column> columns;
+    std::size_t minPayload{0};
+    std::uint32_t rows{0};
+    std::int64_t firstNs{0};
+    std::int64_t lastNs{0};
+    std::chrono::steady_clock::time_point openedAt{};
+    TimestampEncoder timestamps;
+    std::vector<ValueEncoder> values;
+
+    void append(std::int64_t ns, const std::uint8_t *payload) {
+        if (rows == 0U) {
+            firstNs = ns;
+            openedAt = std::chrono::steady_clock::now();
+        }
+        lastNs = ns;
+        ++rows;
+        timestamps.append(ns);
+        for (std::size_t c = 0; c < columns.size(); ++c) {
+            values[c].append(FieldHistory::readScalar(columns[c].type, payload + columns[c].offset));
+        }
+    }
+
+    void reset() {
+        rows = 0;
+        timestamps.clear();
+        for (auto &column : values) {
+            column.clear();
+        }
+    }
+};
+
+HistoryStore &HistoryStore::instance() {
+    static HistoryStore store;
+    return store;
+}
+
+HistoryStore::~HistoryStore() { stop(); }
+
+bool HistoryStore::start(const Config &config, std::string &error) {
+    std::lock_guard control(controlMtx);
+    if (running.load()) {
+        error = "History store already running";
+        return false;
+    }
+    if (config.directory.empty()) {
+        error = "History store directory is required";
+        return false;
+    }
+    if (config.chunkRows < 16U || config.chunkRows > (1U << 20U)) {
+        error = "chunkRows must be between 16 and 1048576";
+        return false;
+    }
+    if (config.sealAfter.count() <= 0) {
+        error = "sealAfter must be positive";
+        return false;
+    }
+    if (config.queueBytes < 64U * 1024U) {
+        error = "Queue must hold at least 64 KiB";
+        return false;
+    }
+    if (!FieldHistory::validateSelection(config.fields, error)) {
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(config.directory, ec);
+    if (ec) {
+        error = "Cannot create " + config.directory + ": " + ec.message();
+        return false;
+    }
+
+    activeConfig = config;
+    if (!openFiles(error)) {
+        closeFiles();
+        return false;
+    }
+    resolveSchemas();
+    if (builders.empty()) {
+        closeFiles();
+        error = "No numeric fields selected for the history store";
+        return false;
+    }
+
+    {
+        std::lock_guard lock(queueMtx);
+        queue.assign(config.queueBytes, 0U);
+        queueUsed = 0;
+        lastQueuedNs = 0;
+        telegrams = 0;
+        dropped = 0;
+        stopRequested = false;
+        layoutChanged = false;
+    }
+    running.store(true);
+    worker = std::thread([this]() { writerLoop(); });
+    std::cout << "[TRDP] History store writing " << builders.size() << " telegrams to " << config.directory
+              << std::endl;
+    return true;
+}
+
+void HistoryStore::stop() {
+    std::lock_guard control(controlMtx);
+    if (!running.load()) {
+        return;
+    }
+    running.store(false);
+    {
+        std::lock_guard lock(queueMtx);
+        stopRequested = true;
+    }
+    queueCv.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    builders.clear();
+    {
+        std::lock_guard lock(queueMtx);
+        tracked.clear();
+        std::vector<std::uint8_t>().swap(queue);
+        queueUsed = 0;
+    }
+    closeFiles();
+}
+
+void HistoryStore::rebuild() {
+    if (!running.load()) {
+        return;
+    }
+    {
+        std::lock_guard lock(queueMtx);
+        layoutChanged = true;
+    }
+    queueCv.notify_all();
+}
+
+void HistoryStore::record(std::uint32_t comId, const std::uint8_t *payload, std::size_t size,
+                          std::int64_t timestampNs) {
+    if (!running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard lock(queueMtx);
+    const auto it = tracked.find(comId);
+    if (it == tracked.end() || size < it->second) {
+        return;
+    }
+    // Only the bytes that carry tracked columns are queued.
+    const auto payloadBytes = it->second;
+    const auto recordBytes = kRecordHeader + roundUp(payloadBytes, 8U);
+    ++telegrams;
+    if (queueUsed + recordBytes > queue.size()) {
+        ++dropped;
+        return;
+    }
+    // Clamped under the queue lock so records reach the writer in timestamp order.
+    const auto ns = std::max(timestampNs, lastQueuedNs);
+    lastQueuedNs = ns;
+    auto *dst = queue.data() + queueUsed;
+    const auto size32 = static_cast<std::uint32_t>(payloadBytes);
+    std::memcpy(dst, &comId, sizeof(comId));
+    std::memcpy(dst + 4U, &size32, sizeof(size32));
+    std::memcpy(dst + 8U, &ns, sizeof(ns));
+    std::memcpy(dst + kRecordHeader, payload, payloadBytes);
+    queueUsed += recordBytes;
+}
+
+void HistoryStore::writerLoop() {
+    std::vector<std::uint8_t> batch(activeConfig.queueBytes);
+    for (;;) {
+        std::size_t used = 0;
+        bool stopping = false;
+        bool relayout = false;
+        {
+            std::unique_lock lock(queueMtx);
+            queueCv.wait_for(lock, kWriterPoll, [this]() { return stopRequested || layoutChanged; });
+            // Hand the filled buffer to the writer and give producers the empty one.
+            queue.swap(batch);
+            used = queueUsed;
+            queueUsed = 0;
+            stopping = stopRequested;
+            relayout = layoutChanged;
+            layoutChanged = false;
+        }
+
+        drain(batch, used);
+        const auto now = std::chrono::steady_clock::now();
+        for (auto &[comId, builder] : builders) {
+            if (builder->rows > 0U && (stopping || relayout || now - builder->openedAt >= activeConfig.sealAfter)) {
+                seal(*builder);
+            }
+        }
+        if (stopping) {
+            return;
+        }
+        if (relayout) {
+            resolveSchemas();
+        }
+    }
+}
+
+void HistoryStore::drain(const std::vector<std::uint8_t> &batch, std::size_t used) {
+    std::size_t pos = 0;
+    while (pos + kRecordHeader <= used) {
+        std::uint32_t comId = 0;
+        std::uint32_t size = 0;
+        std::int64_t ns = 0;
+        std::memcpy(&comId, batch.data() + pos, sizeof(comId));
+        std::memcpy(&size, batch.data() + pos + 4U, sizeof(size));
+        std::memcpy(&ns, batch.data() + pos + 8U, sizeof(ns));
+        const auto *payload = batch.data() + pos + kRecordHeader;
+        pos += kRecordHeader + roundUp(size, 8U);
+
+        const auto it = builders.find(comId);
+        // Records queued before a layout change may no longer match the columns.
+        if (it == builders.end() || size < it->second->minPayload) {
+            continue;
+        }
+        auto &builder = *it->second;
+        builder.append(ns, payload);
+        if (builder.rows >= activeConfig.chunkRows) {
+            seal(builder);
+        }
+    }
+}
+
+void HistoryStore::resolveSchemas() {
+    builders.clear();
+    std::unordered_map<std::uint32_t, std::size_t> resolved;
+    for (auto &telegram : FieldHistory::resolveSelection(activeConfig.fields)) {
+        auto builder = std::make_unique<ChunkBuilder>();
+        builder->comId = telegram.comId;
+        builder->minPayload = telegram.minPayload;
+        builder->columns = telegram.columns;
+        builder->values.resize(telegram.columns.size());
+
+        // Reuse the latest schema of the ComId when the column layout is unchanged.
+        const auto latest = latestSchema.find(telegram.comId);
+        const auto sameLayout = [&](const Schema &schema) {
+            return std::equal(schema.columns.begin(), schema.columns.end(), telegram.columns.begin(),
+                              telegram.columns.end(), [](const auto &lhs, const auto &rhs) {
+                                  return lhs.name == rhs.name && lhs.type == rhs.type && lhs.offset == rhs.offset;
+                              });
+        };
+        if (latest != latestSchema.end() && sameLayout(schemas.at(latest->second))) {
+            builder->schemaId = latest->second;
+        } else {
+            builder->schemaId = nextSchemaId;
+            std::vector<std::uint8_t> block(sizeof(SchemaHeader));
+            for (const auto &column : telegram.columns) {
+                const auto nameBytes = std::min<std::size_t>(column.name.size(), 255U);
+                const auto offset32 = static_cast<std::uint32_t>(column.offset);
+                const auto base = block.size();
+                block.resize(base + 6U + nameBytes);
+                std::memcpy(block.data() + base, &offset32, sizeof(offset32));
+                block[base + 4U] = static_cast<std::uint8_t>(column.type);
+                block[base + 5U] = static_cast<std::uint8_t>(nameBytes);
+                std::memcpy(block.data() + base + 6U, column.name.data(), nameBytes);
+            }
+            block.resize(roundUp(block.size(), 8U));
+            const SchemaHeader header{kSchemaMagic, static_cast<std::uint32_t>(block.size()), telegram.comId,
+                                      builder->schemaId, static_cast<std::uint32_t>(telegram.columns.size()), 0U};
+            std::memcpy(block.data(), &header, sizeof(header));
+
+            Schema schema;
+            schema.id = builder->schemaId;
+            schema.comId = telegram.comId;
+            schema.columns = telegram.columns;
+            IndexEntry entry;
+            entry.kind = kKindSchema;
+            entry.comId = telegram.comId;
+            entry.schemaId = builder->schemaId;
+            if (!append(entry, block, &schema)) {
+                continue;
+            }
+            ++nextSchemaId;
+        }
+        resolved.emplace(telegram.comId, telegram.minPayload);
+        builders.emplace(telegram.comId, std::move(builder));
+    }
+    std::lock_guard lock(queueMtx);
+    tracked.swap(resolved);
+}
+
+void HistoryStore::seal(ChunkBuilder &builder) {
+    const auto columnCount = builder.values.size();
+    auto size = sizeof(ChunkHeader) + (columnCount + 1U) * sizeof(ColumnRef);
+    std::vector<ColumnRef> refs;
+    refs.reserve(columnCount + 1U);
+    const auto addColumn = [&](const BitWriter &writer) {
+        refs.push_back(ColumnRef{static_cast<std::uint32_t>(size), static_cast<std::uint32_t>(writer.data().size())});
+        size += writer.data().size() * sizeof(std::uint64_t);
+    };
+    addColumn(builder.timestamps.out);
+    for (const auto &column : builder.values) {
+        addColumn(column.out);
+    }
+
+    std::vector<std::uint8_t> block(size);
+    const ChunkHeader header{kChunkMagic,   static_cast<std::uint32_t>(size),
+                             builder.comId, builder.schemaId,
+                             builder.rows,  static_cast<std::uint32_t>(columnCount),
+                             builder.firstNs, builder.lastNs};
+    std::memcpy(block.data(), &header, sizeof(header));
+    std::memcpy(block.data() + sizeof(header), refs.data(), refs.size() * sizeof(ColumnRef));
+    const auto copyColumn = [&](const ColumnRef &ref, const BitWriter &writer) {
+        std::memcpy(block.data() + ref.offset, writer.data().data(), writer.data().size() * sizeof(std::uint64_t));
+    };
+    copyColumn(refs[0], builder.timestamps.out);
+    for (std::size_t c = 0; c < columnCount; ++c) {
+        copyColumn(refs[c + 1U], builder.values[c].out);
+    }
+
+    IndexEntry entry;
+    entry.kind = kKindChunk;
+    entry.comId = builder.comId;
+    entry.schemaId = builder.schemaId;
+    entry.rows = builder.rows;
+    entry.firstNs = builder.firstNs;
+    entry.lastNs = builder.lastNs;
+    (void)append(entry, block, nullptr);
+    builder.reset();
+}
+
+bool HistoryStore::append(const IndexEntry &pending, const std::vector<std::uint8_t> &block, Schema *schema) {
+    auto entry = pending;
+    entry.offset = dataEnd;
+    entry.bytes = block.size();
+    const auto fail = [&](const std::string &what) {
+        std::cerr << "[TRDP] History store: " << what << ": " << std::strerror(errno) << std::endl;
+        std::unique_lock lock(storeMtx);
+        lastError = what;
+        return false;
+    };
+
+    if (dataEnd + block.size() > mappedBytes) {
+        // Only the writer grows the file; readers are excluded while the mapping moves.
+        const auto grown = roundUp(dataEnd + block.size(), kGrowBytes);
+        std::unique_lock lock(storeMtx);
+        ::munmap(mapped, mappedBytes);
+        mapped = nullptr;
+        if (::ftruncate(dataFd, static_cast<off_t>(grown)) != 0) {
+            lock.unlock();
+            return fail("cannot grow history.dat");
+        }
+        void *area = ::mmap(nullptr, grown, PROT_READ | PROT_WRITE, MAP_SHARED, dataFd, 0);
+        if (area == MAP_FAILED) {
+            lock.unlock();
+            return fail("cannot map history.dat");
+        }
+        mapped = static_cast<std::uint8_t *>(area);
+        mappedBytes = grown;
+    }
+    if (mapped == nullptr) {
+        return false;
+    }
+    // Bytes past dataEnd are not referenced by the index yet, so readers never see a partial block.
+    std::memcpy(mapped + dataEnd, block.data(), block.size());
+    if (::write(indexFd, &entry, sizeof(entry)) != static_cast<ssize_t>(sizeof(entry))) {
+        return fail("cannot append to history.idx");
+    }
+
+    std::unique_lock lock(storeMtx);
+    dataEnd += block.size();
+    if (schema != nullptr) {
+        latestSchema[entry.comId] = entry.schemaId;
+        schemas[entry.schemaId] = std::move(*schema);
+    } else {
+        chunkIndex[entry.comId].push_back(entry);
+        ++chunkCount;
+        rowCount += entry.rows;
+        rawBytes += static_cast<std::uint64_t>(entry.rows) * 8U * (1U + schemas.at(entry.schemaId).columns.size());
+    }
+    return true;
+}
+
+bool HistoryStore::openFiles(std::string &error) {
+    const auto dir = std::filesystem::path(activeConfig.directory);
+    const auto dataPath = (dir / "history.dat").string();
+    const auto indexPath = (dir / "history.idx").string();
+    dataFd = ::open(dataPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    indexFd = ::open(indexPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (dataFd < 0 || indexFd < 0) {
+        error = "Cannot open history files in " + activeConfig.directory + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat dataStat {};
+    struct stat indexStat {};
+    if (::fstat(dataFd, &dataStat) != 0 || ::fstat(indexFd, &indexStat) != 0) {
+        error = std::string("Cannot stat history files: ") + std::strerror(errno);
+        return false;
+    }
+    const auto fileBytes = static_cast<std::size_t>(dataStat.st_size);
+    mappedBytes = std::max(roundUp(fileBytes, kGrowBytes), kGrowBytes);
+    if (fileBytes < mappedBytes && ::ftruncate(dataFd, static_cast<off_t>(mappedBytes)) != 0) {
+        error = std::string("Cannot size history.dat: ") + std::strerror(errno);
+        return false;
+    }
+    void *area = ::mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, dataFd, 0);
+    if (area == MAP_FAILED) {
+        error = std::string("Cannot map history.dat: ") + std::strerror(errno);
+        mappedBytes = 0;
+        return false;
+    }
+    mapped = static_cast<std::uint8_t *>(area);
+
+    // Replay the index; stop at the first entry that does not describe a complete block at the expected offset.
+    std::vector<IndexEntry> entries(static_cast<std::size_t>(indexStat.st_size) / sizeof(IndexEntry));
+    if (!entries.empty() &&
+        ::pread(indexFd, entries.data(), entries.size() * sizeof(IndexEntry), 0) !=
+            static_cast<ssize_t>(entries.size() * sizeof(IndexEntry))) {
+        error = std::string("Cannot read history.idx: ") + std::strerror(errno);
+        return false;
+    }
+    std::unique_lock lock(storeMtx);
+    ++opens;
+    dataEnd = 0;
+    std::size_t valid = 0;
+    for (const auto &entry : entries) {
+        // Schema blocks of short field names are smaller than a chunk header.
+        const std::size_t minBytes = entry.kind == kKindSchema ? sizeof(SchemaHeader) : sizeof(ChunkHeader);
+        if (entry.offset != dataEnd || entry.bytes < minBytes || entry.offset + entry.bytes > fileBytes) {
+            break;
+        }
+        const auto *block = mapped + entry.offset;
+        std::uint32_t magic = 0;
+        std::memcpy(&magic, block, sizeof(magic));
+        if (entry.kind == kKindSchema && magic == kSchemaMagic) {
+            SchemaHeader header{};
+            std::memcpy(&header, block, sizeof(header));
+            Schema schema;
+            schema.id = header.schemaId;
+            schema.comId = header.comId;
+            std::size_t pos = sizeof(SchemaHeader);
+            bool ok = true;
+            for (std::uint32_t c = 0; c < header.columns && ok; ++c) {
+                if (pos + 6U > entry.bytes || pos + 6U + block[pos + 5U] > entry.bytes) {
+                    ok = false;
+                    break;
+                }
+                std::uint32_t offset = 0;
+                std::memcpy(&offset, block + pos, sizeof(offset));
+                FieldHistory::Column column;
+                column.offset = offset;
+                column.type = static_cast<FieldType>(block[pos + 4U]);
+                column.name.assign(reinterpret_cast<const char *>(block + pos + 6U), block[pos + 5U]);
+                schema.columns.push_back(std::move(column));
+                pos += 6U + block[pos + 5U];
+            }
+            if (!ok) {
+                break;
+            }
+            latestSchema[schema.comId] = schema.id;
+            nextSchemaId = std::max(nextSchemaId, schema.id + 1U);
+            schemas[schema.id] = std::move(schema);
+        } else if (entry.kind == kKindChunk && magic == kChunkMagic && schemas.count(entry.schemaId) != 0U) {
+            chunkIndex[entry.comId].push_back(entry);
+            ++chunkCount;
+            rowCount += entry.rows;
+            rawBytes += static_cast<std::uint64_t>(entry.rows) * 8U * (1U + schemas.at(entry.schemaId).columns.size());
+        } else {
+            break;
+        }
+        dataEnd += entry.bytes;
+        ++valid;
+    }
+    if (valid != entries.size()) {
+        std::cerr << "[TRDP] History store: dropping " << (entries.size() - valid) << " incomplete index entries"
+                  << std::endl;
+        if (::ftruncate(indexFd, static_cast<off_t>(valid * sizeof(IndexEntry))) != 0) {
+            error = std::string("Cannot truncate history.idx: ") + std::strerror(errno);
+            return false;
+        }
+    }
+    ::lseek(indexFd, 0, SEEK_END);
+    lastError.clear();
+    filesOpen = true;
+    return true;
+}
+
+void HistoryStore::closeFiles() {
+    std::unique_lock lock(storeMtx);
+    if (mapped != nullptr) {
+        ::munmap(mapped, mappedBytes);
+        mapped = nullptr;
+    }
+    if (dataFd >= 0) {
+        // Drop the unused tail of the last growth step (never on a half-opened store, whose dataEnd is unknown).
+        if (filesOpen) {
+            (void)::ftruncate(dataFd, static_cast<off_t>(dataEnd));
+        }
+        ::close(dataFd);
+        dataFd = -1;
+    }
+    if (indexFd >= 0) {
+        ::close(indexFd);
+        indexFd = -1;
+    }
+    filesOpen = false;
+    mappedBytes = 0;
+    dataEnd = 0;
+    nextSchemaId = 1;
+    schemas.clear();
+    latestSchema.clear();
+    chunkIndex.clear();
+    chunkCount = 0;
+    rowCount = 0;
+    rawBytes = 0;
+}
+
+const std::vector<HistoryStore::IndexEntry> *HistoryStore::chunksOf(std::uint32_t comId, std::string &error) const {
+    if (mapped == nullptr) {
+        error = "History store is not running";
+        return nullptr;
+    }
+    const auto it = chunkIndex.find(comId);
+    if (it == chunkIndex.end() || it->second.empty()) {
+        error = "ComId " + std::to_string(comId) + " has no stored history";
+        return nullptr;
+    }
+    return &it->second;
+}
+
+std::optional<std::size_t> HistoryStore::columnOf(const IndexEntry &chunk, const std::string &field) const {
+    const auto &columns = schemas.at(chunk.schemaId).columns;
+    const auto column = std::find_if(columns.begin(), columns.end(),
+                                     [&](const FieldHistory::Column &entry) { return entry.name == field; });
+    if (column == columns.end()) {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(column - columns.begin());
+}
+
+bool HistoryStore::decodeChunk(const IndexEntry &chunk, std::size_t column, std::vector<std::int64_t> &timestamps,
+                               std::vector<double> *values, std::string &error) const {
+    const auto *block = mapped + chunk.offset;
+    ChunkHeader header{};
+    std::memcpy(&header, block, sizeof(header));
+    ColumnRef tsRef{};
+    ColumnRef valueRef{};
+    std::memcpy(&tsRef, block + sizeof(ChunkHeader), sizeof(ColumnRef));
+    std::memcpy(&valueRef, block + sizeof(ChunkHeader) + (column + 1U) * sizeof(ColumnRef), sizeof(ColumnRef));
+    const bool ok = header.columns == schemas.at(chunk.schemaId).columns.size() &&
+                    tsRef.offset + tsRef.words * 8ULL <= chunk.bytes &&
+                    valueRef.offset + valueRef.words * 8ULL <= chunk.bytes;
+    BitReader tsReader(block + tsRef.offset, ok ? tsRef.words : 0U);
+    BitReader valueReader(block + valueRef.offset, ok ? valueRef.words : 0U);
+    if (!ok || !decodeTimestamps(tsReader, header.rows, timestamps) ||
+        (values != nullptr && !decodeValues(valueReader, header.rows, *values))) {
+        error = "Corrupt chunk at offset " + std::to_string(chunk.offset);
+        return false;
+    }
+    return true;
+}
+
+std::optional<FieldHistory::Window> HistoryStore::query(std::uint32_t comId, const std::string &field,
+                                                        std::int64_t fromNs, std::int64_t toNs,
+                                                        std::size_t bucketCount, std::string &error) {
+    FieldHistory::Window window;
+    window.comId = comId;
+    window.field = field;
+    {
+        std::shared_lock lock(storeMtx);
+        const auto *chunks = chunksOf(comId, error);
+        if (chunks == nullptr) {
+            return std::nullopt;
+        }
+        window.fromNs = std::max(fromNs, chunks->front().firstNs);
+        window.toNs = std::min(toNs, chunks->back().lastNs);
+    }
+    if (bucketCount > 0U && window.fromNs <= window.toNs) {
+        window.buckets = FieldHistory::makeBuckets(window.fromNs, window.toNs, bucketCount);
+    }
+
+    bool tooMany = false;
+    const auto collect = [&](const std::int64_t *timestamps, const double *values, std::size_t n) {
+        if (bucketCount > 0U) {
+            FieldHistory::accumulate(window.buckets, timestamps, values, n);
+            return;
+        }
+        tooMany = tooMany || window.values.size() + n > kMaxRawSamples;
+        if (!tooMany) {
+            window.timestamps.insert(window.timestamps.end(), timestamps, timestamps + n);
+            window.values.insert(window.values.end(), values, values + n);
+        }
+    };
+    if (!scan(comId, field, window.fromNs, window.toNs, collect, error)) {
+        return std::nullopt;
+    }
+    if (tooMany) {
+        error = "Window holds more than " + std::to_string(kMaxRawSamples) + " samples; request buckets";
+        return std::nullopt;
+    }
+    window.sourceSamples = window.values.size();
+    for (const auto &bucket : window.buckets) {
+        window.sourceSamples += bucket.count;
+    }
+    return window;
+}
+
+std::optional<HistoryStore::Extent> HistoryStore::extent(std::uint32_t comId, const std::string &field,
+                                                         std::int64_t fromNs, std::int64_t toNs, std::string &error) {
+    std::shared_lock lock(storeMtx);
+    const auto *chunks = chunksOf(comId, error);
+    if (chunks == nullptr) {
+        return std::nullopt;
+    }
+    // Chunks of one ComId are sealed in time order, so lastNs is sorted as well.
+    auto chunk = std::lower_bound(chunks->begin(), chunks->end(), fromNs,
+                                  [](const IndexEntry &entry, std::int64_t ns) { return entry.lastNs < ns; });
+    bool fieldStored = false;
+    Extent result;
+    std::vector<std::int64_t> timestamps;
+    const auto include = [&](std::size_t samples, std::int64_t firstNs, std::int64_t lastNs) {
+        if (samples == 0U) {
+            return;
+        }
+        result.firstNs = result.samples == 0U ? firstNs : result.firstNs;
+        result.lastNs = lastNs;
+        result.samples += samples;
+    };
+    for (; chunk != chunks->end() && chunk->firstNs <= toNs; ++chunk) {
+        const auto column = columnOf(*chunk, field);
+        if (!column) {
+            continue;
+        }
+        fieldStored = true;
+        if (chunk->firstNs >= fromNs && chunk->lastNs <= toNs) {
+            include(chunk->rows, chunk->firstNs, chunk->lastNs);
+            continue;
+        }
+        if (!decodeChunk(*chunk, *column, timestamps, nullptr, error)) {
+            return std::nullopt;
+        }
+        const auto first = std::lower_bound(timestamps.begin(), timestamps.end(), fromNs);
+        const auto last = std::upper_bound(timestamps.begin(), timestamps.end(), toNs);
+        if (first < last) {
+            include(static_cast<std::size_t>(last - first), *first, *(last - 1));
+        }
+    }
+    if (!fieldStored) {
+        error = "Field '" + field + "' of ComId " + std::to_string(comId) + " is not stored";
+        return std::nullopt;
+    }
+    return result;
+}
+
+bool HistoryStore::scan(std::uint32_t comId, const std::string &field, std::int64_t fromNs, std::int64_t toNs,
+                        const SampleVisitor &visit, std::string &error) {
+    std::shared_lock lock(storeMtx);
+    const auto *chunks = chunksOf(comId, error);
+    if (chunks == nullptr) {
+        return false;
+    }
+    auto chunk = std::lower_bound(chunks->begin(), chunks->end(), fromNs,
+                                  [](const IndexEntry &entry, std::int64_t ns) { return entry.lastNs < ns; });
+    bool fieldStored = false;
+    // Reused across chunks: decoding a window allocates for the largest chunk only.
+    std::vector<std::int64_t> timestamps;
+    std::vector<double> values;
+    for (; chunk != chunks->end() && chunk->firstNs <= toNs; ++chunk) {
+        const auto column = columnOf(*chunk, field);
+        if (!column) {
+            continue;
+        }
+        fieldStored = true;
+        if (!decodeChunk(*chunk, *column, timestamps, &values, error)) {
+            return false;
+        }
+        const auto first = std::lower_bound(timestamps.begin(), timestamps.end(), fromNs) - timestamps.begin();
+        const auto last = std::upper_bound(timestamps.begin(), timestamps.end(), toNs) - timestamps.begin();
+        if (first < last) {
+            visit(timestamps.data() + first, values.data() + first, static_cast<std::size_t>(last - first));
+        }
+    }
+    if (!fieldStored) {
+        error = "Field '" + field + "' of ComId " + std::to_string(comId) + " is not stored";
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t HistoryStore::version(std::uint32_t comId) {
+    std::shared_lock lock(storeMtx);
+    const auto it = chunkIndex.find(comId);
+    return (opens << kVersionEpochShift) + (it == chunkIndex.end() ? 0U : it->second.size());
+}
+
+HistoryStore::Status HistoryStore::status() {
+    Status status;
+    status.running = running.load();
+    {
+        std::lock_guard lock(queueMtx);
+        status.telegrams = telegrams;
+        status.dropped = dropped;
+        status.queuedBytes = queueUsed;
+        for (const auto &[comId, minPayload] : tracked) {
+            status.comIds.push_back(comId);
+        }
+    }
+    std::sort(status.comIds.begin(), status.comIds.end());
+    std::shared_lock lock(storeMtx);
+    status.config = activeConfig;
+    status.chunks = chunkCount;
+    status.rows = rowCount;
+    status.diskBytes = dataEnd;
+    status.rawBytes = rawBytes;
+    status.error = lastError;
+    return status;
+}
+
+} // namespace trdp
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "field_history.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * Append-only on-disk history of numeric telegram fields for long soak runs.
+ *
+ * The codec path only copies the raw payload into a preallocated in-memory queue (record()); a background writer
+ * thread decodes it into one column per field and compresses each column Gorilla-style: delta-of-delta
+ * timestamps and XOR-encoded doubles. When a telegram's open chunk reaches chunkRows samples or sealAfter, it is
+ * sealed as an immutable chunk at the end of a memory-mapped data file and its time range is appended to an
+ * index file. Queries consult the index for the chunks overlapping the window and decode only the timestamp
+ * column and the requested field's column of each.
+ *
+ * Files in Config::directory: history.dat (schema records and chunks) and history.idx (fixed-size index
+ * entries). Reopening a directory continues the existing history; entries that point past the committed data
+ * (e.g. after a crash) are dropped.
+ */
+class HistoryStore {
+  public:
+    struct Config {
+        std::string directory;
+        // Same syntax as FieldHistory::Config::fields; empty stores every numeric field of every telegram.
+        std::vector<std::string> fields;
+        std::uint32_t chunkRows{4096};
+        std::chrono::seconds sealAfter{60};
+        // Capacity of the queue between the codec path and the writer; telegrams are dropped when it is full.
+        std::size_t queueBytes{8U * 1024U * 1024U};
+    };
+
+    struct Status {
+        bool running{false};
+        Config config;
+        std::uint64_t telegrams{0};
+        std::uint64_t dropped{0};
+        std::uint64_t chunks{0};
+        std::uint64_t rows{0};
+        // Encoded bytes on disk versus the uncompressed 8-byte timestamp + 8 bytes per value.
+        std::uint64_t diskBytes{0};
+        std::uint64_t rawBytes{0};
+        std::size_t queuedBytes{0};
+        std::vector<std::uint32_t> comIds;
+        std::string error;
+    };
+
+    static HistoryStore &instance();
+
+    // Open (or create) the store in config.directory and start the writer. Returns false with a reason in error.
+    bool start(const Config &config, std::string &error);
+    // Seal all open chunks and close the files.
+    void stop();
+    Status status();
+
+    // Re-resolve the tracked fields after the registry changed; open chunks are sealed first.
+    void rebuild();
+
+    // Queue one telegram payload for comId, stamped with the engine's wall time (EngineClock::wallNs). Never blocks
+    // on disk; cheap no-op when the store is closed.
+    void record(std::uint32_t comId, const std::uint8_t *payload, std::size_t size, std::int64_t timestampNs);
+
+    // Samples of comId.field stored between fromNs and toNs, raw or reduced into bucketCount buckets. Open
+    // (not yet sealed) chunks are not visible.
+    std::optional<FieldHistory::Window> query(std::uint32_t comId, const std::string &field, std::int64_t fromNs,
+                                              std::int64_t toNs, std::size_t bucketCount, std::string &error);
+
+    // Consecutive time-ordered runs of samples, one per decoded chunk.
+    using SampleVisitor = std::function<void(const std::int64_t *timestamps, const double *values, std::size_t n)>;
+
+    // Number and time range of the samples scan() visits for the same arguments. Only the chunks at the edges of
+    // the window are decoded; the others are counted from the index.
+    struct Extent {
+        std::size_t samples{0};
+        std::int64_t firstNs{0};
+        std::int64_t lastNs{0};
+    };
+    std::optional<Extent> extent(std::uint32_t comId, const std::string &field, std::int64_t fromNs,
+                                 std::int64_t toNs, std::string &error);
+    // Hand the samples of comId.field between fromNs and toNs to visit chunk by chunk, without collecting them,
+    // so windows of any size can be reduced. Returns false with a reason like query().
+    bool scan(std::uint32_t comId, const std::string &field, std::int64_t fromNs, std::int64_t toNs,
+              const SampleVisitor &visit, std::string &error);
+
+    // Changes whenever a chunk of comId is sealed or the store is reopened.
+    std::uint64_t version(std::uint32_t comId);
+
+    [[nodiscard]] bool active() const noexcept { return running.load(std::memory_order_relaxed); }
+
+  private:
+    struct Schema {
+        std::uint32_t id{0};
+        std::uint32_t comId{0};
+        std::vector<FieldHistory::Column> columns;
+    };
+
+    struct IndexEntry {
+        std::uint32_t kind{0};
+        std::uint32_t comId{0};
+        std::uint32_t schemaId{0};
+        std::uint32_t rows{0};
+        std::uint64_t offset{0};
+        std::uint64_t bytes{0};
+        std::int64_t firstNs{0};
+        std::int64_t lastNs{0};
+    };
+
+    struct ChunkBuilder;
+
+    HistoryStore() = default;
+    ~HistoryStore();
+    HistoryStore(const HistoryStore &) = delete;
+    HistoryStore &operator=(const HistoryStore &) = delete;
+
+    bool openFiles(std::string &error);
+    void closeFiles();
+    void writerLoop();
+    void drain(const std::vector<std::uint8_t> &batch, std::size_t used);
+    void resolveSchemas();
+    void seal(ChunkBuilder &builder);
+    // Write a block at the end of the data file and publish it: schema blocks pass their decoded schema.
+    bool append(const IndexEntry &entry, const std::vector<std::uint8_t> &block, Schema *schema);
+    // The helpers below expect storeMtx to be held.
+    // Sealed chunks of comId, oldest first; nullptr with a reason when there are none.
+    const std::vector<IndexEntry> *chunksOf(std::uint32_t comId, std::string &error) const;
+    // Position of field among the columns of chunk's schema; nullopt when that schema does not store it.
+    std::optional<std::size_t> columnOf(const IndexEntry &chunk, const std::string &field) const;
+    // Decode the timestamps of chunk and, unless values is nullptr, its column.
+    bool decodeChunk(const IndexEntry &chunk, std::size_t column, std::vector<std::int64_t> &timestamps,
+                     std::vector<double> *values, std::string &error) const;
+
+    std::mutex controlMtx;
+
+    // Queue between the codec path and the writer: [comId u32][size u32][timestamp i64][payload, 8-byte padded].
+    std::mutex queueMtx;
+    std::condition_variable queueCv;
+    std::vector<std::uint8_t> queue;
+    std::size_t queueUsed{0};
+    // Later records are clamped to it so the writer sees timestamps in order.
+    std::int64_t lastQueuedNs{0};
+    std::uint64_t telegrams{0};
+    std::uint64_t dropped{0};
+    bool stopRequested{false};
+    bool layoutChanged{false};
+    // ComIds accepted by record(), with the smallest payload that carries every column.
+    std::unordered_map<std::uint32_t, std::size_t> tracked;
+
+    std::atomic<bool> running{false};
+    std::thread worker;
+    Config activeConfig;
+
+    // Writer-thread state.
+    std::map<std::uint32_t, std::unique_ptr<ChunkBuilder>> builders;
+
+    // Guards the mapping, the index and the schemas; the writer takes it exclusively to publish a sealed chunk.
+    std::shared_mutex storeMtx;
+    int dataFd{-1};
+    int indexFd{-1};
+    bool filesOpen{false};
+    std::uint64_t opens{0};
+    std::uint8_t *mapped{nullptr};
+    std::size_t mappedBytes{0};
+    std::uint64_t dataEnd{0};
+    std::uint32_t nextSchemaId{1};
+    std::unordered_map<std::uint32_t, Schema> schemas;
+    std::unordered_map<std::uint32_t, std::uint32_t> latestSchema;
+    std::unordered_map<std::uint32_t, std::vector<IndexEntry>> chunkIndex;
+    std::uint64_t chunkCount{0};
+    std::uint64_t rowCount{0};
+    std::uint64_t rawBytes{0};
+    std::string lastError;
+};
+
+} // namespace trdp
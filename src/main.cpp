@@ -1,6 +1,12 @@
+#include "config_image.h"
+#include "field_history.h"
+#include "history_store.h"
 #include "plugins/TelegramHub.h"
+#include "realtime.h"
+#include "traffic_generator.h"
 #include "trdp_engine.h"
 #include "telegram_model.h"
+#include "workspace_manager.h"
 
 #include <drogon/drogon.h>
 
@@ -12,6 +18,7 @@
 #include <filesystem>
 #include <iostream>
 #include <optional>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <arpa/inet.h>
@@ -24,10 +31,21 @@ namespace {
 struct CliOptions {
     std::uint16_t port{8080};
     std::string xmlPath;
+    std::string configImageDir;
     std::string trdpRxIface;
     std::string trdpTxIface;
     std::string trdpHostsFile;
     std::string dnrMode{"common"};
+    std::string transport{"auto"};
+    bool virtualTime{false};
+    std::uint32_t shards{1};
+    std::vector<int> shardCpus;
+    std::string rtPolicy{"other"};
+    std::uint32_t rtPriority{0};
+    int workerCpu{-1};
+    std::vector<int> appCpus;
+    bool lockMemory{false};
+    bool prefault{false};
     bool enableUriCache{true};
     std::uint32_t cacheTtlMs{30000};
     std::uint32_t cacheEntries{128};
@@ -37,6 +55,17 @@ struct CliOptions {
     bool enableEcsp{false};
     std::uint32_t ecspPollMs{1000};
     std::uint32_t ecspConfirmTimeoutMs{5000};
+    std::uint32_t generateCount{0};
+    std::uint32_t genComIdBase{60000};
+    std::uint32_t genDatasetBytes{64};
+    std::string genCycleMs{"100"};
+    std::string genPattern{"ramp"};
+    std::string genDestIp{"127.0.0.1"};
+    bool genKeepXml{false};
+    std::uint32_t genReportSeconds{5};
+    std::uint32_t historyMiB{0};
+    std::string historyFields;
+    std::string historyDir;
     bool showHelp{false};
 };
 
@@ -59,6 +88,26 @@ std::optional<std::uint32_t> parseUint(const std::string &value) {
     }
 }
 
+// Comma-separated CPU numbers, e.g. "2,3,4,5"; -1 leaves a shard unpinned.
+std::optional<std::vector<int>> parseCpuList(const std::string &value) {
+    std::vector<int> cpus;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        try {
+            std::size_t used = 0;
+            const auto cpu = std::stoi(item, &used);
+            if (used != item.size() || cpu < -1) {
+                return std::nullopt;
+            }
+            cpus.push_back(cpu);
+        } catch (const std::exception &) {
+            return std::nullopt;
+        }
+    }
+    return cpus;
+}
+
 bool parseBool(const std::string &value) {
     std::string lowered(value.size(), '\0');
     std::transform(value.begin(), value.end(), lowered.begin(), [](unsigned char c) {
@@ -101,10 +150,22 @@ void printUsage(const char *exe) {
               << "Options:\n"
               << "  --port <port>           TCP port for Drogon listener (env: PORT or DROGON_PORT)\n"
               << "  --xml <path>           Path to TRDP XML config (env: TRDP_XML_PATH)\n"
+              << "  --config-image-dir <d> Directory for compiled XML images, 'off' to always parse the XML\n"
+              << "                         (default: next to the XML; env: TRDP_CONFIG_IMAGE_DIR)\n"
               << "  --trdp-rx-iface <if>   Interface name for RX (env: TRDP_RX_IFACE)\n"
               << "  --trdp-tx-iface <if>   Interface name for TX (env: TRDP_TX_IFACE)\n"
               << "  --trdp-hosts-file <f>  Hosts file for DNR lookups (env: TRDP_HOSTS_FILE)\n"
               << "  --dnr-mode <mode>      DNR thread mode: common|dedicated (env: TRDP_DNR_MODE)\n"
+              << "  --transport <t>        TRDP transport: auto|stack|native (env: TRDP_TRANSPORT)\n"
+              << "  --virtual-time         Run the engine on a virtual clock (native transport; env: TRDP_VIRTUAL_TIME)\n"
+              << "  --shards <n>           Processing threads sharing the UDP ports (env: TRDP_SHARDS)\n"
+              << "  --shard-cpus <l>       Comma-separated CPU per shard thread (env: TRDP_SHARD_CPUS)\n"
+              << "  --rt-policy <p>        Processing thread policy: other|fifo|rr (env: TRDP_RT_POLICY)\n"
+              << "  --rt-priority <n>      Priority for fifo/rr, 1-99 (env: TRDP_RT_PRIORITY)\n"
+              << "  --worker-cpu <n>       Pin the processing thread to a CPU (env: TRDP_WORKER_CPU)\n"
+              << "  --app-cpus <l>         CPUs for the HTTP threads (default: all but the engine CPUs; env: TRDP_APP_CPUS)\n"
+              << "  --mlockall             Lock all process memory (env: TRDP_MLOCKALL)\n"
+              << "  --prefault             Touch buffers, TRDP heap and thread stacks before going live (env: TRDP_PREFAULT)\n"
               << "  --cache-ttl-ms <ms>    Cache TTL for URI/label lookups (env: TRDP_CACHE_TTL_MS)\n"
               << "  --cache-entries <n>    Maximum cached URI/label entries (env: TRDP_CACHE_ENTRIES)\n"
               << "  --disable-cache        Disable DNR lookup caching (env: TRDP_DISABLE_CACHE)\n"
@@ -114,6 +175,17 @@ void printUsage(const char *exe) {
               << "  --ecsp-confirm-ms <ms> Confirm timeout for ECSP control (env: TRDP_ECSP_CONFIRM_MS)\n"
               << "  --static-root <path>   Directory for UI assets (env: TRDP_STATIC_ROOT)\n"
               << "  --threads <n>          Worker threads for Drogon (default: hardware concurrency)\n"
+              << "  --generate <n>         Publish n synthetic TX PD telegrams instead of the XML set (env: TRDP_GENERATE)\n"
+              << "  --gen-comid-base <id>  First ComId of the generated range (default: 60000)\n"
+              << "  --gen-dataset-bytes <n> Generated dataset size in bytes (default: 64)\n"
+              << "  --gen-cycle-ms <spec>  Cycle: <ms>, <min>-<max> (uniform) or <a>,<b>,... (classes)\n"
+              << "  --gen-pattern <p>      Payload pattern: zeros|ramp|random|comid|prbs (default: ramp)\n"
+              << "  --gen-dest-ip <ip>     Destination address for generated telegrams (default: 127.0.0.1)\n"
+              << "  --gen-keep-xml         Keep the XML telegrams alongside the generated ones\n"
+              << "  --gen-report-s <s>     Log achieved vs target rate every s seconds (0 disables, default: 5)\n"
+              << "  --history-mib <n>      Field history memory budget in MiB, 0 disables (env: TRDP_HISTORY_MIB)\n"
+              << "  --history-fields <l>   Comma-separated <comId> or <comId>.<field> to track (default: all numeric)\n"
+              << "  --history-dir <path>   Also append the tracked fields to an on-disk store (env: TRDP_HISTORY_DIR)\n"
               << "  --help                 Show this help message\n";
 }
 
@@ -129,6 +201,9 @@ CliOptions parseArgs(int argc, char **argv) {
     if (auto envXml = readEnv("TRDP_XML_PATH")) {
         opts.xmlPath = *envXml;
     }
+    if (auto envImageDir = readEnv("TRDP_CONFIG_IMAGE_DIR")) {
+        opts.configImageDir = *envImageDir;
+    }
     if (auto envRx = readEnv("TRDP_RX_IFACE")) {
         opts.trdpRxIface = *envRx;
     }
@@ -141,6 +216,46 @@ CliOptions parseArgs(int argc, char **argv) {
     if (auto envDnrMode = readEnv("TRDP_DNR_MODE")) {
         opts.dnrMode = *envDnrMode;
     }
+    if (auto envTransport = readEnv("TRDP_TRANSPORT")) {
+        opts.transport = *envTransport;
+    }
+    if (auto envVirtual = readEnv("TRDP_VIRTUAL_TIME")) {
+        opts.virtualTime = parseBool(*envVirtual);
+    }
+    if (auto envShards = readEnv("TRDP_SHARDS")) {
+        if (auto parsed = parseUint(*envShards)) {
+            opts.shards = *parsed;
+        }
+    }
+    if (auto envShardCpus = readEnv("TRDP_SHARD_CPUS")) {
+        if (auto parsed = parseCpuList(*envShardCpus)) {
+            opts.shardCpus = *parsed;
+        }
+    }
+    if (auto envPolicy = readEnv("TRDP_RT_POLICY")) {
+        opts.rtPolicy = *envPolicy;
+    }
+    if (auto envPriority = readEnv("TRDP_RT_PRIORITY")) {
+        if (auto parsed = parseUint(*envPriority)) {
+            opts.rtPriority = *parsed;
+        }
+    }
+    if (auto envWorkerCpu = readEnv("TRDP_WORKER_CPU")) {
+        if (auto parsed = parseUint(*envWorkerCpu)) {
+            opts.workerCpu = static_cast<int>(*parsed);
+        }
+    }
+    if (auto envAppCpus = readEnv("TRDP_APP_CPUS")) {
+        if (auto parsed = parseCpuList(*envAppCpus)) {
+            opts.appCpus = *parsed;
+        }
+    }
+    if (auto envMlock = readEnv("TRDP_MLOCKALL")) {
+        opts.lockMemory = parseBool(*envMlock);
+    }
+    if (auto envPrefault = readEnv("TRDP_PREFAULT")) {
+        opts.prefault = parseBool(*envPrefault);
+    }
     if (auto envCacheTtl = readEnv("TRDP_CACHE_TTL_MS")) {
         if (auto parsed = parseUint(*envCacheTtl)) {
             opts.cacheTtlMs = *parsed;
@@ -173,6 +288,19 @@ CliOptions parseArgs(int argc, char **argv) {
     if (auto envStatic = readEnv("TRDP_STATIC_ROOT")) {
         opts.staticRoot = *envStatic;
     }
+    if (auto envGenerate = readEnv("TRDP_GENERATE")) {
+        if (auto parsed = parseUint(*envGenerate)) {
+            opts.generateCount = *parsed;
+        }
+    }
+    if (auto envHistory = readEnv("TRDP_HISTORY_MIB")) {
+        if (auto parsed = parseUint(*envHistory)) {
+            opts.historyMiB = *parsed;
+        }
+    }
+    if (auto envHistoryDir = readEnv("TRDP_HISTORY_DIR")) {
+        opts.historyDir = *envHistoryDir;
+    }
 
     for (int i = 1; i < argc; ++i) {
         const std::string arg = argv[i];
@@ -187,6 +315,9 @@ CliOptions parseArgs(int argc, char **argv) {
         } else if (arg == "--xml" && i + 1 < argc) {
             opts.xmlPath = argv[i + 1];
             ++i;
+        } else if (arg == "--config-image-dir" && i + 1 < argc) {
+            opts.configImageDir = argv[i + 1];
+            ++i;
         } else if (arg == "--trdp-rx-iface" && i + 1 < argc) {
             opts.trdpRxIface = argv[i + 1];
             ++i;
@@ -199,6 +330,47 @@ CliOptions parseArgs(int argc, char **argv) {
         } else if (arg == "--dnr-mode" && i + 1 < argc) {
             opts.dnrMode = argv[i + 1];
             ++i;
+        } else if (arg == "--transport" && i + 1 < argc) {
+            opts.transport = argv[i + 1];
+            ++i;
+        } else if (arg == "--virtual-time") {
+            opts.virtualTime = true;
+        } else if (arg == "--shards" && i + 1 < argc) {
+            if (auto parsed = parseUint(argv[i + 1])) {
+                opts.shards = *parsed;
+            }
+            ++i;
+        } else if (arg == "--shard-cpus" && i + 1 < argc) {
+            if (auto parsed = parseCpuList(argv[i + 1])) {
+                opts.shardCpus = *parsed;
+            } else {
+                std::cerr << "Invalid --shard-cpus value '" << argv[i + 1] << "'; shards stay unpinned" << std::endl;
+            }
+            ++i;
+        } else if (arg == "--rt-policy" && i + 1 < argc) {
+            opts.rtPolicy = argv[i + 1];
+            ++i;
+        } else if (arg == "--rt-priority" && i + 1 < argc) {
+            if (auto parsed = parseUint(argv[i + 1])) {
+                opts.rtPriority = *parsed;
+            }
+            ++i;
+        } else if (arg == "--worker-cpu" && i + 1 < argc) {
+            if (auto parsed = parseUint(argv[i + 1])) {
+                opts.workerCpu = static_cast<int>(*parsed);
+            }
+            ++i;
+        } else if (arg == "--app-cpus" && i + 1 < argc) {
+            if (auto parsed = parseCpuList(argv[i + 1])) {
+                opts.appCpus = *parsed;
+            } else {
+                std::cerr << "Invalid --app-cpus value '" << argv[i + 1] << "'; ignoring" << std::endl;
+            }
+            ++i;
+        } else if (arg == "--mlockall") {
+            opts.lockMemory = true;
+        } else if (arg == "--prefault") {
+            opts.prefault = true;
         } else if (arg == "--cache-ttl-ms" && i + 1 < argc) {
             if (auto parsed = parseUint(argv[i + 1])) {
                 opts.cacheTtlMs = *parsed;
@@ -233,6 +405,48 @@ CliOptions parseArgs(int argc, char **argv) {
         } else if (arg == "--static-root" && i + 1 < argc) {
             opts.staticRoot = argv[i + 1];
             ++i;
+        } else if (arg == "--generate" && i + 1 < argc) {
+            if (auto parsed = parseUint(argv[i + 1])) {
+                opts.generateCount = *parsed;
+            }
+            ++i;
+        } else if (arg == "--gen-comid-base" && i + 1 < argc) {
+            if (auto parsed = parseUint(argv[i + 1])) {
+                opts.genComIdBase = *parsed;
+            }
+            ++i;
+        } else if (arg == "--gen-dataset-bytes" && i + 1 < argc) {
+            if (auto parsed = parseUint(argv[i + 1])) {
+                opts.genDatasetBytes = *parsed;
+            }
+            ++i;
+        } else if (arg == "--gen-cycle-ms" && i + 1 < argc) {
+            opts.genCycleMs = argv[i + 1];
+            ++i;
+        } else if (arg == "--gen-pattern" && i + 1 < argc) {
+            opts.genPattern = argv[i + 1];
+            ++i;
+        } else if (arg == "--gen-dest-ip" && i + 1 < argc) {
+            opts.genDestIp = argv[i + 1];
+            ++i;
+        } else if (arg == "--gen-keep-xml") {
+            opts.genKeepXml = true;
+        } else if (arg == "--gen-report-s" && i + 1 < argc) {
+            if (auto parsed = parseUint(argv[i + 1])) {
+                opts.genReportSeconds = *parsed;
+            }
+            ++i;
+        } else if (arg == "--history-mib" && i + 1 < argc) {
+            if (auto parsed = parseUint(argv[i + 1])) {
+                opts.historyMiB = *parsed;
+            }
+            ++i;
+        } else if (arg == "--history-fields" && i + 1 < argc) {
+            opts.historyFields = argv[i + 1];
+            ++i;
+        } else if (arg == "--history-dir" && i + 1 < argc) {
+            opts.historyDir = argv[i + 1];
+            ++i;
         }
     }
 
@@ -279,6 +493,70 @@ void applyTrdpEnv(const CliOptions &opts) {
     }
 }
 
+std::optional<trdp::TrafficGenerator::Config> generatorConfig(const CliOptions &opts, std::string &error) {
+    trdp::TrafficGenerator::Config config{};
+    config.count = opts.generateCount;
+    config.comIdBase = opts.genComIdBase;
+    config.datasetBytes = opts.genDatasetBytes;
+    config.replaceExisting = !opts.genKeepXml;
+    if (!trdp::TrafficGenerator::applyCycleSpec(opts.genCycleMs, config)) {
+        error = "invalid --gen-cycle-ms value: " + opts.genCycleMs;
+        return std::nullopt;
+    }
+    const auto pattern = trdp::TrafficGenerator::parsePattern(opts.genPattern);
+    if (!pattern) {
+        error = "invalid --gen-pattern value: " + opts.genPattern;
+        return std::nullopt;
+    }
+    config.pattern = *pattern;
+    in_addr addr{};
+    if (inet_aton(opts.genDestIp.c_str(), &addr) == 0) {
+        error = "invalid --gen-dest-ip value: " + opts.genDestIp;
+        return std::nullopt;
+    }
+    config.destIp = ntohl(addr.s_addr);
+    return config;
+}
+
+void logGeneratorStatus() {
+    const auto status = trdp::TrafficGenerator::instance().status();
+    if (!status.running) {
+        return;
+    }
+    std::cout << "[TRDP] Generator: " << status.telegrams << " telegrams, target " << status.targetRate
+              << "/s, achieved " << status.achievedRate << "/s, failed " << status.failed;
+    if (status.cpuMicrosPerTelegram) {
+        std::cout << ", " << *status.cpuMicrosPerTelegram << " us CPU/telegram";
+    }
+    if (status.cpuUtilisation) {
+        std::cout << ", worker CPU " << (*status.cpuUtilisation * 100.0) << "%";
+    }
+    std::cout << std::endl;
+}
+
+// CPUs left to the HTTP threads: the explicit list, or every available CPU the engine threads are not pinned to.
+std::vector<int> appCpuSet(const CliOptions &opts) {
+    if (!opts.appCpus.empty()) {
+        return opts.appCpus;
+    }
+    std::vector<int> engineCpus = opts.shards > 1U ? opts.shardCpus : std::vector<int>{};
+    engineCpus.push_back(opts.workerCpu);
+    if (std::none_of(engineCpus.begin(), engineCpus.end(), [](int cpu) { return cpu >= 0; })) {
+        return {};
+    }
+    auto cpus = trdp::availableCpus();
+    cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                              [&](int cpu) {
+                                  return std::find(engineCpus.begin(), engineCpus.end(), cpu) != engineCpus.end();
+                              }),
+               cpus.end());
+    if (cpus.empty()) {
+        std::cerr << "[TRDP] The engine threads are pinned to every available CPU; HTTP threads are not isolated"
+                  << std::endl;
+    }
+    return cpus;
+}
+
 std::filesystem::path resolveStaticRoot(const CliOptions &opts, const char *argv0) {
     std::vector<std::filesystem::path> candidates;
 
@@ -329,6 +607,7 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    setConfigImageDirectory(opts.configImageDir);
     if (!opts.xmlPath.empty()) {
         setDefaultXmlConfig(opts.xmlPath);
     }
@@ -348,8 +627,12 @@ int main(int argc, char **argv) {
     }
     std::cout << "Using static assets from: " << staticRoot << std::endl;
     app.setDocumentRoot(staticRoot.string());
+    const auto appCpus = appCpuSet(opts);
     if (opts.threads > 0) {
         app.setThreadNum(opts.threads);
+    } else if (!appCpus.empty()) {
+        // One event loop per CPU left to the HTTP side.
+        app.setThreadNum(appCpus.size());
     }
 
     TrdpEngine::TrdpConfig trdpConfig{};
@@ -358,6 +641,28 @@ int main(int argc, char **argv) {
     trdpConfig.hostsFile = opts.trdpHostsFile;
     trdpConfig.enableDnr = opts.enableDnr;
     trdpConfig.dnrMode = opts.dnrMode == "dedicated" ? TrdpEngine::DnrMode::DedicatedThread : TrdpEngine::DnrMode::CommonThread;
+    if (opts.transport == "stack") {
+        trdpConfig.transport = TrdpEngine::Transport::Stack;
+    } else if (opts.transport == "native") {
+        trdpConfig.transport = TrdpEngine::Transport::Native;
+    } else if (opts.transport != "auto") {
+        std::cerr << "Unknown transport '" << opts.transport << "'; using auto" << std::endl;
+    }
+    trdpConfig.virtualTime = opts.virtualTime;
+    trdpConfig.shards = opts.shards;
+    trdpConfig.shardCpus = opts.shardCpus;
+    if (const auto policy = parseSchedPolicy(opts.rtPolicy)) {
+        trdpConfig.workerRealtime.policy = *policy;
+    } else {
+        std::cerr << "Unknown --rt-policy '" << opts.rtPolicy << "'; using other" << std::endl;
+    }
+    trdpConfig.workerRealtime.priority = static_cast<int>(opts.rtPriority);
+    trdpConfig.workerRealtime.cpu = opts.workerCpu;
+    trdpConfig.prefault = opts.prefault;
+    if (opts.lockMemory) {
+        // Before the engine starts, so its buffers and the TRDP heap are locked as they are allocated.
+        RealtimeReport::instance().record(lockProcessMemory());
+    }
     trdpConfig.cacheConfig.enableUriCache = opts.enableUriCache;
     trdpConfig.cacheConfig.uriCacheTtl = std::chrono::milliseconds(opts.cacheTtlMs);
     trdpConfig.cacheConfig.uriCacheEntries = opts.cacheEntries;
@@ -365,12 +670,63 @@ int main(int argc, char **argv) {
     trdpConfig.ecspConfig.pollInterval = std::chrono::milliseconds(opts.ecspPollMs);
     trdpConfig.ecspConfig.confirmTimeout = std::chrono::milliseconds(opts.ecspConfirmTimeoutMs);
 
+    if (opts.generateCount > 0U && !opts.genKeepXml) {
+        // Generated telegrams replace the XML set, so a missing XML must not block startup.
+        markRegistryPopulated();
+    }
     if (!TrdpEngine::instance().start(trdpConfig)) {
         std::cerr << "Failed to start TRDP engine" << std::endl;
         return 1;
     }
 
+    if (opts.generateCount > 0U) {
+        std::string error;
+        const auto genConfig = generatorConfig(opts, error);
+        if (!genConfig || !TrafficGenerator::instance().start(*genConfig, error)) {
+            std::cerr << "Failed to start traffic generator: " << error << std::endl;
+            return 1;
+        }
+        if (opts.genReportSeconds > 0U) {
+            app.getLoop()->runEvery(static_cast<double>(opts.genReportSeconds), logGeneratorStatus);
+        }
+    }
+
+    std::vector<std::string> historyFields;
+    for (std::size_t start = 0; start < opts.historyFields.size();) {
+        const auto comma = std::min(opts.historyFields.find(',', start), opts.historyFields.size());
+        if (comma > start) {
+            historyFields.push_back(opts.historyFields.substr(start, comma - start));
+        }
+        start = comma + 1U;
+    }
+    if (opts.historyMiB > 0U) {
+        FieldHistory::Config historyConfig{};
+        historyConfig.budgetBytes = static_cast<std::size_t>(opts.historyMiB) * 1024U * 1024U;
+        historyConfig.fields = historyFields;
+        std::string error;
+        if (!FieldHistory::instance().configure(historyConfig, error)) {
+            std::cerr << "Field history disabled: " << error << std::endl;
+        }
+    }
+    if (!opts.historyDir.empty()) {
+        HistoryStore::Config storeConfig{};
+        storeConfig.directory = opts.historyDir;
+        storeConfig.fields = historyFields;
+        std::string error;
+        if (!HistoryStore::instance().start(storeConfig, error)) {
+            std::cerr << "History store disabled: " << error << std::endl;
+        }
+    }
+
+    if (!appCpus.empty()) {
+        // Drogon's event-loop threads are created by app.run() and inherit this thread's mask; the engine
+        // threads already run and keep their own pinning.
+        RealtimeReport::instance().record(restrictThreadCpus("app", appCpus));
+    }
+
     app.run();
+    WorkspaceManager::instance().stopAll();
+    HistoryStore::instance().stop();
     telegramHub.shutdown();
     return 0;
 }
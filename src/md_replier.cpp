@@ -0,0 +1,131 @@
+#include "md_replier.h"
+
+#include "checksum.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace trdp {
+
+namespace {
+
+std::size_t replyFieldWidth(const FieldDef &field) {
+    switch (field.type) {
+    case FieldType::BOOL:
+    case FieldType::INT8:
+    case FieldType::UINT8:
+        return 1U * field.arrayLength;
+    case FieldType::INT16:
+    case FieldType::UINT16:
+        return 2U * field.arrayLength;
+    case FieldType::INT32:
+    case FieldType::UINT32:
+    case FieldType::FLOAT:
+        return 4U * field.arrayLength;
+    case FieldType::DOUBLE:
+        return 8U * field.arrayLength;
+    case FieldType::STRING:
+    case FieldType::BYTES:
+        return field.size;
+    }
+    return 0U;
+}
+
+} // namespace
+
+std::shared_ptr<MdReplyTemplate> MdReplyTemplate::compile(const MdReplierDef &def, const DatasetDef &requestDataset,
+                                                          const DatasetDef &replyDataset,
+                                                          std::vector<std::uint8_t> baseBuffer, std::string &error) {
+    auto tmpl = std::make_shared<MdReplyTemplate>();
+    tmpl->base = std::move(baseBuffer);
+    tmpl->base.resize(replyDataset.computeSize(), 0U);
+
+    std::vector<Op> crcOps;
+    for (const auto &rule : def.fields) {
+        if (rule.source == ReplyFieldSource::Template) {
+            continue;
+        }
+        const auto *dst = replyDataset.findField(rule.field);
+        if (dst == nullptr) {
+            error = "reply field '" + rule.field + "' not found in dataset " + replyDataset.name;
+            return nullptr;
+        }
+        Op op{};
+        op.dstOffset = dst->offset;
+        op.width = replyFieldWidth(*dst);
+        if (op.width == 0U || op.dstOffset + op.width > tmpl->base.size()) {
+            error = "reply field '" + rule.field + "' lies outside the reply buffer";
+            return nullptr;
+        }
+
+        switch (rule.source) {
+        case ReplyFieldSource::Echo: {
+            const auto &srcName = rule.requestField.empty() ? rule.field : rule.requestField;
+            const auto *src = requestDataset.findField(srcName);
+            if (src == nullptr) {
+                error = "request field '" + srcName + "' not found in dataset " + requestDataset.name;
+                return nullptr;
+            }
+            op.kind = OpKind::Echo;
+            op.srcOffset = src->offset;
+            op.srcWidth = replyFieldWidth(*src);
+            tmpl->ops.push_back(op);
+            break;
+        }
+        case ReplyFieldSource::Counter:
+            op.kind = OpKind::Counter;
+            tmpl->ops.push_back(op);
+            break;
+        case ReplyFieldSource::Crc16:
+            op.kind = OpKind::Crc16;
+            op.crcStart = rule.crcStart;
+            op.crcLength = rule.crcLength > 0U ? rule.crcLength
+                                               : (op.dstOffset > rule.crcStart ? op.dstOffset - rule.crcStart : 0U);
+            if (op.crcStart + op.crcLength > tmpl->base.size()) {
+                error = "CRC range for '" + rule.field + "' exceeds the reply buffer";
+                return nullptr;
+            }
+            crcOps.push_back(op);
+            break;
+        case ReplyFieldSource::Template:
+            break;
+        }
+    }
+
+    // Checksums must see the final echoed/counter bytes, so they always run last.
+    tmpl->ops.insert(tmpl->ops.end(), crcOps.begin(), crcOps.end());
+    return tmpl;
+}
+
+void MdReplyTemplate::render(const std::uint8_t *request, std::size_t requestSize,
+                             std::vector<std::uint8_t> &out) const {
+    out.assign(base.begin(), base.end());
+    std::uint8_t *dst = out.data();
+
+    for (const auto &op : ops) {
+        switch (op.kind) {
+        case OpKind::Echo: {
+            // Little-endian layout: copying the low bytes and zero-filling widens or truncates integers.
+            std::memset(dst + op.dstOffset, 0, op.width);
+            if (request != nullptr && op.srcOffset < requestSize) {
+                const auto len = std::min({op.width, op.srcWidth, requestSize - op.srcOffset});
+                std::memcpy(dst + op.dstOffset, request + op.srcOffset, len);
+            }
+            break;
+        }
+        case OpKind::Counter: {
+            const auto value = counter.fetch_add(1, std::memory_order_relaxed) + 1U;
+            std::memcpy(dst + op.dstOffset, &value, std::min(op.width, sizeof(value)));
+            break;
+        }
+        case OpKind::Crc16: {
+            const auto crc = crc16Ccitt(dst + op.crcStart, op.crcLength);
+            std::memset(dst + op.dstOffset, 0, op.width);
+            std::memcpy(dst + op.dstOffset, &crc, std::min(op.width, sizeof(crc)));
+            break;
+        }
+        }
+    }
+}
+
+} // namespace trdp
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "telegram_model.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * Precompiled reply for the automatic MD replier.
+ *
+ * The reply dataset is resolved once into a base buffer plus a short list of byte-level
+ * operations (echo request bytes, stamp a counter, compute a CRC16). Rendering a reply is a
+ * memcpy of the base followed by those operations, so no field lookups or FieldValue
+ * conversions happen per request.
+ */
+class MdReplyTemplate {
+  public:
+    // Build a template; returns nullptr and fills error when a rule cannot be resolved.
+    static std::shared_ptr<MdReplyTemplate> compile(const MdReplierDef &def, const DatasetDef &requestDataset,
+                                                    const DatasetDef &replyDataset,
+                                                    std::vector<std::uint8_t> baseBuffer, std::string &error);
+
+    // Render a reply for the given request payload. Reuses the capacity of out.
+    void render(const std::uint8_t *request, std::size_t requestSize, std::vector<std::uint8_t> &out) const;
+
+    [[nodiscard]] std::size_t replySize() const noexcept { return base.size(); }
+    [[nodiscard]] std::size_t operationCount() const noexcept { return ops.size(); }
+
+  private:
+    enum class OpKind { Echo, Counter, Crc16 };
+
+    struct Op {
+        OpKind kind{OpKind::Echo};
+        std::size_t dstOffset{0};
+        std::size_t width{0};
+        std::size_t srcOffset{0};
+        std::size_t srcWidth{0};
+        std::size_t crcStart{0};
+        std::size_t crcLength{0};
+    };
+
+    std::vector<std::uint8_t> base;
+    std::vector<Op> ops;
+    mutable std::atomic<std::uint64_t> counter{0};
+};
+
+} // namespace trdp
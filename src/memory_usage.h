@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace trdp {
+
+// Rough heap accounting for the memory statistics: payload of containers and strings plus the bookkeeping of each
+// node, without allocator overhead.
+
+// Node header of std::map and std::set: colour and three links.
+constexpr std::size_t kTreeNodeOverhead = 4 * sizeof(void *);
+// Control block of a std::make_shared allocation: two counts and a vtable pointer.
+constexpr std::size_t kSharedControlBlock = 2 * sizeof(long) + sizeof(void *);
+
+inline std::size_t heapBytes(const std::string &value) {
+    // Short strings live inside the object.
+    return value.capacity() > std::string().capacity() ? value.capacity() + 1U : 0U;
+}
+
+template <typename T> std::size_t heapBytes(const std::vector<T> &values) { return values.capacity() * sizeof(T); }
+
+} // namespace trdp
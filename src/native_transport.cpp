@@ -0,0 +1,655 @@
+#include "native_transport.h"
+
+#include "checksum.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+namespace trdp {
+
+namespace {
+
+constexpr std::uint16_t kProtocolVersion = 0x0100U;
+constexpr std::size_t kPdHeaderSize = kTrdpPdHeaderSize;
+constexpr std::size_t kMdHeaderSize = kTrdpMdHeaderSize;
+constexpr std::size_t kMaxPdData = 1432U;
+constexpr std::size_t kMaxMdUdpData = 65388U;
+constexpr std::size_t kBatch = 64U;
+constexpr std::size_t kRxBufferSize = 65536U;
+// Bound the number of recvmmsg rounds per socket so one busy port cannot starve the others.
+constexpr int kMaxRxRounds = 8;
+constexpr std::size_t kMaxReplyRoutes = 4096U;
+constexpr int kSocketBufferBytes = 4 * 1024 * 1024;
+
+void writeBe16(std::uint8_t *dest, std::uint16_t value) {
+    dest[0] = static_cast<std::uint8_t>(value >> 8U);
+    dest[1] = static_cast<std::uint8_t>(value);
+}
+
+void writeBe32(std::uint8_t *dest, std::uint32_t value) {
+    dest[0] = static_cast<std::uint8_t>(value >> 24U);
+    dest[1] = static_cast<std::uint8_t>(value >> 16U);
+    dest[2] = static_cast<std::uint8_t>(value >> 8U);
+    dest[3] = static_cast<std::uint8_t>(value);
+}
+
+// The FCS is the only little-endian header field.
+void writeLe32(std::uint8_t *dest, std::uint32_t value) {
+    dest[0] = static_cast<std::uint8_t>(value);
+    dest[1] = static_cast<std::uint8_t>(value >> 8U);
+    dest[2] = static_cast<std::uint8_t>(value >> 16U);
+    dest[3] = static_cast<std::uint8_t>(value >> 24U);
+}
+
+std::uint16_t readBe16(const std::uint8_t *src) {
+    return static_cast<std::uint16_t>((src[0] << 8U) | src[1]);
+}
+
+std::uint32_t readBe32(const std::uint8_t *src) {
+    return (static_cast<std::uint32_t>(src[0]) << 24U) | (static_cast<std::uint32_t>(src[1]) << 16U) |
+           (static_cast<std::uint32_t>(src[2]) << 8U) | static_cast<std::uint32_t>(src[3]);
+}
+
+std::uint32_t readLe32(const std::uint8_t *src) {
+    return static_cast<std::uint32_t>(src[0]) | (static_cast<std::uint32_t>(src[1]) << 8U) |
+           (static_cast<std::uint32_t>(src[2]) << 16U) | (static_cast<std::uint32_t>(src[3]) << 24U);
+}
+
+bool isPdType(std::uint16_t type) {
+    switch (static_cast<TrdpMsgType>(type)) {
+    case TrdpMsgType::Pd:
+    case TrdpMsgType::Pp:
+    case TrdpMsgType::Pr:
+    case TrdpMsgType::Pe:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool isMdType(std::uint16_t type) {
+    switch (static_cast<TrdpMsgType>(type)) {
+    case TrdpMsgType::Mn:
+    case TrdpMsgType::Mr:
+    case TrdpMsgType::Mp:
+    case TrdpMsgType::Mq:
+    case TrdpMsgType::Mc:
+    case TrdpMsgType::Me:
+        return true;
+    default:
+        return false;
+    }
+}
+
+sockaddr_in makeAddress(std::uint32_t ip, std::uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(ip);
+    addr.sin_port = htons(port);
+    return addr;
+}
+
+} // namespace
+
+std::uint32_t trdpFcs(const std::uint8_t *data, std::size_t length) { return crc32(data, length); }
+
+std::size_t trdpHeaderSize(TrdpMsgType type) {
+    return isPdType(static_cast<std::uint16_t>(type)) ? kPdHeaderSize : kMdHeaderSize;
+}
+
+std::size_t writeTrdpHeader(std::uint8_t *dest, const TrdpHeader &header) {
+    const auto headerSize = trdpHeaderSize(header.msgType);
+    writeBe32(dest + 0, header.sequenceCounter);
+    writeBe16(dest + 4, kProtocolVersion);
+    writeBe16(dest + 6, static_cast<std::uint16_t>(header.msgType));
+    writeBe32(dest + 8, header.comId);
+    writeBe32(dest + 12, header.etbTopoCounter);
+    writeBe32(dest + 16, header.opTrainTopoCounter);
+    writeBe32(dest + 20, header.datasetLength);
+    if (headerSize == kPdHeaderSize) {
+        writeBe32(dest + 24, 0U); // reserved
+        writeBe32(dest + 28, 0U); // replyComId
+        writeBe32(dest + 32, 0U); // replyIpAddress
+    } else {
+        writeBe32(dest + 24, static_cast<std::uint32_t>(header.replyStatus));
+        std::memcpy(dest + 28, header.sessionId.data(), header.sessionId.size());
+        writeBe32(dest + 44, header.replyTimeoutUs);
+        // Source and destination URIs (48..111) stay empty.
+        std::memset(dest + 48, 0, 64U);
+    }
+    writeLe32(dest + headerSize - 4U, trdpFcs(dest, headerSize - 4U));
+    return headerSize;
+}
+
+TrdpHeaderCheck readTrdpHeader(const std::uint8_t *bytes, std::size_t length, TrdpHeader &header) {
+    if (length < kPdHeaderSize || (readBe16(bytes + 4) & 0xFF00U) != (kProtocolVersion & 0xFF00U)) {
+        return TrdpHeaderCheck::Malformed;
+    }
+
+    const auto type = readBe16(bytes + 6);
+    std::size_t headerSize = 0;
+    if (isPdType(type)) {
+        headerSize = kPdHeaderSize;
+    } else if (isMdType(type) && length >= kMdHeaderSize) {
+        headerSize = kMdHeaderSize;
+    } else {
+        return TrdpHeaderCheck::Malformed;
+    }
+
+    if (trdpFcs(bytes, headerSize - 4U) != readLe32(bytes + headerSize - 4U)) {
+        return TrdpHeaderCheck::BadFcs;
+    }
+
+    header.datasetLength = readBe32(bytes + 20);
+    if (header.datasetLength > length - headerSize) {
+        return TrdpHeaderCheck::Malformed;
+    }
+
+    header.msgType = static_cast<TrdpMsgType>(type);
+    header.sequenceCounter = readBe32(bytes + 0);
+    header.comId = readBe32(bytes + 8);
+    header.etbTopoCounter = readBe32(bytes + 12);
+    header.opTrainTopoCounter = readBe32(bytes + 16);
+    if (headerSize == kMdHeaderSize) {
+        header.replyStatus = static_cast<std::int32_t>(readBe32(bytes + 24));
+        std::memcpy(header.sessionId.data(), bytes + 28, header.sessionId.size());
+        header.replyTimeoutUs = readBe32(bytes + 44);
+    } else {
+        header.replyStatus = 0;
+        header.sessionId = {};
+        header.replyTimeoutUs = 0U;
+    }
+    return TrdpHeaderCheck::Ok;
+}
+
+NativeTransport::NativeTransport(std::uint32_t bindIp, std::uint32_t localIp) : bindIp(bindIp), localIp(localIp) {}
+
+NativeTransport::~NativeTransport() {
+    for (auto &socket : sockets) {
+        if (socket->fd >= 0) {
+            ::close(socket->fd);
+        }
+    }
+}
+
+bool NativeTransport::openPort(std::uint16_t port) {
+    if (port == 0U) {
+        return false;
+    }
+    if (std::any_of(sockets.begin(), sockets.end(), [port](const auto &s) { return s->port == port; })) {
+        return true;
+    }
+
+    const int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "[TRDP] Native transport: socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    int enable = 1;
+    (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    (void)setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+    (void)setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+    const int multicastTtl = 64;
+    (void)setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &multicastTtl, sizeof(multicastTtl));
+    if (bindIp != 0U) {
+        in_addr iface{};
+        iface.s_addr = htonl(bindIp);
+        (void)setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+    }
+
+    // Bind the wildcard address so multicast and broadcast traffic for the port is received as well, unless the
+    // port is shared with other local devices.
+    const auto local = makeAddress(localIp != 0U ? localIp : INADDR_ANY, port);
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&local), sizeof(local)) != 0) {
+        std::cerr << "[TRDP] Native transport: bind to UDP port " << port << " failed: " << std::strerror(errno)
+                  << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    auto socket = std::make_unique<Socket>();
+    socket->fd = fd;
+    socket->port = port;
+    socket->txMsgs.resize(kBatch);
+    socket->txIov.resize(kBatch);
+    sockets.push_back(std::move(socket));
+    return true;
+}
+
+bool NativeTransport::joinMulticast(std::uint32_t group) {
+    bool joined = true;
+    for (const auto &socket : sockets) {
+        ip_mreq request{};
+        request.imr_multiaddr.s_addr = htonl(group);
+        request.imr_interface.s_addr = htonl(bindIp);
+        if (setsockopt(socket->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) != 0 &&
+            errno != EADDRINUSE) {
+            std::cerr << "[TRDP] Native transport: joining multicast group on port " << socket->port
+                      << " failed: " << std::strerror(errno) << std::endl;
+            joined = false;
+        }
+    }
+    return joined;
+}
+
+std::vector<std::uint16_t> NativeTransport::ports() const {
+    std::vector<std::uint16_t> result;
+    result.reserve(sockets.size());
+    for (const auto &socket : sockets) {
+        result.push_back(socket->port);
+    }
+    return result;
+}
+
+void NativeTransport::setTopologyCounters(std::uint32_t etb, std::uint32_t opTrain) {
+    etbTopoCounter.store(etb, std::memory_order_relaxed);
+    opTrainTopoCounter.store(opTrain, std::memory_order_relaxed);
+}
+
+NativeTransport::Socket *NativeTransport::socketForPort(std::uint16_t port) {
+    for (auto &socket : sockets) {
+        if (socket->port == port) {
+            return socket.get();
+        }
+    }
+    return sockets.empty() ? nullptr : sockets.front().get();
+}
+
+NativeTransport::OutFrame &NativeTransport::nextSlot(Socket &socket) {
+    // Slots are recycled between flushes so steady-state sends do not allocate.
+    if (socket.queued == socket.queue.size()) {
+        socket.queue.emplace_back();
+    }
+    return socket.queue[socket.queued++];
+}
+
+std::uint32_t NativeTransport::nextSequence(Socket &socket, TrdpMsgType type, std::uint32_t comId) {
+    const auto key = (static_cast<std::uint64_t>(type) << 32U) | comId;
+    return socket.sequenceCounters[key]++;
+}
+
+void NativeTransport::reportQueued(QueuedFrame *queued, const Socket &socket, const sockaddr_in &dest,
+                                   const TrdpHeader &header) {
+    if (queued == nullptr) {
+        return;
+    }
+    queued->header = header;
+    queued->destIp = ntohl(dest.sin_addr.s_addr);
+    queued->srcPort = socket.port;
+    queued->destPort = ntohs(dest.sin_port);
+}
+
+bool NativeTransport::queuePd(std::uint32_t comId, std::uint16_t srcPort, std::uint32_t destIp,
+                              std::uint16_t destPort, const std::uint8_t *data, std::size_t size,
+                              QueuedFrame *queued) {
+    if (destIp == 0U || size > kMaxPdData) {
+        return false;
+    }
+    auto *socket = socketForPort(srcPort);
+    if (socket == nullptr) {
+        return false;
+    }
+
+    std::lock_guard lock(socket->txMtx);
+    auto &frame = nextSlot(*socket);
+    frame.dest = makeAddress(destIp, destPort);
+    frame.bytes.resize(kPdHeaderSize + size);
+    TrdpHeader header;
+    header.msgType = TrdpMsgType::Pd;
+    header.sequenceCounter = nextSequence(*socket, TrdpMsgType::Pd, comId);
+    header.comId = comId;
+    header.etbTopoCounter = etbTopoCounter.load(std::memory_order_relaxed);
+    header.opTrainTopoCounter = opTrainTopoCounter.load(std::memory_order_relaxed);
+    header.datasetLength = static_cast<std::uint32_t>(size);
+    writeTrdpHeader(frame.bytes.data(), header);
+    if (size > 0U) {
+        std::memcpy(frame.bytes.data() + kPdHeaderSize, data, size);
+    }
+    reportQueued(queued, *socket, frame.dest, header);
+    return true;
+}
+
+bool NativeTransport::queueMd(TrdpMsgType type, std::uint32_t comId, std::uint16_t srcPort, std::uint32_t destIp,
+                              std::uint16_t destPort, const TrdpSessionId &sessionId, std::int32_t replyStatus,
+                              std::uint32_t replyTimeoutUs, const std::uint8_t *data, std::size_t size,
+                              QueuedFrame *queued) {
+    if (destIp == 0U) {
+        return false;
+    }
+    auto *socket = socketForPort(srcPort);
+    if (socket == nullptr) {
+        return false;
+    }
+    std::lock_guard lock(socket->txMtx);
+    return queueMdLocked(*socket, makeAddress(destIp, destPort), type, comId, sessionId, replyStatus,
+                         replyTimeoutUs, data, size, queued);
+}
+
+bool NativeTransport::queueMdReply(TrdpMsgType type, std::uint32_t comId, const TrdpSessionId &sessionId,
+                                   std::int32_t replyStatus, std::uint32_t replyTimeoutUs, const std::uint8_t *data,
+                                   std::size_t size, QueuedFrame *queued) {
+    ReplyRoute route{};
+    {
+        std::lock_guard routeLock(routeMtx);
+        const auto it = replyRoutes.find(sessionId);
+        if (it == replyRoutes.end()) {
+            return false;
+        }
+        route = it->second;
+    }
+
+    auto *socket = socketForPort(route.localPort);
+    if (socket == nullptr) {
+        return false;
+    }
+    std::lock_guard lock(socket->txMtx);
+    return queueMdLocked(*socket, route.peer, type, comId, sessionId, replyStatus, replyTimeoutUs, data, size,
+                         queued);
+}
+
+bool NativeTransport::queueMdLocked(Socket &socket, const sockaddr_in &dest, TrdpMsgType type, std::uint32_t comId,
+                                    const TrdpSessionId &sessionId, std::int32_t replyStatus,
+                                    std::uint32_t replyTimeoutUs, const std::uint8_t *data, std::size_t size,
+                                    QueuedFrame *queued) {
+    if (size > kMaxMdUdpData) {
+        return false;
+    }
+
+    auto &frame = nextSlot(socket);
+    frame.dest = dest;
+    frame.bytes.resize(kMdHeaderSize + size);
+    TrdpHeader header;
+    header.msgType = type;
+    header.sequenceCounter = nextSequence(socket, type, comId);
+    header.comId = comId;
+    header.etbTopoCounter = etbTopoCounter.load(std::memory_order_relaxed);
+    header.opTrainTopoCounter = opTrainTopoCounter.load(std::memory_order_relaxed);
+    header.datasetLength = static_cast<std::uint32_t>(size);
+    header.replyStatus = replyStatus;
+    header.sessionId = sessionId;
+    header.replyTimeoutUs = replyTimeoutUs;
+    writeTrdpHeader(frame.bytes.data(), header);
+    if (size > 0U) {
+        std::memcpy(frame.bytes.data() + kMdHeaderSize, data, size);
+    }
+    reportQueued(queued, socket, frame.dest, header);
+    return true;
+}
+
+std::size_t NativeTransport::flush() {
+    std::size_t sent = 0;
+    for (auto &socket : sockets) {
+        sent += flushSocket(*socket);
+    }
+    return sent;
+}
+
+std::size_t NativeTransport::flush(PortGroup &group) {
+    std::size_t sent = 0;
+    for (auto *socket : group.members) {
+        sent += flushSocket(*socket);
+    }
+    return sent;
+}
+
+std::size_t NativeTransport::flushSocket(Socket &socket) {
+    std::lock_guard lock(socket.txMtx);
+    auto &txMsgs = socket.txMsgs;
+    auto &txIov = socket.txIov;
+    std::size_t sent = 0;
+    std::size_t next = 0;
+    while (next < socket.queued) {
+        const auto count = std::min(kBatch, socket.queued - next);
+        for (std::size_t i = 0; i < count; ++i) {
+            auto &frame = socket.queue[next + i];
+            txIov[i].iov_base = frame.bytes.data();
+            txIov[i].iov_len = frame.bytes.size();
+            txMsgs[i] = mmsghdr{};
+            txMsgs[i].msg_hdr.msg_name = &frame.dest;
+            txMsgs[i].msg_hdr.msg_namelen = sizeof(frame.dest);
+            txMsgs[i].msg_hdr.msg_iov = &txIov[i];
+            txMsgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        const int rv = ::sendmmsg(socket.fd, txMsgs.data(), static_cast<unsigned int>(count), 0);
+        sendCalls.fetch_add(1, std::memory_order_relaxed);
+        if (rv < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // The first frame failed (e.g. unreachable destination); drop it and carry on with the rest.
+            sendErrors.fetch_add(1, std::memory_order_relaxed);
+            ++next;
+            continue;
+        }
+        for (int i = 0; i < rv; ++i) {
+            bytesSent.fetch_add(txMsgs[static_cast<std::size_t>(i)].msg_len, std::memory_order_relaxed);
+        }
+        framesSent.fetch_add(static_cast<std::uint64_t>(rv), std::memory_order_relaxed);
+        sent += static_cast<std::size_t>(rv);
+        next += static_cast<std::size_t>(rv);
+    }
+    socket.queued = 0;
+    return sent;
+}
+
+std::size_t NativeTransport::prefault(std::size_t framesPerSocket) {
+    std::size_t touched = 0;
+    for (auto &socket : sockets) {
+        std::lock_guard lock(socket->txMtx);
+        if (socket->queue.size() < framesPerSocket) {
+            socket->queue.resize(framesPerSocket);
+        }
+        for (auto &frame : socket->queue) {
+            // resize() writes every byte; shrinking back keeps the capacity for nextSlot().
+            const auto size = frame.bytes.size();
+            frame.bytes.resize(std::max(frame.bytes.capacity(), kMdHeaderSize + kMaxPdData));
+            touched += frame.bytes.size();
+            frame.bytes.resize(size);
+        }
+    }
+    return touched;
+}
+
+std::unique_ptr<NativeTransport::PortGroup> NativeTransport::makePortGroup(const std::vector<std::uint16_t> &ports) {
+    auto group = std::make_unique<PortGroup>();
+    for (const auto port : ports) {
+        const auto it = std::find_if(sockets.begin(), sockets.end(), [port](const auto &s) { return s->port == port; });
+        if (it != sockets.end()) {
+            group->portList.push_back(port);
+            group->members.push_back(it->get());
+        }
+    }
+    initGroup(*group);
+    return group;
+}
+
+void NativeTransport::initGroup(PortGroup &group) {
+    group.buffers.assign(kBatch, std::vector<std::uint8_t>(kRxBufferSize));
+    group.msgs.resize(kBatch);
+    group.iov.resize(kBatch);
+    group.addrs.resize(kBatch);
+    group.pollFds.resize(group.members.size());
+}
+
+std::size_t NativeTransport::poll(std::chrono::nanoseconds timeout, const FrameHandler &handler) {
+    if (!allPorts || allPorts->members.size() != sockets.size()) {
+        allPorts = std::make_unique<PortGroup>();
+        for (const auto &socket : sockets) {
+            allPorts->portList.push_back(socket->port);
+            allPorts->members.push_back(socket.get());
+        }
+        initGroup(*allPorts);
+    }
+    return poll(*allPorts, timeout, handler);
+}
+
+std::size_t NativeTransport::poll(PortGroup &group, std::chrono::nanoseconds timeout, const FrameHandler &handler) {
+    if (group.members.empty()) {
+        std::this_thread::sleep_for(timeout);
+        return 0;
+    }
+
+    for (std::size_t i = 0; i < group.members.size(); ++i) {
+        group.pollFds[i] = pollfd{group.members[i]->fd, POLLIN, 0};
+    }
+    const auto wait = std::max(timeout, std::chrono::nanoseconds(0));
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(std::chrono::duration_cast<std::chrono::seconds>(wait).count());
+    ts.tv_nsec = static_cast<long>((wait % std::chrono::seconds(1)).count());
+    const int rv = ::ppoll(group.pollFds.data(), static_cast<nfds_t>(group.pollFds.size()), &ts, nullptr);
+    if (rv <= 0) {
+        if (rv < 0 && errno != EINTR) {
+            std::cerr << "[TRDP] Native transport: ppoll failed: " << std::strerror(errno) << std::endl;
+        }
+        return 0;
+    }
+
+    std::size_t dispatched = 0;
+    for (std::size_t i = 0; i < group.members.size(); ++i) {
+        if ((group.pollFds[i].revents & POLLIN) != 0) {
+            dispatched += receiveBatches(group, *group.members[i], handler);
+        }
+    }
+    return dispatched;
+}
+
+std::size_t NativeTransport::receiveBatches(PortGroup &group, Socket &socket, const FrameHandler &handler) {
+    auto &rxBuffers = group.buffers;
+    auto &rxMsgs = group.msgs;
+    auto &rxIov = group.iov;
+    auto &rxAddrs = group.addrs;
+    std::size_t dispatched = 0;
+    for (int round = 0; round < kMaxRxRounds; ++round) {
+        for (std::size_t i = 0; i < kBatch; ++i) {
+            rxIov[i].iov_base = rxBuffers[i].data();
+            rxIov[i].iov_len = rxBuffers[i].size();
+            rxMsgs[i] = mmsghdr{};
+            rxMsgs[i].msg_hdr.msg_name = &rxAddrs[i];
+            rxMsgs[i].msg_hdr.msg_namelen = sizeof(rxAddrs[i]);
+            rxMsgs[i].msg_hdr.msg_iov = &rxIov[i];
+            rxMsgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        const int rv = ::recvmmsg(socket.fd, rxMsgs.data(), static_cast<unsigned int>(kBatch), MSG_DONTWAIT, nullptr);
+        recvCalls.fetch_add(1, std::memory_order_relaxed);
+        if (rv <= 0) {
+            if (rv < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "[TRDP] Native transport: recvmmsg on port " << socket.port
+                          << " failed: " << std::strerror(errno) << std::endl;
+            }
+            break;
+        }
+
+        for (int i = 0; i < rv; ++i) {
+            const auto index = static_cast<std::size_t>(i);
+            const auto length = static_cast<std::size_t>(rxMsgs[index].msg_len);
+            framesReceived.fetch_add(1, std::memory_order_relaxed);
+            bytesReceived.fetch_add(length, std::memory_order_relaxed);
+
+            NativeFrame frame{};
+            if (!parseFrame(rxBuffers[index].data(), length, frame)) {
+                continue;
+            }
+            frame.srcIp = ntohl(rxAddrs[index].sin_addr.s_addr);
+            frame.srcPort = ntohs(rxAddrs[index].sin_port);
+            frame.localPort = socket.port;
+            if (frame.msgType == TrdpMsgType::Mr || frame.msgType == TrdpMsgType::Mq) {
+                rememberReplyRoute(frame, rxAddrs[index]);
+            }
+            handler(frame);
+            ++dispatched;
+        }
+
+        if (static_cast<std::size_t>(rv) < kBatch) {
+            break;
+        }
+    }
+    return dispatched;
+}
+
+bool NativeTransport::parseFrame(const std::uint8_t *bytes, std::size_t length, NativeFrame &frame) {
+    TrdpHeader header;
+    switch (readTrdpHeader(bytes, length, header)) {
+    case TrdpHeaderCheck::Ok:
+        break;
+    case TrdpHeaderCheck::Malformed:
+        headerErrors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    case TrdpHeaderCheck::BadFcs:
+        crcErrors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    frame.msgType = header.msgType;
+    frame.sequenceCounter = header.sequenceCounter;
+    frame.comId = header.comId;
+    frame.etbTopoCounter = header.etbTopoCounter;
+    frame.opTrainTopoCounter = header.opTrainTopoCounter;
+
+    // Zero on either side means "don't care", matching the TCNopen stack's topology filtering.
+    const auto localEtb = etbTopoCounter.load(std::memory_order_relaxed);
+    const auto localOpTrain = opTrainTopoCounter.load(std::memory_order_relaxed);
+    if ((frame.etbTopoCounter != 0U && localEtb != 0U && frame.etbTopoCounter != localEtb) ||
+        (frame.opTrainTopoCounter != 0U && localOpTrain != 0U && frame.opTrainTopoCounter != localOpTrain)) {
+        topologyErrors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    frame.replyStatus = header.replyStatus;
+    frame.sessionId = header.sessionId;
+    frame.replyTimeoutUs = header.replyTimeoutUs;
+    frame.data = bytes + trdpHeaderSize(header.msgType);
+    frame.size = header.datasetLength;
+    return true;
+}
+
+void NativeTransport::rememberReplyRoute(const NativeFrame &frame, const sockaddr_in &peer) {
+    std::lock_guard lock(routeMtx);
+    const auto [it, inserted] = replyRoutes.insert_or_assign(frame.sessionId, ReplyRoute{peer, frame.localPort});
+    (void)it;
+    if (inserted) {
+        replyRouteOrder.push_back(frame.sessionId);
+        if (replyRouteOrder.size() > kMaxReplyRoutes) {
+            replyRoutes.erase(replyRouteOrder.front());
+            replyRouteOrder.pop_front();
+        }
+    }
+}
+
+NativeTransport::Stats NativeTransport::stats() const {
+    Stats result;
+    result.framesSent = framesSent.load(std::memory_order_relaxed);
+    result.bytesSent = bytesSent.load(std::memory_order_relaxed);
+    result.sendCalls = sendCalls.load(std::memory_order_relaxed);
+    result.sendErrors = sendErrors.load(std::memory_order_relaxed);
+    result.framesReceived = framesReceived.load(std::memory_order_relaxed);
+    result.bytesReceived = bytesReceived.load(std::memory_order_relaxed);
+    result.recvCalls = recvCalls.load(std::memory_order_relaxed);
+    result.headerErrors = headerErrors.load(std::memory_order_relaxed);
+    result.crcErrors = crcErrors.load(std::memory_order_relaxed);
+    result.topologyErrors = topologyErrors.load(std::memory_order_relaxed);
+    return result;
+}
+
+TrdpSessionId NativeTransport::newSessionId() {
+    // Random (version 4) UUID; TRDP only requires uniqueness per session.
+    static thread_local std::mt19937_64 rng{std::random_device{}()};
+    TrdpSessionId id{};
+    for (std::size_t i = 0; i < id.size(); i += 8U) {
+        const auto value = rng();
+        std::memcpy(id.data() + i, &value, 8U);
+    }
+    id[6] = static_cast<std::uint8_t>((id[6] & 0x0FU) | 0x40U);
+    id[8] = static_cast<std::uint8_t>((id[8] & 0x3FU) | 0x80U);
+    return id;
+}
+
+} // namespace trdp
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+namespace trdp {
+
+// TRDP message types as carried in the frame header (two ASCII characters, network byte order).
+enum class TrdpMsgType : std::uint16_t {
+    Pd = 0x5064,
+    Pp = 0x5070,
+    Pr = 0x5072,
+    Pe = 0x5065,
+    Mn = 0x4D6E,
+    Mr = 0x4D72,
+    Mp = 0x4D70,
+    Mq = 0x4D71,
+    Mc = 0x4D63,
+    Me = 0x4D65,
+};
+
+using TrdpSessionId = std::array<std::uint8_t, 16>;
+
+constexpr std::size_t kTrdpPdHeaderSize = 40U;
+constexpr std::size_t kTrdpMdHeaderSize = 116U;
+
+// Header fields of a TRDP frame. The MD fields are ignored for PD message types.
+struct TrdpHeader {
+    TrdpMsgType msgType{TrdpMsgType::Pd};
+    std::uint32_t sequenceCounter{0};
+    std::uint32_t comId{0};
+    std::uint32_t etbTopoCounter{0};
+    std::uint32_t opTrainTopoCounter{0};
+    std::uint32_t datasetLength{0};
+    std::int32_t replyStatus{0};
+    TrdpSessionId sessionId{};
+    std::uint32_t replyTimeoutUs{0};
+};
+
+// What a queue call stamped into an outgoing frame, for callers that record their own traffic.
+struct QueuedFrame {
+    TrdpHeader header;
+    std::uint32_t destIp{0};
+    std::uint16_t srcPort{0};
+    std::uint16_t destPort{0};
+};
+
+// A validated frame handed to the receive handler. data points into the transport's receive buffer and is only
+// valid for the duration of the callback.
+struct NativeFrame {
+    TrdpMsgType msgType{TrdpMsgType::Pd};
+    std::uint32_t comId{0};
+    std::uint32_t sequenceCounter{0};
+    std::uint32_t etbTopoCounter{0};
+    std::uint32_t opTrainTopoCounter{0};
+    // MD header fields; zero for PD.
+    std::int32_t replyStatus{0};
+    TrdpSessionId sessionId{};
+    std::uint32_t replyTimeoutUs{0};
+    std::uint32_t srcIp{0};
+    std::uint16_t srcPort{0};
+    std::uint16_t localPort{0};
+    const std::uint8_t *data{nullptr};
+    std::size_t size{0};
+};
+
+/**
+ * Built-in TRDP PD/MD transport over plain UDP sockets.
+ *
+ * Implements the IEC 61375-2-3 PD (40 byte) and MD (116 byte) headers with per-ComId sequence counters,
+ * ETB/operational train topology counters and the CRC-32 header FCS, so the simulator can exchange traffic
+ * with real TRDP devices without the TCNopen stack. One socket is opened per configured port and shared by
+ * PD and MD. Frames are queued by the caller and written with sendmmsg on flush(); poll() drains ready
+ * sockets with recvmmsg.
+ *
+ * Queueing/flush may be called from any thread; every socket has its own send lock, so threads sending from
+ * different ports do not contend. poll() must only be called from one thread (the engine worker), or from one
+ * thread per PortGroup when the ports are split between several polling threads; the handler runs on the polling
+ * thread with no transport lock held.
+ */
+class NativeTransport {
+    struct Socket;
+
+  public:
+    using FrameHandler = std::function<void(const NativeFrame &)>;
+
+    struct Stats {
+        std::uint64_t framesSent{0};
+        std::uint64_t bytesSent{0};
+        std::uint64_t sendCalls{0};
+        std::uint64_t sendErrors{0};
+        std::uint64_t framesReceived{0};
+        std::uint64_t bytesReceived{0};
+        std::uint64_t recvCalls{0};
+        std::uint64_t headerErrors{0};
+        std::uint64_t crcErrors{0};
+        std::uint64_t topologyErrors{0};
+    };
+
+    // bindIp selects the multicast interface (host byte order, 0 = default route). A non-zero localIp binds the
+    // sockets to that address instead of the wildcard; they then no longer receive multicast.
+    explicit NativeTransport(std::uint32_t bindIp, std::uint32_t localIp = 0U);
+    ~NativeTransport();
+    NativeTransport(const NativeTransport &) = delete;
+    NativeTransport &operator=(const NativeTransport &) = delete;
+
+    // Open (or reuse) the UDP socket for a local port. Must be called before the worker starts polling.
+    bool openPort(std::uint16_t port);
+    // Join a multicast group on every open socket.
+    bool joinMulticast(std::uint32_t group);
+    [[nodiscard]] std::vector<std::uint16_t> ports() const;
+
+    // Counters stamped into outgoing headers; received frames carrying different non-zero values are dropped.
+    void setTopologyCounters(std::uint32_t etbTopoCounter, std::uint32_t opTrainTopoCounter);
+
+    // Queue a PD frame sent from the socket bound to srcPort. Nothing reaches the wire until flush().
+    // The queue calls fill queued, when given, with the header and addressing of the frame.
+    bool queuePd(std::uint32_t comId, std::uint16_t srcPort, std::uint32_t destIp, std::uint16_t destPort,
+                 const std::uint8_t *data, std::size_t size, QueuedFrame *queued = nullptr);
+    // Queue an MD frame to an explicit destination.
+    bool queueMd(TrdpMsgType type, std::uint32_t comId, std::uint16_t srcPort, std::uint32_t destIp,
+                 std::uint16_t destPort, const TrdpSessionId &sessionId, std::int32_t replyStatus,
+                 std::uint32_t replyTimeoutUs, const std::uint8_t *data, std::size_t size,
+                 QueuedFrame *queued = nullptr);
+    // Queue an MD frame back to the peer that sent the Mr/Mq with this session id. Fails for unknown sessions.
+    bool queueMdReply(TrdpMsgType type, std::uint32_t comId, const TrdpSessionId &sessionId,
+                      std::int32_t replyStatus, std::uint32_t replyTimeoutUs, const std::uint8_t *data,
+                      std::size_t size, QueuedFrame *queued = nullptr);
+
+    // Write all queued frames; returns the number sent.
+    std::size_t flush();
+
+    // Wait up to timeout for traffic and dispatch every valid frame to handler. Returns the number dispatched.
+    // The wait has the resolution of ppoll(), so cyclic deadlines below a millisecond are honoured.
+    std::size_t poll(std::chrono::nanoseconds timeout, const FrameHandler &handler);
+
+    // Ports served by one polling thread, with its own poll set and receive buffers. Groups polled concurrently
+    // must not share a port, and no thread may use the plain poll() at the same time.
+    class PortGroup {
+      public:
+        [[nodiscard]] const std::vector<std::uint16_t> &ports() const noexcept { return portList; }
+
+      private:
+        friend class NativeTransport;
+        std::vector<std::uint16_t> portList;
+        std::vector<Socket *> members;
+        std::vector<pollfd> pollFds;
+        std::vector<std::vector<std::uint8_t>> buffers;
+        std::vector<mmsghdr> msgs;
+        std::vector<iovec> iov;
+        std::vector<sockaddr_in> addrs;
+    };
+
+    // Group of already opened ports; ports that were not opened are skipped.
+    std::unique_ptr<PortGroup> makePortGroup(const std::vector<std::uint16_t> &ports);
+    std::size_t poll(PortGroup &group, std::chrono::nanoseconds timeout, const FrameHandler &handler);
+    // Write the frames queued on the ports of group only.
+    std::size_t flush(PortGroup &group);
+
+    // Pre-allocate and touch framesPerSocket full-size send slots on every socket, so steady-state sends neither
+    // allocate nor page-fault. Returns the number of bytes touched.
+    std::size_t prefault(std::size_t framesPerSocket);
+
+    [[nodiscard]] Stats stats() const;
+
+    static TrdpSessionId newSessionId();
+
+  private:
+    struct OutFrame {
+        sockaddr_in dest{};
+        std::vector<std::uint8_t> bytes;
+    };
+
+    struct Socket {
+        int fd{-1};
+        std::uint16_t port{0};
+        // Guards the send queue, the sequence counters and the sendmmsg scratch of this socket.
+        std::mutex txMtx;
+        std::vector<OutFrame> queue;
+        std::size_t queued{0};
+        // Header sequence counter per message type and ComId, like a TCNopen session per port.
+        std::unordered_map<std::uint64_t, std::uint32_t> sequenceCounters;
+        std::vector<mmsghdr> txMsgs;
+        std::vector<iovec> txIov;
+    };
+
+    struct ReplyRoute {
+        sockaddr_in peer{};
+        std::uint16_t localPort{0};
+    };
+
+    Socket *socketForPort(std::uint16_t port);
+    static OutFrame &nextSlot(Socket &socket);
+    static std::uint32_t nextSequence(Socket &socket, TrdpMsgType type, std::uint32_t comId);
+    void initGroup(PortGroup &group);
+    std::size_t flushSocket(Socket &socket);
+    bool queueMdLocked(Socket &socket, const sockaddr_in &dest, TrdpMsgType type, std::uint32_t comId,
+                       const TrdpSessionId &sessionId, std::int32_t replyStatus, std::uint32_t replyTimeoutUs,
+                       const std::uint8_t *data, std::size_t size, QueuedFrame *queued);
+    static void reportQueued(QueuedFrame *queued, const Socket &socket, const sockaddr_in &dest,
+                             const TrdpHeader &header);
+    std::size_t receiveBatches(PortGroup &group, Socket &socket, const FrameHandler &handler);
+    bool parseFrame(const std::uint8_t *bytes, std::size_t length, NativeFrame &frame);
+    void rememberReplyRoute(const NativeFrame &frame, const sockaddr_in &peer);
+
+    std::uint32_t bindIp{0};
+    std::uint32_t localIp{0};
+    // Sockets are only added before polling starts, so the vector itself is never resized concurrently.
+    std::vector<std::unique_ptr<Socket>> sockets;
+
+    std::atomic<std::uint32_t> etbTopoCounter{0};
+    std::atomic<std::uint32_t> opTrainTopoCounter{0};
+
+    // Receive state of the plain poll(), covering every socket.
+    std::unique_ptr<PortGroup> allPorts;
+
+    std::mutex routeMtx;
+    std::map<TrdpSessionId, ReplyRoute> replyRoutes;
+    std::deque<TrdpSessionId> replyRouteOrder;
+
+    std::atomic<std::uint64_t> framesSent{0};
+    std::atomic<std::uint64_t> bytesSent{0};
+    std::atomic<std::uint64_t> sendCalls{0};
+    std::atomic<std::uint64_t> sendErrors{0};
+    std::atomic<std::uint64_t> framesReceived{0};
+    std::atomic<std::uint64_t> bytesReceived{0};
+    std::atomic<std::uint64_t> recvCalls{0};
+    std::atomic<std::uint64_t> headerErrors{0};
+    std::atomic<std::uint64_t> crcErrors{0};
+    std::atomic<std::uint64_t> topologyErrors{0};
+};
+
+// CRC-32 (IEEE 802.3) as used for the TRDP header frame check sequence.
+std::uint32_t trdpFcs(const std::uint8_t *data, std::size_t length);
+
+// 40 for PD message types, 116 for MD.
+std::size_t trdpHeaderSize(TrdpMsgType type);
+
+// Serialise header (big-endian fields, empty URIs, CRC-32 FCS) into dest, which must hold
+// trdpHeaderSize(header.msgType) bytes. Returns the number of bytes written.
+std::size_t writeTrdpHeader(std::uint8_t *dest, const TrdpHeader &header);
+
+enum class TrdpHeaderCheck { Ok, Malformed, BadFcs };
+
+// Parse and validate the TRDP header at the start of a UDP payload of length bytes (protocol version, message
+// type, FCS and that the dataset fits). The dataset follows at trdpHeaderSize(header.msgType).
+TrdpHeaderCheck readTrdpHeader(const std::uint8_t *bytes, std::size_t length, TrdpHeader &header);
+
+} // namespace trdp
@@ -0,0 +1,209 @@
+#include "payload_verifier.h"
+
+#include "checksum.h"
+#include "tx_generator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace trdp {
+
+namespace {
+
+constexpr std::size_t kSequenceBytes = 4U;
+constexpr std::size_t kCrcBytes = 4U;
+constexpr std::uint32_t kWindowBits = 64U;
+
+std::uint32_t readLe32(const std::uint8_t *src) {
+    std::uint32_t value = 0;
+    std::memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+// Bits hi..lo (inclusive, hi >= lo) of a 64-bit word.
+std::uint64_t bitRange(std::uint32_t hi, std::uint32_t lo) {
+    const auto upper = hi >= 63U ? ~0ULL : (1ULL << (hi + 1U)) - 1ULL;
+    return upper & ~((1ULL << lo) - 1ULL);
+}
+
+} // namespace
+
+PayloadVerifier &PayloadVerifier::instance() {
+    static PayloadVerifier verifier;
+    return verifier;
+}
+
+std::size_t PayloadVerifier::prbsViolations(const std::uint8_t *data, std::size_t size, std::uint32_t order) {
+    const auto tap = prbsTap(order);
+    if (tap == 0U || data == nullptr) {
+        return 0U;
+    }
+    // Bit t of the run (MSB first) must equal bit t-order ^ bit t-tap for every t >= order. Each step checks 32
+    // bits at once: the big-endian word of the four bytes before and the four bytes of the block puts bit t at
+    // position 31-(t-base), so shifting the word right by order (tap) lines up bit t-order (t-tap) with it.
+    const auto bits = size * 8U;
+    std::size_t violations = 0;
+    for (std::size_t base = 0; base < bits; base += 32U) {
+        const auto first = base / 8U;
+        std::uint64_t word = 0;
+        for (std::size_t i = 0; i < 8U; ++i) {
+            const auto index = first + i;
+            const bool inside = index >= 4U && index - 4U < size;
+            word = (word << 8U) | (inside ? data[index - 4U] : 0U);
+        }
+        const auto lo = std::max<std::size_t>(base, order);
+        const auto hi = std::min<std::size_t>(base + 32U, bits);
+        if (lo >= hi) {
+            continue;
+        }
+        const auto mask = bitRange(static_cast<std::uint32_t>(31U - (lo - base)),
+                                   static_cast<std::uint32_t>(32U - (hi - base)));
+        const auto errors = (word ^ (word >> order) ^ (word >> tap)) & mask;
+        violations += static_cast<std::size_t>(__builtin_popcountll(errors));
+    }
+    return violations;
+}
+
+bool PayloadVerifier::start(const Config &config, std::string &error) {
+    if (config.prbsOrder != 0U && prbsTap(config.prbsOrder) == 0U) {
+        error = "prbsOrder must be 0, 7, 9, 15, 23 or 31";
+        return false;
+    }
+
+    std::lock_guard lock(mtx);
+    activeConfig = config;
+    selected.clear();
+    selected.insert(config.comIds.begin(), config.comIds.end());
+    streams.clear();
+    startedAt = std::chrono::steady_clock::now();
+    running.store(true, std::memory_order_relaxed);
+    std::cout << "[TRDP] Payload verifier started for "
+              << (selected.empty() ? std::string("all PD telegrams") : std::to_string(selected.size()) + " ComIds")
+              << std::endl;
+    return true;
+}
+
+void PayloadVerifier::stop() {
+    std::lock_guard lock(mtx);
+    if (!running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    running.store(false, std::memory_order_relaxed);
+    stoppedAt = std::chrono::steady_clock::now();
+    std::cout << "[TRDP] Payload verifier stopped" << std::endl;
+}
+
+PayloadVerifier::Status PayloadVerifier::status() {
+    std::lock_guard lock(mtx);
+    Status status;
+    status.running = running.load(std::memory_order_relaxed);
+    status.config = activeConfig;
+    if (startedAt != std::chrono::steady_clock::time_point{}) {
+        const auto end = status.running ? std::chrono::steady_clock::now() : stoppedAt;
+        status.elapsedSeconds = std::chrono::duration<double>(end - startedAt).count();
+    }
+    status.telegrams.reserve(streams.size());
+    for (const auto &[comId, stream] : streams) {
+        const auto &counters = stream.counters;
+        status.total.received += counters.received;
+        status.total.lost += counters.lost;
+        status.total.duplicated += counters.duplicated;
+        status.total.reordered += counters.reordered;
+        status.total.corrupted += counters.corrupted;
+        status.total.crcErrors += counters.crcErrors;
+        status.total.prbsErrors += counters.prbsErrors;
+        status.total.truncated += counters.truncated;
+        status.total.resyncs += counters.resyncs;
+        status.telegrams.push_back(counters);
+    }
+    std::sort(status.telegrams.begin(), status.telegrams.end(),
+              [](const Counters &a, const Counters &b) { return a.comId < b.comId; });
+    return status;
+}
+
+void PayloadVerifier::verify(std::uint32_t comId, const std::uint8_t *payload, std::size_t size) {
+    if (!active() || payload == nullptr) {
+        return;
+    }
+    std::lock_guard lock(mtx);
+    if (!running.load(std::memory_order_relaxed) || (!selected.empty() && selected.count(comId) == 0U)) {
+        return;
+    }
+
+    auto &stream = streams[comId];
+    auto &counters = stream.counters;
+    counters.comId = comId;
+    ++counters.received;
+
+    const auto &config = activeConfig;
+    const auto trailer = config.crc ? kCrcBytes : 0U;
+    if (size < trailer || config.sequenceOffset + kSequenceBytes > size - trailer ||
+        config.payloadOffset > size - trailer) {
+        ++counters.truncated;
+        return;
+    }
+
+    bool corrupted = false;
+    if (config.crc && crc32(payload, size - kCrcBytes) != readLe32(payload + size - kCrcBytes)) {
+        ++counters.crcErrors;
+        corrupted = true;
+    }
+    if (config.prbsOrder != 0U &&
+        prbsViolations(payload + config.payloadOffset, size - trailer - config.payloadOffset, config.prbsOrder) !=
+            0U) {
+        ++counters.prbsErrors;
+        corrupted = true;
+    }
+    if (corrupted) {
+        ++counters.corrupted;
+        return;
+    }
+    account(stream, readLe32(payload + config.sequenceOffset));
+}
+
+void PayloadVerifier::account(Stream &stream, std::uint32_t sequence) {
+    auto &counters = stream.counters;
+    counters.lastSequence = sequence;
+    if (!stream.started) {
+        stream.started = true;
+        stream.highest = sequence;
+        stream.window = 1U;
+        return;
+    }
+
+    // Stamps wrap; anything within half the range above the highest stamp is ahead of it.
+    const auto ahead = sequence - stream.highest;
+    if (ahead == 0U) {
+        ++counters.duplicated;
+        return;
+    }
+    if (ahead < 0x80000000U) {
+        counters.lost += ahead - 1U;
+        stream.window = ahead >= kWindowBits ? 1U : (stream.window << ahead) | 1U;
+        stream.highest = sequence;
+        return;
+    }
+
+    const auto behind = stream.highest - sequence;
+    if (behind >= kWindowBits) {
+        // Too old to tell a late arrival from a restarted sender: start over from this stamp.
+        ++counters.resyncs;
+        stream.highest = sequence;
+        stream.window = 1U;
+        return;
+    }
+    const auto bit = 1ULL << behind;
+    if ((stream.window & bit) != 0U) {
+        ++counters.duplicated;
+        return;
+    }
+    stream.window |= bit;
+    ++counters.reordered;
+    if (counters.lost > 0U) {
+        // The stamp was counted lost when the gap opened.
+        --counters.lost;
+    }
+}
+
+} // namespace trdp
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * Receive-side integrity check for sequence-stamped test traffic.
+ *
+ * The expected payload carries a UINT32 sequence stamp at sequenceOffset, a run of PRBS bytes from
+ * payloadOffset and, optionally, a CRC-32 over everything before it in its last four bytes. This is what the
+ * traffic generator's "prbs" pattern sends (a counter and a PRBS generator on every telegram). Each received PD
+ * payload is checked before it is decoded:
+ *
+ * - corruption: the CRC-32 (table driven) and the PRBS run, which is validated without knowing the sender's
+ *   state by checking the polynomial recurrence s[t] = s[t-n] ^ s[t-k] over 64-bit words;
+ * - sequence: a stamp below the highest one seen is a duplicate when it was already received (64-stamp window)
+ *   and a reordered arrival otherwise; gaps count as lost until the stamp turns up late. A stamp far outside the
+ *   window resynchronises (sender restart).
+ *
+ * Corrupted telegrams are not used for sequence accounting.
+ */
+class PayloadVerifier {
+  public:
+    struct Config {
+        // Telegrams to verify; empty verifies every received PD ComId.
+        std::vector<std::uint32_t> comIds;
+        std::size_t sequenceOffset{0};
+        std::size_t payloadOffset{4};
+        // PRBS polynomial of the payload run (7, 9, 15, 23 or 31); 0 skips the PRBS check.
+        std::uint32_t prbsOrder{15};
+        // The last four bytes hold a CRC-32 over the rest of the payload.
+        bool crc{false};
+    };
+
+    struct Counters {
+        std::uint32_t comId{0};
+        std::uint64_t received{0};
+        std::uint64_t lost{0};
+        std::uint64_t duplicated{0};
+        std::uint64_t reordered{0};
+        std::uint64_t corrupted{0};
+        std::uint64_t crcErrors{0};
+        std::uint64_t prbsErrors{0};
+        // Payloads too short for the configured layout.
+        std::uint64_t truncated{0};
+        std::uint64_t resyncs{0};
+        std::uint32_t lastSequence{0};
+    };
+
+    struct Status {
+        bool running{false};
+        Config config;
+        double elapsedSeconds{0.0};
+        Counters total;
+        std::vector<Counters> telegrams;
+    };
+
+    static PayloadVerifier &instance();
+
+    // Start (or restart) verification with fresh counters. Returns false with a reason in error.
+    bool start(const Config &config, std::string &error);
+    void stop();
+    Status status();
+
+    // Check one received PD payload. Cheap no-op while stopped or for ComIds that are not verified.
+    void verify(std::uint32_t comId, const std::uint8_t *payload, std::size_t size);
+
+    [[nodiscard]] bool active() const noexcept { return running.load(std::memory_order_relaxed); }
+
+    // Number of recurrence violations of a PRBS-order run of size bytes (MSB first); 0 for a clean run.
+    static std::size_t prbsViolations(const std::uint8_t *data, std::size_t size, std::uint32_t order);
+
+  private:
+    struct Stream {
+        Counters counters;
+        bool started{false};
+        std::uint32_t highest{0};
+        // Bit i set: stamp highest - i has been received.
+        std::uint64_t window{0};
+    };
+
+    PayloadVerifier() = default;
+    PayloadVerifier(const PayloadVerifier &) = delete;
+    PayloadVerifier &operator=(const PayloadVerifier &) = delete;
+
+    void account(Stream &stream, std::uint32_t sequence);
+
+    std::mutex mtx;
+    std::atomic<bool> running{false};
+    Config activeConfig;
+    std::unordered_set<std::uint32_t> selected;
+    std::unordered_map<std::uint32_t, Stream> streams;
+    std::chrono::steady_clock::time_point startedAt{};
+    std::chrono::steady_clock::time_point stoppedAt{};
+};
+
+} // namespace trdp
@@ -47,8 +47,11 @@ Json::Value fieldValueToJson(const FieldValue &value) {
 
 TelegramHub::TelegramHub() = default;
 
+TelegramHub::TelegramHub(TelegramRegistry &registry, TrdpEngine &engine) : registry(&registry), engine(&engine) {}
+
 void TelegramHub::initAndStart(const Json::Value &) {
     g_instance = this;
+    TrdpEngine::instance().setHub(this);
     TrdpEngine::instance().start();
 }
 
@@ -58,11 +61,18 @@ void TelegramHub::shutdown() {
         connections.clear();
     }
     TrdpEngine::instance().stop();
+    TrdpEngine::instance().setHub(nullptr);
     g_instance = nullptr;
 }
 
 TelegramHub *TelegramHub::instance() { return g_instance; }
 
+TelegramRegistry &TelegramHub::telegramRegistry() const {
+    return registry != nullptr ? *registry : TelegramRegistry::instance();
+}
+
+TrdpEngine &TelegramHub::trdpEngine() const { return engine != nullptr ? *engine : TrdpEngine::instance(); }
+
 void TelegramHub::subscribe(const drogon::WebSocketConnectionPtr &conn) {
     {
         std::lock_guard lock(connMtx);
@@ -79,6 +89,17 @@ void TelegramHub::unsubscribe(const drogon::WebSocketConnectionPtr &conn) {
     }
 }
 
+void TelegramHub::closeConnections() {
+    std::set<drogon::WebSocketConnectionPtr> closing;
+    {
+        std::lock_guard lock(connMtx);
+        closing.swap(connections);
+    }
+    for (const auto &conn : closing) {
+        conn->forceClose();
+    }
+}
+
 void TelegramHub::publishRxUpdate(std::uint32_t comId, const std::map<std::string, FieldValue> &fields) {
     Json::Value payload;
     payload["type"] = "rx";
@@ -124,7 +145,7 @@ void TelegramHub::publishMdStatus(const std::string &sessionId, std::uint32_t co
 }
 
 void TelegramHub::sendSnapshot(const drogon::WebSocketConnectionPtr &conn) {
-    if (!ensureRegistryInitialized()) {
+    if (registry == nullptr && !ensureRegistryInitialized()) {
         Json::Value error;
         error["type"] = "error";
         error["message"] = "TRDP registry is not initialised";
@@ -135,9 +156,10 @@ void TelegramHub::sendSnapshot(const drogon::WebSocketConnectionPtr &conn) {
     Json::Value payload;
     payload["type"] = "snapshot";
     auto &items = payload["telegrams"];
-    for (const auto &telegram : TelegramRegistry::instance().listTelegrams()) {
-        Json::Value tg = telegramToJson(telegram);
-        const auto runtime = TelegramRegistry::instance().getOrCreateRuntime(telegram.comId);
+    const auto contents = telegramRegistry().snapshot();
+    for (const auto &[comId, telegram] : contents->telegrams) {
+        Json::Value tg = telegramToJson(*telegram);
+        const auto runtime = telegramRegistry().getOrCreateRuntime(comId);
         if (runtime) {
             tg["fields"] = fieldsToJson(runtime->snapshotFields());
         }
@@ -146,6 +168,11 @@ void TelegramHub::sendSnapshot(const drogon::WebSocketConnectionPtr &conn) {
     conn->send(payload.toStyledString());
 }
 
+bool TelegramHub::hasSubscribers() {
+    std::lock_guard lock(connMtx);
+    return !connections.empty();
+}
+
 void TelegramHub::broadcast(const Json::Value &payload) {
     const auto message = payload.toStyledString();
     std::lock_guard lock(connMtx);
@@ -178,7 +205,7 @@ Json::Value TelegramHub::telegramToJson(const TelegramDef &telegram) const {
     json["replyTimeoutMs"] = static_cast<Json::UInt64>(telegram.replyTimeout.count());
     json["confirmTimeoutMs"] = static_cast<Json::UInt64>(telegram.confirmTimeout.count());
     if (telegram.direction == Direction::Tx && telegram.type == TelegramType::PD) {
-        json["txActive"] = TrdpEngine::instance().txPublishActive(telegram.comId).value_or(false);
+        json["txActive"] = trdpEngine().txPublishActive(telegram.comId).value_or(false);
     }
     return json;
 }
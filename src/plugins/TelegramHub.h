@@ -1,5 +1,6 @@
 #pragma once
 
+#include "telegram_events.h"
 #include "telegram_model.h"
 
 #include <drogon/plugins/Plugin.h>
@@ -11,26 +12,36 @@
 
 namespace trdp {
 
-class TelegramHub : public drogon::Plugin<TelegramHub> {
+class TrdpEngine;
+
+class TelegramHub : public drogon::Plugin<TelegramHub>, public TelegramEventSink {
   public:
     TelegramHub();
+    // Hub of an additional workspace; it is not registered as a plugin and serves registry and engine instead of
+    // the default ones.
+    TelegramHub(TelegramRegistry &registry, TrdpEngine &engine);
 
     void initAndStart(const Json::Value &config) override;
     void shutdown() override;
 
     void subscribe(const drogon::WebSocketConnectionPtr &conn);
     void unsubscribe(const drogon::WebSocketConnectionPtr &conn);
+    // Disconnect every client (workspace removal).
+    void closeConnections();
 
-    void publishRxUpdate(std::uint32_t comId, const std::map<std::string, FieldValue> &fields);
+    void publishRxUpdate(std::uint32_t comId, const std::map<std::string, FieldValue> &fields) override;
     void publishTxConfirmation(std::uint32_t comId, const std::map<std::string, FieldValue> &fields,
-                               std::optional<bool> txActive = std::nullopt);
+                               std::optional<bool> txActive = std::nullopt) override;
     void publishMdStatus(const std::string &sessionId, std::uint32_t comId, const std::string &event,
                          const std::string &mode, std::uint32_t expectedReplies, std::uint32_t receivedReplies,
                          const std::string &detail = "", const Json::Value &fields = Json::Value(),
-                         const Json::Value &options = Json::Value());
+                         const Json::Value &options = Json::Value()) override;
 
     void sendSnapshot(const drogon::WebSocketConnectionPtr &conn);
 
+    // True when at least one WebSocket client is connected; lets hot paths skip building payloads.
+    bool hasSubscribers() override;
+
     static TelegramHub *instance();
 
   private:
@@ -38,6 +49,11 @@ class TelegramHub : public drogon::Plugin<TelegramHub> {
     Json::Value fieldsToJson(const std::map<std::string, FieldValue> &fields) const;
     Json::Value telegramToJson(const TelegramDef &telegram) const;
 
+    TelegramRegistry &telegramRegistry() const;
+    TrdpEngine &trdpEngine() const;
+
+    TelegramRegistry *registry{nullptr};
+    TrdpEngine *engine{nullptr};
     std::mutex connMtx;
     std::set<drogon::WebSocketConnectionPtr> connections;
 };
@@ -0,0 +1,335 @@
+#include "realtime.h"
+
+#include <algorithm>
+#include <alloca.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace trdp {
+
+namespace {
+
+int nativePolicy(SchedPolicy policy) {
+    switch (policy) {
+    case SchedPolicy::Fifo:
+        return SCHED_FIFO;
+    case SchedPolicy::RoundRobin:
+        return SCHED_RR;
+    case SchedPolicy::Other:
+        break;
+    }
+    return SCHED_OTHER;
+}
+
+std::string describePolicy(int policy, int priority) {
+    switch (policy) {
+    case SCHED_FIFO:
+        return "SCHED_FIFO priority " + std::to_string(priority);
+    case SCHED_RR:
+        return "SCHED_RR priority " + std::to_string(priority);
+    case SCHED_OTHER:
+        return "SCHED_OTHER";
+    default:
+        return "policy " + std::to_string(policy);
+    }
+}
+
+std::vector<int> cpusOf(const cpu_set_t &set) {
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::string permissionHint(int err, const char *hint) {
+    std::string detail = std::strerror(err);
+    if (err == EPERM) {
+        detail += std::string(" (") + hint + ")";
+    }
+    return detail;
+}
+
+std::size_t pageSize() {
+    const long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : 4096U;
+}
+
+} // namespace
+
+std::optional<SchedPolicy> parseSchedPolicy(const std::string &value) {
+    std::string lowered(value.size(), '\0');
+    std::transform(value.begin(), value.end(), lowered.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lowered == "other" || lowered == "normal") {
+        return SchedPolicy::Other;
+    }
+    if (lowered == "fifo") {
+        return SchedPolicy::Fifo;
+    }
+    if (lowered == "rr") {
+        return SchedPolicy::RoundRobin;
+    }
+    return std::nullopt;
+}
+
+std::string schedPolicyToString(SchedPolicy policy) {
+    switch (policy) {
+    case SchedPolicy::Fifo:
+        return "fifo";
+    case SchedPolicy::RoundRobin:
+        return "rr";
+    case SchedPolicy::Other:
+        break;
+    }
+    return "other";
+}
+
+std::vector<RealtimeCheck> applyThreadRealtime(const std::string &label, const ThreadRealtime &settings) {
+    std::vector<RealtimeCheck> checks;
+    const auto self = pthread_self();
+
+    if (settings.policy != SchedPolicy::Other) {
+        RealtimeCheck check;
+        check.setting = label + " scheduling";
+        const auto policy = nativePolicy(settings.policy);
+        check.requested = describePolicy(policy, settings.priority);
+        const int minPriority = sched_get_priority_min(policy);
+        const int maxPriority = sched_get_priority_max(policy);
+        if (settings.priority < minPriority || settings.priority > maxPriority) {
+            check.detail = "priority must be " + std::to_string(minPriority) + "-" + std::to_string(maxPriority);
+        } else {
+            sched_param param{};
+            param.sched_priority = settings.priority;
+            const int err = pthread_setschedparam(self, policy, &param);
+            int actualPolicy = SCHED_OTHER;
+            sched_param actual{};
+            (void)pthread_getschedparam(self, &actualPolicy, &actual);
+            check.applied = err == 0 && actualPolicy == policy && actual.sched_priority == settings.priority;
+            check.detail = err != 0 ? permissionHint(err, "needs CAP_SYS_NICE or an rtprio limit")
+                                    : "running " + describePolicy(actualPolicy, actual.sched_priority);
+        }
+        checks.push_back(std::move(check));
+    }
+
+    if (settings.cpu >= 0) {
+        RealtimeCheck check;
+        check.setting = label + " affinity";
+        check.requested = "CPU " + std::to_string(settings.cpu);
+        if (settings.cpu >= CPU_SETSIZE) {
+            check.detail = "CPU out of range";
+        } else {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(settings.cpu, &set);
+            const int err = pthread_setaffinity_np(self, sizeof(set), &set);
+            cpu_set_t actual;
+            CPU_ZERO(&actual);
+            (void)pthread_getaffinity_np(self, sizeof(actual), &actual);
+            const auto cpus = cpusOf(actual);
+            check.applied = err == 0 && cpus == std::vector<int>{settings.cpu};
+            check.detail = err != 0 ? std::string(std::strerror(err)) : "running on CPU(s) " + formatCpuList(cpus);
+        }
+        checks.push_back(std::move(check));
+    }
+    return checks;
+}
+
+RealtimeCheck lockProcessMemory() {
+    RealtimeCheck check;
+    check.setting = "mlockall";
+    check.requested = "current and future pages";
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        const int err = errno;
+        check.detail = permissionHint(err, "raise RLIMIT_MEMLOCK, e.g. ulimit -l unlimited");
+        if (err == ENOMEM) {
+            check.detail += " (RLIMIT_MEMLOCK too small)";
+        }
+        return check;
+    }
+    // VmLck confirms the pages are actually locked.
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmLck:", 0) == 0) {
+            const auto value = line.substr(line.find_first_not_of(" \t", 6));
+            check.applied = std::atoll(value.c_str()) > 0;
+            check.detail = "VmLck " + value;
+            return check;
+        }
+    }
+    check.applied = true;
+    check.detail = "locked";
+    return check;
+}
+
+RealtimeCheck restrictThreadCpus(const std::string &label, const std::vector<int> &cpus) {
+    RealtimeCheck check;
+    check.setting = label + " affinity";
+    check.requested = "CPU(s) " + formatCpuList(cpus);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    if (CPU_COUNT(&set) == 0) {
+        check.detail = "no valid CPU";
+        return check;
+    }
+    const int rv = sched_setaffinity(0, sizeof(set), &set);
+    const int err = errno;
+    cpu_set_t actual;
+    CPU_ZERO(&actual);
+    (void)sched_getaffinity(0, sizeof(actual), &actual);
+    const auto applied = cpusOf(actual);
+    check.applied = rv == 0 && CPU_EQUAL(&set, &actual);
+    check.detail = rv != 0 ? std::string(std::strerror(err)) : "running on CPU(s) " + formatCpuList(applied);
+    return check;
+}
+
+std::vector<int> availableCpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return {};
+    }
+    return cpusOf(set);
+}
+
+void prefaultStack(std::size_t bytes) {
+    auto *stack = static_cast<volatile unsigned char *>(alloca(bytes));
+    const auto step = pageSize();
+    for (std::size_t offset = 0; offset < bytes; offset += step) {
+        stack[offset] = 0;
+    }
+}
+
+void prefaultPages(void *data, std::size_t size) {
+    if (data == nullptr || size == 0U) {
+        return;
+    }
+    auto *bytes = static_cast<volatile unsigned char *>(data);
+    const auto step = pageSize();
+    for (std::size_t offset = 0; offset < size; offset += step) {
+        bytes[offset] = bytes[offset];
+    }
+    bytes[size - 1U] = bytes[size - 1U];
+}
+
+std::string formatCpuList(const std::vector<int> &cpus) {
+    std::string result;
+    for (const auto cpu : cpus) {
+        if (!result.empty()) {
+            result += ',';
+        }
+        result += std::to_string(cpu);
+    }
+    return result.empty() ? "none" : result;
+}
+
+std::size_t CycleJitter::bucketOf(std::uint64_t ns) noexcept {
+    if (ns < kSubBuckets) {
+        return static_cast<std::size_t>(ns);
+    }
+    const auto msb = static_cast<std::size_t>(63 - __builtin_clzll(ns));
+    const auto step = static_cast<std::size_t>((ns >> (msb - 2)) & (kSubBuckets - 1));
+    return std::min(kBuckets - 1, (msb - 1) * kSubBuckets + step);
+}
+
+std::uint64_t CycleJitter::bucketUpperNs(std::size_t bucket) noexcept {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    const auto msb = bucket / kSubBuckets + 1;
+    const auto step = bucket % kSubBuckets;
+    return ((kSubBuckets + step + 1) << (msb - 2)) - 1;
+}
+
+void CycleJitter::record(std::chrono::nanoseconds lateness) noexcept {
+    const auto ns = static_cast<std::uint64_t>(std::max<std::int64_t>(lateness.count(), 0));
+    // Single writer, so the maximum needs no compare-exchange; the atomics only keep the API's reads well-defined.
+    histogram[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    totalNs.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > maxNs.load(std::memory_order_relaxed)) {
+        maxNs.store(ns, std::memory_order_relaxed);
+    }
+    count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CycleJitter::recordOverruns(std::uint64_t cycles) noexcept {
+    overruns.fetch_add(cycles, std::memory_order_relaxed);
+}
+
+CycleJitter::Snapshot CycleJitter::snapshot() const noexcept {
+    Snapshot result;
+    result.samples = count.load(std::memory_order_relaxed);
+    result.overruns = overruns.load(std::memory_order_relaxed);
+    result.maxUs = static_cast<double>(maxNs.load(std::memory_order_relaxed)) / 1000.0;
+    if (result.samples == 0) {
+        return result;
+    }
+    result.meanUs = static_cast<double>(totalNs.load(std::memory_order_relaxed)) / 1000.0 /
+                    static_cast<double>(result.samples);
+    const auto rank = result.samples - result.samples / 100;
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        seen += histogram[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            result.p99Us = std::min(static_cast<double>(bucketUpperNs(bucket)) / 1000.0, result.maxUs);
+            break;
+        }
+    }
+    return result;
+}
+
+void CycleJitter::reset() noexcept {
+    for (auto &bucket : histogram) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    totalNs.store(0, std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+    overruns.store(0, std::memory_order_relaxed);
+}
+
+RealtimeReport &RealtimeReport::instance() {
+    static RealtimeReport report;
+    return report;
+}
+
+void RealtimeReport::record(const RealtimeCheck &check) {
+    if (check.applied) {
+        std::cout << "[TRDP] Real-time " << check.setting << " (" << check.requested << "): ok, " << check.detail
+                  << std::endl;
+    } else {
+        std::cerr << "[TRDP] Real-time " << check.setting << " (" << check.requested
+                  << ") not applied: " << check.detail << std::endl;
+    }
+    std::lock_guard lock(mtx);
+    const auto it = std::find_if(entries.begin(), entries.end(),
+                                 [&](const RealtimeCheck &entry) { return entry.setting == check.setting; });
+    if (it != entries.end()) {
+        *it = check;
+    } else {
+        entries.push_back(check);
+    }
+}
+
+std::vector<RealtimeCheck> RealtimeReport::checks() const {
+    std::lock_guard lock(mtx);
+    return entries;
+}
+
+} // namespace trdp
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace trdp {
+
+enum class SchedPolicy { Other, Fifo, RoundRobin };
+
+// "other", "fifo" or "rr" (case-insensitive).
+std::optional<SchedPolicy> parseSchedPolicy(const std::string &value);
+std::string schedPolicyToString(SchedPolicy policy);
+
+// Scheduling of one processing thread. Priority is only used by the real-time policies (1-99 on Linux).
+struct ThreadRealtime {
+    SchedPolicy policy{SchedPolicy::Other};
+    int priority{0};
+    // CPU the thread is pinned to; negative leaves it unpinned.
+    int cpu{-1};
+};
+
+// Outcome of one real-time setting, read back from the kernel after it was applied.
+struct RealtimeCheck {
+    // E.g. "worker scheduling", "shard 1 affinity", "mlockall", "app affinity".
+    std::string setting;
+    std::string requested;
+    bool applied{false};
+    std::string detail;
+};
+
+// Apply policy, priority and CPU to the calling thread; returns one check per requested setting (none when
+// settings asks for nothing). label names the thread in the checks.
+std::vector<RealtimeCheck> applyThreadRealtime(const std::string &label, const ThreadRealtime &settings);
+
+// mlockall(MCL_CURRENT | MCL_FUTURE): keep every current and future page of the process resident.
+RealtimeCheck lockProcessMemory();
+
+// Restrict the calling thread, and every thread it creates afterwards, to cpus.
+RealtimeCheck restrictThreadCpus(const std::string &label, const std::vector<int> &cpus);
+
+// CPUs the process may run on.
+std::vector<int> availableCpus();
+
+// Write every page of the calling thread's stack down to bytes below the current frame, so later deep calls
+// do not page-fault.
+void prefaultStack(std::size_t bytes);
+
+// Touch every page of [data, data + size) without changing its contents.
+void prefaultPages(void *data, std::size_t size);
+
+std::string formatCpuList(const std::vector<int> &cpus);
+
+/**
+ * Measured lateness of one processing thread's cyclic publications: how long after its scheduled instant each
+ * telegram was handed to the transport. Recorded by that thread only and read lock-free by the API; the
+ * percentile comes from a histogram with four linear steps per power of two, so it is exact to within 25 %.
+ */
+class CycleJitter {
+  public:
+    struct Snapshot {
+        std::uint64_t samples{0};
+        double meanUs{0.0};
+        double p99Us{0.0};
+        double maxUs{0.0};
+        // Whole cycles skipped because the thread was still busy when the following one fell due.
+        std::uint64_t overruns{0};
+    };
+
+    void record(std::chrono::nanoseconds lateness) noexcept;
+    void recordOverruns(std::uint64_t cycles) noexcept;
+    [[nodiscard]] Snapshot snapshot() const noexcept;
+    void reset() noexcept;
+
+  private:
+    static constexpr std::size_t kSubBuckets = 4;
+    static constexpr std::size_t kBuckets = 64 * kSubBuckets;
+    static std::size_t bucketOf(std::uint64_t ns) noexcept;
+    static std::uint64_t bucketUpperNs(std::size_t bucket) noexcept;
+
+    std::array<std::atomic<std::uint64_t>, kBuckets> histogram{};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> totalNs{0};
+    std::atomic<std::uint64_t> maxNs{0};
+    std::atomic<std::uint64_t> overruns{0};
+};
+
+/**
+ * Startup report of the real-time settings. Each check is logged when recorded and replaces an earlier check of
+ * the same setting, so restarting the engine does not accumulate entries.
+ */
+class RealtimeReport {
+  public:
+    static RealtimeReport &instance();
+
+    void record(const RealtimeCheck &check);
+    [[nodiscard]] std::vector<RealtimeCheck> checks() const;
+
+  private:
+    RealtimeReport() = default;
+
+    mutable std::mutex mtx;
+    std::vector<RealtimeCheck> entries;
+};
+
+} // namespace trdp
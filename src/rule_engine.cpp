@@ -0,0 +1,832 @@
+#include "rule_engine.h"
+
+#include "field_history.h"
+#include "trdp_engine.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <tuple>
+
+namespace trdp {
+
+enum class RuleEngine::Op : std::uint8_t {
+    Const,
+    Load,
+    Neg,
+    Not,
+    BitNot,
+    Mul,
+    Div,
+    Mod,
+    Add,
+    Sub,
+    Shl,
+    Shr,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    Eq,
+    Ne,
+    BitAnd,
+    BitXor,
+    BitOr,
+    // Short circuit: keep the decided 0/1 on the stack and jump to arg, or pop the operand and fall through.
+    JumpIfFalse,
+    JumpIfTrue,
+    ToBool,
+};
+
+namespace {
+
+constexpr std::size_t kMaxStack = 32U;
+constexpr std::size_t kMaxNesting = 64U;
+
+bool truthy(double value) { return value != 0.0 && !std::isnan(value); }
+
+// Bitwise operators work on the integer part, saturated to the int64 range.
+std::int64_t toInt(double value) {
+    if (std::isnan(value)) {
+        return 0;
+    }
+    if (value >= 9.2233720368547758e18) {
+        return std::numeric_limits<std::int64_t>::max();
+    }
+    if (value <= -9.2233720368547758e18) {
+        return std::numeric_limits<std::int64_t>::min();
+    }
+    return static_cast<std::int64_t>(value);
+}
+
+bool isNumericScalar(const FieldDef &field) {
+    if (field.arrayLength != 1U) {
+        return false;
+    }
+    return field.type != FieldType::STRING && field.type != FieldType::BYTES;
+}
+
+template <typename T> T saturate(double value) {
+    if (std::isnan(value)) {
+        return T{};
+    }
+    const auto rounded = std::round(value);
+    if (rounded <= static_cast<double>(std::numeric_limits<T>::min())) {
+        return std::numeric_limits<T>::min();
+    }
+    if (rounded >= static_cast<double>(std::numeric_limits<T>::max())) {
+        return std::numeric_limits<T>::max();
+    }
+    return static_cast<T>(rounded);
+}
+
+FieldValue toFieldValue(FieldType type, double value) {
+    switch (type) {
+    case FieldType::BOOL:
+        return truthy(value);
+    case FieldType::INT8:
+        return saturate<std::int8_t>(value);
+    case FieldType::UINT8:
+        return saturate<std::uint8_t>(value);
+    case FieldType::INT16:
+        return saturate<std::int16_t>(value);
+    case FieldType::UINT16:
+        return saturate<std::uint16_t>(value);
+    case FieldType::INT32:
+        return saturate<std::int32_t>(value);
+    case FieldType::UINT32:
+        return saturate<std::uint32_t>(value);
+    case FieldType::FLOAT:
+        return static_cast<float>(value);
+    case FieldType::DOUBLE:
+        return value;
+    case FieldType::STRING:
+    case FieldType::BYTES:
+        break;
+    }
+    return std::monostate{};
+}
+
+std::size_t scalarWidth(FieldType type) {
+    switch (type) {
+    case FieldType::BOOL:
+    case FieldType::INT8:
+    case FieldType::UINT8:
+        return 1U;
+    case FieldType::INT16:
+    case FieldType::UINT16:
+        return 2U;
+    case FieldType::INT32:
+    case FieldType::UINT32:
+    case FieldType::FLOAT:
+        return 4U;
+    case FieldType::DOUBLE:
+        return 8U;
+    case FieldType::STRING:
+    case FieldType::BYTES:
+        break;
+    }
+    return 0U;
+}
+
+struct Token {
+    enum class Kind { Number, Name, Symbol, End };
+    Kind kind{Kind::End};
+    std::string text;
+    double number{0.0};
+    std::size_t position{0};
+};
+
+bool tokenize(const std::string &text, std::vector<Token> &tokens, std::string &error) {
+    static const char *const kSymbols[] = {"||", "&&", "==", "!=", "<=", ">=", "<<", ">>", "|", "^", "&", "<",
+                                           ">",  "+",  "-",  "*",  "/",  "%",  "!",  "~",  "(", ")", "."};
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        const auto c = static_cast<unsigned char>(text[pos]);
+        if (std::isspace(c) != 0) {
+            ++pos;
+            continue;
+        }
+        Token token;
+        token.position = pos;
+        if (std::isdigit(c) != 0) {
+            // A '.' only belongs to the number when a digit follows, so "1001.Status" is ComId 1001, field Status.
+            std::size_t end = pos;
+            if (text.compare(pos, 2, "0x") == 0 || text.compare(pos, 2, "0X") == 0) {
+                end += 2;
+                while (end < text.size() && std::isxdigit(static_cast<unsigned char>(text[end])) != 0) {
+                    ++end;
+                }
+                token.number = static_cast<double>(std::strtoull(text.c_str() + pos + 2, nullptr, 16));
+            } else {
+                while (end < text.size() && std::isdigit(static_cast<unsigned char>(text[end])) != 0) {
+                    ++end;
+                }
+                if (end + 1U < text.size() && text[end] == '.' &&
+                    std::isdigit(static_cast<unsigned char>(text[end + 1U])) != 0) {
+                    ++end;
+                    while (end < text.size() && std::isdigit(static_cast<unsigned char>(text[end])) != 0) {
+                        ++end;
+                    }
+                }
+                token.number = std::strtod(text.substr(pos, end - pos).c_str(), nullptr);
+            }
+            token.kind = Token::Kind::Number;
+            token.text = text.substr(pos, end - pos);
+            pos = end;
+        } else if (std::isalpha(c) != 0 || c == '_') {
+            std::size_t end = pos;
+            while (end < text.size() &&
+                   (std::isalnum(static_cast<unsigned char>(text[end])) != 0 || text[end] == '_')) {
+                ++end;
+            }
+            token.kind = Token::Kind::Name;
+            token.text = text.substr(pos, end - pos);
+            pos = end;
+        } else {
+            for (const auto *symbol : kSymbols) {
+                const std::string candidate(symbol);
+                if (text.compare(pos, candidate.size(), candidate) == 0) {
+                    token.kind = Token::Kind::Symbol;
+                    token.text = candidate;
+                    break;
+                }
+            }
+            if (token.kind != Token::Kind::Symbol) {
+                error = "unexpected '" + std::string(1, text[pos]) + "' at position " + std::to_string(pos);
+                return false;
+            }
+            pos += token.text.size();
+        }
+        tokens.push_back(std::move(token));
+    }
+    Token end;
+    end.position = text.size();
+    tokens.push_back(end);
+    return true;
+}
+
+} // namespace
+
+// Resolves telegram/field names against a registry snapshot and turns expressions into bytecode. Field loads are
+// deduplicated into the shared slot table.
+class RuleEngine::Compiler {
+  public:
+    explicit Compiler(std::vector<Slot> &slots) : slots(slots), contents(TelegramRegistry::instance().snapshot()) {}
+
+    bool compileRule(const RuleDef &def, CompiledRule &rule, std::string &error) {
+        if (!compileExpression(def.condition, rule.condition, rule.inputs, error)) {
+            error = "condition: " + error;
+            return false;
+        }
+        for (const auto &action : def.actions) {
+            const auto *telegram = findTelegram(action.telegram);
+            if (telegram == nullptr) {
+                error = "unknown telegram '" + action.telegram + "'";
+                return false;
+            }
+            if (telegram->direction != Direction::Tx) {
+                error = "'" + action.telegram + "' is not a TX telegram";
+                return false;
+            }
+            const auto *dataset = contents->findDataset(telegram->datasetName);
+            CompiledAction compiled;
+            compiled.comId = telegram->comId;
+            for (const auto &assignment : action.assignments) {
+                const auto *field = dataset ? dataset->findField(assignment.field) : nullptr;
+                if (field == nullptr) {
+                    error = "unknown field '" + action.telegram + "." + assignment.field + "'";
+                    return false;
+                }
+                if (!isNumericScalar(*field)) {
+                    error = "field '" + action.telegram + "." + assignment.field + "' is not a numeric scalar";
+                    return false;
+                }
+                CompiledAssignment target;
+                target.field = field->name;
+                target.type = field->type;
+                if (!compileExpression(assignment.expression, target.program, rule.inputs, error)) {
+                    error = action.telegram + "." + assignment.field + ": " + error;
+                    return false;
+                }
+                compiled.assignments.push_back(std::move(target));
+            }
+            rule.actions.push_back(std::move(compiled));
+        }
+        std::sort(rule.inputs.begin(), rule.inputs.end());
+        rule.inputs.erase(std::unique(rule.inputs.begin(), rule.inputs.end()), rule.inputs.end());
+        return true;
+    }
+
+  private:
+    bool compileExpression(const std::string &text, Program &program, std::vector<std::uint32_t> &refs,
+                           std::string &error) {
+        tokens.clear();
+        if (!tokenize(text, tokens, error)) {
+            return false;
+        }
+        if (tokens.size() == 1U) {
+            error = "empty expression";
+            return false;
+        }
+        current = 0;
+        depth = 0;
+        maxDepth = 0;
+        nesting = 0;
+        code = &program;
+        inputs = &refs;
+        parseError.clear();
+        program.code.clear();
+        if (!parseExpression(1) || !expectEnd()) {
+            error = parseError;
+            return false;
+        }
+        if (maxDepth > kMaxStack) {
+            error = "expression is too deeply nested";
+            return false;
+        }
+        return true;
+    }
+
+    static int precedence(const std::string &symbol) {
+        static const std::map<std::string, int> kPrecedence = {
+            {"||", 1}, {"&&", 2}, {"|", 3},  {"^", 4},  {"&", 5},  {"==", 6}, {"!=", 6}, {"<", 7},
+            {"<=", 7}, {">", 7},  {">=", 7}, {"<<", 8}, {">>", 8}, {"+", 9},  {"-", 9},  {"*", 10},
+            {"/", 10}, {"%", 10}};
+        const auto it = kPrecedence.find(symbol);
+        return it == kPrecedence.end() ? 0 : it->second;
+    }
+
+    static Op binaryOp(const std::string &symbol) {
+        static const std::map<std::string, Op> kOps = {
+            {"|", Op::BitOr}, {"^", Op::BitXor}, {"&", Op::BitAnd}, {"==", Op::Eq}, {"!=", Op::Ne},
+            {"<", Op::Lt},    {"<=", Op::Le},    {">", Op::Gt},     {">=", Op::Ge}, {"<<", Op::Shl},
+            {">>", Op::Shr},  {"+", Op::Add},    {"-", Op::Sub},    {"*", Op::Mul}, {"/", Op::Div},
+            {"%", Op::Mod}};
+        return kOps.at(symbol);
+    }
+
+    const Token &peek() const { return tokens[current]; }
+    bool isSymbol(const char *symbol) const {
+        return peek().kind == Token::Kind::Symbol && peek().text == symbol;
+    }
+
+    bool fail(const std::string &message) {
+        if (parseError.empty()) {
+            parseError = message + " at position " + std::to_string(peek().position);
+        }
+        return false;
+    }
+
+    bool expectEnd() { return peek().kind == Token::Kind::End || fail("unexpected '" + peek().text + "'"); }
+
+    std::size_t emit(Op op, std::uint32_t arg = 0, double value = 0.0) {
+        switch (op) {
+        case Op::Const:
+        case Op::Load:
+            ++depth;
+            break;
+        case Op::Neg:
+        case Op::Not:
+        case Op::BitNot:
+        case Op::ToBool:
+            break;
+        default:
+            // Binary operators, and the fall-through path of the short-circuit jumps, consume one operand.
+            --depth;
+            break;
+        }
+        maxDepth = std::max(maxDepth, depth);
+        code->code.push_back(Instruction{op, arg, value});
+        return code->code.size() - 1U;
+    }
+
+    // Precedence climbing; every operator is left-associative.
+    bool parseExpression(int minPrecedence) {
+        if (++nesting > kMaxNesting) {
+            return fail("expression is too deeply nested");
+        }
+        if (!parseUnary()) {
+            return false;
+        }
+        while (peek().kind == Token::Kind::Symbol) {
+            const auto symbol = peek().text;
+            const auto prec = precedence(symbol);
+            if (prec == 0 || prec < minPrecedence) {
+                break;
+            }
+            ++current;
+            if (symbol == "&&" || symbol == "||") {
+                const auto jump = emit(symbol == "&&" ? Op::JumpIfFalse : Op::JumpIfTrue);
+                if (!parseExpression(prec + 1)) {
+                    return false;
+                }
+                emit(Op::ToBool);
+                code->code[jump].arg = static_cast<std::uint32_t>(code->code.size());
+            } else {
+                if (!parseExpression(prec + 1)) {
+                    return false;
+                }
+                emit(binaryOp(symbol));
+            }
+        }
+        --nesting;
+        return true;
+    }
+
+    bool parseUnary() {
+        if (isSymbol("!") || isSymbol("-") || isSymbol("~") || isSymbol("+")) {
+            const auto symbol = peek().text;
+            ++current;
+            if (++nesting > kMaxNesting) {
+                return fail("expression is too deeply nested");
+            }
+            if (!parseUnary()) {
+                return false;
+            }
+            --nesting;
+            if (symbol == "!") {
+                emit(Op::Not);
+            } else if (symbol == "-") {
+                emit(Op::Neg);
+            } else if (symbol == "~") {
+                emit(Op::BitNot);
+            }
+            return true;
+        }
+        return parsePrimary();
+    }
+
+    bool parsePrimary() {
+        const auto token = peek();
+        if (isSymbol("(")) {
+            ++current;
+            if (!parseExpression(1)) {
+                return false;
+            }
+            if (!isSymbol(")")) {
+                return fail("expected ')'");
+            }
+            ++current;
+            return true;
+        }
+        if (token.kind == Token::Kind::Name && (token.text == "true" || token.text == "false")) {
+            ++current;
+            emit(Op::Const, 0, token.text == "true" ? 1.0 : 0.0);
+            return true;
+        }
+        if (token.kind != Token::Kind::Name && token.kind != Token::Kind::Number) {
+            return fail(token.kind == Token::Kind::End ? "unexpected end of expression"
+                                                       : "unexpected '" + token.text + "'");
+        }
+        ++current;
+        if (!isSymbol(".")) {
+            if (token.kind == Token::Kind::Number) {
+                emit(Op::Const, 0, token.number);
+                return true;
+            }
+            --current;
+            return fail("expected <Telegram>.<Field> instead of '" + token.text + "'");
+        }
+        ++current;
+        if (peek().kind != Token::Kind::Name) {
+            return fail("expected a field name after '" + token.text + ".'");
+        }
+        const auto fieldName = peek().text;
+        const auto reference = token.text + "." + fieldName;
+        const auto *telegram = findTelegram(token.text);
+        if (telegram == nullptr) {
+            return fail("unknown telegram '" + token.text + "'");
+        }
+        if (telegram->direction != Direction::Rx) {
+            return fail("'" + token.text + "' is not an RX telegram");
+        }
+        const auto *dataset = contents->findDataset(telegram->datasetName);
+        const auto *field = dataset ? dataset->findField(fieldName) : nullptr;
+        if (field == nullptr) {
+            return fail("unknown field '" + reference + "'");
+        }
+        if (!isNumericScalar(*field)) {
+            return fail("field '" + reference + "' is not a numeric scalar");
+        }
+        ++current;
+        const auto slot = slotFor(telegram->comId, *field);
+        inputs->push_back(slot);
+        emit(Op::Load, slot);
+        return true;
+    }
+
+    const TelegramDef *findTelegram(const std::string &ref) const {
+        for (const auto &[comId, telegram] : contents->telegrams) {
+            if (telegram->name == ref) {
+                return telegram.get();
+            }
+        }
+        if (!ref.empty() && std::all_of(ref.begin(), ref.end(), [](char c) { return std::isdigit(c) != 0; })) {
+            return contents->findTelegram(static_cast<std::uint32_t>(std::strtoul(ref.c_str(), nullptr, 10)));
+        }
+        return nullptr;
+    }
+
+    std::uint32_t slotFor(std::uint32_t comId, const FieldDef &field) {
+        const auto key = std::make_tuple(comId, field.offset, field.type);
+        const auto it = slotIndex.find(key);
+        if (it != slotIndex.end()) {
+            return it->second;
+        }
+        const auto index = static_cast<std::uint32_t>(slots.size());
+        slots.push_back(Slot{comId, field.type, field.offset, 0.0, false});
+        slotIndex.emplace(key, index);
+        return index;
+    }
+
+    std::vector<Slot> &slots;
+    std::map<std::tuple<std::uint32_t, std::size_t, FieldType>, std::uint32_t> slotIndex;
+    // Rules compile against one registry state.
+    std::shared_ptr<const RegistrySnapshot> contents;
+
+    std::vector<Token> tokens;
+    std::size_t current{0};
+    std::size_t depth{0};
+    std::size_t maxDepth{0};
+    std::size_t nesting{0};
+    Program *code{nullptr};
+    std::vector<std::uint32_t> *inputs{nullptr};
+    std::string parseError;
+};
+
+RuleEngine &RuleEngine::instance() {
+    static RuleEngine engine;
+    return engine;
+}
+
+std::optional<RuleEngine::Trigger> RuleEngine::parseTrigger(const std::string &value) {
+    if (value.empty() || value == "rising") {
+        return Trigger::Rising;
+    }
+    if (value == "always") {
+        return Trigger::Always;
+    }
+    return std::nullopt;
+}
+
+std::string RuleEngine::triggerToString(Trigger trigger) { return trigger == Trigger::Always ? "always" : "rising"; }
+
+bool RuleEngine::configure(const std::vector<RuleDef> &defs, std::string &error) {
+    std::vector<Rule> compiled;
+    std::vector<Slot> slots;
+    Compiler compiler(slots);
+    for (const auto &def : defs) {
+        if (def.name.empty()) {
+            error = "Every rule needs a name";
+            return false;
+        }
+        if (std::any_of(compiled.begin(), compiled.end(),
+                        [&](const Rule &rule) { return rule.def.name == def.name; })) {
+            error = "Duplicate rule name '" + def.name + "'";
+            return false;
+        }
+        Rule rule;
+        rule.def = def;
+        rule.stats.name = def.name;
+        CompiledRule program;
+        if (!compiler.compileRule(def, program, error)) {
+            error = "Rule '" + def.name + "': " + error;
+            return false;
+        }
+        rule.compiled = std::move(program);
+        rule.stats.compiled = true;
+        compiled.push_back(std::move(rule));
+    }
+
+    std::lock_guard lock(mtx);
+    link(compiled, slots);
+    std::cout << "[TRDP] Loaded " << ruleSet.size() << " rule(s) reading " << slotTable.size() << " field(s)"
+              << std::endl;
+    return true;
+}
+
+void RuleEngine::rebuild() {
+    std::lock_guard lock(mtx);
+    if (ruleSet.empty()) {
+        return;
+    }
+    std::vector<Rule> compiled;
+    std::vector<Slot> slots;
+    Compiler compiler(slots);
+    for (auto &previous : ruleSet) {
+        Rule rule;
+        rule.def = previous.def;
+        rule.stats = previous.stats;
+        rule.stats.state = false;
+        rule.stats.error.clear();
+        CompiledRule program;
+        std::string error;
+        if (compiler.compileRule(rule.def, program, error)) {
+            rule.compiled = std::move(program);
+        } else {
+            rule.stats.error = error;
+            std::cerr << "[TRDP] Rule '" << rule.def.name << "' disabled: " << error << std::endl;
+        }
+        rule.stats.compiled = rule.compiled.has_value();
+        compiled.push_back(std::move(rule));
+    }
+    link(compiled, slots);
+}
+
+void RuleEngine::link(std::vector<Rule> &rules, std::vector<Slot> &slots) {
+    ruleSet = std::move(rules);
+    slotTable = std::move(slots);
+    inputs.clear();
+    dependents.assign(slotTable.size(), {});
+    for (std::uint32_t index = 0; index < slotTable.size(); ++index) {
+        const auto &slot = slotTable[index];
+        auto &input = inputs[slot.comId];
+        input.slots.push_back(index);
+        input.minPayload = std::max(input.minPayload, slot.offset + scalarWidth(slot.type));
+    }
+    bool any = false;
+    for (std::uint32_t index = 0; index < ruleSet.size(); ++index) {
+        if (!ruleSet[index].compiled) {
+            continue;
+        }
+        any = true;
+        for (const auto slot : ruleSet[index].compiled->inputs) {
+            dependents[slot].push_back(index);
+        }
+    }
+    ++generation;
+    hasRules.store(any, std::memory_order_relaxed);
+}
+
+bool RuleEngine::evaluate(const Program &program, double &result) const {
+    double stack[kMaxStack];
+    std::size_t top = 0;
+    const auto *code = program.code.data();
+    const auto size = program.code.size();
+    std::size_t pc = 0;
+    while (pc < size) {
+        const auto &instruction = code[pc++];
+        switch (instruction.op) {
+        case Op::Const:
+            stack[top++] = instruction.value;
+            continue;
+        case Op::Load:
+            stack[top++] = slotTable[instruction.arg].value;
+            continue;
+        case Op::Neg:
+            stack[top - 1U] = -stack[top - 1U];
+            continue;
+        case Op::Not:
+            stack[top - 1U] = truthy(stack[top - 1U]) ? 0.0 : 1.0;
+            continue;
+        case Op::BitNot:
+            stack[top - 1U] = static_cast<double>(~toInt(stack[top - 1U]));
+            continue;
+        case Op::ToBool:
+            stack[top - 1U] = truthy(stack[top - 1U]) ? 1.0 : 0.0;
+            continue;
+        case Op::JumpIfFalse:
+        case Op::JumpIfTrue: {
+            const bool value = truthy(stack[top - 1U]);
+            if (value == (instruction.op == Op::JumpIfTrue)) {
+                stack[top - 1U] = value ? 1.0 : 0.0;
+                pc = instruction.arg;
+            } else {
+                --top;
+            }
+            continue;
+        }
+        default:
+            break;
+        }
+
+        const double rhs = stack[--top];
+        double &lhs = stack[top - 1U];
+        switch (instruction.op) {
+        case Op::Mul:
+            lhs *= rhs;
+            break;
+        case Op::Div:
+            if (rhs == 0.0) {
+                return false;
+            }
+            lhs /= rhs;
+            break;
+        case Op::Mod: {
+            const auto divisor = toInt(rhs);
+            if (divisor == 0) {
+                return false;
+            }
+            const auto dividend = toInt(lhs);
+            lhs = divisor == -1 ? 0.0 : static_cast<double>(dividend % divisor);
+            break;
+        }
+        case Op::Add:
+            lhs += rhs;
+            break;
+        case Op::Sub:
+            lhs -= rhs;
+            break;
+        case Op::Shl:
+        case Op::Shr: {
+            const auto shift = std::clamp<std::int64_t>(toInt(rhs), 0, 63);
+            const auto bits = static_cast<std::uint64_t>(toInt(lhs));
+            lhs = static_cast<double>(static_cast<std::int64_t>(instruction.op == Op::Shl ? bits << shift
+                                                                                           : bits >> shift));
+            break;
+        }
+        case Op::Lt:
+            lhs = lhs < rhs ? 1.0 : 0.0;
+            break;
+        case Op::Le:
+            lhs = lhs <= rhs ? 1.0 : 0.0;
+            break;
+        case Op::Gt:
+            lhs = lhs > rhs ? 1.0 : 0.0;
+            break;
+        case Op::Ge:
+            lhs = lhs >= rhs ? 1.0 : 0.0;
+            break;
+        case Op::Eq:
+            lhs = lhs == rhs ? 1.0 : 0.0;
+            break;
+        case Op::Ne:
+            lhs = lhs != rhs ? 1.0 : 0.0;
+            break;
+        case Op::BitAnd:
+            lhs = static_cast<double>(toInt(lhs) & toInt(rhs));
+            break;
+        case Op::BitXor:
+            lhs = static_cast<double>(toInt(lhs) ^ toInt(rhs));
+            break;
+        case Op::BitOr:
+            lhs = static_cast<double>(toInt(lhs) | toInt(rhs));
+            break;
+        default:
+            break;
+        }
+    }
+    result = stack[0];
+    return true;
+}
+
+void RuleEngine::onRx(std::uint32_t comId, const std::uint8_t *payload, std::size_t size) {
+    if (!active()) {
+        return;
+    }
+    const auto received = std::chrono::steady_clock::now();
+    std::vector<Pending> pending;
+    std::uint64_t firedGeneration = 0;
+    {
+        std::lock_guard lock(mtx);
+        const auto input = inputs.find(comId);
+        if (input == inputs.end() || size < input->second.minPayload) {
+            return;
+        }
+        // Refresh the slots and collect the rules reading a changed one, in configuration order.
+        std::vector<std::uint32_t> dirty;
+        for (const auto index : input->second.slots) {
+            auto &slot = slotTable[index];
+            const auto value = FieldHistory::readScalar(slot.type, payload + slot.offset);
+            if (slot.known && (value == slot.value || (std::isnan(value) && std::isnan(slot.value)))) {
+                continue;
+            }
+            slot.value = value;
+            slot.known = true;
+            dirty.insert(dirty.end(), dependents[index].begin(), dependents[index].end());
+        }
+        if (dirty.empty()) {
+            return;
+        }
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+        for (const auto index : dirty) {
+            auto &rule = ruleSet[index];
+            const auto &compiled = *rule.compiled;
+            if (!std::all_of(compiled.inputs.begin(), compiled.inputs.end(),
+                             [this](std::uint32_t slot) { return slotTable[slot].known; })) {
+                continue;
+            }
+            ++rule.stats.evaluations;
+            double condition = 0.0;
+            if (!evaluate(compiled.condition, condition)) {
+                ++rule.stats.failures;
+                continue;
+            }
+            const bool holds = truthy(condition);
+            const bool fire = holds && (rule.def.trigger == Trigger::Always || !rule.stats.state);
+            rule.stats.state = holds;
+            if (!fire) {
+                continue;
+            }
+            ++rule.stats.fires;
+            const auto firstAction = pending.size();
+            bool ok = true;
+            for (const auto &action : compiled.actions) {
+                Pending send{index, action.comId, {}};
+                for (const auto &assignment : action.assignments) {
+                    double value = 0.0;
+                    ok = ok && evaluate(assignment.program, value);
+                    send.fields[assignment.field] = toFieldValue(assignment.type, value);
+                }
+                pending.push_back(std::move(send));
+            }
+            if (!ok) {
+                ++rule.stats.failures;
+                pending.resize(firstAction);
+            }
+        }
+        firedGeneration = generation;
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    // Send outside the lock: the engine takes its own state lock and may be feeding onRx from another thread.
+    std::vector<std::pair<std::size_t, bool>> results;
+    results.reserve(pending.size());
+    for (const auto &send : pending) {
+        results.emplace_back(send.rule, TrdpEngine::instance().sendTxTelegram(send.comId, send.fields));
+    }
+    const auto reaction =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - received);
+
+    std::lock_guard lock(mtx);
+    if (generation != firedGeneration) {
+        return;
+    }
+    for (const auto &[index, sent] : results) {
+        auto &stats = ruleSet[index].stats;
+        stats.failures += sent ? 0U : 1U;
+        stats.lastReaction = reaction;
+        stats.maxReaction = std::max(stats.maxReaction, reaction);
+    }
+}
+
+std::vector<RuleEngine::RuleDef> RuleEngine::rules() {
+    std::lock_guard lock(mtx);
+    std::vector<RuleDef> defs;
+    defs.reserve(ruleSet.size());
+    for (const auto &rule : ruleSet) {
+        defs.push_back(rule.def);
+    }
+    return defs;
+}
+
+std::vector<RuleEngine::RuleStats> RuleEngine::stats() {
+    std::lock_guard lock(mtx);
+    std::vector<RuleStats> result;
+    result.reserve(ruleSet.size());
+    for (const auto &rule : ruleSet) {
+        result.push_back(rule.stats);
+    }
+    return result;
+}
+
+} // namespace trdp
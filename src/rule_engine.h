@@ -0,0 +1,162 @@
+#pragma once
+
+#include "telegram_model.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * Trigger rules evaluated inside the RX decode path.
+ *
+ * A rule pairs a condition over RX telegram fields, e.g. `RxStatus.ErrorFlags & 0x4`, with actions that assign TX
+ * fields and send the telegram (PD: the new values go out with the next cycle, MD: the message is sent right
+ * away). Expressions use C operator precedence over numbers, `<Telegram>.<Field>` references (telegram by name
+ * or ComId) and the literals true/false. They are parsed once and compiled to a small stack bytecode whose
+ * loads address numeric slots resolved to payload offsets, so evaluation never touches names or FieldValues.
+ *
+ * Each decoded RX payload refreshes the slots of its telegram; only rules reading a slot whose value changed are
+ * evaluated. A Rising rule fires when its condition turns true, an Always rule on every input change while the
+ * condition holds. Actions run on the thread that decoded the telegram. Rules wait until every input telegram
+ * has been received once.
+ */
+class RuleEngine {
+  public:
+    enum class Trigger { Rising, Always };
+
+    struct Assignment {
+        std::string field;
+        std::string expression;
+    };
+
+    struct ActionDef {
+        // Name or ComId of a TX telegram.
+        std::string telegram;
+        std::vector<Assignment> assignments;
+    };
+
+    struct RuleDef {
+        std::string name;
+        std::string condition;
+        Trigger trigger{Trigger::Rising};
+        std::vector<ActionDef> actions;
+    };
+
+    struct RuleStats {
+        std::string name;
+        bool compiled{false};
+        // Compile error after a registry reload that broke the rule.
+        std::string error;
+        bool state{false};
+        std::uint64_t evaluations{0};
+        std::uint64_t fires{0};
+        // Evaluation errors (division by zero) and actions the engine refused to send.
+        std::uint64_t failures{0};
+        // From RX decode to the last action handed to the stack.
+        std::chrono::nanoseconds lastReaction{0};
+        std::chrono::nanoseconds maxReaction{0};
+    };
+
+    static RuleEngine &instance();
+
+    // Replace the rule set. Every rule must compile against the current registry; on error nothing changes.
+    bool configure(const std::vector<RuleDef> &rules, std::string &error);
+    // Recompile the current rule set after the registry changed; rules that no longer compile stay inactive.
+    void rebuild();
+
+    // Refresh the inputs of comId from a decoded payload and run the rules that depend on changed values.
+    // Cheap no-op when no rule reads comId.
+    void onRx(std::uint32_t comId, const std::uint8_t *payload, std::size_t size);
+
+    std::vector<RuleDef> rules();
+    std::vector<RuleStats> stats();
+
+    static std::optional<Trigger> parseTrigger(const std::string &value);
+    static std::string triggerToString(Trigger trigger);
+
+    [[nodiscard]] bool active() const noexcept { return hasRules.load(std::memory_order_relaxed); }
+
+  private:
+    enum class Op : std::uint8_t;
+
+    struct Instruction {
+        Op op;
+        std::uint32_t arg{0};
+        double value{0.0};
+    };
+
+    struct Program {
+        std::vector<Instruction> code;
+    };
+
+    struct Slot {
+        std::uint32_t comId{0};
+        FieldType type{FieldType::UINT8};
+        std::size_t offset{0};
+        double value{0.0};
+        bool known{false};
+    };
+
+    struct Input {
+        std::size_t minPayload{0};
+        std::vector<std::uint32_t> slots;
+    };
+
+    struct CompiledAssignment {
+        std::string field;
+        FieldType type{FieldType::UINT8};
+        Program program;
+    };
+
+    struct CompiledAction {
+        std::uint32_t comId{0};
+        std::vector<CompiledAssignment> assignments;
+    };
+
+    struct CompiledRule {
+        Program condition;
+        std::vector<CompiledAction> actions;
+        std::vector<std::uint32_t> inputs;
+    };
+
+    struct Rule {
+        RuleDef def;
+        std::optional<CompiledRule> compiled;
+        RuleStats stats;
+    };
+
+    struct Pending {
+        std::size_t rule{0};
+        std::uint32_t comId{0};
+        std::map<std::string, FieldValue> fields;
+    };
+
+    class Compiler;
+
+    RuleEngine() = default;
+    RuleEngine(const RuleEngine &) = delete;
+    RuleEngine &operator=(const RuleEngine &) = delete;
+
+    void link(std::vector<Rule> &rules, std::vector<Slot> &slots);
+    bool evaluate(const Program &program, double &result) const;
+
+    std::mutex mtx;
+    std::vector<Rule> ruleSet;
+    std::vector<Slot> slotTable;
+    std::unordered_map<std::uint32_t, Input> inputs;
+    // Rules reading each slot.
+    std::vector<std::vector<std::uint32_t>> dependents;
+    // Bumped on every configure/rebuild so late statistics from in-flight actions are dropped.
+    std::uint64_t generation{0};
+    std::atomic<bool> hasRules{false};
+};
+
+} // namespace trdp
@@ -0,0 +1,161 @@
+#include "sdt.h"
+
+#include "checksum.h"
+
+#include <algorithm>
+
+namespace trdp {
+
+namespace {
+
+constexpr std::uint16_t kSdtProtocolVersion = 0x0002U;
+constexpr std::uint32_t kSc32Init = 0xFFFFFFFFU;
+
+void writeBe16(std::uint8_t *dest, std::uint16_t value) {
+    dest[0] = static_cast<std::uint8_t>(value >> 8U);
+    dest[1] = static_cast<std::uint8_t>(value);
+}
+
+void writeBe32(std::uint8_t *dest, std::uint32_t value) {
+    dest[0] = static_cast<std::uint8_t>(value >> 24U);
+    dest[1] = static_cast<std::uint8_t>(value >> 16U);
+    dest[2] = static_cast<std::uint8_t>(value >> 8U);
+    dest[3] = static_cast<std::uint8_t>(value);
+}
+
+std::uint16_t readBe16(const std::uint8_t *src) {
+    return static_cast<std::uint16_t>((src[0] << 8U) | src[1]);
+}
+
+std::uint32_t readBe32(const std::uint8_t *src) {
+    return (static_cast<std::uint32_t>(src[0]) << 24U) | (static_cast<std::uint32_t>(src[1]) << 16U) |
+           (static_cast<std::uint32_t>(src[2]) << 8U) | src[3];
+}
+
+} // namespace
+
+std::shared_ptr<SdtChannel> SdtChannel::compile(const SdtDef &def, std::size_t datasetSize,
+                                                std::chrono::milliseconds cycle, std::string &error) {
+    if (datasetSize < kTrailerSize) {
+        error = "SDT needs a dataset of at least " + std::to_string(kTrailerSize) + " bytes for its trailer";
+        return nullptr;
+    }
+    if (def.nRxSafe == 0U) {
+        error = "SDT n-rxsafe must be at least 1";
+        return nullptr;
+    }
+    auto channel = std::make_shared<SdtChannel>();
+    channel->def = def;
+    channel->sid = computeSid(def);
+    channel->txPeriod = def.txPeriod.count() > 0 ? def.txPeriod : cycle;
+    const std::chrono::nanoseconds rxPeriod = def.rxPeriod.count() > 0 ? def.rxPeriod : channel->txPeriod;
+    channel->freshWindow = rxPeriod * def.nRxSafe;
+    channel->counters.config = def;
+    channel->counters.sid = channel->sid;
+    return channel;
+}
+
+std::uint32_t SdtChannel::computeSid(const SdtDef &def) {
+    std::uint8_t block[28] = {};
+    writeBe32(block, def.smi);
+    writeBe16(block + 6, kSdtProtocolVersion);
+    std::copy(def.consistId.begin(), def.consistId.end(), block + 8);
+    writeBe32(block + 24, def.safeTopoCount);
+    return sc32(block, sizeof(block), kSc32Init);
+}
+
+void SdtChannel::seal(std::uint8_t *buffer, std::size_t size) {
+    if (buffer == nullptr || size < kTrailerSize) {
+        return;
+    }
+    std::lock_guard lock(mtx);
+    auto *trailer = buffer + size - kTrailerSize;
+    writeBe32(trailer, 0U);
+    writeBe16(trailer + 4, 0U);
+    writeBe16(trailer + 6, def.userDataVersion);
+    writeBe32(trailer + 8, ++ssc);
+    writeBe32(trailer + 12, sc32(buffer, size - 4U, sid));
+    ++counters.sealed;
+    counters.ssc = ssc;
+}
+
+bool SdtChannel::check(const std::uint8_t *payload, std::size_t size, std::chrono::steady_clock::time_point now) {
+    std::lock_guard lock(mtx);
+    ++counters.received;
+    if (synced && freshWindow.count() > 0 && now - lastNewAt > freshWindow) {
+        // One error per stale period. The channel resynchronises on this telegram, which also recovers from a
+        // restarted sender whose SSC went backwards.
+        ++counters.freshnessErrors;
+        synced = false;
+        lastValid = false;
+    }
+    if (payload == nullptr || size < kTrailerSize) {
+        ++counters.scErrors;
+        lastValid = false;
+        return false;
+    }
+    const auto *trailer = payload + size - kTrailerSize;
+    if (readBe32(trailer + 12) != sc32(payload, size - 4U, sid)) {
+        ++counters.scErrors;
+        lastValid = false;
+        return false;
+    }
+    if (readBe16(trailer + 6) != def.userDataVersion) {
+        ++counters.udvErrors;
+        lastValid = false;
+        return false;
+    }
+
+    const auto received = readBe32(trailer + 8);
+    if (!synced) {
+        synced = true;
+        ssc = received;
+        refSsc = received;
+        refTime = now;
+        lastNewAt = now;
+        lastValid = true;
+        counters.ssc = received;
+        ++counters.accepted;
+        return true;
+    }
+
+    const auto advance = received - ssc;
+    if (advance == 0U || advance >= 0x80000000U) {
+        // Repeated or earlier SSC: the data is not new. Validity is left to the freshness supervision.
+        ++counters.oldSsc;
+        return false;
+    }
+    counters.lostSsc += advance - 1U;
+    ssc = received;
+    counters.ssc = received;
+    lastNewAt = now;
+
+    if (def.lmiMax > 0U && txPeriod.count() > 0) {
+        // The sender steps the SSC once per cycle, so the reference predicts the SSC that should be arriving now.
+        const auto elapsedCycles = static_cast<std::uint32_t>((now - refTime) / txPeriod);
+        const auto lag = static_cast<std::int32_t>(refSsc + elapsedCycles - received);
+        if (lag < 0) {
+            // Arrived faster than the reference telegram: it becomes the new reference.
+            refSsc = received;
+            refTime = now;
+        } else if (static_cast<std::uint32_t>(lag) > def.lmiMax) {
+            ++counters.latencyErrors;
+            refSsc = received;
+            refTime = now;
+            lastValid = false;
+            return false;
+        }
+    }
+    lastValid = true;
+    ++counters.accepted;
+    return true;
+}
+
+SdtChannel::Stats SdtChannel::stats(std::chrono::steady_clock::time_point now) {
+    std::lock_guard lock(mtx);
+    auto result = counters;
+    result.valid = synced && lastValid && (freshWindow.count() == 0 || now - lastNewAt <= freshWindow);
+    return result;
+}
+
+} // namespace trdp
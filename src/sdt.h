@@ -0,0 +1,78 @@
+#pragma once
+
+#include "telegram_model.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * SDTv2 safe data transmission on one PD telegram.
+ *
+ * The last 16 bytes of the dataset are the SDT trailer (big-endian): reserved UINT32 and UINT16, user data
+ * version, safe sequence counter (SSC) and the SC-32 safety code over everything before it, seeded with the SID.
+ * The SID is the SC-32 of the SMI, the SDT protocol version, the consist UUID and the safe topography counter.
+ *
+ * A TX channel seals every publication: it stamps the user data version, increments the SSC and computes the
+ * safety code. An RX channel checks each received telegram and tracks the SDT error classes: safety code and
+ * user data version failures, old (repeated or earlier) SSCs, lost SSCs, latency (the SSC lags behind the one
+ * expected from the sender cycle by more than lmiMax cycles) and freshness (no newer SSC within nRxSafe receive
+ * periods). Invalid telegrams are still decoded, so the bad values can be inspected.
+ */
+class SdtChannel {
+  public:
+    static constexpr std::size_t kTrailerSize = 16U;
+
+    struct Stats {
+        SdtDef config;
+        std::uint32_t sid{0};
+        // RX: the last telegram passed every check and the SSC is still fresh.
+        bool valid{false};
+        std::uint32_t ssc{0};
+        std::uint64_t sealed{0};
+        std::uint64_t received{0};
+        std::uint64_t accepted{0};
+        std::uint64_t scErrors{0};
+        std::uint64_t udvErrors{0};
+        std::uint64_t oldSsc{0};
+        std::uint64_t lostSsc{0};
+        std::uint64_t latencyErrors{0};
+        std::uint64_t freshnessErrors{0};
+    };
+
+    // Build a channel for a telegram whose dataset is datasetSize bytes; cycle is the telegram cycle and the
+    // default sender period. Returns nullptr and fills error when the parameters do not fit.
+    static std::shared_ptr<SdtChannel> compile(const SdtDef &def, std::size_t datasetSize,
+                                               std::chrono::milliseconds cycle, std::string &error);
+
+    static std::uint32_t computeSid(const SdtDef &def);
+
+    // TX: write the trailer for the next publication into buffer.
+    void seal(std::uint8_t *buffer, std::size_t size);
+    // RX: validate a received VDP; returns true when it passed every check.
+    bool check(const std::uint8_t *payload, std::size_t size, std::chrono::steady_clock::time_point now);
+
+    Stats stats(std::chrono::steady_clock::time_point now);
+
+  private:
+    std::mutex mtx;
+    SdtDef def;
+    std::uint32_t sid{0};
+    std::chrono::nanoseconds txPeriod{0};
+    std::chrono::nanoseconds freshWindow{0};
+    std::uint32_t ssc{0};
+    bool synced{false};
+    bool lastValid{false};
+    // Latency reference: the SSC accepted at refTime.
+    std::uint32_t refSsc{0};
+    std::chrono::steady_clock::time_point refTime{};
+    std::chrono::steady_clock::time_point lastNewAt{};
+    Stats counters;
+};
+
+} // namespace trdp
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "telegram_model.h"
+
+#include <json/value.h>
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace trdp {
+
+/**
+ * Receiver of the per-telegram events a TrdpEngine reports: RX updates, TX confirmations and MD session
+ * progress. The TelegramHub plugin implements it for the web clients; the engine itself only knows this
+ * interface, so it links without the web backend.
+ */
+class TelegramEventSink {
+  public:
+    virtual ~TelegramEventSink() = default;
+
+    // True when anyone listens; lets hot paths skip building payloads.
+    virtual bool hasSubscribers() = 0;
+
+    virtual void publishRxUpdate(std::uint32_t comId, const std::map<std::string, FieldValue> &fields) = 0;
+    virtual void publishTxConfirmation(std::uint32_t comId, const std::map<std::string, FieldValue> &fields,
+                                       std::optional<bool> txActive = std::nullopt) = 0;
+    virtual void publishMdStatus(const std::string &sessionId, std::uint32_t comId, const std::string &event,
+                                 const std::string &mode, std::uint32_t expectedReplies,
+                                 std::uint32_t receivedReplies, const std::string &detail = "",
+                                 const Json::Value &fields = Json::Value(),
+                                 const Json::Value &options = Json::Value()) = 0;
+};
+
+} // namespace trdp
@@ -1,5 +1,8 @@
 #include "telegram_model.h"
 
+#include "config_image.h"
+#include "memory_usage.h"
+
 #include <arpa/inet.h>
 
 #include <algorithm>
@@ -7,7 +10,9 @@
 #include <cctype>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <mutex>
 #include <stdexcept>
 #include <system_error>
@@ -224,6 +229,128 @@ std::optional<std::uint16_t> parsePort(const tinyxml2::XMLElement &element, cons
     return static_cast<std::uint16_t>(value);
 }
 
+bool parseBoolAttribute(const tinyxml2::XMLElement &element, const char *name, bool fallback = false) {
+    if (const char *value = element.Attribute(name)) {
+        const auto upper = toUpper(value);
+        return upper == "1" || upper == "TRUE" || upper == "YES" || upper == "ON";
+    }
+    return fallback;
+}
+
+ReplyFieldSource parseReplySource(const std::string &rawSource) {
+    const auto source = toUpper(rawSource);
+    if (source == "ECHO") {
+        return ReplyFieldSource::Echo;
+    }
+    if (source == "COUNTER") {
+        return ReplyFieldSource::Counter;
+    }
+    if (source == "CRC16") {
+        return ReplyFieldSource::Crc16;
+    }
+    return ReplyFieldSource::Template;
+}
+
+MdReplierDef parseReplier(const tinyxml2::XMLElement &element) {
+    MdReplierDef replier;
+    replier.enabled = parseBoolAttribute(element, "replier", false);
+    replier.replyComId = static_cast<std::uint32_t>(parseSizeAttribute(element, "replyComId", 0U));
+    if (const char *dataset = element.Attribute("replyDataset")) {
+        replier.replyDataset = dataset;
+    }
+    replier.delay = std::chrono::milliseconds(parseSizeAttribute(element, "replyDelay", 0U));
+    replier.maxRepliesPerSecond = static_cast<std::uint32_t>(parseSizeAttribute(element, "replyRate", 0U));
+    replier.requireConfirm = parseBoolAttribute(element, "replyConfirm", false);
+    replier.confirmTimeout = std::chrono::milliseconds(parseSizeAttribute(element, "replyConfirmTimeout", 0U));
+    replier.userStatus = static_cast<std::uint16_t>(parseSizeAttribute(element, "replyStatus", 0U));
+
+    for (auto child = element.FirstChildElement(); child != nullptr; child = child->NextSiblingElement()) {
+        if (toUpper(child->Name() ? child->Name() : "") != "REPLY" || child->Attribute("field") == nullptr) {
+            continue;
+        }
+        ReplyFieldRule rule;
+        rule.field = child->Attribute("field");
+        if (const char *source = child->Attribute("source")) {
+            rule.source = parseReplySource(source);
+        }
+        if (const char *from = child->Attribute("from")) {
+            rule.requestField = from;
+        }
+        rule.crcStart = parseSizeAttribute(*child, "start", 0U);
+        rule.crcLength = parseSizeAttribute(*child, "length", 0U);
+        replier.fields.push_back(rule);
+    }
+    if (!replier.fields.empty() || replier.replyComId != 0U || !replier.replyDataset.empty()) {
+        replier.enabled = parseBoolAttribute(element, "replier", true);
+    }
+    return replier;
+}
+
+double parseDoubleAttribute(const tinyxml2::XMLElement &element, const char *name, double fallback) {
+    if (const char *value = element.Attribute(name)) {
+        char *endPtr = nullptr;
+        const auto parsed = std::strtod(value, &endPtr);
+        if (endPtr != value) {
+            return parsed;
+        }
+    }
+    return fallback;
+}
+
+std::vector<FieldGeneratorDef> parseGenerators(const tinyxml2::XMLElement &element) {
+    std::vector<FieldGeneratorDef> generators;
+    for (auto child = element.FirstChildElement(); child != nullptr; child = child->NextSiblingElement()) {
+        if (toUpper(child->Name() ? child->Name() : "") != "GENERATOR" || child->Attribute("field") == nullptr) {
+            continue;
+        }
+        FieldGeneratorDef generator;
+        generator.field = child->Attribute("field");
+        if (const char *kind = child->Attribute("kind")) {
+            const auto parsed = parseFieldGeneratorKind(kind);
+            if (!parsed) {
+                std::cerr << "Skipping generator for field " << generator.field << ": unknown kind " << kind << "\n";
+                continue;
+            }
+            generator.kind = *parsed;
+        }
+        generator.min = parseDoubleAttribute(*child, "min", generator.min);
+        generator.max = parseDoubleAttribute(*child, "max", generator.max);
+        generator.step = parseDoubleAttribute(*child, "step", generator.step);
+        generator.period = std::chrono::milliseconds(parseSizeAttribute(*child, "period", 1000U));
+        generator.order = static_cast<std::uint32_t>(parseSizeAttribute(*child, "order", generator.order));
+        generator.seed = static_cast<std::uint32_t>(parseSizeAttribute(*child, "seed", generator.seed));
+        generators.push_back(generator);
+    }
+    return generators;
+}
+
+SdtDef parseSdt(const tinyxml2::XMLElement &element) {
+    SdtDef sdt;
+    for (auto child = element.FirstChildElement(); child != nullptr; child = child->NextSiblingElement()) {
+        const auto name = toUpper(child->Name() ? child->Name() : "");
+        if (name != "SDT-PARAMETER" && name != "SDT") {
+            continue;
+        }
+        sdt.enabled = true;
+        sdt.smi = static_cast<std::uint32_t>(parseSizeAttribute(*child, "smi1", parseSizeAttribute(*child, "smi", 0U)));
+        sdt.userDataVersion = static_cast<std::uint16_t>(parseSizeAttribute(*child, "udv", 0U));
+        sdt.safeTopoCount = static_cast<std::uint32_t>(parseSizeAttribute(*child, "safe-topo-count", 0U));
+        if (const char *consist = child->Attribute("consist-id")) {
+            if (const auto parsed = parseConsistId(consist)) {
+                sdt.consistId = *parsed;
+            } else {
+                std::cerr << "Ignoring SDT consist-id " << consist << ": expected 32 hex digits\n";
+            }
+        }
+        sdt.txPeriod = std::chrono::milliseconds(parseSizeAttribute(*child, "tx-period", 0U));
+        sdt.rxPeriod = std::chrono::milliseconds(parseSizeAttribute(*child, "rx-period", 0U));
+        sdt.nRxSafe = static_cast<std::uint32_t>(parseSizeAttribute(*child, "n-rxsafe", sdt.nRxSafe));
+        sdt.lmiMax = static_cast<std::uint32_t>(parseSizeAttribute(*child, "lmi-max", sdt.lmiMax));
+        break;
+    }
+    return sdt;
+}
+
 bool elementMatches(const tinyxml2::XMLElement &element, const std::vector<std::string> &names) {
     const auto nameUpper = toUpper(element.Name() ? element.Name() : "");
     return std::any_of(names.begin(), names.end(), [&nameUpper](const std::string &candidate) {
@@ -240,11 +367,298 @@ void collectElements(const tinyxml2::XMLElement &root, const std::vector<std::st
         collectElements(*child, names, out);
     }
 }
+
+std::uint64_t hashFieldName(const std::string &name) {
+    // FNV-1a.
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (const auto c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::size_t displacedSlot(std::uint64_t hash, std::uint32_t displacement, std::size_t mask) {
+    // Finaliser of MurmurHash3, so every displacement gives an independent slot.
+    std::uint64_t mixed = hash ^ (displacement * 0x9E3779B97F4A7C15ULL);
+    mixed ^= mixed >> 33U;
+    mixed *= 0xFF51AFD7ED558CCDULL;
+    mixed ^= mixed >> 33U;
+    return static_cast<std::size_t>(mixed) & mask;
+}
+
+std::size_t nextPowerOfTwo(std::size_t value) {
+    std::size_t result = 1;
+    while (result < value) {
+        result <<= 1U;
+    }
+    return result;
+}
 } // namespace
 
+bool operator==(const FieldDef &a, const FieldDef &b) {
+    return a.name == b.name && a.type == b.type && a.offset == b.offset && a.size == b.size &&
+           a.bitOffset == b.bitOffset && a.arrayLength == b.arrayLength && a.checksum == b.checksum &&
+           a.checksumStart == b.checksumStart && a.checksumLength == b.checksumLength;
+}
+
+bool operator==(const DatasetDef &a, const DatasetDef &b) {
+    return a.name == b.name && a.size == b.size && a.fields == b.fields;
+}
+
+bool operator==(const ReplyFieldRule &a, const ReplyFieldRule &b) {
+    return a.field == b.field && a.source == b.source && a.requestField == b.requestField &&
+           a.crcStart == b.crcStart && a.crcLength == b.crcLength;
+}
+
+bool operator==(const MdReplierDef &a, const MdReplierDef &b) {
+    return a.enabled == b.enabled && a.replyComId == b.replyComId && a.replyDataset == b.replyDataset &&
+           a.delay == b.delay && a.maxRepliesPerSecond == b.maxRepliesPerSecond &&
+           a.requireConfirm == b.requireConfirm && a.confirmTimeout == b.confirmTimeout &&
+           a.userStatus == b.userStatus && a.fields == b.fields;
+}
+
+bool operator==(const FieldGeneratorDef &a, const FieldGeneratorDef &b) {
+    return a.field == b.field && a.kind == b.kind && a.min == b.min && a.max == b.max && a.step == b.step &&
+           a.period == b.period && a.order == b.order && a.seed == b.seed;
+}
+
+bool operator==(const SdtDef &a, const SdtDef &b) {
+    return a.enabled == b.enabled && a.smi == b.smi && a.userDataVersion == b.userDataVersion &&
+           a.consistId == b.consistId && a.safeTopoCount == b.safeTopoCount && a.txPeriod == b.txPeriod &&
+           a.rxPeriod == b.rxPeriod && a.nRxSafe == b.nRxSafe && a.lmiMax == b.lmiMax;
+}
+
+bool operator==(const TelegramDef &a, const TelegramDef &b) {
+    return a.comId == b.comId && a.name == b.name && a.direction == b.direction && a.type == b.type &&
+           a.datasetName == b.datasetName && a.srcIp == b.srcIp && a.destIp == b.destIp && a.ttl == b.ttl &&
+           a.srcPort == b.srcPort && a.destPort == b.destPort && a.trdpFlags == b.trdpFlags && a.qos == b.qos &&
+           a.cycle == b.cycle && a.expectedReplies == b.expectedReplies && a.replyTimeout == b.replyTimeout &&
+           a.confirmTimeout == b.confirmTimeout && a.replier == b.replier && a.generators == b.generators &&
+           a.sdt == b.sdt;
+}
+
 FieldValue defaultValueForField(const FieldDef &field) { return defaultValueForFieldImpl(field); }
 
+std::optional<FieldGeneratorKind> parseFieldGeneratorKind(const std::string &value) {
+    static const std::pair<const char *, FieldGeneratorKind> kKinds[] = {
+        {"COUNTER", FieldGeneratorKind::Counter},   {"RAMP", FieldGeneratorKind::Ramp},
+        {"SINE", FieldGeneratorKind::Sine},         {"SQUARE", FieldGeneratorKind::Square},
+        {"SAWTOOTH", FieldGeneratorKind::Sawtooth}, {"RANDOMWALK", FieldGeneratorKind::RandomWalk},
+        {"PRBS", FieldGeneratorKind::Prbs}};
+    const auto upper = toUpper(value);
+    for (const auto &[name, kind] : kKinds) {
+        if (upper == name) {
+            return kind;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string fieldGeneratorKindToString(FieldGeneratorKind kind) {
+    switch (kind) {
+    case FieldGeneratorKind::Counter:
+        return "counter";
+    case FieldGeneratorKind::Ramp:
+        return "ramp";
+    case FieldGeneratorKind::Sine:
+        return "sine";
+    case FieldGeneratorKind::Square:
+        return "square";
+    case FieldGeneratorKind::Sawtooth:
+        return "sawtooth";
+    case FieldGeneratorKind::RandomWalk:
+        return "randomwalk";
+    case FieldGeneratorKind::Prbs:
+        return "prbs";
+    }
+    return "counter";
+}
+
+std::optional<ChecksumKind> parseChecksumKind(const std::string &value) {
+    const auto upper = toUpper(value);
+    if (upper == "CRC16") {
+        return ChecksumKind::Crc16;
+    }
+    if (upper == "CRC32") {
+        return ChecksumKind::Crc32;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::array<std::uint8_t, 16>> parseConsistId(const std::string &value) {
+    std::array<std::uint8_t, 16> result{};
+    std::size_t digits = 0;
+    for (const char c : value) {
+        if (c == '-') {
+            continue;
+        }
+        if (std::isxdigit(static_cast<unsigned char>(c)) == 0 || digits >= 32U) {
+            return std::nullopt;
+        }
+        const auto nibble = static_cast<std::uint8_t>(std::isdigit(static_cast<unsigned char>(c)) != 0
+                                                          ? c - '0'
+                                                          : std::toupper(static_cast<unsigned char>(c)) - 'A' + 10);
+        result[digits / 2U] = static_cast<std::uint8_t>((result[digits / 2U] << 4U) | nibble);
+        ++digits;
+    }
+    if (digits != 32U) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::string consistIdToString(const std::array<std::uint8_t, 16> &consistId) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(32);
+    for (const auto byte : consistId) {
+        result.push_back(kHex[byte >> 4U]);
+        result.push_back(kHex[byte & 0x0FU]);
+    }
+    return result;
+}
+
+std::string checksumKindToString(ChecksumKind kind) {
+    switch (kind) {
+    case ChecksumKind::Crc16:
+        return "crc16";
+    case ChecksumKind::Crc32:
+        return "crc32";
+    case ChecksumKind::None:
+        break;
+    }
+    return "none";
+}
+
+void FieldNameIndex::build(const std::vector<FieldDef> &fields) {
+    displacements.clear();
+    slots.clear();
+    indexed = 0;
+
+    // (hash, position), without later duplicates of a name: findField returns the first field of that name.
+    std::vector<std::pair<std::uint64_t, std::int32_t>> keys;
+    keys.reserve(fields.size());
+    for (std::size_t position = 0; position < fields.size(); ++position) {
+        keys.emplace_back(hashFieldName(fields[position].name), static_cast<std::int32_t>(position));
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::pair<std::uint64_t, std::int32_t>> unique;
+    unique.reserve(keys.size());
+    for (const auto &key : keys) {
+        if (!unique.empty() && unique.back().first == key.first) {
+            if (fields[unique.back().second].name != fields[key.second].name) {
+                return; // 64-bit collision of two names: leave the dataset unindexed.
+            }
+            continue;
+        }
+        unique.push_back(key);
+    }
+
+    // Buckets of about four names each, placed largest first into a table at most half full.
+    const std::size_t bucketCount = nextPowerOfTwo(std::max<std::size_t>(1, unique.size() / 4U));
+    std::vector<std::vector<std::pair<std::uint64_t, std::int32_t>>> buckets(bucketCount);
+    for (const auto &key : unique) {
+        buckets[(key.first >> 32U) & (bucketCount - 1U)].push_back(key);
+    }
+    std::vector<std::size_t> order(bucketCount);
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&buckets](std::size_t a, std::size_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    constexpr std::uint32_t kMaxDisplacement = 1U << 16U;
+    for (std::size_t tableSize = nextPowerOfTwo(unique.size() * 2U); tableSize <= unique.size() * 16U + 16U;
+         tableSize *= 2U) {
+        const std::size_t mask = tableSize - 1U;
+        std::vector<std::int32_t> table(tableSize, -1);
+        std::vector<std::uint32_t> chosen(bucketCount, 0);
+        std::vector<std::size_t> placed;
+        bool complete = true;
+        for (const auto bucket : order) {
+            const auto &members = buckets[bucket];
+            if (members.empty()) {
+                break;
+            }
+            std::uint32_t displacement = 0;
+            for (; displacement < kMaxDisplacement; ++displacement) {
+                placed.clear();
+                bool fits = true;
+                for (const auto &member : members) {
+                    const auto slot = displacedSlot(member.first, displacement, mask);
+                    if (table[slot] >= 0 || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+                        fits = false;
+                        break;
+                    }
+                    placed.push_back(slot);
+                }
+                if (fits) {
+                    break;
+                }
+            }
+            if (displacement == kMaxDisplacement) {
+                complete = false;
+                break;
+            }
+            chosen[bucket] = displacement;
+            for (std::size_t i = 0; i < members.size(); ++i) {
+                table[placed[i]] = members[i].second;
+            }
+        }
+        if (complete) {
+            displacements = std::move(chosen);
+            slots = std::move(table);
+            indexed = fields.size();
+            return;
+        }
+    }
+}
+
+std::int32_t FieldNameIndex::candidate(const std::string &name) const {
+    if (slots.empty()) {
+        return -1;
+    }
+    const auto hash = hashFieldName(name);
+    const auto displacement = displacements[(hash >> 32U) & (displacements.size() - 1U)];
+    return slots[displacedSlot(hash, displacement, slots.size() - 1U)];
+}
+
+bool FieldNameIndex::restore(std::vector<std::uint32_t> displacementTable, std::vector<std::int32_t> slotTable,
+                             std::size_t fieldCount) {
+    displacements.clear();
+    slots.clear();
+    indexed = 0;
+    if (displacementTable.empty() && slotTable.empty()) {
+        return true; // Stored unindexed.
+    }
+    const auto powerOfTwo = [](std::size_t value) { return value != 0U && (value & (value - 1U)) == 0U; };
+    if (!powerOfTwo(displacementTable.size()) || !powerOfTwo(slotTable.size())) {
+        return false;
+    }
+    for (const auto position : slotTable) {
+        if (position >= 0 && static_cast<std::size_t>(position) >= fieldCount) {
+            return false;
+        }
+    }
+    displacements = std::move(displacementTable);
+    slots = std::move(slotTable);
+    indexed = fieldCount;
+    return true;
+}
+
+std::size_t FieldNameIndex::footprint() const noexcept {
+    return displacements.size() * sizeof(std::uint32_t) + slots.size() * sizeof(std::int32_t);
+}
+
 const FieldDef *DatasetDef::findField(const std::string &fieldName) const {
+    if (!fields.empty() && fieldIndex.size() == fields.size()) {
+        const auto position = fieldIndex.candidate(fieldName);
+        if (position < 0 || static_cast<std::size_t>(position) >= fields.size() ||
+            fields[static_cast<std::size_t>(position)].name != fieldName) {
+            return nullptr;
+        }
+        return &fields[static_cast<std::size_t>(position)];
+    }
     const auto it = std::find_if(fields.begin(), fields.end(), [&fieldName](const FieldDef &field) {
         return field.name == fieldName;
     });
@@ -254,6 +668,8 @@ const FieldDef *DatasetDef::findField(const std::string &fieldName) const {
     return &(*it);
 }
 
+void DatasetDef::indexFields() { fieldIndex.build(fields); }
+
 std::size_t DatasetDef::computeSize() const {
     if (size > 0) {
         return size;
@@ -269,147 +685,318 @@ std::size_t DatasetDef::computeSize() const {
     return maxOffset;
 }
 
-TelegramRuntime::TelegramRuntime(const DatasetDef &dataset)
-    : datasetDef(dataset), buffer(calculateInitialBufferSize()) {
-    for (const auto &field : datasetDef.fields) {
-        fieldValues.emplace(field.name, defaultValueForField(field));
+TelegramRuntime::TelegramRuntime(std::shared_ptr<const DatasetDef> dataset) : datasetDef(std::move(dataset)) {
+    length = datasetDef->computeSize();
+    allocateOwnStorage(length);
+    fieldValues.reserve(datasetDef->fields.size());
+    for (const auto &field : datasetDef->fields) {
+        fieldValues.push_back(defaultValueForField(field));
     }
 }
 
+std::size_t TelegramRuntime::fieldPosition(const std::string &fieldName) const {
+    const auto *field = datasetDef->findField(fieldName);
+    return field != nullptr ? static_cast<std::size_t>(field - datasetDef->fields.data()) : std::string::npos;
+}
+
 std::optional<FieldValue> TelegramRuntime::getFieldValue(const std::string &fieldName) const {
-    std::shared_lock lock(mtx);
-    const auto it = fieldValues.find(fieldName);
-    if (it == fieldValues.end()) {
+    const auto position = fieldPosition(fieldName);
+    if (position == std::string::npos) {
         return std::nullopt;
     }
-    return it->second;
+    std::shared_lock lock(mtx);
+    return fieldValues[position];
 }
 
 std::map<std::string, FieldValue> TelegramRuntime::snapshotFields() const {
+    std::map<std::string, FieldValue> result;
     std::shared_lock lock(mtx);
-    return fieldValues;
+    for (std::size_t i = 0; i < fieldValues.size(); ++i) {
+        // A repeated name keeps the first field's value, as findField does.
+        result.emplace(datasetDef->fields[i].name, fieldValues[i]);
+    }
+    return result;
 }
 
 bool TelegramRuntime::setFieldValue(const std::string &fieldName, const FieldValue &value) {
-    std::unique_lock lock(mtx);
-    const auto it = fieldValues.find(fieldName);
-    if (it == fieldValues.end()) {
+    const auto position = fieldPosition(fieldName);
+    if (position == std::string::npos) {
         return false;
     }
-    it->second = value;
+    std::unique_lock lock(mtx);
+    fieldValues[position] = value;
     return true;
 }
 
 std::vector<std::uint8_t> TelegramRuntime::getBufferCopy() const {
     std::shared_lock lock(mtx);
-    return buffer;
+    return std::vector<std::uint8_t>(bytes, bytes + length);
 }
 
 void TelegramRuntime::overwriteBuffer(const std::vector<std::uint8_t> &data) {
     std::unique_lock lock(mtx);
-    buffer = data;
+    if (data.size() > capacity) {
+        allocateOwnStorage(data.size());
+    }
+    std::copy(data.begin(), data.end(), bytes);
+    length = data.size();
 }
 
-void TelegramRuntime::updateBuffer(const std::function<void(std::vector<std::uint8_t> &)> &mutator) {
+std::size_t TelegramRuntime::bufferSize() const noexcept { return length; }
+
+void TelegramRuntime::relocate(const std::shared_ptr<BufferArena> &arena, std::size_t slot) {
     std::unique_lock lock(mtx);
-    mutator(buffer);
+    if (slot >= arena->slotCount() || arena->slotCapacity(slot) < length) {
+        return;
+    }
+    auto *target = arena->slot(slot);
+    std::copy(bytes, bytes + length, target);
+    storage = arena;
+    bytes = target;
+    capacity = arena->slotCapacity(slot);
+}
+
+std::size_t TelegramRuntime::bufferCapacity() const {
+    std::shared_lock lock(mtx);
+    return capacity;
 }
 
-std::size_t TelegramRuntime::bufferSize() const noexcept { return buffer.size(); }
+std::size_t TelegramRuntime::memoryUsage() const {
+    std::shared_lock lock(mtx);
+    std::size_t total = sizeof(TelegramRuntime) + kSharedControlBlock + heapBytes(fieldValues);
+    for (const auto &value : fieldValues) {
+        if (const auto *text = std::get_if<std::string>(&value)) {
+            total += heapBytes(*text);
+        } else if (const auto *raw = std::get_if<std::vector<std::uint8_t>>(&value)) {
+            total += heapBytes(*raw);
+        }
+    }
+    return total;
+}
 
-std::size_t TelegramRuntime::calculateInitialBufferSize() const { return datasetDef.computeSize(); }
+void TelegramRuntime::allocateOwnStorage(std::size_t size) {
+    auto own = BufferArena::create({BufferArena::Request{size, BufferArena::kCacheLine}});
+    if (bytes != nullptr) {
+        std::copy(bytes, bytes + std::min(length, size), own->slot(0));
+    }
+    storage = std::move(own);
+    bytes = storage->slot(0);
+    capacity = storage->slotCapacity(0);
+}
 
 TelegramRegistry &TelegramRegistry::instance() {
     static TelegramRegistry registry;
     return registry;
 }
 
+const DatasetDef *RegistrySnapshot::findDataset(const std::string &name) const {
+    const auto it = datasets.find(name);
+    return it != datasets.end() ? it->second.get() : nullptr;
+}
+
+const TelegramDef *RegistrySnapshot::findTelegram(std::uint32_t comId) const {
+    if (comIdIndex.size() == telegrams.size()) {
+        const auto *entry = comIdIndex.find(comId);
+        return entry != nullptr ? entry->telegram : nullptr;
+    }
+    const auto it = telegrams.find(comId);
+    return it != telegrams.end() ? it->second.get() : nullptr;
+}
+
+const DatasetDef *RegistrySnapshot::datasetOf(std::uint32_t comId) const {
+    if (comIdIndex.size() == telegrams.size()) {
+        const auto *entry = comIdIndex.find(comId);
+        return entry != nullptr ? entry->dataset : nullptr;
+    }
+    const auto *telegram = findTelegram(comId);
+    return telegram != nullptr ? findDataset(telegram->datasetName) : nullptr;
+}
+
+void RegistrySnapshot::addDataset(DatasetDef dataset) {
+    dataset.indexFields();
+    auto name = dataset.name;
+    datasets[std::move(name)] = std::make_shared<const DatasetDef>(std::move(dataset));
+    comIdIndex.clear();
+}
+
+bool RegistrySnapshot::addTelegram(TelegramDef telegram) {
+    if (datasets.find(telegram.datasetName) == datasets.end()) {
+        return false;
+    }
+    const auto comId = telegram.comId;
+    telegrams[comId] = std::make_shared<const TelegramDef>(std::move(telegram));
+    comIdIndex.clear();
+    return true;
+}
+
+void RegistrySnapshot::buildIndex() {
+    std::vector<std::pair<std::uint32_t, IndexEntry>> entries;
+    entries.reserve(telegrams.size());
+    for (const auto &[comId, telegram] : telegrams) {
+        entries.emplace_back(comId, IndexEntry{telegram.get(), findDataset(telegram->datasetName)});
+    }
+    comIdIndex.build(entries);
+}
+
 void TelegramRegistry::registerDataset(const DatasetDef &dataset) {
-    std::unique_lock lock(mtx);
-    datasets[dataset.name] = dataset;
+    std::lock_guard lock(mtx);
+    auto next = std::make_shared<RegistrySnapshot>(*current);
+    next->addDataset(dataset);
+    publishLocked(std::move(next));
 }
 
 void TelegramRegistry::registerTelegram(const TelegramDef &telegram) {
-    std::unique_lock lock(mtx);
-    const auto datasetIt = datasets.find(telegram.datasetName);
-    if (datasetIt == datasets.end()) {
+    std::lock_guard lock(mtx);
+    auto next = std::make_shared<RegistrySnapshot>(*current);
+    if (!next->addTelegram(telegram)) {
         throw std::invalid_argument("Dataset not registered for telegram: " + telegram.datasetName);
     }
-    telegrams[telegram.comId] = telegram;
+    publishLocked(std::move(next));
 }
 
 void TelegramRegistry::clear() {
-    std::unique_lock lock(mtx);
-    datasets.clear();
-    telegrams.clear();
-    runtimes.clear();
+    std::lock_guard lock(mtx);
+    publishLocked(std::make_shared<RegistrySnapshot>());
+}
+
+std::shared_ptr<const RegistrySnapshot> TelegramRegistry::snapshot() const {
+    return std::atomic_load(&current);
+}
+
+void TelegramRegistry::publish(RegistrySnapshot next) {
+    std::lock_guard lock(mtx);
+    publishLocked(std::make_shared<RegistrySnapshot>(std::move(next)));
+}
+
+void TelegramRegistry::publishLocked(std::shared_ptr<RegistrySnapshot> next) {
+    // A reloaded XML arrives as all-new definitions; those equal to the current ones take over the current
+    // pointers, so their runtimes survive and the engine keeps their endpoints.
+    for (auto &[name, dataset] : next->datasets) {
+        const auto it = current->datasets.find(name);
+        if (it != current->datasets.end() && it->second != dataset && *it->second == *dataset) {
+            dataset = it->second;
+        }
+    }
+    for (auto &[comId, telegram] : next->telegrams) {
+        const auto it = current->telegrams.find(comId);
+        if (it != current->telegrams.end() && it->second != telegram && *it->second == *telegram) {
+            telegram = it->second;
+        }
+    }
+    next->buildIndex();
+    runtimes.eraseIf([&](std::uint32_t comId, const std::shared_ptr<TelegramRuntime> &) {
+        // Datasets are shared between snapshots until replaced, so a changed layout shows as a new pointer.
+        const auto *after = next->datasetOf(comId);
+        return after == nullptr || after != current->datasetOf(comId);
+    });
+    std::atomic_store(&current, std::shared_ptr<const RegistrySnapshot>(std::move(next)));
 }
 
 std::vector<DatasetDef> TelegramRegistry::listDatasets() const {
-    std::shared_lock lock(mtx);
+    const auto contents = snapshot();
     std::vector<DatasetDef> result;
-    result.reserve(datasets.size());
-    for (const auto &entry : datasets) {
-        result.push_back(entry.second);
+    result.reserve(contents->datasets.size());
+    for (const auto &entry : contents->datasets) {
+        result.push_back(*entry.second);
     }
     return result;
 }
 
 std::optional<DatasetDef> TelegramRegistry::getDatasetCopy(const std::string &name) const {
-    std::shared_lock lock(mtx);
-    const auto it = datasets.find(name);
-    if (it == datasets.end()) {
-        return std::nullopt;
+    const auto contents = snapshot();
+    if (const auto *dataset = contents->findDataset(name)) {
+        return *dataset;
     }
-    return it->second;
+    return std::nullopt;
 }
 
 std::optional<TelegramDef> TelegramRegistry::getTelegramCopy(std::uint32_t comId) const {
-    std::shared_lock lock(mtx);
-    const auto it = telegrams.find(comId);
-    if (it == telegrams.end()) {
-        return std::nullopt;
+    const auto contents = snapshot();
+    if (const auto *telegram = contents->findTelegram(comId)) {
+        return *telegram;
     }
-    return it->second;
+    return std::nullopt;
 }
 
 std::vector<TelegramDef> TelegramRegistry::listTelegrams() const {
-    std::shared_lock lock(mtx);
+    const auto contents = snapshot();
     std::vector<TelegramDef> result;
-    result.reserve(telegrams.size());
-    for (const auto &entry : telegrams) {
-        result.push_back(entry.second);
+    result.reserve(contents->telegrams.size());
+    for (const auto &entry : contents->telegrams) {
+        result.push_back(*entry.second);
     }
     return result;
 }
 
 std::shared_ptr<TelegramRuntime> TelegramRegistry::getOrCreateRuntime(std::uint32_t comId) {
-    std::unique_lock lock(mtx);
-    const auto runtimeIt = runtimes.find(comId);
-    if (runtimeIt != runtimes.end()) {
-        return runtimeIt->second;
+    std::lock_guard lock(mtx);
+    if (const auto *runtime = runtimes.find(comId)) {
+        return *runtime;
     }
 
-    const auto telegramIt = telegrams.find(comId);
-    if (telegramIt == telegrams.end()) {
+    const auto *telegram = current->findTelegram(comId);
+    if (telegram == nullptr) {
         return nullptr;
     }
-
-    const auto datasetIt = datasets.find(telegramIt->second.datasetName);
-    if (datasetIt == datasets.end()) {
+    const auto dataset = current->datasets.find(telegram->datasetName);
+    if (dataset == current->datasets.end()) {
         return nullptr;
     }
 
-    auto runtime = std::make_shared<TelegramRuntime>(datasetIt->second);
-    runtimes.emplace(comId, runtime);
+    auto runtime = std::make_shared<TelegramRuntime>(dataset->second);
+    runtimes[comId] = runtime;
     return runtime;
 }
 
+RegistryMemory TelegramRegistry::memoryUsage() const {
+    RegistryMemory usage;
+    const auto contents = snapshot();
+    for (const auto &[name, dataset] : contents->datasets) {
+        usage.datasetBytes += kTreeNodeOverhead + sizeof(name) + heapBytes(name) + kSharedControlBlock +
+                              sizeof(DatasetDef) + heapBytes(dataset->name) + heapBytes(dataset->fields) +
+                              dataset->fieldIndex.footprint();
+        for (const auto &field : dataset->fields) {
+            usage.datasetBytes += heapBytes(field.name);
+        }
+    }
+    usage.datasets = contents->datasets.size();
+    for (const auto &[comId, telegram] : contents->telegrams) {
+        (void)comId;
+        usage.telegramBytes += kTreeNodeOverhead + sizeof(comId) + sizeof(telegram) + kSharedControlBlock +
+                               sizeof(TelegramDef) + heapBytes(telegram->name) + heapBytes(telegram->datasetName) +
+                               heapBytes(telegram->replier.replyDataset) + heapBytes(telegram->replier.fields) +
+                               heapBytes(telegram->generators);
+        for (const auto &rule : telegram->replier.fields) {
+            usage.telegramBytes += heapBytes(rule.field) + heapBytes(rule.requestField);
+        }
+        for (const auto &generator : telegram->generators) {
+            usage.telegramBytes += heapBytes(generator.field);
+        }
+    }
+    usage.telegrams = contents->telegrams.size();
+    usage.telegramBytes += contents->comIdIndex.footprint();
+
+    std::lock_guard lock(mtx);
+    usage.runtimes = runtimes.size();
+    for (const auto &[comId, runtime] : runtimes) {
+        (void)comId;
+        usage.runtimeBytes += sizeof(comId) + sizeof(runtime) + runtime->memoryUsage();
+        usage.bufferBytes += runtime->bufferCapacity();
+    }
+    return usage;
+}
+
 bool loadFromTauXml(const std::string &xmlPath) {
     defaultXmlLoaded = false;
+    defaultXmlLoaded = loadFromTauXml(xmlPath, TelegramRegistry::instance());
+    return defaultXmlLoaded;
+}
+
+namespace {
 
+bool compileTauXml(const std::string &xmlPath, const std::string &source, RegistrySnapshot &contents) {
     tinyxml2::XMLDocument doc;
-    if (doc.LoadFile(xmlPath.c_str()) != tinyxml2::XML_SUCCESS) {
+    if (doc.Parse(source.data(), source.size()) != tinyxml2::XML_SUCCESS) {
         std::cerr << "Failed to load TRDP XML: " << xmlPath << " (" << doc.ErrorStr() << ")\n";
         return false;
     }
@@ -420,8 +1007,6 @@ bool loadFromTauXml(const std::string &xmlPath) {
         return false;
     }
 
-    TelegramRegistry::instance().clear();
-
     std::vector<const tinyxml2::XMLElement *> datasetNodes;
     collectElements(*root, {"dataset", "DataSet", "Dataset"}, datasetNodes);
 
@@ -456,12 +1041,22 @@ bool loadFromTauXml(const std::string &xmlPath) {
             if (field.arrayLength == 0) {
                 field.arrayLength = 1;
             }
+            if (const char *checksum = fieldNode->Attribute("checksum")) {
+                if (const auto kind = parseChecksumKind(checksum)) {
+                    field.checksum = *kind;
+                    field.checksumStart = parseSizeAttribute(*fieldNode, "checksumStart", 0U);
+                    field.checksumLength = parseSizeAttribute(*fieldNode, "checksumLength", 0U);
+                } else {
+                    std::cerr << "Ignoring checksum of field " << field.name << ": unknown algorithm " << checksum
+                              << "\n";
+                }
+            }
 
             dataset.fields.push_back(field);
         }
 
         if (!dataset.name.empty()) {
-            TelegramRegistry::instance().registerDataset(dataset);
+            contents.addDataset(std::move(dataset));
         }
     }
 
@@ -522,15 +1117,61 @@ bool loadFromTauXml(const std::string &xmlPath) {
         if (confirmTimeoutMs > 0U) {
             telegram.confirmTimeout = std::chrono::milliseconds(confirmTimeoutMs);
         }
+        if (telegram.type == TelegramType::MD) {
+            telegram.replier = parseReplier(*tgNode);
+        } else {
+            if (telegram.direction == Direction::Tx) {
+                telegram.generators = parseGenerators(*tgNode);
+            }
+            telegram.sdt = parseSdt(*tgNode);
+        }
 
-        try {
-            TelegramRegistry::instance().registerTelegram(telegram);
-        } catch (const std::exception &ex) {
-            std::cerr << "Skipping telegram with ComId " << telegram.comId << ": " << ex.what() << "\n";
+        const auto datasetName = telegram.datasetName;
+        if (!contents.addTelegram(std::move(telegram))) {
+            std::cerr << "Skipping telegram with ComId " << *comId << ": Dataset not registered for telegram: "
+                      << datasetName << "\n";
         }
     }
+    return true;
+}
 
-    defaultXmlLoaded = true;
+} // namespace
+
+bool loadFromTauXml(const std::string &xmlPath, TelegramRegistry &registry) {
+    std::ifstream file(xmlPath, std::ios::binary);
+    const std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!file.is_open() || file.bad()) {
+        std::cerr << "Failed to load TRDP XML: " << xmlPath << " (unable to read file)\n";
+        return false;
+    }
+
+    // A compiled image of exactly this XML skips parsing altogether.
+    const auto started = std::chrono::steady_clock::now();
+    const auto sourceHash = configSourceHash(source);
+    const auto imagePath = configImagePath(xmlPath);
+    if (!imagePath.empty()) {
+        if (auto image = readConfigImage(imagePath, sourceHash)) {
+            const auto telegramCount = image->telegrams.size();
+            registry.publish(std::move(*image));
+            std::cout << "[TRDP] Loaded " << telegramCount << " telegram(s) from config image " << imagePath
+                      << " in "
+                      << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                               started)
+                             .count()
+                      << " us" << std::endl;
+            return true;
+        }
+    }
+
+    // Built off-line and swapped in at the end, so readers never see a half-loaded registry.
+    RegistrySnapshot contents;
+    if (!compileTauXml(xmlPath, source, contents)) {
+        return false;
+    }
+    if (!imagePath.empty() && writeConfigImage(imagePath, contents, sourceHash)) {
+        std::cout << "[TRDP] Compiled " << xmlPath << " into config image " << imagePath << std::endl;
+    }
+    registry.publish(std::move(contents));
     return true;
 }
 
@@ -597,5 +1238,15 @@ bool ensureRegistryInitialized() {
     return defaultXmlLoaded;
 }
 
+void markRegistryPopulated() {
+    std::call_once(xmlBootstrapFlag, []() {});
+    defaultXmlLoaded = true;
+}
+
+bool reloadDefaultXml() {
+    std::call_once(xmlBootstrapFlag, []() {});
+    return loadDefaultXmlInternal();
+}
+
 } // namespace trdp
 
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "buffer_arena.h"
+#include "flat_index.h"
+
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -28,6 +32,9 @@ enum class FieldType {
     BYTES,
 };
 
+// Checksum the engine computes into a field on encode and verifies on receive.
+enum class ChecksumKind { None, Crc16, Crc32 };
+
 struct FieldDef {
     std::string name;
     FieldType type{FieldType::BYTES};
@@ -35,21 +42,123 @@ struct FieldDef {
     std::size_t size{0};
     std::size_t bitOffset{0};
     std::size_t arrayLength{1};
+    // Computed checksum over checksumLength bytes from checksumStart; a zero length covers everything from
+    // checksumStart up to the field.
+    ChecksumKind checksum{ChecksumKind::None};
+    std::size_t checksumStart{0};
+    std::size_t checksumLength{0};
+};
+
+/**
+ * Minimal perfect hash over the field names of one dataset (hash and displace): a name hashes to a bucket whose
+ * displacement sends it to a slot no other name uses, so a lookup is one hash of the name, two array reads and a
+ * single string compare. Positions refer to DatasetDef::fields.
+ */
+class FieldNameIndex {
+  public:
+    void build(const std::vector<FieldDef> &fields);
+    // Position of the only field that can be called name; the caller confirms the name matches.
+    [[nodiscard]] std::int32_t candidate(const std::string &name) const;
+    // Number of fields the index was built over.
+    [[nodiscard]] std::size_t size() const noexcept { return indexed; }
+    [[nodiscard]] std::size_t footprint() const noexcept;
+
+    // The built tables, so a compiled configuration image can store the index instead of searching it again.
+    [[nodiscard]] const std::vector<std::uint32_t> &displacementTable() const noexcept { return displacements; }
+    [[nodiscard]] const std::vector<std::int32_t> &slotTable() const noexcept { return slots; }
+    // Adopt tables stored from an index over fieldCount fields; false, leaving the index empty, when they are not
+    // power-of-two sized or point outside the fields.
+    bool restore(std::vector<std::uint32_t> displacementTable, std::vector<std::int32_t> slotTable,
+                 std::size_t fieldCount);
+
+  private:
+    std::vector<std::uint32_t> displacements;
+    std::vector<std::int32_t> slots;
+    std::size_t indexed{0};
 };
 
 struct DatasetDef {
     std::string name;
     std::size_t size{0};
     std::vector<FieldDef> fields;
+    // Built by indexFields(); findField scans linearly while it does not cover fields.
+    FieldNameIndex fieldIndex;
 
     [[nodiscard]] const FieldDef *findField(const std::string &fieldName) const;
     [[nodiscard]] std::size_t computeSize() const;
+    // Index the field names; call again after changing fields. Registering a dataset does this.
+    void indexFields();
 };
 
 enum class Direction { Tx, Rx };
 
 enum class TelegramType { PD, MD };
 
+// How a reply field is filled when the engine answers an MD request automatically.
+enum class ReplyFieldSource { Template, Echo, Counter, Crc16 };
+
+struct ReplyFieldRule {
+    std::string field;
+    ReplyFieldSource source{ReplyFieldSource::Template};
+    // Request field copied into the reply for Echo rules.
+    std::string requestField;
+    // Byte range of the reply covered by Crc16 rules; a zero length covers everything before the field.
+    std::size_t crcStart{0};
+    std::size_t crcLength{0};
+};
+
+struct MdReplierDef {
+    bool enabled{false};
+    // ComId used for the reply; its dataset/runtime provide the reply template. Falls back to the request ComId.
+    std::uint32_t replyComId{0};
+    // Explicit reply dataset when no reply telegram is configured.
+    std::string replyDataset;
+    std::chrono::milliseconds delay{0};
+    // Maximum replies per second (0 = unlimited); excess requests are dropped.
+    std::uint32_t maxRepliesPerSecond{0};
+    bool requireConfirm{false};
+    std::chrono::milliseconds confirmTimeout{0};
+    std::uint16_t userStatus{0};
+    std::vector<ReplyFieldRule> fields;
+};
+
+// Value the engine writes into a TX PD field before every cyclic publication.
+enum class FieldGeneratorKind { Counter, Ramp, Sine, Square, Sawtooth, RandomWalk, Prbs };
+
+struct FieldGeneratorDef {
+    std::string field;
+    FieldGeneratorKind kind{FieldGeneratorKind::Counter};
+    // Counters wrap from max back to min, ramps bounce between them, waveforms swing across them and random walks
+    // stay inside. max <= min selects the full range of an integer field.
+    double min{0.0};
+    double max{0.0};
+    // Counter/ramp increment and largest random walk move per cycle.
+    double step{1.0};
+    std::chrono::milliseconds period{1000};
+    // PRBS polynomial order (7, 9, 15, 23 or 31).
+    std::uint32_t order{7};
+    std::uint32_t seed{1};
+};
+
+// SDTv2 parameters of a safe PD telegram (the TCNopen <sdt-parameter> element). The last 16 bytes of its dataset
+// carry the SDT trailer: two reserved words, the user data version, the SSC and the safety code.
+struct SdtDef {
+    bool enabled{false};
+    // Safe message identifier.
+    std::uint32_t smi{0};
+    std::uint16_t userDataVersion{0};
+    // Consist UUID and safe topography counter, folded into the SID together with the SMI.
+    std::array<std::uint8_t, 16> consistId{};
+    std::uint32_t safeTopoCount{0};
+    // Sender cycle; 0 uses the telegram cycle.
+    std::chrono::milliseconds txPeriod{0};
+    // Receiver sampling period; 0 uses txPeriod. Data without a newer SSC for nRxSafe * rxPeriod is stale.
+    std::chrono::milliseconds rxPeriod{0};
+    std::uint32_t nRxSafe{3};
+    // Largest tolerated latency in sender cycles; 0 disables latency monitoring.
+    std::uint32_t lmiMax{0};
+};
+
 using FieldValue = std::variant<
     std::monostate,
     bool,
@@ -83,13 +192,48 @@ struct TelegramDef {
     std::uint32_t expectedReplies{0};
     std::chrono::milliseconds replyTimeout{0};
     std::chrono::milliseconds confirmTimeout{0};
+    MdReplierDef replier;
+    std::vector<FieldGeneratorDef> generators;
+    SdtDef sdt;
 };
 
+// Definitions compare by configuration; derived state such as DatasetDef::fieldIndex is not compared.
+bool operator==(const FieldDef &a, const FieldDef &b);
+bool operator==(const DatasetDef &a, const DatasetDef &b);
+bool operator==(const ReplyFieldRule &a, const ReplyFieldRule &b);
+bool operator==(const MdReplierDef &a, const MdReplierDef &b);
+bool operator==(const FieldGeneratorDef &a, const FieldGeneratorDef &b);
+bool operator==(const SdtDef &a, const SdtDef &b);
+bool operator==(const TelegramDef &a, const TelegramDef &b);
+
 FieldValue defaultValueForField(const FieldDef &field);
+// "counter", "ramp", "sine", "square", "sawtooth", "randomwalk" or "prbs" (case-insensitive).
+std::optional<FieldGeneratorKind> parseFieldGeneratorKind(const std::string &value);
+std::string fieldGeneratorKindToString(FieldGeneratorKind kind);
+// "crc16" (CRC-16/CCITT-FALSE) or "crc32" (IEEE 802.3), case-insensitive.
+std::optional<ChecksumKind> parseChecksumKind(const std::string &value);
+std::string checksumKindToString(ChecksumKind kind);
+// 32 hex digits, optionally with dashes (UUID notation).
+std::optional<std::array<std::uint8_t, 16>> parseConsistId(const std::string &value);
+std::string consistIdToString(const std::array<std::uint8_t, 16> &consistId);
+
+// Approximate heap bytes, for sizing hosts: containers, strings and objects, without allocator overhead.
+struct RegistryMemory {
+    std::size_t datasets{0};
+    std::size_t datasetBytes{0};
+    std::size_t telegrams{0};
+    std::size_t telegramBytes{0};
+    std::size_t runtimes{0};
+    // Runtime objects and field values.
+    std::size_t runtimeBytes{0};
+    // Buffer slots, including padding.
+    std::size_t bufferBytes{0};
+};
 
 class TelegramRuntime {
   public:
-    explicit TelegramRuntime(const DatasetDef &dataset);
+    // The dataset is shared with the registry: every runtime of a dataset refers to one definition.
+    explicit TelegramRuntime(std::shared_ptr<const DatasetDef> dataset);
 
     [[nodiscard]] std::optional<FieldValue> getFieldValue(const std::string &fieldName) const;
     [[nodiscard]] std::map<std::string, FieldValue> snapshotFields() const;
@@ -97,28 +241,94 @@ class TelegramRuntime {
 
     [[nodiscard]] std::vector<std::uint8_t> getBufferCopy() const;
     void overwriteBuffer(const std::vector<std::uint8_t> &data);
-    void updateBuffer(const std::function<void(std::vector<std::uint8_t> &)> &mutator);
+    // Mutate the buffer in place under the write lock. Templates rather than std::function so the cyclic
+    // publish path, which calls them per telegram per cycle, never allocates for the callback.
+    template <typename Mutator> void updateBuffer(Mutator &&mutator) {
+        std::unique_lock lock(mtx);
+        mutator(bytes, length);
+    }
+    // Read the buffer in place under the read lock.
+    template <typename Reader> void readBuffer(Reader &&reader) const {
+        std::shared_lock lock(mtx);
+        reader(static_cast<const std::uint8_t *>(bytes), length);
+    }
 
     [[nodiscard]] std::size_t bufferSize() const noexcept;
-    [[nodiscard]] const DatasetDef &dataset() const noexcept { return datasetDef; }
+    [[nodiscard]] const DatasetDef &dataset() const noexcept { return *datasetDef; }
+
+    // Move the buffer into slot of arena, keeping its contents. A payload later overwritten with more bytes
+    // than the slot holds moves the buffer back to a block of its own.
+    void relocate(const std::shared_ptr<BufferArena> &arena, std::size_t slot);
+    // Bytes the buffer occupies, including padding: its slot capacity.
+    [[nodiscard]] std::size_t bufferCapacity() const;
+    // Bytes of the runtime object and its field values, excluding the buffer.
+    [[nodiscard]] std::size_t memoryUsage() const;
 
   private:
-    DatasetDef datasetDef;
+    std::shared_ptr<const DatasetDef> datasetDef;
     mutable std::shared_mutex mtx;
-    std::vector<std::uint8_t> buffer;
-    std::map<std::string, FieldValue> fieldValues;
+    // The buffer is a slot of storage: a single-slot arena of its own until the engine lays out its telegrams
+    // in a shared one.
+    std::shared_ptr<BufferArena> storage;
+    std::uint8_t *bytes{nullptr};
+    std::size_t length{0};
+    std::size_t capacity{0};
+    // Decoded value of each field, by position in the dataset; names live only in the shared definition.
+    std::vector<FieldValue> fieldValues;
 
-    std::size_t calculateInitialBufferSize() const;
+    void allocateOwnStorage(std::size_t size);
+    // Position of fieldName in fieldValues, or npos.
+    std::size_t fieldPosition(const std::string &fieldName) const;
+};
+
+// Registry contents at one point in time, never modified once published. Definitions are shared by pointer between
+// snapshots, so publishing a change copies pointers rather than definitions.
+struct RegistrySnapshot {
+    std::map<std::string, std::shared_ptr<const DatasetDef>> datasets;
+    std::map<std::uint32_t, std::shared_ptr<const TelegramDef>> telegrams;
+
+    struct IndexEntry {
+        const TelegramDef *telegram{nullptr};
+        const DatasetDef *dataset{nullptr};
+    };
+    // Flat ComId index over telegrams and their datasets, built on publication; lookups fall back to the maps
+    // while a snapshot is under construction.
+    ComIdIndex<IndexEntry> comIdIndex;
+
+    [[nodiscard]] const DatasetDef *findDataset(const std::string &name) const;
+    [[nodiscard]] const TelegramDef *findTelegram(std::uint32_t comId) const;
+    // Dataset of a telegram; nullptr when either is unknown.
+    [[nodiscard]] const DatasetDef *datasetOf(std::uint32_t comId) const;
+
+    // For a snapshot under construction. A dataset replaces one of the same name; addTelegram returns false when
+    // the telegram's dataset is not in the snapshot.
+    void addDataset(DatasetDef dataset);
+    bool addTelegram(TelegramDef telegram);
+    void buildIndex();
 };
 
 class TelegramRegistry {
   public:
+    // Registry of the default workspace; additional workspaces own their own instance.
     static TelegramRegistry &instance();
 
+    TelegramRegistry() = default;
+    TelegramRegistry(const TelegramRegistry &) = delete;
+    TelegramRegistry &operator=(const TelegramRegistry &) = delete;
+
     void registerDataset(const DatasetDef &dataset);
     void registerTelegram(const TelegramDef &telegram);
     void clear();
 
+    // Current contents: one atomic load, after which the caller iterates without locking or copying. The snapshot
+    // stays valid, unchanged, however the registry changes afterwards.
+    [[nodiscard]] std::shared_ptr<const RegistrySnapshot> snapshot() const;
+    // Replace the contents with next in one step. Definitions equal to the current ones are kept as they are, so
+    // after reloading an XML only edited telegrams and datasets show as new pointers. Runtimes of removed
+    // telegrams, and of telegrams whose dataset changed, are dropped.
+    void publish(RegistrySnapshot next);
+
+    // Copying accessors, for callers that keep a definition beyond the snapshot they read it from.
     [[nodiscard]] std::vector<DatasetDef> listDatasets() const;
     [[nodiscard]] std::optional<DatasetDef> getDatasetCopy(const std::string &name) const;
     [[nodiscard]] std::optional<TelegramDef> getTelegramCopy(std::uint32_t comId) const;
@@ -126,18 +336,27 @@ class TelegramRegistry {
 
     std::shared_ptr<TelegramRuntime> getOrCreateRuntime(std::uint32_t comId);
 
+    [[nodiscard]] RegistryMemory memoryUsage() const;
+
   private:
-    TelegramRegistry() = default;
+    // Serialises writers and guards runtimes; readers only load current.
+    mutable std::mutex mtx;
+    // Only replaced with std::atomic_store.
+    std::shared_ptr<const RegistrySnapshot> current{std::make_shared<const RegistrySnapshot>()};
+    FlatComIdMap<std::shared_ptr<TelegramRuntime>> runtimes;
 
-    mutable std::shared_mutex mtx;
-    std::map<std::string, DatasetDef> datasets;
-    std::map<std::uint32_t, TelegramDef> telegrams;
-    std::map<std::uint32_t, std::shared_ptr<TelegramRuntime>> runtimes;
+    void publishLocked(std::shared_ptr<RegistrySnapshot> next);
 };
 
 bool loadFromTauXml(const std::string &xmlPath);
+// Load xmlPath into registry, replacing its content; the default XML state is left untouched.
+bool loadFromTauXml(const std::string &xmlPath, TelegramRegistry &registry);
 void setDefaultXmlConfig(const std::string &xmlPath);
 bool ensureRegistryInitialized();
+// Treat the registry as initialised even though it was populated programmatically (no XML involved).
+void markRegistryPopulated();
+// Re-read the default XML (TRDP_XML_PATH or setDefaultXmlConfig) into the registry.
+bool reloadDefaultXml();
 
 } // namespace trdp
 
@@ -0,0 +1,395 @@
+#include "traffic_generator.h"
+
+#include "trdp_engine.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <random>
+
+namespace trdp {
+
+namespace {
+
+// Largest PD payload a single TRDP frame can carry.
+constexpr std::size_t kMaxPdPayload = 1432U;
+constexpr std::size_t kSequenceBytes = 4U;
+
+std::string toLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+} // namespace
+
+TrafficGenerator &TrafficGenerator::instance() {
+    static TrafficGenerator generator;
+    return generator;
+}
+
+bool TrafficGenerator::applyCycleSpec(const std::string &spec, Config &config) {
+    const auto parseMs = [](const std::string &text) -> std::optional<std::chrono::milliseconds> {
+        try {
+            std::size_t consumed = 0;
+            const auto value = std::stol(text, &consumed);
+            if (consumed != text.size() || value <= 0) {
+                return std::nullopt;
+            }
+            return std::chrono::milliseconds(value);
+        } catch (const std::exception &) {
+            return std::nullopt;
+        }
+    };
+
+    if (spec.find(',') != std::string::npos) {
+        std::vector<std::chrono::milliseconds> classes;
+        std::size_t start = 0;
+        while (start <= spec.size()) {
+            const auto end = std::min(spec.find(',', start), spec.size());
+            const auto cycle = parseMs(spec.substr(start, end - start));
+            if (!cycle) {
+                return false;
+            }
+            classes.push_back(*cycle);
+            start = end + 1;
+        }
+        config.distribution = CycleDistribution::Classes;
+        config.cycleClasses = std::move(classes);
+        return true;
+    }
+
+    if (const auto dash = spec.find('-'); dash != std::string::npos) {
+        const auto low = parseMs(spec.substr(0, dash));
+        const auto high = parseMs(spec.substr(dash + 1));
+        if (!low || !high || *high < *low) {
+            return false;
+        }
+        config.distribution = CycleDistribution::Uniform;
+        config.cycleMin = *low;
+        config.cycleMax = *high;
+        return true;
+    }
+
+    const auto fixed = parseMs(spec);
+    if (!fixed) {
+        return false;
+    }
+    config.distribution = CycleDistribution::Fixed;
+    config.cycleMin = *fixed;
+    config.cycleMax = *fixed;
+    return true;
+}
+
+std::optional<TrafficGenerator::CycleDistribution> TrafficGenerator::parseDistribution(const std::string &value) {
+    const auto lowered = toLower(value);
+    if (lowered == "fixed") {
+        return CycleDistribution::Fixed;
+    }
+    if (lowered == "uniform") {
+        return CycleDistribution::Uniform;
+    }
+    if (lowered == "classes") {
+        return CycleDistribution::Classes;
+    }
+    return std::nullopt;
+}
+
+std::optional<TrafficGenerator::PayloadPattern> TrafficGenerator::parsePattern(const std::string &value) {
+    const auto lowered = toLower(value);
+    if (lowered == "zeros" || lowered == "zero") {
+        return PayloadPattern::Zeros;
+    }
+    if (lowered == "ramp") {
+        return PayloadPattern::Ramp;
+    }
+    if (lowered == "random") {
+        return PayloadPattern::Random;
+    }
+    if (lowered == "comid") {
+        return PayloadPattern::ComId;
+    }
+    if (lowered == "prbs") {
+        return PayloadPattern::Prbs;
+    }
+    return std::nullopt;
+}
+
+std::string TrafficGenerator::distributionToString(CycleDistribution distribution) {
+    switch (distribution) {
+    case CycleDistribution::Fixed:
+        return "fixed";
+    case CycleDistribution::Uniform:
+        return "uniform";
+    case CycleDistribution::Classes:
+        return "classes";
+    }
+    return "fixed";
+}
+
+std::string TrafficGenerator::patternToString(PayloadPattern pattern) {
+    switch (pattern) {
+    case PayloadPattern::Zeros:
+        return "zeros";
+    case PayloadPattern::Ramp:
+        return "ramp";
+    case PayloadPattern::Random:
+        return "random";
+    case PayloadPattern::ComId:
+        return "comid";
+    case PayloadPattern::Prbs:
+        return "prbs";
+    }
+    return "ramp";
+}
+
+DatasetDef TrafficGenerator::buildDataset(const Config &config) {
+    DatasetDef dataset;
+    dataset.name = "Generated" + std::to_string(config.datasetBytes);
+    dataset.size = config.datasetBytes;
+
+    FieldDef sequence;
+    sequence.name = "Sequence";
+    sequence.type = FieldType::UINT32;
+    sequence.offset = 0;
+    sequence.size = kSequenceBytes;
+    dataset.fields.push_back(sequence);
+
+    if (config.datasetBytes > kSequenceBytes) {
+        FieldDef payload;
+        payload.name = "Payload";
+        payload.type = FieldType::BYTES;
+        payload.offset = kSequenceBytes;
+        payload.size = config.datasetBytes - kSequenceBytes;
+        dataset.fields.push_back(payload);
+    }
+    return dataset;
+}
+
+std::vector<std::chrono::milliseconds> TrafficGenerator::assignCycles(const Config &config) {
+    std::vector<std::chrono::milliseconds> cycles;
+    cycles.reserve(config.count);
+    // Seeded from the ComId base so the same request always yields the same schedule.
+    std::mt19937 rng(config.comIdBase);
+    std::uniform_int_distribution<long long> uniform(config.cycleMin.count(),
+                                                     std::max(config.cycleMin.count(), config.cycleMax.count()));
+    for (std::uint32_t i = 0; i < config.count; ++i) {
+        switch (config.distribution) {
+        case CycleDistribution::Fixed:
+            cycles.push_back(config.cycleMin);
+            break;
+        case CycleDistribution::Uniform:
+            cycles.emplace_back(uniform(rng));
+            break;
+        case CycleDistribution::Classes:
+            cycles.push_back(config.cycleClasses[i % config.cycleClasses.size()]);
+            break;
+        }
+    }
+    return cycles;
+}
+
+std::vector<std::uint8_t> TrafficGenerator::buildPayload(const Config &config, std::uint32_t comId,
+                                                         std::size_t length) {
+    std::vector<std::uint8_t> payload(length, 0U);
+    switch (config.pattern) {
+    case PayloadPattern::Zeros:
+    case PayloadPattern::Prbs:
+        // Prbs payloads come from the engine-side generators.
+        break;
+    case PayloadPattern::Ramp:
+        for (std::size_t i = 0; i < length; ++i) {
+            payload[i] = static_cast<std::uint8_t>(i);
+        }
+        break;
+    case PayloadPattern::Random: {
+        std::mt19937 rng(comId);
+        for (auto &byte : payload) {
+            byte = static_cast<std::uint8_t>(rng());
+        }
+        break;
+    }
+    case PayloadPattern::ComId:
+        for (std::size_t i = 0; i < length; ++i) {
+            payload[i] = static_cast<std::uint8_t>(comId >> (8U * (3U - (i % 4U))));
+        }
+        break;
+    }
+    return payload;
+}
+
+bool TrafficGenerator::start(const Config &config, std::string &error) {
+    if (config.count == 0) {
+        error = "count must be greater than zero";
+        return false;
+    }
+    if (config.comIdBase == 0 || static_cast<std::uint64_t>(config.comIdBase) + config.count > 0xFFFFFFFFULL) {
+        error = "ComId range is invalid";
+        return false;
+    }
+    if (config.datasetBytes < kSequenceBytes || config.datasetBytes > kMaxPdPayload) {
+        error = "datasetBytes must be between " + std::to_string(kSequenceBytes) + " and " +
+                std::to_string(kMaxPdPayload);
+        return false;
+    }
+    if (config.distribution == CycleDistribution::Classes) {
+        if (config.cycleClasses.empty() ||
+            std::any_of(config.cycleClasses.begin(), config.cycleClasses.end(),
+                        [](const auto &cycle) { return cycle.count() <= 0; })) {
+            error = "cycle classes must be a non-empty list of positive values";
+            return false;
+        }
+    } else if (config.cycleMin.count() <= 0 ||
+               (config.distribution == CycleDistribution::Uniform && config.cycleMax < config.cycleMin)) {
+        error = "cycle times must be positive and min <= max";
+        return false;
+    }
+
+    std::lock_guard lock(mtx);
+    auto &engine = TrdpEngine::instance();
+    auto &registry = TelegramRegistry::instance();
+    const auto engineConfig = engine.activeConfig();
+
+    engine.stop();
+    if (running && active.replaceExisting) {
+        reloadDefaultXml();
+    }
+    if (!config.replaceExisting && !ensureRegistryInitialized()) {
+        std::cerr << "[TRDP] Generator: no XML telegrams loaded; running generated telegrams only" << std::endl;
+    }
+    // The generated set is added to a copy and published once.
+    RegistrySnapshot contents = config.replaceExisting ? RegistrySnapshot{} : *registry.snapshot();
+
+    const auto dataset = buildDataset(config);
+    contents.addDataset(dataset);
+    const auto cycles = assignCycles(config);
+
+    comIds.clear();
+    comIds.reserve(config.count);
+    targetRate = 0.0;
+    for (std::uint32_t i = 0; i < config.count; ++i) {
+        TelegramDef telegram;
+        telegram.comId = config.comIdBase + i;
+        telegram.name = "Gen" + std::to_string(telegram.comId);
+        telegram.direction = Direction::Tx;
+        telegram.type = TelegramType::PD;
+        telegram.datasetName = dataset.name;
+        telegram.destIp = config.destIp;
+        telegram.srcPort = config.port;
+        telegram.destPort = config.port;
+        telegram.cycle = cycles[i];
+        // Every pattern stamps a full-range UINT32 counter, wrapping like a TRDP sequence counter.
+        FieldGeneratorDef sequence;
+        sequence.field = "Sequence";
+        sequence.kind = FieldGeneratorKind::Counter;
+        telegram.generators.push_back(sequence);
+        if (config.pattern == PayloadPattern::Prbs && config.datasetBytes > kSequenceBytes) {
+            FieldGeneratorDef payload;
+            payload.field = "Payload";
+            payload.kind = FieldGeneratorKind::Prbs;
+            payload.order = 15U;
+            payload.seed = telegram.comId;
+            telegram.generators.push_back(payload);
+        }
+        comIds.push_back(telegram.comId);
+        targetRate += 1000.0 / static_cast<double>(cycles[i].count());
+        contents.addTelegram(std::move(telegram));
+    }
+    registry.publish(std::move(contents));
+    markRegistryPopulated();
+
+    engine.setPdSendLogging(!config.quiet);
+    if (!engine.start(engineConfig)) {
+        engine.setPdSendLogging(true);
+        comIds.clear();
+        running = false;
+        error = "TRDP engine failed to start";
+        return false;
+    }
+
+    std::size_t activated = 0;
+    for (const auto comId : comIds) {
+        std::map<std::string, FieldValue> fields;
+        if (config.datasetBytes > kSequenceBytes && config.pattern != PayloadPattern::Prbs) {
+            fields.emplace("Payload", buildPayload(config, comId, config.datasetBytes - kSequenceBytes));
+        }
+        if (engine.sendTxTelegram(comId, fields)) {
+            ++activated;
+        }
+    }
+
+    active = config;
+    running = true;
+    startedAt = std::chrono::steady_clock::now();
+    const auto counters = engine.txCounters();
+    baseSent = counters.pdSent;
+    baseFailed = counters.pdFailed;
+    baseCpu = engine.workerCpuTime();
+
+    std::cout << "[TRDP] Generator started " << activated << "/" << comIds.size() << " telegrams (ComId "
+              << config.comIdBase << "-" << (config.comIdBase + config.count - 1U) << ", " << config.datasetBytes
+              << " bytes), target " << targetRate << " telegrams/s" << std::endl;
+    return true;
+}
+
+void TrafficGenerator::stop() {
+    std::lock_guard lock(mtx);
+    if (!running) {
+        return;
+    }
+
+    auto &engine = TrdpEngine::instance();
+    if (active.replaceExisting) {
+        // Bring back the XML telegram set the generator displaced.
+        const auto engineConfig = engine.activeConfig();
+        engine.stop();
+        if (!reloadDefaultXml()) {
+            TelegramRegistry::instance().clear();
+        }
+        engine.start(engineConfig);
+    } else {
+        for (const auto comId : comIds) {
+            engine.stopTxTelegram(comId);
+        }
+    }
+    engine.setPdSendLogging(true);
+
+    running = false;
+    comIds.clear();
+    std::cout << "[TRDP] Generator stopped" << std::endl;
+}
+
+TrafficGenerator::Status TrafficGenerator::status() {
+    std::lock_guard lock(mtx);
+    Status status;
+    status.running = running;
+    status.config = active;
+    status.telegrams = static_cast<std::uint32_t>(comIds.size());
+    status.targetRate = targetRate;
+    if (!running) {
+        return status;
+    }
+
+    auto &engine = TrdpEngine::instance();
+    const auto counters = engine.txCounters();
+    status.sent = counters.pdSent - baseSent;
+    status.failed = counters.pdFailed - baseFailed;
+    status.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+    if (status.elapsedSeconds > 0.0) {
+        status.achievedRate = static_cast<double>(status.sent) / status.elapsedSeconds;
+    }
+
+    const auto cpu = engine.workerCpuTime();
+    if (cpu && baseCpu) {
+        const auto cpuMicros = std::chrono::duration<double, std::micro>(*cpu - *baseCpu).count();
+        if (status.sent > 0) {
+            status.cpuMicrosPerTelegram = cpuMicros / static_cast<double>(status.sent);
+        }
+        if (status.elapsedSeconds > 0.0) {
+            status.cpuUtilisation = cpuMicros / (status.elapsedSeconds * 1e6);
+        }
+    }
+    return status;
+}
+
+} // namespace trdp
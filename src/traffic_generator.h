@@ -0,0 +1,100 @@
+#pragma once
+
+#include "telegram_model.h"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace trdp {
+
+/**
+ * Synthetic PD load generator.
+ *
+ * Registers a block of virtual TX PD telegrams straight into the TelegramRegistry (no XML), restarts the
+ * engine so endpoints are rebuilt, and activates cyclic publishing for each of them. Status reports the
+ * target send rate implied by the cycle times next to the rate the engine actually achieved and the
+ * processing thread CPU time spent per telegram sent.
+ */
+class TrafficGenerator {
+  public:
+    enum class CycleDistribution { Fixed, Uniform, Classes };
+    enum class PayloadPattern { Zeros, Ramp, Random, ComId, Prbs };
+
+    struct Config {
+        std::uint32_t count{0};
+        std::uint32_t comIdBase{60000};
+        // Dataset size in bytes; the first four bytes hold a UINT32 sequence field.
+        std::size_t datasetBytes{64};
+        CycleDistribution distribution{CycleDistribution::Fixed};
+        // Fixed uses cycleMin; Uniform draws from [cycleMin, cycleMax]; Classes assigns cycleClasses round-robin.
+        std::chrono::milliseconds cycleMin{100};
+        std::chrono::milliseconds cycleMax{100};
+        std::vector<std::chrono::milliseconds> cycleClasses;
+        // Every pattern counts the sequence field up per publication; Prbs also refills the payload with PRBS-15 on
+        // each one (see PayloadVerifier), the others keep the payload they start with.
+        PayloadPattern pattern{PayloadPattern::Ramp};
+        std::uint32_t destIp{0x7F000001U};
+        std::uint16_t port{17224};
+        // Drop the XML telegrams so only generated traffic is sent.
+        bool replaceExisting{true};
+        // Silence per-send logging while the generator runs.
+        bool quiet{true};
+    };
+
+    struct Status {
+        bool running{false};
+        Config config;
+        std::uint32_t telegrams{0};
+        double targetRate{0.0};
+        double achievedRate{0.0};
+        std::uint64_t sent{0};
+        std::uint64_t failed{0};
+        double elapsedSeconds{0.0};
+        // Processing thread CPU time per sent telegram and as a share of wall time; nullopt when unavailable.
+        std::optional<double> cpuMicrosPerTelegram;
+        std::optional<double> cpuUtilisation;
+    };
+
+    static TrafficGenerator &instance();
+
+    // Replace the current telegram set with generated telegrams and start publishing. Returns false with a
+    // reason in error when the configuration is invalid or the engine cannot be restarted.
+    bool start(const Config &config, std::string &error);
+
+    // Stop publishing and, when the XML set was replaced, restore it from the default XML.
+    void stop();
+
+    Status status();
+
+    // Parse "100" (fixed), "50-200" (uniform) or "10,100,1000" (classes) into the cycle fields of config.
+    static bool applyCycleSpec(const std::string &spec, Config &config);
+    static std::optional<CycleDistribution> parseDistribution(const std::string &value);
+    static std::optional<PayloadPattern> parsePattern(const std::string &value);
+    static std::string distributionToString(CycleDistribution distribution);
+    static std::string patternToString(PayloadPattern pattern);
+
+  private:
+    TrafficGenerator() = default;
+    TrafficGenerator(const TrafficGenerator &) = delete;
+    TrafficGenerator &operator=(const TrafficGenerator &) = delete;
+
+    static DatasetDef buildDataset(const Config &config);
+    static std::vector<std::chrono::milliseconds> assignCycles(const Config &config);
+    static std::vector<std::uint8_t> buildPayload(const Config &config, std::uint32_t comId, std::size_t length);
+
+    std::mutex mtx;
+    bool running{false};
+    Config active;
+    std::vector<std::uint32_t> comIds;
+    double targetRate{0.0};
+    std::chrono::steady_clock::time_point startedAt{};
+    std::uint64_t baseSent{0};
+    std::uint64_t baseFailed{0};
+    std::optional<std::chrono::nanoseconds> baseCpu;
+};
+
+} // namespace trdp
@@ -1,6 +1,15 @@
 #include "trdp_engine.h"
 
-#include "plugins/TelegramHub.h"
+#include "capture_recorder.h"
+#ifdef TRDP_FAKE_STACK
+#include "fake_stack/fake_trdp_stack.h"
+#endif
+#include "field_history.h"
+#include "history_store.h"
+#include "memory_usage.h"
+#include "payload_verifier.h"
+#include "rule_engine.h"
+#include "telegram_events.h"
 
 #include <algorithm>
 #include <array>
@@ -17,12 +26,14 @@
 #include <sstream>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <pthread.h>
+#include <time.h>
 #include <type_traits>
 #include <utility>
 
 #ifdef TRDP_STACK_PRESENT
 #include <trdp/api/tau_dnr.h>
-#if __has_include(<trdp/api/tau_ecsp.h>)
+#if __has_include(<trdp/api/tau_ecsp.h>) && !defined(TRDP_DISABLE_TAU_ECSP)
 #include <trdp/api/tau_ecsp.h>
 #define TRDP_HAS_TAU_ECSP 1
 #endif
@@ -40,6 +51,8 @@ namespace trdp {
 #ifdef TRDP_STACK_PRESENT
 void pdReceiveCallback(void *refCon, TRDP_APP_SESSION_T /*session*/, const TRDP_PD_INFO_T *pInfo, UINT8 *pData,
                        UINT32 dataSize);
+void pdSendCallback(void *refCon, TRDP_APP_SESSION_T session, const TRDP_PD_INFO_T *pInfo, UINT8 *pData,
+                    UINT32 dataSize);
 void mdReceiveCallback(void *refCon, TRDP_APP_SESSION_T /*session*/, const TRDP_MD_INFO_T *pInfo, UINT8 *pData,
                        UINT32 dataSize);
 #endif
@@ -51,6 +64,25 @@ constexpr bool kDnrCompiledIn = true;
 constexpr bool kDnrCompiledIn = false;
 #endif
 
+TrdpMsgType nativeMsgType(MdMode mode)
+{
+    switch (mode) {
+    case MdMode::Notify:
+        return TrdpMsgType::Mn;
+    case MdMode::Request:
+        return TrdpMsgType::Mr;
+    case MdMode::ReplyNoConfirm:
+        return TrdpMsgType::Mp;
+    case MdMode::ReplyWithConfirm:
+        return TrdpMsgType::Mq;
+    case MdMode::Confirm:
+        return TrdpMsgType::Mc;
+    case MdMode::Error:
+        return TrdpMsgType::Me;
+    }
+    return TrdpMsgType::Mn;
+}
+
 std::string mdModeToString(MdMode mode)
 {
     switch (mode) {
@@ -253,7 +285,8 @@ bool encodeSingleValue(const FieldDef &field, const FieldValue &value, std::uint
     return false;
 }
 
-std::vector<std::uint8_t> encodeFields(const DatasetDef &dataset, const std::map<std::string, FieldValue> &fields) {
+std::vector<std::uint8_t> encodeFields(const DatasetDef &dataset, const std::map<std::string, FieldValue> &fields,
+                                       const std::vector<ChecksumField> &checksums) {
     const auto bufferSize = dataset.computeSize();
     std::vector<std::uint8_t> buffer(bufferSize, 0U);
 
@@ -304,10 +337,11 @@ std::vector<std::uint8_t> encodeFields(const DatasetDef &dataset, const std::map
         }
     }
 
+    // Checksums cover the final bytes, so they are computed last.
+    writeChecksums(checksums, buffer.data(), buffer.size());
     return buffer;
 }
 
-#ifdef TRDP_STACK_PRESENT
 std::string formatIp(std::uint32_t ip) {
     in_addr addr{};
     addr.s_addr = htonl(ip);
@@ -318,56 +352,57 @@ std::string formatIp(std::uint32_t ip) {
     return buffer;
 }
 
-bool ipAssignedToLocalInterface(std::uint32_t ip) {
-    if (ip == 0U) {
-        return true;
+std::optional<std::uint32_t> resolveInterfaceIp(const std::string &ifName) {
+    if (ifName.empty()) {
+        return std::nullopt;
     }
 
     ifaddrs *ifaddr = nullptr;
     if (getifaddrs(&ifaddr) != 0 || ifaddr == nullptr) {
-        return false;
+        return std::nullopt;
     }
 
-    bool found = false;
+    std::optional<std::uint32_t> ip;
     for (auto *ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
-        if (ifa->ifa_addr == nullptr || ifa->ifa_addr->sa_family != AF_INET) {
+        if (ifa->ifa_name == nullptr || ifa->ifa_addr == nullptr || ifa->ifa_addr->sa_family != AF_INET) {
             continue;
         }
-        const auto *addr = reinterpret_cast<sockaddr_in *>(ifa->ifa_addr);
-        if (addr->sin_addr.s_addr == htonl(ip)) {
-            found = true;
+        if (ifName == ifa->ifa_name) {
+            const auto *addr = reinterpret_cast<sockaddr_in *>(ifa->ifa_addr);
+            ip = static_cast<std::uint32_t>(ntohl(addr->sin_addr.s_addr));
             break;
         }
     }
 
     freeifaddrs(ifaddr);
-    return found;
+    return ip;
 }
 
-std::optional<std::uint32_t> resolveInterfaceIp(const std::string &ifName) {
-    if (ifName.empty()) {
-        return std::nullopt;
+#ifdef TRDP_STACK_PRESENT
+bool ipAssignedToLocalInterface(std::uint32_t ip) {
+    if (ip == 0U) {
+        return true;
     }
 
     ifaddrs *ifaddr = nullptr;
     if (getifaddrs(&ifaddr) != 0 || ifaddr == nullptr) {
-        return std::nullopt;
+        return false;
     }
 
-    std::optional<std::uint32_t> ip;
+    bool found = false;
     for (auto *ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
-        if (ifa->ifa_name == nullptr || ifa->ifa_addr == nullptr || ifa->ifa_addr->sa_family != AF_INET) {
+        if (ifa->ifa_addr == nullptr || ifa->ifa_addr->sa_family != AF_INET) {
             continue;
         }
-        if (ifName == ifa->ifa_name) {
-            const auto *addr = reinterpret_cast<sockaddr_in *>(ifa->ifa_addr);
-            ip = static_cast<std::uint32_t>(ntohl(addr->sin_addr.s_addr));
+        const auto *addr = reinterpret_cast<sockaddr_in *>(ifa->ifa_addr);
+        if (addr->sin_addr.s_addr == htonl(ip)) {
+            found = true;
             break;
         }
     }
 
     freeifaddrs(ifaddr);
-    return ip;
+    return found;
 }
 
 std::optional<std::uint32_t> firstNonLoopbackIp() {
@@ -484,25 +519,69 @@ static TRDP_DNR_OPTS_T mapDnrMode(TrdpEngine::DnrMode mode) {
 }
 #endif
 
+// Stack depth each processing thread touches at start when prefaulting.
+constexpr std::size_t kPrefaultStackBytes = 256U * 1024U;
+
+std::optional<std::chrono::nanoseconds> threadCpuTime(std::thread &thread) {
+    if (!thread.joinable()) {
+        return std::nullopt;
+    }
+    clockid_t clockId{};
+    if (pthread_getcpuclockid(thread.native_handle(), &clockId) != 0) {
+        return std::nullopt;
+    }
+    timespec ts{};
+    if (clock_gettime(clockId, &ts) != 0) {
+        return std::nullopt;
+    }
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// True when a and b differ at most in their IP addresses, which a PD binding can follow in place.
+bool differsOnlyInAddresses(const TelegramDef &a, const TelegramDef &b) {
+    auto moved = a;
+    moved.srcIp = b.srcIp;
+    moved.destIp = b.destIp;
+    return moved == b;
+}
+
+bool isMulticast(std::uint32_t ip) { return (ip & 0xF0000000U) == 0xE0000000U; }
+
+const std::vector<ChecksumField> kNoChecksums;
+
 } // namespace
 
 std::vector<std::uint8_t> encodeFieldsToBuffer(const TelegramRuntime &runtime,
-                                               const std::map<std::string, FieldValue> &fields) {
-    return encodeFields(runtime.dataset(), fields);
+                                               const std::map<std::string, FieldValue> &fields,
+                                               const std::vector<ChecksumField> &checksums) {
+    return encodeFields(runtime.dataset(), fields, checksums);
 }
 
-#ifdef TRDP_STACK_PRESENT
 constexpr std::uint16_t kDefaultTrdpPort = 17224;
 
-std::uint16_t resolveDefaultPort(TelegramType type) {
-    for (const auto &telegram : TelegramRegistry::instance().listTelegrams()) {
-        if (telegram.type == type && telegram.destPort != 0U) {
-            return telegram.destPort;
+std::uint16_t resolveDefaultPort(const TelegramRegistry &registry, TelegramType type) {
+    const auto contents = registry.snapshot();
+    for (const auto &[comId, telegram] : contents->telegrams) {
+        if (telegram->type == type && telegram->destPort != 0U) {
+            return telegram->destPort;
         }
     }
     return kDefaultTrdpPort;
 }
 
+std::uint16_t TrdpEngine::resolvePortForEndpoint(const TelegramDef &telegram) const {
+    // Prefer the local/source port when transmitting and the destination port when receiving.
+    if (telegram.direction == Direction::Tx && telegram.srcPort != 0U) {
+        return telegram.srcPort;
+    }
+    if (telegram.destPort != 0U) {
+        return telegram.destPort;
+    }
+    return telegram.srcPort;
+}
+
+#ifdef TRDP_STACK_PRESENT
+
 TRDP_APP_SESSION_T TrdpEngine::defaultPdSession() const {
     if (pdSessions.empty()) {
         return nullptr;
@@ -531,15 +610,22 @@ TRDP_APP_SESSION_T TrdpEngine::mdSessionForPort(std::uint16_t port) const {
     return defaultMdSession();
 }
 
-std::uint16_t TrdpEngine::resolvePortForEndpoint(const TelegramDef &telegram) const {
-    // Prefer the local/source port when transmitting and the destination port when receiving.
-    if (telegram.direction == Direction::Tx && telegram.srcPort != 0U) {
-        return telegram.srcPort;
-    }
-    if (telegram.destPort != 0U) {
-        return telegram.destPort;
+std::uint16_t TrdpEngine::stackSessionPort(TRDP_APP_SESSION_T session) const {
+    for (const auto *sessions : {&pdSessions, &mdAppSessions}) {
+        for (const auto &[port, candidate] : *sessions) {
+            if (candidate == session) {
+                return port;
+            }
+        }
     }
-    return telegram.srcPort;
+    return 0U;
+}
+
+std::pair<std::uint16_t, std::uint16_t> TrdpEngine::stackRxPorts(TRDP_APP_SESSION_T session, std::uint32_t comId) {
+    const auto localPort = stackSessionPort(session);
+    const auto *endpoint = findEndpoint(comId);
+    const auto srcPort = endpoint != nullptr && endpoint->def->srcPort != 0U ? endpoint->def->srcPort : localPort;
+    return {srcPort, localPort};
 }
 
 std::string TrdpEngine::formatMdSessionKey(const MdSessionKey &key) {
@@ -562,21 +648,21 @@ TrdpEngine::MdSessionKey TrdpEngine::mdSessionKeyFromId(const TRDP_UUID_T &sessi
 }
 
 void TrdpEngine::trackMdRequest(const MdSessionKey &sessionKey, const EndpointHandle &endpoint) {
-    if (endpoint.def.expectedReplies == 0 && endpoint.def.confirmTimeout.count() == 0) {
+    if (endpoint.def->expectedReplies == 0 && endpoint.def->confirmTimeout.count() == 0) {
         return;
     }
 
     MdRequestState state{};
-    state.comId = endpoint.def.comId;
-    state.expectedReplies = endpoint.def.expectedReplies;
-    state.sentAt = std::chrono::steady_clock::now();
-    state.confirmObserved = endpoint.def.confirmTimeout.count() == 0;
+    state.comId = endpoint.def->comId;
+    state.expectedReplies = endpoint.def->expectedReplies;
+    state.sentAt = clock.now();
+    state.confirmObserved = endpoint.def->confirmTimeout.count() == 0;
 
-    if (endpoint.def.replyTimeout.count() > 0) {
-        state.replyDeadline = state.sentAt + endpoint.def.replyTimeout;
+    if (endpoint.def->replyTimeout.count() > 0) {
+        state.replyDeadline = state.sentAt + endpoint.def->replyTimeout;
     }
-    if (endpoint.def.confirmTimeout.count() > 0) {
-        state.confirmDeadline = state.sentAt + endpoint.def.confirmTimeout;
+    if (endpoint.def->confirmTimeout.count() > 0) {
+        state.confirmDeadline = state.sentAt + endpoint.def->confirmTimeout;
     }
 
     std::lock_guard lock(mdRequestMtx);
@@ -655,8 +741,8 @@ std::string TrdpEngine::allocateMdSessionId(const MdSendOptions &options) const
     return oss.str();
 }
 
-TrdpEngine::MdTimelineState &TrdpEngine::recordMdTimeline(const std::string &sessionId, std::uint32_t comId,
-                                                          const MdSendOptions &options)
+TrdpEngine::MdTimelineState TrdpEngine::recordMdTimeline(const std::string &sessionId, std::uint32_t comId,
+                                                         const MdSendOptions &options, const std::string &lastEvent)
 {
     std::lock_guard lock(mdSessionMtx);
     auto &state = mdTimelineSessions[sessionId];
@@ -664,7 +750,7 @@ TrdpEngine::MdTimelineState &TrdpEngine::recordMdTimeline(const std::string &ses
     state.comId = comId;
     state.mode = options.mode;
     state.expectedReplies = options.expectedReplies;
-    state.sentAt = std::chrono::steady_clock::now();
+    state.sentAt = clock.now();
     state.replyDeadline = options.replyTimeout.count() > 0 ? state.sentAt + options.replyTimeout
                                                           : std::chrono::steady_clock::time_point{};
     state.confirmDeadline = options.confirmTimeout.count() > 0 ? state.sentAt + options.confirmTimeout
@@ -677,6 +763,7 @@ TrdpEngine::MdTimelineState &TrdpEngine::recordMdTimeline(const std::string &ses
     state.replierThrottled = options.throttleReplier;
     state.replyConfirmToggle = options.toggleReplyConfirm;
     state.multicastExpected = options.multicastReplies || options.expectedReplies > 1;
+    state.lastEvent = lastEvent;
     return state;
 }
 
@@ -698,7 +785,7 @@ void TrdpEngine::notifyMdStatus(const MdTimelineState &state, const std::string
     options["multicastReplies"] = state.multicastExpected;
     options["replyTimeoutMs"] = static_cast<Json::UInt64>(state.replyTimeout.count());
     options["confirmTimeoutMs"] = static_cast<Json::UInt64>(state.confirmTimeout.count());
-    if (auto *hub = TelegramHub::instance()) {
+    if (auto *hub = eventHub.load()) {
         hub->publishMdStatus(state.sessionId, state.comId, event, mdModeToString(state.mode), state.expectedReplies,
                              state.receivedReplies, state.lastEvent, fieldJson, options);
     }
@@ -783,144 +870,608 @@ void TrdpEngine::reapMdTimeouts(std::chrono::steady_clock::time_point now)
     }
 }
 
-TrdpEngine &TrdpEngine::instance() {
-    static TrdpEngine engine;
-    return engine;
+std::shared_ptr<TrdpEngine::MdReplierState> TrdpEngine::compileMdReplier(const TelegramDef &telegram,
+                                                                         const MdReplierDef &def,
+                                                                         std::string &error) const
+{
+    const auto contents = registry.snapshot();
+    const auto *requestDataset = contents->findDataset(telegram.datasetName);
+    if (requestDataset == nullptr) {
+        error = "request dataset " + telegram.datasetName + " not registered";
+        return nullptr;
+    }
+
+    auto state = std::make_shared<MdReplierState>();
+    state->def = def;
+    state->replyComId = def.replyComId != 0U ? def.replyComId : telegram.comId;
+
+    const DatasetDef *replyDataset = nullptr;
+    std::vector<std::uint8_t> baseBuffer;
+    if (const auto *replyTelegram = contents->findTelegram(state->replyComId);
+        replyTelegram != nullptr && def.replyDataset.empty()) {
+        replyDataset = contents->findDataset(replyTelegram->datasetName);
+        if (auto runtime = registry.getOrCreateRuntime(state->replyComId)) {
+            baseBuffer = runtime->getBufferCopy();
+        }
+    } else if (!def.replyDataset.empty()) {
+        replyDataset = contents->findDataset(def.replyDataset);
+    }
+    if (replyDataset == nullptr) {
+        error = "reply dataset for ComId " + std::to_string(state->replyComId) + " not registered";
+        return nullptr;
+    }
+
+    state->replyTemplate = MdReplyTemplate::compile(def, *requestDataset, *replyDataset, std::move(baseBuffer), error);
+    if (!state->replyTemplate) {
+        return nullptr;
+    }
+    state->scratch.reserve(state->replyTemplate->replySize());
+    state->tokens = static_cast<double>(def.maxRepliesPerSecond);
+    state->lastRefill = clock.now();
+    return state;
 }
 
-bool TrdpEngine::bootstrapRegistry() {
-    if (!ensureRegistryInitialized()) {
-        std::cerr << "TRDP registry failed to initialise from XML" << std::endl;
+bool TrdpEngine::configureMdReplier(std::uint32_t comId, const MdReplierDef &def, std::string &error)
+{
+    const auto table = endpointSnapshot();
+    auto *endpoint = findEndpoint(*table, comId);
+    if (endpoint == nullptr) {
+        error = "unknown ComId";
+        return false;
+    }
+    if (endpoint->def->type != TelegramType::MD) {
+        error = "ComId is not an MD telegram";
         return false;
     }
+
+    std::shared_ptr<MdReplierState> state;
+    if (def.enabled) {
+        state = compileMdReplier(*endpoint->def, def, error);
+        if (!state) {
+            return false;
+        }
+    }
+
+    std::lock_guard replierLock(replierMtx);
+    if (endpoint->replier && state) {
+        // Keep the counters across reconfiguration so a running soak test does not lose its totals.
+        state->requests = endpoint->replier->requests;
+        state->replies = endpoint->replier->replies;
+        state->throttled = endpoint->replier->throttled;
+        state->failed = endpoint->replier->failed;
+        state->confirms = endpoint->replier->confirms;
+        state->confirmTimeouts = endpoint->replier->confirmTimeouts;
+        state->pending = endpoint->replier->pending;
+    }
+    endpoint->replierConfig = def;
+    endpoint->replier = std::move(state);
+    std::cout << "[TRDP] MD replier " << (def.enabled ? "enabled" : "disabled") << " for ComId " << comId
+              << std::endl;
     return true;
 }
 
-bool TrdpEngine::initialiseTrdpStack() {
-    std::cout << "[TRDP] Initialising stack..." << std::endl;
-    if (!stackAvailable) {
-        std::cout << "[TRDP] Stack not available at build time; running in stub mode" << std::endl;
-        pdSessionInitialised = true;
-        mdSessionInitialised = true;
-        return true;
+std::vector<std::uint8_t> TrdpEngine::encodeTxBuffer(std::uint32_t comId, const TelegramRuntime &runtime,
+                                                     const std::map<std::string, FieldValue> &fields) {
+    const auto table = endpointSnapshot();
+    if (const auto *endpoint = findEndpoint(*table, comId)) {
+        return encodeFieldsToBuffer(runtime, fields, endpoint->checksums ? endpoint->checksums->fields : kNoChecksums);
     }
+    // Not bound (e.g. the engine is stopped): resolve the dataset's checksum fields for this one buffer.
+    std::string checksumError;
+    return encodeFieldsToBuffer(runtime, fields, resolveChecksums(runtime.dataset(), checksumError));
+}
 
-#ifdef TRDP_STACK_PRESENT
-    constexpr std::size_t kHeapSize = 64 * 1024;
-    heapStorage.assign(kHeapSize, 0U);
-
-    TRDP_MEM_CONFIG_T memConfig{};
-    memConfig.p = heapStorage.data();
-    memConfig.size = static_cast<UINT32>(heapStorage.size());
+bool TrdpEngine::configureTxGenerators(std::uint32_t comId, const std::vector<FieldGeneratorDef> &defs,
+                                       std::string &error)
+{
+    const auto table = endpointSnapshot();
+    auto *endpoint = findEndpoint(*table, comId);
+    if (endpoint == nullptr) {
+        error = "unknown ComId";
+        return false;
+    }
+    if (endpoint->def->type != TelegramType::PD || endpoint->def->direction != Direction::Tx) {
+        error = "ComId is not a TX PD telegram";
+        return false;
+    }
 
-    const TRDP_ERR_T initErr = tlc_init(nullptr, nullptr, &memConfig);
-    if (initErr != TRDP_NO_ERR) {
-        logTrdpError("tlc_init", initErr);
-        if (initErr == TRDP_PARAM_ERR) {
-            std::cerr << "[TRDP] Hint: verify TRDP/TAU packages are installed and compatible with the simulator build; "
-                      << "parameter errors often indicate a version or configuration mismatch." << std::endl;
+    std::shared_ptr<TxGeneratorSet> generators;
+    if (!defs.empty()) {
+        generators = TxGeneratorSet::compile(defs, endpoint->runtime->dataset(), error);
+        if (!generators) {
+            return false;
         }
-        return false;
     }
+    std::lock_guard endpointLock(endpoint->mtx);
+    endpoint->generatorConfig = defs;
+    endpoint->generators = std::move(generators);
+    std::cout << "[TRDP] " << defs.size() << " TX generator(s) configured for ComId " << comId << std::endl;
+    return true;
+}
 
-    std::uint32_t sessionIp = 0U;
-    const auto txIp = resolveInterfaceIp(config.txInterface);
-    const auto rxIp = resolveInterfaceIp(config.rxInterface);
-    if (config.txInterface.empty() && config.rxInterface.empty()) {
-        sessionIp = 0U;
-    } else if (txIp) {
-        sessionIp = *txIp;
-    } else if (rxIp) {
-        sessionIp = *rxIp;
+std::optional<TrdpEngine::TxGeneratorStats> TrdpEngine::txGeneratorStats(std::uint32_t comId)
+{
+    const auto table = endpointSnapshot();
+    auto *endpoint = findEndpoint(*table, comId);
+    if (endpoint == nullptr || endpoint->def->type != TelegramType::PD || endpoint->def->direction != Direction::Tx) {
+        return std::nullopt;
     }
+    std::lock_guard endpointLock(endpoint->mtx);
+    TxGeneratorStats stats{};
+    stats.config = endpoint->generatorConfig;
+    stats.active = endpoint->generators != nullptr;
+    stats.cycles = endpoint->generators ? endpoint->generators->steps() : 0U;
+    return stats;
+}
 
-    if (sessionIp == 0U) {
-        for (const auto &telegram : TelegramRegistry::instance().listTelegrams()) {
-            if (telegram.direction == Direction::Tx && telegram.srcIp != 0U) {
-                sessionIp = telegram.srcIp;
-                break;
-            }
+bool TrdpEngine::configureSdt(std::uint32_t comId, const SdtDef &def, std::string &error)
+{
+    const auto table = endpointSnapshot();
+    auto *endpoint = findEndpoint(*table, comId);
+    if (endpoint == nullptr) {
+        error = "unknown ComId";
+        return false;
+    }
+    if (endpoint->def->type != TelegramType::PD) {
+        error = "SDT applies to PD telegrams only";
+        return false;
+    }
+
+    std::shared_ptr<SdtChannel> channel;
+    if (def.enabled) {
+        channel = SdtChannel::compile(def, endpoint->runtime->dataset().computeSize(), endpoint->def->cycle, error);
+        if (!channel) {
+            return false;
         }
     }
+    std::lock_guard endpointLock(endpoint->mtx);
+    endpoint->sdtConfig = def;
+    endpoint->sdt = std::move(channel);
+    std::cout << "[TRDP] SDT " << (def.enabled ? "enabled" : "disabled") << " for ComId " << comId << std::endl;
+    return true;
+}
 
-    if (sessionIp != 0U && !ipAssignedToLocalInterface(sessionIp)) {
-        std::cerr << "[TRDP] Selected session IP " << formatIp(sessionIp)
-                  << " is not configured on this host; falling back to default interface selection" << std::endl;
-        sessionIp = 0U;
+std::optional<SdtChannel::Stats> TrdpEngine::sdtStats(std::uint32_t comId)
+{
+    const auto table = endpointSnapshot();
+    auto *endpoint = findEndpoint(*table, comId);
+    if (endpoint == nullptr || endpoint->def->type != TelegramType::PD) {
+        return std::nullopt;
+    }
+    std::unique_lock endpointLock(endpoint->mtx);
+    if (!endpoint->sdt) {
+        SdtChannel::Stats stats{};
+        stats.config = endpoint->sdtConfig;
+        stats.config.enabled = false;
+        return stats;
     }
+    const auto channel = endpoint->sdt;
+    endpointLock.unlock();
+    return channel->stats(clock.now());
+}
 
-    if ((sessionIp & 0xFF000000U) == 0x7F000000U) {
-        const auto fallbackIp = firstNonLoopbackIp();
-        if (fallbackIp) {
-            std::cerr << "[TRDP] Loopback session IP " << formatIp(sessionIp)
-                      << " will be replaced with non-loopback address " << formatIp(*fallbackIp)
-                      << " to satisfy TRDP socket binding requirements" << std::endl;
-            sessionIp = *fallbackIp;
-        } else {
-            std::cerr << "[TRDP] Only loopback interfaces found; attempting to continue with " << formatIp(sessionIp)
-                      << std::endl;
-        }
-    } else if (sessionIp == 0U) {
-        const auto fallbackIp = firstNonLoopbackIp();
-        if (fallbackIp) {
-            std::cout << "[TRDP] No session IP configured; defaulting to interface IP " << formatIp(*fallbackIp)
-                      << std::endl;
-            sessionIp = *fallbackIp;
-        }
+std::optional<TrdpEngine::ChecksumStats> TrdpEngine::checksumStats(std::uint32_t comId)
+{
+    const auto table = endpointSnapshot();
+    auto *endpoint = findEndpoint(*table, comId);
+    if (endpoint == nullptr || !endpoint->checksums) {
+        return std::nullopt;
     }
+    ChecksumStats stats{};
+    stats.fields = endpoint->checksums->fields;
+    stats.checked = endpoint->checksums->checked.load(std::memory_order_relaxed);
+    stats.mismatches = endpoint->checksums->mismatches.load(std::memory_order_relaxed);
+    return stats;
+}
 
-    if (!config.txInterface.empty() && !txIp) {
-        std::cerr << "[TRDP] Unable to resolve TX interface '" << config.txInterface
-                  << "'; falling back to default stack selection" << std::endl;
+std::optional<TrdpEngine::MdReplierStats> TrdpEngine::mdReplierStats(std::uint32_t comId)
+{
+    const auto table = endpointSnapshot();
+    auto *endpoint = findEndpoint(*table, comId);
+    if (endpoint == nullptr || endpoint->def->type != TelegramType::MD) {
+        return std::nullopt;
     }
-    if (!config.rxInterface.empty() && !rxIp) {
-        std::cerr << "[TRDP] Unable to resolve RX interface '" << config.rxInterface
-                  << "'; falling back to default stack selection" << std::endl;
+
+    MdReplierStats stats{};
+    std::lock_guard replierLock(replierMtx);
+    stats.config = endpoint->replierConfig;
+    if (const auto &state = endpoint->replier) {
+        stats.enabled = true;
+        stats.replyComId = state->replyComId;
+        stats.replyBytes = state->replyTemplate->replySize();
+        stats.requests = state->requests;
+        stats.replies = state->replies;
+        stats.throttled = state->throttled;
+        stats.failed = state->failed;
+        stats.confirms = state->confirms;
+        stats.confirmTimeouts = state->confirmTimeouts;
+        stats.pending = state->pending;
+    }
+    return stats;
+}
+
+void TrdpEngine::handleMdRequest(std::uint32_t comId, const MdReplySessionId &sessionId, std::uint32_t requesterIp,
+                                 const std::uint8_t *data, std::size_t size)
+{
+    auto *endpoint = findEndpoint(comId);
+    if (endpoint == nullptr) {
+        return;
     }
 
-    resolvedSessionIp = sessionIp;
-    if (resolvedSessionIp != 0U) {
-        std::cout << "[TRDP] Binding TRDP sessions to interface IP " << formatIp(resolvedSessionIp) << std::endl;
+    std::unique_lock lock(replierMtx);
+    const auto state = endpoint->replier;
+    if (!state) {
+        return;
     }
+    ++state->requests;
 
-    std::set<std::uint16_t> pdPorts;
-    std::set<std::uint16_t> mdPorts;
-    bool hasPdTelegrams = false;
-    bool hasMdTelegrams = false;
-    for (const auto &telegram : TelegramRegistry::instance().listTelegrams()) {
-        const auto addPort = [](std::set<std::uint16_t> &ports, std::uint16_t port) {
-            if (port != 0U) {
-                ports.insert(port);
+    if (state->def.maxRepliesPerSecond > 0U) {
+        const auto now = clock.now();
+        const double elapsed = std::chrono::duration<double>(now - state->lastRefill).count();
+        const double limit = static_cast<double>(state->def.maxRepliesPerSecond);
+        state->tokens = std::min(limit, state->tokens + elapsed * limit);
+        state->lastRefill = now;
+        if (state->tokens < 1.0) {
+            ++state->throttled;
+            return;
+        }
+        state->tokens -= 1.0;
+    }
+
+    if (state->def.delay.count() > 0) {
+        PendingMdReply pending{};
+        pending.due = clock.now() + state->def.delay;
+        pending.comId = comId;
+        pending.sessionId = sessionId;
+        pending.requesterIp = requesterIp;
+        state->replyTemplate->render(data, size, pending.payload);
+        // A shard answers the requests it received itself; it is awake now and reschedules after this callback.
+        auto *const shard = currentShard != nullptr && currentShard->engine == this ? currentShard : nullptr;
+        auto &queue = shard != nullptr ? shard->pendingReplies : pendingMdReplies;
+        queue.push_back(std::move(pending));
+        std::push_heap(queue.begin(), queue.end(),
+                       [](const PendingMdReply &lhs, const PendingMdReply &rhs) { return lhs.due > rhs.due; });
+        ++state->pending;
+        if (shard == nullptr) {
+            lock.unlock();
+            {
+                // A sharded worker checks the queue under stateMtx before it waits, so it cannot miss this.
+                std::lock_guard wake(stateMtx);
             }
-        };
-        if (telegram.type == TelegramType::PD) {
-            hasPdTelegrams = true;
-            addPort(pdPorts, telegram.srcPort);
-            addPort(pdPorts, telegram.destPort);
-        } else {
-            hasMdTelegrams = true;
-            addPort(mdPorts, telegram.srcPort);
-            addPort(mdPorts, telegram.destPort);
+            cv.notify_all();
         }
+        return;
     }
 
-    if (!hasPdTelegrams) {
-        std::cout << "[TRDP] No PD telegrams configured; skipping PD stack setup" << std::endl;
-    }
-    if (!hasMdTelegrams) {
-        std::cout << "[TRDP] No MD telegrams configured; skipping MD stack setup" << std::endl;
+    state->replyTemplate->render(data, size, state->scratch);
+    if (sendMdReply(*endpoint, *state, sessionId, requesterIp, state->scratch)) {
+        ++state->replies;
+    } else {
+        ++state->failed;
     }
+}
 
-    if (hasPdTelegrams && pdPorts.empty()) {
-        pdPorts.insert(resolveDefaultPort(TelegramType::PD));
+void TrdpEngine::noteMdReplierConfirm(std::uint32_t comId, bool timedOut)
+{
+    auto *endpoint = findEndpoint(comId);
+    if (endpoint == nullptr) {
+        return;
     }
-    if (hasMdTelegrams && mdPorts.empty()) {
-        mdPorts.insert(resolveDefaultPort(TelegramType::MD));
+    std::lock_guard lock(replierMtx);
+    if (const auto &state = endpoint->replier) {
+        ++(timedOut ? state->confirmTimeouts : state->confirms);
     }
+}
 
-    const auto trdpSessionIp = toTrdpIp(resolvedSessionIp);
-
-    auto openPdSession = [&](std::uint16_t port) {
+bool TrdpEngine::sendMdReply(EndpointHandle &endpoint, const MdReplierState &state, const MdReplySessionId &sessionId,
+                             std::uint32_t requesterIp, const std::vector<std::uint8_t> &payload)
+{
+    if (!endpoint.mdHandleReady) {
+        return false;
+    }
+    const auto confirmTimeout =
+        state.def.confirmTimeout.count() > 0 ? state.def.confirmTimeout : endpoint.def->confirmTimeout;
+    const auto confirmTimeoutUs =
+        state.def.requireConfirm
+            ? static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(confirmTimeout).count())
+            : 0U;
+    const auto msgType = state.def.requireConfirm ? TrdpMsgType::Mq : TrdpMsgType::Mp;
+    const bool capturing = CaptureRecorder::instance().active();
+    if (nativeTransport) {
+        QueuedFrame queued;
+        if (nativeTransport->queueMdReply(msgType, state.replyComId, sessionId, state.def.userStatus,
+                                          confirmTimeoutUs, payload.data(), payload.size(),
+                                          capturing ? &queued : nullptr)) {
+            nativeTransport->flush();
+            if (capturing) {
+                captureTx(endpoint, queued, payload.data(), payload.size());
+            }
+            return true;
+        }
+        // No peer recorded for this session (e.g. a simulated request); fall through to the stub report.
+    }
+#ifdef TRDP_STACK_PRESENT
+    if (stackAvailable) {
+        TRDP_UUID_T trdpSessionId{};
+        static_assert(sizeof(trdpSessionId) == sizeof(MdReplySessionId), "Unexpected TRDP_UUID_T size");
+        std::memcpy(&trdpSessionId, sessionId.data(), sessionId.size());
+        TRDP_SEND_PARAM_T sendParam = TRDP_MD_DEFAULT_SEND_PARAM;
+        sendParam.ttl = endpoint.def->ttl;
+        applyTelegramQos(*endpoint.def, sendParam);
+        applyTelegramPorts(*endpoint.def, sendParam);
+        TRDP_ERR_T err{};
+        if (state.def.requireConfirm) {
+            err = tlm_replyQuery(endpoint.mdSessionHandle, &trdpSessionId, state.replyComId, state.def.userStatus,
+                                 confirmTimeoutUs, &sendParam, payload.data(), static_cast<UINT32>(payload.size()),
+                                 nullptr);
+        } else {
+            err = tlm_reply(endpoint.mdSessionHandle, &trdpSessionId, state.replyComId, state.def.userStatus,
+                            &sendParam, payload.data(), static_cast<UINT32>(payload.size()), nullptr);
+        }
+        if (err != TRDP_NO_ERR) {
+            std::cerr << "[TRDP] " << (state.def.requireConfirm ? "tlm_replyQuery" : "tlm_reply")
+                      << " failed for ComId " << endpoint.def->comId << ": " << describeTrdpError(err) << std::endl;
+            return false;
+        }
+        if (capturing) {
+            // The stack answers from the session's MD port to the requester; it keeps MD sequence counters private.
+            QueuedFrame queued;
+            queued.header.msgType = msgType;
+            queued.header.comId = state.replyComId;
+            queued.header.etbTopoCounter = etbTopoCounter;
+            queued.header.opTrainTopoCounter = opTrainTopoCounter;
+            queued.header.replyStatus = state.def.userStatus;
+            queued.header.sessionId = sessionId;
+            queued.header.replyTimeoutUs = confirmTimeoutUs;
+            queued.destIp = requesterIp;
+            queued.srcPort = stackSessionPort(endpoint.mdSessionHandle);
+            queued.destPort = queued.srcPort;
+            captureTx(endpoint, queued, payload.data(), payload.size());
+        }
+        return true;
+    }
+#else
+    (void)state;
+    (void)sessionId;
+    (void)requesterIp;
+#endif
+    std::cout << "[TRDP] MD auto-reply ComId=" << endpoint.def->comId << " bytes=" << payload.size()
+              << " (stub)" << std::endl;
+    return true;
+}
+
+void TrdpEngine::dispatchMdReplies(std::chrono::steady_clock::time_point now, std::vector<PendingMdReply> &queue)
+{
+    const auto laterFirst = [](const PendingMdReply &lhs, const PendingMdReply &rhs) { return lhs.due > rhs.due; };
+    std::lock_guard lock(replierMtx);
+    while (!queue.empty() && queue.front().due <= now) {
+        std::pop_heap(queue.begin(), queue.end(), laterFirst);
+        auto reply = std::move(queue.back());
+        queue.pop_back();
+
+        auto *endpoint = findEndpoint(reply.comId);
+        if (endpoint == nullptr || !endpoint->replier) {
+            continue;
+        }
+        auto &state = *endpoint->replier;
+        state.pending -= std::min<std::size_t>(state.pending, 1U);
+        if (sendMdReply(*endpoint, state, reply.sessionId, reply.requesterIp, reply.payload)) {
+            ++state.replies;
+        } else {
+            ++state.failed;
+        }
+    }
+}
+
+std::optional<std::chrono::steady_clock::time_point> TrdpEngine::nextMdReplyDue(
+    const std::vector<PendingMdReply> &queue)
+{
+    std::lock_guard lock(replierMtx);
+    if (queue.empty()) {
+        return std::nullopt;
+    }
+    return queue.front().due;
+}
+
+std::optional<std::chrono::steady_clock::time_point> TrdpEngine::nextDeadline()
+{
+    std::optional<std::chrono::steady_clock::time_point> next = nextMdReplyDue(pendingMdReplies);
+    const auto consider = [&next](std::chrono::steady_clock::time_point due) {
+        if (due.time_since_epoch().count() != 0 && (!next || due < *next)) {
+            next = due;
+        }
+    };
+    for (auto &[comId, endpoint] : *endpointTable) {
+        (void)comId;
+        if (endpoint.def->type == TelegramType::PD && endpoint.def->direction == Direction::Tx &&
+            endpoint.txCyclicActive.load() && endpoint.cycle.count() > 0) {
+            std::lock_guard endpointLock(endpoint.mtx);
+            consider(endpoint.nextSend);
+        }
+    }
+    if (const auto timeout = nextMdTimeout()) {
+        consider(*timeout);
+    }
+    return next;
+}
+
+std::optional<std::chrono::steady_clock::time_point> TrdpEngine::nextMdTimeout()
+{
+    std::optional<std::chrono::steady_clock::time_point> next;
+    const auto consider = [&next](std::chrono::steady_clock::time_point due) {
+        if (due.time_since_epoch().count() != 0 && (!next || due < *next)) {
+            next = due;
+        }
+    };
+    std::lock_guard lock(mdSessionMtx);
+    for (const auto &[sessionId, state] : mdTimelineSessions) {
+        (void)sessionId;
+        if (state.expectedReplies > state.receivedReplies) {
+            consider(state.replyDeadline);
+        }
+        if (!state.confirmObserved) {
+            consider(state.confirmDeadline);
+        }
+    }
+    return next;
+}
+
+TrdpEngine::TrdpEngine() : registry(TelegramRegistry::instance()), primary(true) {}
+
+TrdpEngine::TrdpEngine(TelegramRegistry &registry, std::string workspace)
+    : registry(registry), workspace(std::move(workspace)) {}
+
+TrdpEngine::~TrdpEngine() { stop(); }
+
+TrdpEngine &TrdpEngine::instance() {
+    static TrdpEngine engine;
+    return engine;
+}
+
+bool TrdpEngine::bootstrapRegistry() {
+    if (!primary) {
+        // Workspace registries are loaded by their owner before the engine starts.
+        return true;
+    }
+    if (!ensureRegistryInitialized()) {
+        std::cerr << "TRDP registry failed to initialise from XML" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TrdpEngine::initialiseTrdpStack() {
+    std::cout << "[TRDP] Initialising stack..." << std::endl;
+    if (!stackAvailable) {
+        if (!initialiseNativeTransport()) {
+            std::cout << "[TRDP] No TRDP transport available; running in stub mode" << std::endl;
+        }
+        pdSessionInitialised = true;
+        mdSessionInitialised = true;
+        return true;
+    }
+
+#ifdef TRDP_STACK_PRESENT
+    constexpr std::size_t kHeapSize = 64 * 1024;
+    heapStorage.assign(kHeapSize, 0U);
+    if (config.prefault) {
+        prefaultPages(heapStorage.data(), heapStorage.size());
+    }
+
+    TRDP_MEM_CONFIG_T memConfig{};
+    memConfig.p = heapStorage.data();
+    memConfig.size = static_cast<UINT32>(heapStorage.size());
+
+    const TRDP_ERR_T initErr = tlc_init(nullptr, nullptr, &memConfig);
+    if (initErr != TRDP_NO_ERR) {
+        logTrdpError("tlc_init", initErr);
+        if (initErr == TRDP_PARAM_ERR) {
+            std::cerr << "[TRDP] Hint: verify TRDP/TAU packages are installed and compatible with the simulator build; "
+                      << "parameter errors often indicate a version or configuration mismatch." << std::endl;
+        }
+        return false;
+    }
+
+    std::uint32_t sessionIp = 0U;
+    const auto txIp = resolveInterfaceIp(config.txInterface);
+    const auto rxIp = resolveInterfaceIp(config.rxInterface);
+    if (config.txInterface.empty() && config.rxInterface.empty()) {
+        sessionIp = 0U;
+    } else if (txIp) {
+        sessionIp = *txIp;
+    } else if (rxIp) {
+        sessionIp = *rxIp;
+    }
+
+    if (sessionIp == 0U) {
+        const auto contents = registry.snapshot();
+        for (const auto &[comId, telegram] : contents->telegrams) {
+            if (telegram->direction == Direction::Tx && telegram->srcIp != 0U) {
+                sessionIp = telegram->srcIp;
+                break;
+            }
+        }
+    }
+
+    if (sessionIp != 0U && !ipAssignedToLocalInterface(sessionIp)) {
+        std::cerr << "[TRDP] Selected session IP " << formatIp(sessionIp)
+                  << " is not configured on this host; falling back to default interface selection" << std::endl;
+        sessionIp = 0U;
+    }
+
+    if ((sessionIp & 0xFF000000U) == 0x7F000000U) {
+        const auto fallbackIp = firstNonLoopbackIp();
+        if (fallbackIp) {
+            std::cerr << "[TRDP] Loopback session IP " << formatIp(sessionIp)
+                      << " will be replaced with non-loopback address " << formatIp(*fallbackIp)
+                      << " to satisfy TRDP socket binding requirements" << std::endl;
+            sessionIp = *fallbackIp;
+        } else {
+            std::cerr << "[TRDP] Only loopback interfaces found; attempting to continue with " << formatIp(sessionIp)
+                      << std::endl;
+        }
+    } else if (sessionIp == 0U) {
+        const auto fallbackIp = firstNonLoopbackIp();
+        if (fallbackIp) {
+            std::cout << "[TRDP] No session IP configured; defaulting to interface IP " << formatIp(*fallbackIp)
+                      << std::endl;
+            sessionIp = *fallbackIp;
+        }
+    }
+
+    if (!config.txInterface.empty() && !txIp) {
+        std::cerr << "[TRDP] Unable to resolve TX interface '" << config.txInterface
+                  << "'; falling back to default stack selection" << std::endl;
+    }
+    if (!config.rxInterface.empty() && !rxIp) {
+        std::cerr << "[TRDP] Unable to resolve RX interface '" << config.rxInterface
+                  << "'; falling back to default stack selection" << std::endl;
+    }
+
+    resolvedSessionIp = sessionIp;
+    if (resolvedSessionIp != 0U) {
+        std::cout << "[TRDP] Binding TRDP sessions to interface IP " << formatIp(resolvedSessionIp) << std::endl;
+    }
+
+    std::set<std::uint16_t> pdPorts;
+    std::set<std::uint16_t> mdPorts;
+    bool hasPdTelegrams = false;
+    bool hasMdTelegrams = false;
+    const auto contents = registry.snapshot();
+    for (const auto &[comId, telegram] : contents->telegrams) {
+        const auto addPort = [](std::set<std::uint16_t> &ports, std::uint16_t port) {
+            if (port != 0U) {
+                ports.insert(port);
+            }
+        };
+        if (telegram->type == TelegramType::PD) {
+            hasPdTelegrams = true;
+            addPort(pdPorts, telegram->srcPort);
+            addPort(pdPorts, telegram->destPort);
+        } else {
+            hasMdTelegrams = true;
+            addPort(mdPorts, telegram->srcPort);
+            addPort(mdPorts, telegram->destPort);
+        }
+    }
+
+    if (!hasPdTelegrams) {
+        std::cout << "[TRDP] No PD telegrams configured; skipping PD stack setup" << std::endl;
+    }
+    if (!hasMdTelegrams) {
+        std::cout << "[TRDP] No MD telegrams configured; skipping MD stack setup" << std::endl;
+    }
+
+    if (hasPdTelegrams && pdPorts.empty()) {
+        pdPorts.insert(resolveDefaultPort(registry, TelegramType::PD));
+    }
+    if (hasMdTelegrams && mdPorts.empty()) {
+        mdPorts.insert(resolveDefaultPort(registry, TelegramType::MD));
+    }
+
+    const auto trdpSessionIp = toTrdpIp(resolvedSessionIp);
+
+    auto openPdSession = [&](std::uint16_t port) {
         TRDP_PD_CONFIG_T pdDefault{};
         pdDefault.port = port;
         pdDefault.sendParam = TRDP_PD_DEFAULT_SEND_PARAM;
@@ -1057,10 +1608,6 @@ bool TrdpEngine::initialiseTrdpStack() {
         (void)tlc_configSession(session, nullptr, nullptr, nullptr, nullptr);
         (void)tlc_updateSession(session);
     }
-#else
-    pdSessionInitialised = true;
-    mdSessionInitialised = true;
-#endif
 
     if (pdSessionInitialised) {
         std::cout << "[TRDP] PD session handle ready on ports";
@@ -1082,6 +1629,78 @@ bool TrdpEngine::initialiseTrdpStack() {
     } else {
         std::cout << "[TRDP] MD stack inactive" << std::endl;
     }
+#else
+    pdSessionInitialised = true;
+    mdSessionInitialised = true;
+#endif
+    return true;
+}
+
+bool TrdpEngine::initialiseNativeTransport() {
+    std::uint32_t bindIp = 0U;
+    if (const auto txIp = resolveInterfaceIp(config.txInterface)) {
+        bindIp = *txIp;
+    } else if (const auto rxIp = resolveInterfaceIp(config.rxInterface)) {
+        bindIp = *rxIp;
+    }
+    std::uint32_t localIp = 0U;
+    if (!config.hostIp.empty()) {
+        in_addr addr{};
+        if (inet_pton(AF_INET, config.hostIp.c_str(), &addr) != 1) {
+            std::cerr << "[TRDP] Invalid host IP " << config.hostIp << std::endl;
+            return false;
+        }
+        localIp = ntohl(addr.s_addr);
+    }
+    resolvedSessionIp = localIp;
+
+    // PD and MD share one socket per port; the message type in the header tells them apart.
+    std::set<std::uint16_t> ports;
+    std::set<std::uint32_t> multicastGroups;
+    const auto contents = registry.snapshot();
+    for (const auto &[comId, telegram] : contents->telegrams) {
+        if (telegram->srcPort != 0U) {
+            ports.insert(telegram->srcPort);
+        }
+        if (telegram->destPort != 0U) {
+            ports.insert(telegram->destPort);
+        }
+        if (telegram->direction == Direction::Rx && (telegram->destIp & 0xF0000000U) == 0xE0000000U) {
+            multicastGroups.insert(telegram->destIp);
+        }
+    }
+    if (ports.empty()) {
+        ports.insert(kDefaultTrdpPort);
+    }
+
+    auto transport = std::make_unique<NativeTransport>(bindIp, localIp);
+    for (const auto port : ports) {
+        transport->openPort(port);
+    }
+    if (transport->ports().empty()) {
+        std::cerr << "[TRDP] Native transport could not open any UDP port" << std::endl;
+        return false;
+    }
+    for (const auto group : multicastGroups) {
+        transport->joinMulticast(group);
+    }
+    transport->setTopologyCounters(etbTopoCounter, opTrainTopoCounter);
+
+    std::cout << "[TRDP] Native UDP transport ready on ports";
+    for (const auto port : transport->ports()) {
+        std::cout << ' ' << port;
+    }
+    if (localIp != 0U) {
+        std::cout << " on " << formatIp(localIp);
+    }
+    if (bindIp != 0U) {
+        std::cout << " (interface " << formatIp(bindIp) << ")";
+    }
+    if (!primary) {
+        std::cout << " for workspace " << workspace;
+    }
+    std::cout << std::endl;
+    nativeTransport = std::move(transport);
     return true;
 }
 
@@ -1090,6 +1709,11 @@ void TrdpEngine::teardownTrdpStack() {
         return;
     }
 
+    if (nativeTransport) {
+        nativeTransport->flush();
+        nativeTransport.reset();
+    }
+
     if (stackAvailable) {
 #ifdef TRDP_STACK_PRESENT
         for (auto &[port, session] : mdAppSessions) {
@@ -1172,6 +1796,10 @@ std::chrono::milliseconds TrdpEngine::stackIntervalHint() const {
         }
 #endif
     }
+    return idleIntervalHint();
+}
+
+std::chrono::milliseconds TrdpEngine::idleIntervalHint() const {
     if (config.idleInterval.count() > 0) {
         return config.idleInterval;
     }
@@ -1222,7 +1850,7 @@ void TrdpEngine::trimCaches() {
         return;
     }
 
-    const auto now = std::chrono::steady_clock::now();
+    const auto now = clock.now();
     const auto eraseExpired = [&](auto &cache) {
         for (auto it = cache.begin(); it != cache.end();) {
             if (now >= it->second.expiresAt) {
@@ -1254,9 +1882,9 @@ void TrdpEngine::updateCacheLimits() {
 void TrdpEngine::setCacheEntry(CacheEntry &entry, CacheEntry::Payload value) {
     entry.payload = std::move(value);
     if (config.cacheConfig.uriCacheTtl.count() > 0) {
-        entry.expiresAt = std::chrono::steady_clock::now() + config.cacheConfig.uriCacheTtl;
+        entry.expiresAt = clock.now() + config.cacheConfig.uriCacheTtl;
     } else {
-        entry.expiresAt = std::chrono::steady_clock::now();
+        entry.expiresAt = clock.now();
     }
 }
 
@@ -1264,12 +1892,15 @@ void TrdpEngine::markTopologyChanged() {
     ++etbTopoCounter;
     ++opTrainTopoCounter;
     topologyCountersDirty = true;
+    if (nativeTransport) {
+        nativeTransport->setTopologyCounters(etbTopoCounter, opTrainTopoCounter);
+    }
     std::cout << "[TRDP] Topology change detected; ETB=" << etbTopoCounter
               << " OpTrain=" << opTrainTopoCounter << std::endl;
 }
 
-void TrdpEngine::applyTopologyCounters(TRDP_APP_SESSION_T session) {
 #ifdef TRDP_STACK_PRESENT
+void TrdpEngine::applyTopologyCounters(TRDP_APP_SESSION_T session) {
     if (!session) {
         return;
     }
@@ -1279,30 +1910,90 @@ void TrdpEngine::applyTopologyCounters(TRDP_APP_SESSION_T session) {
         std::cerr << "[TRDP] Failed to set topology counters during session setup; ETB err=" << etbErr
                   << " OpTrain err=" << opErr << std::endl;
     }
-#else
-    (void)session;
-#endif
 }
+#endif
 
 bool TrdpEngine::publishPdBuffer(EndpointHandle &endpoint, const std::vector<std::uint8_t> &buffer) {
+    return publishPdBuffer(endpoint, buffer.data(), buffer.size());
+}
+
+bool TrdpEngine::publishPdBuffer(EndpointHandle &endpoint, const std::uint8_t *data, std::size_t size) {
     if (!endpoint.pdHandleReady) {
-        std::cerr << "[TRDP] PD session not available; drop TX ComId " << endpoint.def.comId << std::endl;
+        std::cerr << "[TRDP] PD session not available; drop TX ComId " << endpoint.def->comId << std::endl;
+        pdTxFailed.fetch_add(1, std::memory_order_relaxed);
         return false;
     }
+    if (nativeTransport) {
+        const auto destPort = endpoint.def->destPort != 0U ? endpoint.def->destPort : kDefaultTrdpPort;
+        const bool capturing = CaptureRecorder::instance().active();
+        QueuedFrame queued;
+        if (!nativeTransport->queuePd(endpoint.def->comId, resolvePortForEndpoint(*endpoint.def), endpoint.def->destIp,
+                                      destPort, data, size, capturing ? &queued : nullptr)) {
+            std::cerr << "[TRDP] Native PD send failed for ComId " << endpoint.def->comId << std::endl;
+            pdTxFailed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (capturing) {
+            captureTx(endpoint, queued, data, size);
+        }
+    }
 #ifdef TRDP_STACK_PRESENT
     if (stackAvailable) {
-        TRDP_ERR_T err = tlp_put(endpoint.pdSessionHandle, endpoint.pdPublishHandle, buffer.data(),
-                                 static_cast<UINT32>(buffer.size()));
+        TRDP_ERR_T err =
+            tlp_put(endpoint.pdSessionHandle, endpoint.pdPublishHandle, data, static_cast<UINT32>(size));
         if (err != TRDP_NO_ERR) {
-            std::cerr << "[TRDP] tlp_put failed for ComId " << endpoint.def.comId << ": " << err << std::endl;
+            std::cerr << "[TRDP] tlp_put failed for ComId " << endpoint.def->comId << ": " << err << std::endl;
+            pdTxFailed.fetch_add(1, std::memory_order_relaxed);
             return false;
         }
     }
 #endif
-    std::cout << "[TRDP] PD send ComId=" << endpoint.def.comId << " bytes=" << buffer.size() << std::endl;
+    // The stack sends on its own cycle; pdSendCallback records those frames as they leave.
+    pdTxSent.fetch_add(1, std::memory_order_relaxed);
+    if (logPdSends.load(std::memory_order_relaxed)) {
+        std::cout << "[TRDP] PD send ComId=" << endpoint.def->comId << " bytes=" << size << std::endl;
+    }
     return true;
 }
 
+void TrdpEngine::captureTx(const EndpointHandle &endpoint, const QueuedFrame &queued, const std::uint8_t *data,
+                           std::size_t size) {
+    CapturedTelegram telegram;
+    telegram.direction = CaptureDirection::Tx;
+    telegram.header = queued.header;
+    telegram.header.datasetLength = static_cast<std::uint32_t>(size);
+    telegram.srcIp = endpoint.def->srcIp != 0U ? endpoint.def->srcIp : resolvedSessionIp;
+    telegram.destIp = queued.destIp;
+    telegram.srcPort = queued.srcPort;
+    telegram.destPort = queued.destPort;
+    telegram.data = data;
+    telegram.size = size;
+    telegram.timestampNs = clock.wallNowNs();
+    CaptureRecorder::instance().record(telegram);
+}
+
+TrdpEngine::TrdpConfig TrdpEngine::activeConfig() {
+    std::lock_guard lock(stateMtx);
+    return config;
+}
+
+TrdpEngine::TxCounters TrdpEngine::txCounters() const noexcept {
+    return TxCounters{pdTxSent.load(std::memory_order_relaxed), pdTxFailed.load(std::memory_order_relaxed)};
+}
+
+std::optional<std::chrono::nanoseconds> TrdpEngine::workerCpuTime() {
+    if (!running.load() || !worker.joinable()) {
+        return std::nullopt;
+    }
+    auto total = threadCpuTime(worker);
+    for (auto &shard : shards) {
+        if (const auto cpu = threadCpuTime(shard->thread); total && cpu) {
+            *total += *cpu;
+        }
+    }
+    return total;
+}
+
 bool TrdpEngine::initialiseDnr() {
 #if defined(TRDP_STACK_PRESENT) && TRDP_HAS_TAU_DNR
     if constexpr (!kDnrCompiledIn) {
@@ -1378,13 +2069,12 @@ void TrdpEngine::pollEcspStatus() {
     if (!ecspInitialised) {
         return;
     }
-    static auto lastPoll = std::chrono::steady_clock::time_point{};
-    const auto now = std::chrono::steady_clock::now();
-    if (lastPoll.time_since_epoch().count() != 0 &&
-        now - lastPoll < std::max(config.ecspConfig.pollInterval, std::chrono::milliseconds(10))) {
+    const auto now = clock.now();
+    if (lastEcspPoll.time_since_epoch().count() != 0 &&
+        now - lastEcspPoll < std::max(config.ecspConfig.pollInterval, std::chrono::milliseconds(10))) {
         return;
     }
-    lastPoll = now;
+    lastEcspPoll = now;
     TRDP_APP_SESSION_T session = pdSessionInitialised ? defaultPdSession() : defaultMdSession();
     if (session == nullptr) {
         return;
@@ -1444,7 +2134,9 @@ bool TrdpEngine::processStackOnce(
             topologyCountersDirty = false;
         }
 
-        if (pdSessionInitialised) {
+        // With stack shards, each session is processed by the shard owning its port instead.
+        const bool ownsSessions = shards.empty();
+        if (pdSessionInitialised && ownsSessions) {
             bool firstPd = true;
             for (const auto &[port, session] : pdSessions) {
                 (void)port;
@@ -1458,7 +2150,7 @@ bool TrdpEngine::processStackOnce(
                 firstPd = false;
             }
         }
-        if (mdSessionInitialised) {
+        if (mdSessionInitialised && ownsSessions) {
             bool firstMd = true;
             for (const auto &[port, session] : mdAppSessions) {
                 (void)port;
@@ -1481,182 +2173,630 @@ bool TrdpEngine::processStackOnce(
     return true;
 }
 
-void TrdpEngine::dispatchCyclicTransmissions(std::chrono::steady_clock::time_point now) {
-    for (auto &[comId, endpoint] : endpoints) {
-        if (endpoint.def.type != TelegramType::PD || endpoint.def.direction != Direction::Tx) {
-            continue;
-        }
-        if (!endpoint.txCyclicActive || endpoint.cycle.count() <= 0) {
+std::optional<std::chrono::steady_clock::time_point> TrdpEngine::dispatchCyclicTransmissions(
+    std::chrono::steady_clock::time_point now) {
+    std::optional<std::chrono::steady_clock::time_point> next;
+    for (auto &[comId, endpoint] : endpointTable->cyclic) {
+        if (endpoint->shard != nullptr || !endpoint->txCyclicActive.load(std::memory_order_relaxed)) {
             continue;
         }
-        if (endpoint.nextSend.time_since_epoch().count() == 0) {
-            endpoint.nextSend = now + endpoint.cycle;
-            continue;
-        }
-        if (now < endpoint.nextSend) {
-            continue;
-        }
-
-        const auto buffer = endpoint.runtime->getBufferCopy();
-        if (publishPdBuffer(endpoint, buffer)) {
-            endpoint.nextSend = now + endpoint.cycle;
-            if (auto *hub = TelegramHub::instance()) {
-                hub->publishTxConfirmation(comId, endpoint.runtime->snapshotFields(), endpoint.txCyclicActive);
-            }
-        } else {
-            endpoint.txCyclicActive = false;
+        std::lock_guard endpointLock(endpoint->mtx);
+        if (const auto due = publishIfDue(comId, *endpoint, now, workerJitter); due && (!next || *due < *next)) {
+            next = due;
         }
     }
+    if (nativeTransport) {
+        nativeTransport->flush();
+    }
+    return next;
+}
+
+std::optional<std::chrono::steady_clock::time_point> TrdpEngine::publishIfDue(std::uint32_t comId,
+                                                                              EndpointHandle &endpoint,
+                                                                              std::chrono::steady_clock::time_point now,
+                                                                              CycleJitter &jitter) {
+    if (!endpoint.txCyclicActive.load() || endpoint.cycle.count() <= 0) {
+        return std::nullopt;
+    }
+    if (endpoint.nextSend.time_since_epoch().count() == 0) {
+        endpoint.nextSend = now + endpoint.cycle;
+        return endpoint.nextSend;
+    }
+    if (now < endpoint.nextSend) {
+        return endpoint.nextSend;
+    }
+
+    // Published straight from the runtime's arena slot, under its lock, so the payload is never copied.
+    bool published = false;
+    const auto send = [&](const std::uint8_t *data, std::size_t size) {
+        published = publishPdBuffer(endpoint, data, size);
+        if (published && primary) {
+            const auto stampNs = clock.wallNowNs();
+            FieldHistory::instance().record(comId, data, size, stampNs);
+            HistoryStore::instance().record(comId, data, size, stampNs);
+        }
+    };
+    const bool stamped = endpoint.generators || endpoint.sdt;
+    if (stamped) {
+        // Generated fields and the SDT trailer are written straight into the runtime buffer; the field map is
+        // only refreshed below when a client is watching.
+        endpoint.runtime->updateBuffer([&](std::uint8_t *data, std::size_t size) {
+            if (endpoint.generators) {
+                endpoint.generators->advance(data, size, now);
+                if (endpoint.checksums) {
+                    writeChecksums(endpoint.checksums->fields, data, size);
+                }
+            }
+            if (endpoint.sdt) {
+                endpoint.sdt->seal(data, size);
+            }
+            send(data, size);
+        });
+    } else {
+        endpoint.runtime->readBuffer(send);
+    }
+    if (!published) {
+        endpoint.txCyclicActive.store(false);
+        return std::nullopt;
+    }
+    // Lateness against the scheduled instant, read after the send so it includes the time spent publishing the
+    // endpoints ahead of this one in the same pass.
+    const auto sentAt = clock.now();
+    jitter.record(sentAt - endpoint.nextSend);
+    endpoint.nextSend += endpoint.cycle;
+    if (endpoint.nextSend <= sentAt) {
+        // A full cycle or more behind: skip the missed instants instead of sending a burst, keeping the phase.
+        const auto missed = (sentAt - endpoint.nextSend) / endpoint.cycle + 1;
+        endpoint.nextSend += missed * endpoint.cycle;
+        jitter.recordOverruns(static_cast<std::uint64_t>(missed));
+    }
+    // Skip building the JSON confirmation when nobody is listening; it dominates large cyclic loads.
+    if (auto *hub = eventHub.load(); hub != nullptr && hub->hasSubscribers()) {
+        if (stamped) {
+            decodeFieldsIntoRuntime(endpoint.runtime->dataset(), *endpoint.runtime, endpoint.runtime->getBufferCopy());
+        }
+        hub->publishTxConfirmation(comId, endpoint.runtime->snapshotFields(), endpoint.txCyclicActive.load());
+    }
+    return endpoint.nextSend;
+}
+
+thread_local TrdpEngine::Shard *TrdpEngine::currentShard = nullptr;
+
+void TrdpEngine::startShards() {
+    std::vector<std::uint16_t> ports;
+    if (nativeTransport) {
+        ports = nativeTransport->ports();
+    }
+#ifdef TRDP_STACK_PRESENT
+    if (stackAvailable) {
+        // Each port has its own PD and/or MD session; the shard owning the port runs tlc_process for both.
+        std::set<std::uint16_t> sessionPorts;
+        for (const auto &[port, session] : pdSessions) {
+            (void)session;
+            sessionPorts.insert(port);
+        }
+        for (const auto &[port, session] : mdAppSessions) {
+            (void)session;
+            sessionPorts.insert(port);
+        }
+        ports.assign(sessionPorts.begin(), sessionPorts.end());
+    }
+#endif
+    const auto count = std::min(config.shards, ports.size());
+    if (count == 0U) {
+        return;
+    }
+
+    // Balance the ports by the number of cyclic telegrams they carry: busiest port first, onto the least loaded
+    // shard.
+    std::map<std::uint16_t, std::size_t> load;
+    for (const auto port : ports) {
+        load[port] = 0U;
+    }
+    for (const auto &[comId, endpoint] : *endpointTable) {
+        (void)comId;
+        if (endpoint.def->type == TelegramType::PD && endpoint.def->direction == Direction::Tx) {
+            if (const auto it = load.find(resolvePortForEndpoint(*endpoint.def)); it != load.end()) {
+                ++it->second;
+            }
+        }
+    }
+    std::vector<std::pair<std::uint16_t, std::size_t>> byLoad(load.begin(), load.end());
+    std::stable_sort(byLoad.begin(), byLoad.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+    std::vector<std::vector<std::uint16_t>> shardPorts(count);
+    std::vector<std::size_t> shardLoad(count, 0U);
+    for (const auto &[port, telegrams] : byLoad) {
+        const auto target = static_cast<std::size_t>(
+            std::min_element(shardLoad.begin(), shardLoad.end()) - shardLoad.begin());
+        shardPorts[target].push_back(port);
+        // Every port counts, so idle ports are spread as well.
+        shardLoad[target] += telegrams + 1U;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        auto shard = std::make_unique<Shard>();
+        shard->engine = this;
+        shard->index = i;
+        shard->realtime = config.workerRealtime;
+        shard->realtime.cpu = i < config.shardCpus.size() ? config.shardCpus[i] : -1;
+        shard->prefault = config.prefault;
+        std::sort(shardPorts[i].begin(), shardPorts[i].end());
+        shard->portList = shardPorts[i];
+        if (nativeTransport) {
+            shard->ports = nativeTransport->makePortGroup(shardPorts[i]);
+        }
+#ifdef TRDP_STACK_PRESENT
+        for (const auto port : shard->portList) {
+            if (const auto it = pdSessions.find(port); it != pdSessions.end()) {
+                shard->sessions.push_back(it->second);
+            }
+            if (const auto it = mdAppSessions.find(port); it != mdAppSessions.end()) {
+                shard->sessions.push_back(it->second);
+            }
+        }
+#endif
+        shards.push_back(std::move(shard));
+    }
+    assignShardEndpoints();
+
+    for (auto &shard : shards) {
+        shard->thread = std::thread([this, raw = shard.get()]() { shardLoop(*raw); });
+        std::cout << "[TRDP] Shard " << shard->index << ": " << shard->cyclic.size() << " cyclic telegram(s) on "
+                  << (nativeTransport ? "port(s)" : "stack session port(s)");
+        for (const auto port : shard->portList) {
+            std::cout << ' ' << port;
+        }
+        std::cout << std::endl;
+    }
+}
+
+void TrdpEngine::assignShardEndpoints() {
+    std::map<std::uint16_t, Shard *> owner;
+    for (auto &shard : shards) {
+        shard->cyclic.clear();
+        for (const auto port : shard->portList) {
+            owner[port] = shard.get();
+        }
+    }
+    for (auto &[comId, endpoint] : endpointTable->cyclic) {
+        if (const auto it = owner.find(resolvePortForEndpoint(*endpoint->def)); it != owner.end()) {
+            endpoint->shard = it->second;
+            it->second->cyclic.emplace_back(comId, endpoint);
+        }
+    }
+}
+
+void TrdpEngine::stopShards() {
+    for (auto &shard : shards) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+    // transportStatus() lists the shards under stateMtx.
+    std::lock_guard lock(stateMtx);
+    shards.clear();
+}
+
+void TrdpEngine::shardLoop(Shard &shard) {
+    applyRealtime("shard " + std::to_string(shard.index), shard.realtime, shard.prefault);
+    currentShard = &shard;
+#ifdef TRDP_STACK_PRESENT
+    if (!shard.ports) {
+        stackShardLoop(shard);
+        currentShard = nullptr;
+        return;
+    }
+#endif
+    const auto handler = [this](const NativeFrame &frame) { handleNativeFrame(frame); };
+    while (!stopRequested.load()) {
+        if (parkRequested.load()) {
+            parkIfRequested();
+            continue;
+        }
+        const auto now = clock.now();
+        auto wakeAt = now + stackIntervalHint();
+        for (auto &[comId, endpoint] : shard.cyclic) {
+            if (!endpoint->txCyclicActive.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            std::lock_guard endpointLock(endpoint->mtx);
+            if (const auto due = publishIfDue(comId, *endpoint, now, shard.jitter)) {
+                wakeAt = std::min(wakeAt, *due);
+            }
+        }
+        dispatchMdReplies(now, shard.pendingReplies);
+        if (const auto replyDue = nextMdReplyDue(shard.pendingReplies)) {
+            wakeAt = std::min(wakeAt, *replyDue);
+        }
+        shard.framesSent.fetch_add(nativeTransport->flush(*shard.ports), std::memory_order_relaxed);
+        // Measured after the flush so the wait ends at the due instant itself, not a flush later.
+        nativeTransport->poll(*shard.ports, wakeAt - clock.now(), handler);
+    }
+    currentShard = nullptr;
+}
+
+#ifdef TRDP_STACK_PRESENT
+void TrdpEngine::stackShardLoop(Shard &shard) {
+    while (!stopRequested.load()) {
+        if (parkRequested.load()) {
+            parkIfRequested();
+            continue;
+        }
+        const auto now = clock.now();
+        auto wakeAt = now + idleIntervalHint();
+        for (auto &[comId, endpoint] : shard.cyclic) {
+            if (!endpoint->txCyclicActive.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            std::lock_guard endpointLock(endpoint->mtx);
+            if (const auto due = publishIfDue(comId, *endpoint, now, shard.jitter)) {
+                wakeAt = std::min(wakeAt, *due);
+            }
+        }
+        dispatchMdReplies(now, shard.pendingReplies);
+        if (const auto replyDue = nextMdReplyDue(shard.pendingReplies)) {
+            wakeAt = std::min(wakeAt, *replyDue);
+        }
+
+        // One select over the sockets of every owned session, until the earliest of their stack deadlines.
+        TRDP_FDS_T readFds{};
+        FD_ZERO(&readFds);
+        TRDP_SOCK_T maxFd = -1;
+        for (auto *session : shard.sessions) {
+            TRDP_TIME_T interval{};
+            TRDP_FDS_T sessionFds{};
+            FD_ZERO(&sessionFds);
+            TRDP_SOCK_T sessionMaxFd = -1;
+            if (tlc_getInterval(session, &interval, &sessionFds, &sessionMaxFd) != TRDP_NO_ERR) {
+                continue;
+            }
+            wakeAt = std::min(wakeAt, now + std::chrono::seconds(interval.tv_sec) +
+                                          std::chrono::microseconds(interval.tv_usec));
+            for (TRDP_SOCK_T fd = 0; fd <= sessionMaxFd; ++fd) {
+                if (FD_ISSET(fd, &sessionFds)) {
+                    FD_SET(fd, &readFds);
+                }
+            }
+            maxFd = std::max(maxFd, sessionMaxFd);
+        }
+        const auto wait = std::max(std::chrono::ceil<std::chrono::microseconds>(wakeAt - clock.now()),
+                                   std::chrono::microseconds(0));
+        timeval tv{};
+        tv.tv_sec = static_cast<time_t>(wait.count() / 1000000);
+        tv.tv_usec = static_cast<suseconds_t>(wait.count() % 1000000);
+        const int rv = select(static_cast<int>(maxFd) + 1, &readFds, nullptr, nullptr, &tv);
+        if (rv < 0) {
+            if (errno != EINTR) {
+                std::cerr << "[TRDP] select (shard " << shard.index << ") failed: " << errno << std::endl;
+            }
+            FD_ZERO(&readFds);
+        }
+        for (auto *session : shard.sessions) {
+            TRDP_FDS_T ready = readFds;
+            INT32 readyCount = std::max(rv, 0);
+            const TRDP_ERR_T err = tlc_process(session, &ready, &readyCount);
+            if (err != TRDP_NO_ERR) {
+                std::cerr << "[TRDP] tlc_process (shard " << shard.index << ") failed: " << err << std::endl;
+            }
+        }
+    }
+}
+#endif
+
+void TrdpEngine::prefaultBuffers() {
+    std::size_t touched = 0;
+    std::map<std::uint16_t, std::size_t> txPerPort;
+    for (auto &[comId, endpoint] : *endpointTable) {
+        (void)comId;
+        endpoint.runtime->updateBuffer([&touched](std::uint8_t *data, std::size_t size) {
+            prefaultPages(data, size);
+            touched += size;
+        });
+        if (endpoint.def->direction == Direction::Tx) {
+            ++txPerPort[resolvePortForEndpoint(*endpoint.def)];
+        }
+    }
+    if (nativeTransport) {
+        std::size_t slots = 0;
+        for (const auto &[port, count] : txPerPort) {
+            (void)port;
+            slots = std::max(slots, count);
+        }
+        // One more slot per socket for MD replies and confirms.
+        touched += nativeTransport->prefault(slots + 1U);
+    }
+#ifdef TRDP_STACK_PRESENT
+    touched += heapStorage.size();
+#endif
+    RealtimeCheck check;
+    check.setting = primary ? "prefault" : workspace + " prefault";
+    check.requested = "TX/RX buffers, send queues, TRDP heap, thread stacks";
+    check.applied = true;
+    check.detail = std::to_string(endpointTable->size()) + " telegram buffers, " + std::to_string(touched / 1024U) +
+                   " KiB touched";
+    RealtimeReport::instance().record(check);
+}
+
+void TrdpEngine::applyRealtime(const std::string &thread, const ThreadRealtime &settings, bool prefault) const {
+    for (const auto &check : applyThreadRealtime(primary ? thread : workspace + " " + thread, settings)) {
+        RealtimeReport::instance().record(check);
+    }
+    if (prefault) {
+        prefaultStack(kPrefaultStackBytes);
+    }
 }
 
 void TrdpEngine::buildEndpoints() {
-    endpoints.clear();
+    auto table = std::make_shared<EndpointTable>();
 
-    for (const auto &telegram : TelegramRegistry::instance().listTelegrams()) {
-        auto runtime = TelegramRegistry::instance().getOrCreateRuntime(telegram.comId);
+    const auto contents = registry.snapshot();
+    for (const auto &[comId, definition] : contents->telegrams) {
+        auto runtime = registry.getOrCreateRuntime(comId);
         if (!runtime) {
-            std::cerr << "[TRDP] Failed to allocate runtime for ComId " << telegram.comId << std::endl;
+            std::cerr << "[TRDP] Failed to allocate runtime for ComId " << comId << std::endl;
             continue;
         }
-        EndpointHandle handle{.def = telegram, .runtime = runtime, .cycle = telegram.cycle};
+        // Endpoints hold a mutex and are built in place.
+        bindEndpoint(table->handles[comId], definition, std::move(runtime));
+    }
+    finishEndpointTable(*table);
+    std::atomic_store(&endpointTable, std::move(table));
+}
 
-        if (telegram.type == TelegramType::MD) {
+void TrdpEngine::bindEndpoint(EndpointHandle &handle, const std::shared_ptr<const TelegramDef> &definition,
+                              std::shared_ptr<TelegramRuntime> runtime) {
+    const auto &telegram = *definition;
+    handle.def = definition;
+    handle.generatorConfig = telegram.generators;
+    handle.sdtConfig = telegram.sdt;
+    handle.replierConfig = telegram.replier;
+    handle.runtime = runtime;
+    handle.cycle = telegram.cycle;
+    std::string checksumError;
+    auto checksums = resolveChecksums(runtime->dataset(), checksumError);
+    if (!checksumError.empty()) {
+        std::cerr << "[TRDP] ComId " << telegram.comId << ": " << checksumError << std::endl;
+    }
+    if (!checksums.empty()) {
+        handle.checksums = std::make_shared<ChecksumState>();
+        handle.checksums->fields = std::move(checksums);
+    }
+    if (telegram.type == TelegramType::PD && telegram.sdt.enabled) {
+        std::string sdtError;
+        handle.sdt = SdtChannel::compile(telegram.sdt, runtime->dataset().computeSize(), telegram.cycle, sdtError);
+        if (!handle.sdt) {
+            std::cerr << "[TRDP] SDT disabled for ComId " << telegram.comId << ": " << sdtError << std::endl;
+        }
+    }
+
+    if (telegram.type == TelegramType::MD) {
+        // Without the stack the native transport (or stub) serves every port opened at initialisation.
+        handle.mdHandleReady = mdSessionInitialised;
+#ifdef TRDP_STACK_PRESENT
+        if (stackAvailable) {
             handle.mdSessionHandle = mdSessionForPort(resolvePortForEndpoint(telegram));
-            const bool hasRequestedPort = mdAppSessions.find(resolvePortForEndpoint(telegram)) != mdAppSessions.end();
-            const std::uint16_t boundPort = hasRequestedPort ? resolvePortForEndpoint(telegram)
-                                                             : (mdAppSessions.empty() ? 0U : mdAppSessions.begin()->first);
+            const bool hasRequestedPort =
+                mdAppSessions.find(resolvePortForEndpoint(telegram)) != mdAppSessions.end();
+            const std::uint16_t boundPort = hasRequestedPort
+                                                ? resolvePortForEndpoint(telegram)
+                                                : (mdAppSessions.empty() ? 0U : mdAppSessions.begin()->first);
             handle.mdHandleReady = mdSessionInitialised && handle.mdSessionHandle != nullptr;
-#ifdef TRDP_STACK_PRESENT
             std::cout << "[TRDP] MD endpoint selection for ComId " << telegram.comId << " requestedPort="
-                      << resolvePortForEndpoint(telegram) << " boundPort=" << boundPort << " flags=0x" << std::hex
-                      << telegram.trdpFlags << std::dec << " qos=" << static_cast<unsigned>(telegram.qos)
-                      << std::endl;
+                      << resolvePortForEndpoint(telegram) << " boundPort=" << boundPort << " flags=0x"
+                      << std::hex << telegram.trdpFlags << std::dec
+                      << " qos=" << static_cast<unsigned>(telegram.qos) << std::endl;
             if (boundPort != resolvePortForEndpoint(telegram)) {
                 std::cerr << "[TRDP] MD session port mismatch for ComId " << telegram.comId << " (requested "
-                          << resolvePortForEndpoint(telegram) << ", bound " << boundPort
-                          << ")" << std::endl;
-            }
-            if (handle.mdHandleReady && stackAvailable) {
-                TRDP_URI_USER_T emptyUri{};
-                const auto trdpSrcIp = toTrdpIp(telegram.srcIp);
-                const auto trdpDestIp = toTrdpIp(telegram.destIp);
-                TRDP_ERR_T mdErr =
-                    tlm_addListener(handle.mdSessionHandle, &handle.mdListenerHandle, this, mdReceiveCallback, TRUE,
-                                    telegram.comId, etbTopoCounter, opTrainTopoCounter, trdpSrcIp, trdpSrcIp,
-                                    trdpDestIp, 0U, emptyUri, emptyUri);
-                handle.mdHandleReady = (mdErr == TRDP_NO_ERR);
-                if (mdErr != TRDP_NO_ERR) {
-                    std::cerr << "[TRDP] tlm_addListener failed for ComId " << telegram.comId << ": " << mdErr
-                              << std::endl;
-                }
+                          << resolvePortForEndpoint(telegram) << ", bound " << boundPort << ")" << std::endl;
             }
+        }
+        if (handle.mdHandleReady && stackAvailable) {
+            TRDP_URI_USER_T emptyUri{};
+            const auto trdpSrcIp = toTrdpIp(telegram.srcIp);
+            const auto trdpDestIp = toTrdpIp(telegram.destIp);
+            TRDP_ERR_T mdErr =
+                tlm_addListener(handle.mdSessionHandle, &handle.mdListenerHandle, this, mdReceiveCallback, TRUE,
+                                telegram.comId, etbTopoCounter, opTrainTopoCounter, trdpSrcIp, trdpSrcIp,
+                                trdpDestIp, 0U, emptyUri, emptyUri);
+            handle.mdHandleReady = (mdErr == TRDP_NO_ERR);
+            if (mdErr != TRDP_NO_ERR) {
+                std::cerr << "[TRDP] tlm_addListener failed for ComId " << telegram.comId << ": " << mdErr
+                          << std::endl;
+            }
+        }
 #endif
-            if (handle.mdHandleReady) {
-                std::cout << "[TRDP] Binding MD endpoint for ComId " << telegram.comId << std::endl;
-            } else if (!mdSessionInitialised) {
-                std::cerr << "[TRDP] MD session not initialised; unable to bind ComId " << telegram.comId
+        if (telegram.replier.enabled) {
+            std::string replierError;
+            handle.replier = compileMdReplier(telegram, telegram.replier, replierError);
+            if (!handle.replier) {
+                std::cerr << "[TRDP] MD replier disabled for ComId " << telegram.comId << ": " << replierError
                           << std::endl;
-            } else {
-                std::cerr << "[TRDP] Failed to bind MD endpoint for ComId " << telegram.comId
-                          << "; see previous errors" << std::endl;
             }
+        }
+        if (handle.mdHandleReady) {
+            std::cout << "[TRDP] Binding MD endpoint for ComId " << telegram.comId << std::endl;
+        } else if (!mdSessionInitialised) {
+            std::cerr << "[TRDP] MD session not initialised; unable to bind ComId " << telegram.comId
+                      << std::endl;
         } else {
+            std::cerr << "[TRDP] Failed to bind MD endpoint for ComId " << telegram.comId
+                      << "; see previous errors" << std::endl;
+        }
+    } else {
+        handle.pdHandleReady = pdSessionInitialised;
+        if (nativeTransport && telegram.direction == Direction::Tx && telegram.destIp == 0U) {
+            std::cerr << "[TRDP] ComId " << telegram.comId
+                      << " has no destination IP; the native transport cannot publish it" << std::endl;
+            handle.pdHandleReady = false;
+        }
+#ifdef TRDP_STACK_PRESENT
+        if (stackAvailable) {
             const auto requestedPort = resolvePortForEndpoint(telegram);
             const bool hasRequestedPort = pdSessions.find(requestedPort) != pdSessions.end();
-            const std::uint16_t boundPort = hasRequestedPort ? requestedPort
-                                                             : (pdSessions.empty() ? 0U : pdSessions.begin()->first);
+            const std::uint16_t boundPort =
+                hasRequestedPort ? requestedPort : (pdSessions.empty() ? 0U : pdSessions.begin()->first);
             handle.pdSessionHandle = pdSessionForPort(requestedPort);
             handle.pdHandleReady = pdSessionInitialised && handle.pdSessionHandle != nullptr;
-#ifdef TRDP_STACK_PRESENT
             std::cout << "[TRDP] PD endpoint selection for ComId " << telegram.comId << " requestedPort="
-                      << requestedPort << " boundPort=" << boundPort << " flags=0x" << std::hex << telegram.trdpFlags
-                      << std::dec << " qos=" << static_cast<unsigned>(telegram.qos) << std::endl;
+                      << requestedPort << " boundPort=" << boundPort << " flags=0x" << std::hex
+                      << telegram.trdpFlags << std::dec << " qos=" << static_cast<unsigned>(telegram.qos)
+                      << std::endl;
             if (boundPort != requestedPort) {
                 std::cerr << "[TRDP] PD session port mismatch for ComId " << telegram.comId << " (requested "
                           << requestedPort << ", bound " << boundPort << ")" << std::endl;
             }
-            if (handle.pdHandleReady && stackAvailable) {
-                auto effectiveSrcIp = telegram.srcIp;
-                if (telegram.direction == Direction::Tx && (effectiveSrcIp & 0xFF000000U) == 0x7F000000U && resolvedSessionIp != 0U) {
-                    std::cerr << "[TRDP] Source IP " << formatIp(effectiveSrcIp) << " for ComId " << telegram.comId
-                              << " is loopback; using session interface IP " << formatIp(resolvedSessionIp)
-                              << " for publishes" << std::endl;
-                    effectiveSrcIp = resolvedSessionIp;
-                }
-                if (telegram.direction == Direction::Tx && effectiveSrcIp != 0U && !ipAssignedToLocalInterface(effectiveSrcIp)) {
-                    std::cerr << "[TRDP] Source IP " << formatIp(effectiveSrcIp) << " for ComId " << telegram.comId
-                              << " is not configured on this host; TRDP will reject the publish request. "
-                              << "Update the XML or set TRDP_TX_IFACE/TRDP_RX_IFACE to match a local IPv4 address."
-                              << std::endl;
-                    handle.pdHandleReady = false;
-                }
-
-                auto destIp = telegram.destIp;
-                if (telegram.direction == Direction::Tx && (destIp & 0xFF000000U) == 0x7F000000U && resolvedSessionIp != 0U) {
-                    std::cerr << "[TRDP] Destination IP " << formatIp(destIp) << " for ComId " << telegram.comId
-                              << " is loopback; using session interface IP " << formatIp(resolvedSessionIp)
-                              << " for publishes" << std::endl;
-                    destIp = resolvedSessionIp;
-                }
-                if (telegram.direction == Direction::Rx && destIp != 0U && !ipAssignedToLocalInterface(destIp)) {
-                    std::cerr << "[TRDP] Destination IP " << formatIp(destIp) << " for ComId " << telegram.comId
-                              << " is not configured on this host; subscribing with a wildcard address."
-                              << std::endl;
-                    destIp = 0U;
-                }
-                const auto trdpSrcIp = toTrdpIp(effectiveSrcIp);
-                const auto trdpDestIp = toTrdpIp(destIp);
-                TRDP_SEND_PARAM_T sendParam = TRDP_PD_DEFAULT_SEND_PARAM;
-                sendParam.ttl = telegram.ttl;
-                TRDP_COM_PARAM_T recvParams = TRDP_PD_DEFAULT_SEND_PARAM;
-                recvParams.ttl = telegram.ttl;
-                applyTelegramQos(telegram, sendParam);
-                applyTelegramPorts(telegram, sendParam);
-                applyTelegramQos(telegram, recvParams);
-                applyTelegramPorts(telegram, recvParams);
-                  const TRDP_FLAGS_T pdFlags = static_cast<TRDP_FLAGS_T>(telegram.trdpFlags);
-                  const auto buffer = runtime->getBufferCopy();
-                  TRDP_ERR_T pdErr{};
-                  if (telegram.direction == Direction::Tx) {
-                      const auto intervalUs = static_cast<UINT32>(
-                          std::chrono::duration_cast<std::chrono::microseconds>(telegram.cycle).count());
-                      constexpr UINT32 redundancyId = 0U;
-                      pdErr = tlp_publish(handle.pdSessionHandle, &handle.pdPublishHandle, this, nullptr, 0U,
-                                          telegram.comId, etbTopoCounter, opTrainTopoCounter, trdpSrcIp, trdpDestIp,
-                                          intervalUs, redundancyId, pdFlags, &sendParam, buffer.data(),
-                                          static_cast<UINT32>(buffer.size()));
-                  } else {
-                      constexpr UINT32 redundancyId = 0U;
-                      pdErr = tlp_subscribe(handle.pdSessionHandle, &handle.pdSubscribeHandle, this, pdReceiveCallback, 0U,
-                                             telegram.comId, etbTopoCounter, opTrainTopoCounter, trdpSrcIp, trdpSrcIp,
-                                             trdpDestIp, pdFlags, &recvParams, 0U, static_cast<TRDP_TO_BEHAVIOR_T>(0U));
-                  }
-                handle.pdHandleReady = (pdErr == TRDP_NO_ERR);
-                if (pdErr != TRDP_NO_ERR) {
-                    std::cerr << "[TRDP] PD binding failed for ComId " << telegram.comId << ": "
-                              << describeTrdpError(pdErr) << std::endl;
-                }
+        }
+        if (handle.pdHandleReady && stackAvailable) {
+            const auto [effectiveSrcIp, destIp] = pdStackAddresses(telegram);
+            const auto trdpSrcIp = toTrdpIp(effectiveSrcIp);
+            const auto trdpDestIp = toTrdpIp(destIp);
+            TRDP_SEND_PARAM_T sendParam = TRDP_PD_DEFAULT_SEND_PARAM;
+            sendParam.ttl = telegram.ttl;
+            TRDP_COM_PARAM_T recvParams = TRDP_PD_DEFAULT_SEND_PARAM;
+            recvParams.ttl = telegram.ttl;
+            applyTelegramQos(telegram, sendParam);
+            applyTelegramPorts(telegram, sendParam);
+            applyTelegramQos(telegram, recvParams);
+            applyTelegramPorts(telegram, recvParams);
+              const TRDP_FLAGS_T pdFlags = static_cast<TRDP_FLAGS_T>(telegram.trdpFlags);
+              const auto buffer = runtime->getBufferCopy();
+              TRDP_ERR_T pdErr{};
+              if (telegram.direction == Direction::Tx) {
+                  const auto intervalUs = static_cast<UINT32>(
+                      std::chrono::duration_cast<std::chrono::microseconds>(telegram.cycle).count());
+                  constexpr UINT32 redundancyId = 0U;
+                  // The pre-send callback lets a capture record the frames the stack actually sends.
+                  pdErr = tlp_publish(handle.pdSessionHandle, &handle.pdPublishHandle, this, pdSendCallback, 0U,
+                                      telegram.comId, etbTopoCounter, opTrainTopoCounter, trdpSrcIp, trdpDestIp,
+                                      intervalUs, redundancyId,
+                                      static_cast<TRDP_FLAGS_T>(pdFlags | TRDP_FLAGS_CALLBACK), &sendParam,
+                                      buffer.data(),
+                                      static_cast<UINT32>(buffer.size()));
+              } else {
+                  constexpr UINT32 redundancyId = 0U;
+                  pdErr = tlp_subscribe(handle.pdSessionHandle, &handle.pdSubscribeHandle, this, pdReceiveCallback, 0U,
+                                         telegram.comId, etbTopoCounter, opTrainTopoCounter, trdpSrcIp, trdpSrcIp,
+                                         trdpDestIp, pdFlags, &recvParams, 0U, static_cast<TRDP_TO_BEHAVIOR_T>(0U));
+              }
+            handle.pdHandleReady = (pdErr == TRDP_NO_ERR);
+            if (pdErr != TRDP_NO_ERR) {
+                std::cerr << "[TRDP] PD binding failed for ComId " << telegram.comId << ": "
+                          << describeTrdpError(pdErr) << std::endl;
             }
+        }
 #endif
-            if (handle.pdHandleReady) {
-                std::cout << "[TRDP] Binding PD endpoint for ComId " << telegram.comId << std::endl;
-            } else if (!pdSessionInitialised) {
-                std::cerr << "[TRDP] PD session not initialised; unable to bind ComId " << telegram.comId
-                          << std::endl;
-            } else {
-                std::cerr << "[TRDP] Failed to bind PD endpoint for ComId " << telegram.comId
-                          << "; see previous errors" << std::endl;
+        if (handle.pdHandleReady) {
+            std::cout << "[TRDP] Binding PD endpoint for ComId " << telegram.comId << std::endl;
+        } else if (!pdSessionInitialised) {
+            std::cerr << "[TRDP] PD session not initialised; unable to bind ComId " << telegram.comId
+                      << std::endl;
+        } else {
+            std::cerr << "[TRDP] Failed to bind PD endpoint for ComId " << telegram.comId
+                      << "; see previous errors" << std::endl;
+        }
+        if (telegram.direction == Direction::Tx && !telegram.generators.empty()) {
+            std::string generatorError;
+            handle.generators =
+                TxGeneratorSet::compile(telegram.generators, runtime->dataset(), generatorError);
+            if (!handle.generators) {
+                std::cerr << "[TRDP] TX generators disabled for ComId " << telegram.comId << ": "
+                          << generatorError << std::endl;
             }
         }
-        endpoints.emplace(telegram.comId, std::move(handle));
     }
 }
 
+#ifdef TRDP_STACK_PRESENT
+std::pair<std::uint32_t, std::uint32_t> TrdpEngine::pdStackAddresses(const TelegramDef &telegram) const {
+    auto effectiveSrcIp = telegram.srcIp;
+    if (telegram.direction == Direction::Tx && (effectiveSrcIp & 0xFF000000U) == 0x7F000000U && resolvedSessionIp != 0U) {
+        std::cerr << "[TRDP] Source IP " << formatIp(effectiveSrcIp) << " for ComId " << telegram.comId
+                  << " is loopback; using session interface IP " << formatIp(resolvedSessionIp)
+                  << " for publishes" << std::endl;
+        effectiveSrcIp = resolvedSessionIp;
+    }
+    if (telegram.direction == Direction::Tx && effectiveSrcIp != 0U && !ipAssignedToLocalInterface(effectiveSrcIp)) {
+        std::cerr << "[TRDP] Source IP " << formatIp(effectiveSrcIp) << " for ComId " << telegram.comId
+                  << " is not configured on this host; TRDP will reject the publish request. "
+                  << "Update the XML or set TRDP_TX_IFACE/TRDP_RX_IFACE to match a local IPv4 address."
+                  << std::endl;
+    }
+
+    auto destIp = telegram.destIp;
+    if (telegram.direction == Direction::Tx && (destIp & 0xFF000000U) == 0x7F000000U && resolvedSessionIp != 0U) {
+        std::cerr << "[TRDP] Destination IP " << formatIp(destIp) << " for ComId " << telegram.comId
+                  << " is loopback; using session interface IP " << formatIp(resolvedSessionIp)
+                  << " for publishes" << std::endl;
+        destIp = resolvedSessionIp;
+    }
+    if (telegram.direction == Direction::Rx && destIp != 0U && !ipAssignedToLocalInterface(destIp)) {
+        std::cerr << "[TRDP] Destination IP " << formatIp(destIp) << " for ComId " << telegram.comId
+                  << " is not configured on this host; subscribing with a wildcard address."
+                  << std::endl;
+        destIp = 0U;
+    }
+    return {effectiveSrcIp, destIp};
+}
+#endif
+
+void TrdpEngine::finishEndpointTable(EndpointTable &table) const {
+    layoutBuffers(table);
+    std::vector<std::pair<std::uint32_t, EndpointHandle *>> entries;
+    entries.reserve(table.handles.size());
+    for (auto &[comId, handle] : table.handles) {
+        entries.emplace_back(comId, &handle);
+    }
+    table.index.build(entries);
+}
+
+void TrdpEngine::layoutBuffers(EndpointTable &table) const {
+    const auto group = [](const EndpointHandle &handle) {
+        if (handle.def->direction == Direction::Rx) {
+            return 2;
+        }
+        return handle.def->type == TelegramType::PD && handle.cycle.count() > 0 ? 0 : 1;
+    };
+    std::vector<EndpointHandle *> order;
+    order.reserve(table.handles.size());
+    for (auto &[comId, handle] : table.handles) {
+        (void)comId;
+        order.push_back(&handle);
+    }
+    // Stable, so telegrams of one cycle stay in ComId order.
+    std::stable_sort(order.begin(), order.end(), [&group](const EndpointHandle *a, const EndpointHandle *b) {
+        const auto groupA = group(*a);
+        const auto groupB = group(*b);
+        if (groupA != groupB) {
+            return groupA < groupB;
+        }
+        return groupA == 0 && a->cycle < b->cycle;
+    });
+
+    std::vector<BufferArena::Request> requests;
+    requests.reserve(order.size());
+    for (auto *handle : order) {
+        // RX buffers are rewritten on every receipt, stamped TX buffers on every publication.
+        const bool rewritten = handle->def->direction == Direction::Rx || handle->generators || handle->sdt;
+        requests.push_back({std::max(handle->runtime->bufferSize(), handle->runtime->dataset().computeSize()),
+                            rewritten ? BufferArena::kWriterAlignment : BufferArena::kCacheLine});
+        if (handle->def->type == TelegramType::PD && handle->def->direction == Direction::Tx) {
+            table.cyclic.emplace_back(handle->def->comId, handle);
+        }
+    }
+    table.buffers = BufferArena::create(requests);
+    for (std::size_t slot = 0; slot < order.size(); ++slot) {
+        order[slot]->runtime->relocate(table.buffers, slot);
+    }
+    std::cout << "[TRDP] " << order.size() << " telegram buffer(s) laid out in "
+              << (table.buffers->footprint() + 1023U) / 1024U << " KiB" << std::endl;
+}
+
 bool TrdpEngine::start() {
     return start(TrdpConfig{});
 }
 
 bool TrdpEngine::start(const TrdpConfig &cfg) {
+    std::unique_lock lifecycle(lifecycleMtx);
     std::lock_guard lock(stateMtx);
     const bool configChanged = config.rxInterface != cfg.rxInterface || config.txInterface != cfg.txInterface ||
                                config.hostsFile != cfg.hostsFile || config.enableDnr != cfg.enableDnr ||
@@ -1678,11 +2818,48 @@ bool TrdpEngine::start(const TrdpConfig &cfg) {
         return true;
     }
 
+    if (cfg.shards > 1U && cfg.virtualTime) {
+        // Virtual time steps through every deadline from the worker alone; shards would race it.
+        std::cerr << "[TRDP] Sharded processing cannot run on virtual time; use one processing thread" << std::endl;
+        return false;
+    }
     config = cfg;
+#ifdef TRDP_FAKE_STACK
+    constexpr bool kStackFollowsClock = true;
+#else
+    constexpr bool kStackFollowsClock = false;
+#endif
+    if (((config.virtualTime && !kStackFollowsClock) || !primary) && config.transport != Transport::Native) {
+        // The TCNopen stack keeps its own timers and is initialised once per process, so virtual time and
+        // workspace engines run on the native transport. The fake stack's clock can follow ours instead.
+        if (config.transport == Transport::Stack) {
+            std::cerr << "[TRDP] " << (primary ? "Virtual time" : "Workspace " + workspace)
+                      << " needs the native transport; ignoring transport stack" << std::endl;
+        }
+        config.transport = Transport::Native;
+    }
+    clock.setVirtual(config.virtualTime);
+    lastEcspPoll = {};
 #ifdef TRDP_STACK_PRESENT
-    stackAvailable = true;
+    stackAvailable = config.transport != Transport::Native;
 #else
     stackAvailable = false;
+    if (config.transport == Transport::Stack) {
+        std::cerr << "[TRDP] TCNopen stack not present in this build; using the native UDP transport" << std::endl;
+    }
+#endif
+
+#ifdef TRDP_FAKE_STACK
+    if (clock.isVirtual() && stackAvailable) {
+        // The worker moves the fake's clock from now on; its own jumps would run ahead of our deadlines.
+        auto &fake = FakeTrdpStack::instance();
+        auto fakeConfig = fake.config();
+        fakeStackAutoAdvance = fakeConfig.autoAdvance;
+        fakeConfig.autoAdvance = false;
+        fake.setConfig(fakeConfig);
+        fakeStackOrigin = fake.now();
+        fakeClockOrigin = clock.now();
+    }
 #endif
 
     if (config.enableDnr && (!stackAvailable || !kDnrCompiledIn)) {
@@ -1702,11 +2879,23 @@ bool TrdpEngine::start(const TrdpConfig &cfg) {
     }
 
     buildEndpoints();
-    if (endpoints.empty()) {
+    if (endpointTable->empty()) {
         std::cerr << "[TRDP] No telegrams registered; nothing to start" << std::endl;
     }
+    if (config.prefault) {
+        prefaultBuffers();
+    }
+    if (primary) {
+        FieldHistory::instance().rebuild();
+        HistoryStore::instance().rebuild();
+        RuleEngine::instance().rebuild();
+    }
     stopRequested.store(false);
     running.store(true);
+    workerJitter.reset();
+    if (config.shards > 1U) {
+        startShards();
+    }
     worker = std::thread([this]() { processingLoop(); });
     return true;
 }
@@ -1719,10 +2908,18 @@ void TrdpEngine::stop() {
         }
         stopRequested.store(true);
     }
+    {
+        // Parked threads, and a reload waiting for them to park, check stopRequested under parkMtx.
+        std::lock_guard park(parkMtx);
+    }
+    parkCv.notify_all();
     cv.notify_all();
     if (worker.joinable()) {
         worker.join();
     }
+    stopShards();
+    // API calls still sending through the transport finish first; later ones find the empty table.
+    std::unique_lock lifecycle(lifecycleMtx);
     running.store(false);
 #ifdef TRDP_STACK_PRESENT
     {
@@ -1730,57 +2927,353 @@ void TrdpEngine::stop() {
         mdRequestStates.clear();
     }
 #endif
+    {
+        std::lock_guard replierLock(replierMtx);
+        pendingMdReplies.clear();
+    }
+    std::atomic_store(&endpointTable, std::make_shared<EndpointTable>());
     teardownTrdpStack();
-    endpoints.clear();
+#ifdef TRDP_FAKE_STACK
+    if (fakeStackAutoAdvance) {
+        auto fakeConfig = FakeTrdpStack::instance().config();
+        fakeConfig.autoAdvance = *fakeStackAutoAdvance;
+        FakeTrdpStack::instance().setConfig(fakeConfig);
+        fakeStackAutoAdvance.reset();
+    }
+#endif
     std::cout << "[TRDP] Stack stopped" << std::endl;
 }
 
-TrdpEngine::EndpointHandle *TrdpEngine::findEndpoint(std::uint32_t comId) {
-    auto it = endpoints.find(comId);
-    if (it == endpoints.end()) {
-        return nullptr;
+TrdpEngine::ReloadReport TrdpEngine::applyRegistryChanges() {
+    const auto started = std::chrono::steady_clock::now();
+    const auto since = [](std::chrono::steady_clock::time_point from) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - from);
+    };
+    ReloadReport report;
+    std::lock_guard reload(reloadMtx);
+    {
+        std::lock_guard lock(stateMtx);
+        if (!running.load() || stopRequested.load()) {
+            return report;
+        }
+    }
+    // Park before taking lifecycleMtx: a rule firing on a processing thread sends under a shared lifecycle lock, so
+    // waiting for the threads while holding it exclusively would never return.
+    if (!parkProcessingThreads()) {
+        releaseProcessingThreads();
+        return report;
+    }
+    const auto parked = std::chrono::steady_clock::now();
+    std::unique_lock lifecycle(lifecycleMtx);
+    std::unique_lock lock(stateMtx);
+    if (!running.load() || stopRequested.load()) {
+        releaseProcessingThreads();
+        return report;
+    }
+
+    // Plan against the live endpoints. The registry keeps the pointers of definitions that did not change, so an
+    // endpoint whose definition and dataset are the registry's current ones is untouched.
+    enum class Change { Added, Changed, Readdressed, Unchanged };
+    const auto contents = registry.snapshot();
+    auto &current = *endpointTable;
+    std::set<std::uint16_t> openPorts;
+    if (nativeTransport) {
+        const auto ports = nativeTransport->ports();
+        openPorts.insert(ports.begin(), ports.end());
+    }
+    bool portsMissing = false;
+    std::vector<std::pair<std::uint32_t, Change>> plan;
+    plan.reserve(contents->telegrams.size());
+    for (const auto &[comId, definition] : contents->telegrams) {
+        auto change = Change::Added;
+        if (const auto *endpoint = findEndpoint(current, comId)) {
+            if (&endpoint->runtime->dataset() != contents->datasetOf(comId)) {
+                change = Change::Changed;
+            } else if (endpoint->def == definition) {
+                change = Change::Unchanged;
+            } else if (definition->type == TelegramType::PD && differsOnlyInAddresses(*endpoint->def, *definition)) {
+                change = Change::Readdressed;
+            } else {
+                change = Change::Changed;
+            }
+        }
+        if (change != Change::Unchanged && nativeTransport) {
+            for (const auto port : {definition->srcPort, definition->destPort}) {
+                portsMissing = portsMissing || (port != 0U && openPorts.count(port) == 0U);
+            }
+        }
+#ifdef TRDP_STACK_PRESENT
+        if (change != Change::Unchanged && stackAvailable) {
+            // Without a session of its own the telegram would fall back to the default one, and no shard owns the
+            // port; sessions are opened per PD and MD port at start, so a port without one needs a restart too.
+            const auto &sessions = definition->type == TelegramType::PD ? pdSessions : mdAppSessions;
+            portsMissing = portsMissing || sessions.empty();
+            for (const auto port : {definition->srcPort, definition->destPort}) {
+                portsMissing = portsMissing || (port != 0U && sessions.count(port) == 0U);
+            }
+        }
+#endif
+        plan.emplace_back(comId, change);
+    }
+    for (const auto &[comId, change] : plan) {
+        (void)comId;
+        ++(change == Change::Added         ? report.added
+           : change == Change::Changed     ? report.changed
+           : change == Change::Readdressed ? report.readdressed
+                                           : report.unchanged);
+    }
+    for (const auto &[comId, endpoint] : current) {
+        (void)endpoint;
+        if (contents->telegrams.count(comId) == 0U) {
+            ++report.removed;
+        }
+    }
+
+    if (portsMissing) {
+        // Sockets and stack sessions are opened once, before the processing threads start polling them.
+        const auto restartConfig = config;
+        lock.unlock();
+        lifecycle.unlock();
+        releaseProcessingThreads();
+        std::cout << "[TRDP] Reload needs UDP ports the transport has not opened; restarting the engine" << std::endl;
+        stop();
+        report.restarted = true;
+        report.applied = start(restartConfig);
+        report.apply = since(started);
+        return report;
+    }
+
+    for (auto &[comId, endpoint] : current) {
+        if (contents->telegrams.count(comId) == 0U) {
+            unbindEndpoint(endpoint);
+        }
+    }
+    auto table = std::make_shared<EndpointTable>();
+    for (const auto &[comId, change] : plan) {
+        const auto &definition = contents->telegrams.find(comId)->second;
+        auto *previous = findEndpoint(current, comId);
+        if (nativeTransport && change != Change::Unchanged && definition->direction == Direction::Rx &&
+            isMulticast(definition->destIp)) {
+            nativeTransport->joinMulticast(definition->destIp);
+        }
+        if (change == Change::Unchanged || change == Change::Readdressed) {
+            auto &handle = table->handles[comId];
+            adoptEndpoint(handle, *previous);
+            if (change == Change::Unchanged || readdressEndpoint(handle, *definition)) {
+                handle.def = definition;
+                continue;
+            }
+            table->handles.erase(comId);
+        }
+        // A TX telegram that was publishing keeps publishing once bound again.
+        const bool wasActive = previous != nullptr && previous->txCyclicActive.load();
+        if (previous != nullptr) {
+            unbindEndpoint(*previous);
+        }
+        auto runtime = registry.getOrCreateRuntime(comId);
+        if (!runtime) {
+            std::cerr << "[TRDP] Failed to allocate runtime for ComId " << comId << std::endl;
+            continue;
+        }
+        auto &handle = table->handles[comId];
+        bindEndpoint(handle, definition, std::move(runtime));
+        if (wasActive && handle.pdHandleReady) {
+            handle.txCyclicActive.store(true);
+        }
+    }
+    finishEndpointTable(*table);
+    std::atomic_store(&endpointTable, std::move(table));
+    assignShardEndpoints();
+    releaseProcessingThreads();
+    report.paused = since(parked);
+
+    if (primary) {
+        FieldHistory::instance().rebuild();
+        HistoryStore::instance().rebuild();
+        RuleEngine::instance().rebuild();
+    }
+    report.applied = true;
+    report.apply = since(started);
+    std::cout << "[TRDP] Reload applied: " << report.added << " added, " << report.removed << " removed, "
+              << report.changed << " changed, " << report.readdressed << " readdressed, " << report.unchanged
+              << " unchanged; processing paused " << report.paused.count() << " us, applied in "
+              << report.apply.count() << " us" << std::endl;
+    return report;
+}
+
+void TrdpEngine::unbindEndpoint(EndpointHandle &handle) {
+    handle.txCyclicActive.store(false);
+#ifdef TRDP_STACK_PRESENT
+    if (stackAvailable) {
+        const auto comId = handle.def->comId;
+        const auto report = [comId](const char *call, TRDP_ERR_T err) {
+            if (err != TRDP_NO_ERR) {
+                std::cerr << "[TRDP] " << call << " failed for ComId " << comId << ": " << describeTrdpError(err)
+                          << std::endl;
+            }
+        };
+        if (handle.pdPublishHandle != nullptr) {
+            report("tlp_unpublish", tlp_unpublish(handle.pdSessionHandle, handle.pdPublishHandle));
+            handle.pdPublishHandle = nullptr;
+        }
+        if (handle.pdSubscribeHandle != nullptr) {
+            report("tlp_unsubscribe", tlp_unsubscribe(handle.pdSessionHandle, handle.pdSubscribeHandle));
+            handle.pdSubscribeHandle = nullptr;
+        }
+        if (handle.mdListenerHandle != nullptr) {
+            report("tlm_delListener", tlm_delListener(handle.mdSessionHandle, handle.mdListenerHandle));
+            handle.mdListenerHandle = nullptr;
+        }
+    }
+#endif
+    handle.pdHandleReady = false;
+    handle.mdHandleReady = false;
+}
+
+bool TrdpEngine::readdressEndpoint(EndpointHandle &handle, const TelegramDef &telegram) {
+    if (!stackAvailable) {
+        // The native transport addresses every frame from the definition; only its destination check is redone.
+        if (nativeTransport && telegram.direction == Direction::Tx && telegram.destIp == 0U) {
+            return false;
+        }
+        handle.pdHandleReady = pdSessionInitialised;
+        return true;
+    }
+#ifdef TRDP_STACK_PRESENT
+    if (!handle.pdHandleReady) {
+        return false;
+    }
+    const auto [srcIp, destIp] = pdStackAddresses(telegram);
+    const auto err = telegram.direction == Direction::Tx
+                         ? tlp_republish(handle.pdSessionHandle, handle.pdPublishHandle, etbTopoCounter,
+                                         opTrainTopoCounter, toTrdpIp(srcIp), toTrdpIp(destIp))
+                         : tlp_resubscribe(handle.pdSessionHandle, handle.pdSubscribeHandle, etbTopoCounter,
+                                           opTrainTopoCounter, toTrdpIp(srcIp), toTrdpIp(srcIp), toTrdpIp(destIp));
+    if (err != TRDP_NO_ERR) {
+        std::cerr << "[TRDP] Moving ComId " << telegram.comId << " to its new addresses failed: "
+                  << describeTrdpError(err) << "; binding it again" << std::endl;
+        return false;
     }
-    return &it->second;
+    std::cout << "[TRDP] Readdressed PD endpoint for ComId " << telegram.comId << std::endl;
+#endif
+    return true;
+}
+
+void TrdpEngine::adoptEndpoint(EndpointHandle &to, EndpointHandle &from) {
+    to.def = from.def;
+    to.runtime = from.runtime;
+    to.pdHandleReady = from.pdHandleReady;
+    to.mdHandleReady = from.mdHandleReady;
+    to.cycle = from.cycle;
+    to.checksums = from.checksums;
+#ifdef TRDP_STACK_PRESENT
+    to.pdPublishHandle = from.pdPublishHandle;
+    to.pdSubscribeHandle = from.pdSubscribeHandle;
+    to.mdListenerHandle = from.mdListenerHandle;
+    std::copy(std::begin(from.mdSessionId), std::end(from.mdSessionId), std::begin(to.mdSessionId));
+    to.pdSessionHandle = from.pdSessionHandle;
+    to.mdSessionHandle = from.mdSessionHandle;
+#endif
+    {
+        // API calls working on an earlier snapshot may still hold the old endpoint.
+        std::lock_guard endpointLock(from.mtx);
+        to.txCyclicActive.store(from.txCyclicActive.load());
+        to.nextSend = from.nextSend;
+        to.generators = from.generators;
+        to.generatorConfig = from.generatorConfig;
+        to.sdt = from.sdt;
+        to.sdtConfig = from.sdtConfig;
+    }
+    std::lock_guard replierLock(replierMtx);
+    to.replier = from.replier;
+    to.replierConfig = from.replierConfig;
+}
+
+void TrdpEngine::parkIfRequested() {
+    std::unique_lock lock(parkMtx);
+    ++parkedThreads;
+    parkCv.notify_all();
+    parkCv.wait(lock, [this]() { return !parkRequested.load() || stopRequested.load(); });
+    --parkedThreads;
+}
+
+bool TrdpEngine::parkProcessingThreads() {
+    std::size_t threads = 0;
+    {
+        // Under stateMtx, so the worker's wait for delayed MD replies cannot miss the request.
+        std::lock_guard lock(stateMtx);
+        threads = 1U + shards.size();
+        std::lock_guard park(parkMtx);
+        parkRequested.store(true);
+    }
+    cv.notify_all();
+    std::unique_lock park(parkMtx);
+    parkCv.wait(park, [&]() { return parkedThreads == threads || stopRequested.load(); });
+    return !stopRequested.load();
+}
+
+void TrdpEngine::releaseProcessingThreads() {
+    {
+        std::lock_guard park(parkMtx);
+        parkRequested.store(false);
+    }
+    parkCv.notify_all();
+}
+
+std::shared_ptr<TrdpEngine::EndpointTable> TrdpEngine::endpointSnapshot() const {
+    return std::atomic_load(&endpointTable);
+}
+
+TrdpEngine::EndpointHandle *TrdpEngine::findEndpoint(std::uint32_t comId) {
+    return findEndpoint(*endpointTable, comId);
+}
+
+TrdpEngine::EndpointHandle *TrdpEngine::findEndpoint(EndpointTable &table, std::uint32_t comId) {
+    auto *const *endpoint = table.index.find(comId);
+    return endpoint != nullptr ? *endpoint : nullptr;
 }
 
 bool TrdpEngine::sendTxTelegram(std::uint32_t comId, const std::map<std::string, FieldValue> &txFields,
                                 const std::optional<MdSendOptions> &mdOptions) {
-    std::unique_lock lock(stateMtx);
+    // Neither stateMtx nor the processing threads are waited for: the transport stays up while lifecycle is held,
+    // and the endpoint's own lock orders this send against its cyclic publications.
+    std::shared_lock lifecycle(lifecycleMtx);
+    const auto table = endpointSnapshot();
     std::optional<bool> txActive;
     std::map<std::string, FieldValue> confirmationFields;
     try {
-        auto *endpoint = findEndpoint(comId);
+        auto *endpoint = findEndpoint(*table, comId);
         if (endpoint == nullptr) {
             std::cerr << "[TRDP] Unknown TX ComId " << comId << std::endl;
             return false;
         }
-        if (endpoint->def.direction != Direction::Tx) {
+        if (endpoint->def->direction != Direction::Tx) {
             std::cerr << "[TRDP] ComId " << comId << " is not marked as TX" << std::endl;
             return false;
         }
 
         MdSendOptions mdConfig{};
-        if (endpoint->def.type == TelegramType::MD) {
+        if (endpoint->def->type == TelegramType::MD) {
             mdConfig = mdOptions.value_or(MdSendOptions{});
             if (!mdOptions.has_value()) {
-                mdConfig.mode = endpoint->def.confirmTimeout.count() > 0 || endpoint->def.expectedReplies > 0
+                mdConfig.mode = endpoint->def->confirmTimeout.count() > 0 || endpoint->def->expectedReplies > 0
                                     ? MdMode::Request
                                     : MdMode::Notify;
             }
             if (!mdConfig.destIp.has_value()) {
-                mdConfig.destIp = endpoint->def.destIp;
+                mdConfig.destIp = endpoint->def->destIp;
             }
             if (!mdConfig.destPort.has_value()) {
-                mdConfig.destPort = endpoint->def.destPort;
+                mdConfig.destPort = endpoint->def->destPort;
             }
             if (mdConfig.expectedReplies == 0) {
-                mdConfig.expectedReplies = endpoint->def.expectedReplies;
+                mdConfig.expectedReplies = endpoint->def->expectedReplies;
             }
             if (mdConfig.replyTimeout.count() == 0) {
-                mdConfig.replyTimeout = endpoint->def.replyTimeout;
+                mdConfig.replyTimeout = endpoint->def->replyTimeout;
             }
             if (mdConfig.confirmTimeout.count() == 0) {
-                mdConfig.confirmTimeout = endpoint->def.confirmTimeout;
+                mdConfig.confirmTimeout = endpoint->def->confirmTimeout;
             }
         }
 
@@ -1789,19 +3282,36 @@ bool TrdpEngine::sendTxTelegram(std::uint32_t comId, const std::map<std::string,
         }
 
         const auto mergedFields = mergeRuntimeFields(*endpoint->runtime, txFields);
-        const auto buffer = encodeFieldsToBuffer(*endpoint->runtime, mergedFields);
+        auto buffer = encodeFieldsToBuffer(*endpoint->runtime, mergedFields,
+                                           endpoint->checksums ? endpoint->checksums->fields : kNoChecksums);
+        std::unique_lock endpointLock(endpoint->mtx);
+        if (endpoint->generators) {
+            // An explicit send is a publication too: generated fields step and own their bytes.
+            endpoint->generators->advance(buffer.data(), buffer.size(), clock.now());
+            if (endpoint->checksums) {
+                writeChecksums(endpoint->checksums->fields, buffer.data(), buffer.size());
+            }
+        }
+        if (endpoint->sdt) {
+            endpoint->sdt->seal(buffer.data(), buffer.size());
+        }
         endpoint->runtime->overwriteBuffer(buffer);
+        if (primary) {
+            const auto stampNs = clock.wallNowNs();
+            FieldHistory::instance().record(comId, buffer.data(), buffer.size(), stampNs);
+            HistoryStore::instance().record(comId, buffer.data(), buffer.size(), stampNs);
+        }
         confirmationFields = mergedFields;
 
         std::string mdSessionId;
-        MdTimelineState *mdState = nullptr;
+        std::optional<MdTimelineState> mdState;
         bool sent = false;
-        if (endpoint->def.type == TelegramType::MD) {
+        if (endpoint->def->type == TelegramType::MD) {
             if (!endpoint->mdHandleReady) {
                 std::cerr << "[TRDP] MD session not available; drop TX ComId " << comId << std::endl;
                 return false;
             }
-            const auto destIp = mdConfig.destIp.value_or(endpoint->def.destIp);
+            const auto destIp = mdConfig.destIp.value_or(endpoint->def->destIp);
             if (mdConfig.protocol.empty()) {
                 const bool multicast = (destIp & 0xf0000000U) == 0xe0000000U;
                 mdConfig.protocol = multicast ? "udp-multicast" : "udp-unicast";
@@ -1810,50 +3320,84 @@ bool TrdpEngine::sendTxTelegram(std::uint32_t comId, const std::map<std::string,
                 mdConfig.payloadBytes = buffer.size();
             }
             mdConfig.multicastReplies = mdConfig.multicastReplies || mdConfig.expectedReplies > 1;
+            auto wireSessionId = NativeTransport::newSessionId();
+            const auto replyTimeoutUs = static_cast<std::uint32_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(mdConfig.replyTimeout).count());
 #ifdef TRDP_STACK_PRESENT
             if (stackAvailable) {
                 TRDP_SEND_PARAM_T sendParam = TRDP_MD_DEFAULT_SEND_PARAM;
-                sendParam.ttl = endpoint->def.ttl;
-                applyTelegramQos(endpoint->def, sendParam);
-                applyTelegramPorts(endpoint->def, sendParam);
+                sendParam.ttl = endpoint->def->ttl;
+                applyTelegramQos(*endpoint->def, sendParam);
+                applyTelegramPorts(*endpoint->def, sendParam);
                 const auto numReplies = static_cast<UINT32>(mdConfig.expectedReplies);
-                const auto replyTimeout = static_cast<UINT32>(mdConfig.replyTimeout.count());
-                const auto confirmTimeout = static_cast<UINT32>(mdConfig.confirmTimeout.count());
+                // The reply timeout is in microseconds; zero keeps the session default.
                 TRDP_ERR_T err = tlm_request(endpoint->mdSessionHandle, this, mdReceiveCallback, &endpoint->mdSessionId,
-                                             comId, etbTopoCounter, opTrainTopoCounter, endpoint->def.srcIp, destIp,
-                                             numReplies, replyTimeout, confirmTimeout, &sendParam, buffer.data(),
+                                             comId, etbTopoCounter, opTrainTopoCounter, endpoint->def->srcIp, destIp,
+                                             TRDP_FLAGS_DEFAULT, numReplies, replyTimeoutUs, &sendParam, buffer.data(),
                                              static_cast<UINT32>(buffer.size()), nullptr, nullptr);
                 if (err != TRDP_NO_ERR) {
                     std::cerr << "[TRDP] tlm_request failed for ComId " << comId << ": " << err << std::endl;
                     return false;
                 }
                 trackMdRequest(mdSessionKeyFromId(endpoint->mdSessionId), *endpoint);
+                std::memcpy(wireSessionId.data(), &endpoint->mdSessionId, wireSessionId.size());
             }
 #endif
+            const auto mdDestPort = mdConfig.destPort.value_or(0U) != 0U ? *mdConfig.destPort : kDefaultTrdpPort;
+            const bool capturing = CaptureRecorder::instance().active();
+            QueuedFrame queued;
+            if (nativeTransport) {
+                if (!nativeTransport->queueMd(nativeMsgType(mdConfig.mode), comId, resolvePortForEndpoint(*endpoint->def),
+                                              destIp, mdDestPort, wireSessionId, 0, replyTimeoutUs, buffer.data(),
+                                              buffer.size(), capturing ? &queued : nullptr)) {
+                    std::cerr << "[TRDP] Native MD send failed for ComId " << comId << std::endl;
+                    return false;
+                }
+                nativeTransport->flush();
+            } else if (capturing) {
+                // The stack keeps its MD sequence counters private; everything else is what tlm_* was given.
+                queued.header.msgType = nativeMsgType(mdConfig.mode);
+                queued.header.comId = comId;
+                queued.header.etbTopoCounter = etbTopoCounter;
+                queued.header.opTrainTopoCounter = opTrainTopoCounter;
+                queued.header.sessionId = wireSessionId;
+                queued.header.replyTimeoutUs = replyTimeoutUs;
+                queued.destIp = destIp;
+#ifdef TRDP_STACK_PRESENT
+                queued.srcPort = stackSessionPort(endpoint->mdSessionHandle);
+#endif
+                queued.destPort = mdDestPort;
+            }
+            if (capturing) {
+                captureTx(*endpoint, queued, buffer.data(), buffer.size());
+            }
             std::cout << "[TRDP] MD send ComId=" << comId << " bytes=" << buffer.size() << std::endl;
             mdSessionId = allocateMdSessionId(mdConfig);
-            mdState = &recordMdTimeline(mdSessionId, comId, mdConfig);
-            mdState->lastEvent = "sent";
+            mdState = recordMdTimeline(mdSessionId, comId, mdConfig, "sent");
             sent = true;
         } else {
             sent = publishPdBuffer(*endpoint, buffer);
+            if (sent && nativeTransport) {
+                nativeTransport->flush();
+            }
         }
 
-        if (sent && endpoint->def.type == TelegramType::PD) {
+        if (sent && endpoint->def->type == TelegramType::PD) {
             if (endpoint->cycle.count() > 0) {
-                endpoint->txCyclicActive = true;
-                endpoint->nextSend = std::chrono::steady_clock::now() + endpoint->cycle;
+                endpoint->txCyclicActive.store(true);
+                endpoint->nextSend = clock.now() + endpoint->cycle;
             }
-            txActive = endpoint->txCyclicActive;
+            txActive = endpoint->txCyclicActive.load();
         }
 
-        lock.unlock();
+        endpointLock.unlock();
+        lifecycle.unlock();
 
         if (sent) {
-            if (mdState != nullptr) {
+            if (mdState) {
                 notifyMdStatus(*mdState, "sent", &confirmationFields);
             }
-            if (auto *hub = TelegramHub::instance()) {
+            if (auto *hub = eventHub.load()) {
                 hub->publishTxConfirmation(comId, confirmationFields, txActive);
             }
         }
@@ -1868,58 +3412,156 @@ bool TrdpEngine::sendTxTelegram(std::uint32_t comId, const std::map<std::string,
     return false;
 }
 
+std::size_t TrdpEngine::sendReplayTelegrams(const std::vector<ReplayTelegram> &telegrams) {
+    std::shared_lock lifecycle(lifecycleMtx);
+    if (!running.load()) {
+        return 0;
+    }
+    const auto table = endpointSnapshot();
+    // Copy of a replayed PD payload handed to publishPdBuffer, reused across the batch.
+    std::vector<std::uint8_t> scratch;
+    std::size_t sent = 0;
+    for (const auto &telegram : telegrams) {
+        auto *endpoint = findEndpoint(*table, telegram.comId);
+        const bool txEndpoint = endpoint != nullptr && endpoint->def->direction == Direction::Tx;
+        if (trdpHeaderSize(telegram.msgType) == kTrdpPdHeaderSize) {
+            if (txEndpoint && endpoint->def->type == TelegramType::PD) {
+                scratch.assign(telegram.data, telegram.data + telegram.size);
+                std::lock_guard endpointLock(endpoint->mtx);
+                sent += publishPdBuffer(*endpoint, scratch) ? 1U : 0U;
+            } else if (nativeTransport) {
+                sent += nativeTransport->queuePd(telegram.comId, resolveDefaultPort(registry, TelegramType::PD), telegram.destIp,
+                                                 telegram.destPort, telegram.data, telegram.size)
+                            ? 1U
+                            : 0U;
+            }
+            continue;
+        }
+
+        if (nativeTransport) {
+            const auto srcPort =
+                txEndpoint ? resolvePortForEndpoint(*endpoint->def) : resolveDefaultPort(registry, TelegramType::MD);
+            sent += nativeTransport->queueMd(TrdpMsgType::Mn, telegram.comId, srcPort, telegram.destIp,
+                                             telegram.destPort, NativeTransport::newSessionId(), 0, 0U,
+                                             telegram.data, telegram.size)
+                        ? 1U
+                        : 0U;
+            continue;
+        }
+#ifdef TRDP_STACK_PRESENT
+        // tlm_notify needs a session bound to the ComId's port, which only MD endpoints have.
+        if (stackAvailable && endpoint != nullptr && endpoint->mdHandleReady) {
+            TRDP_SEND_PARAM_T sendParam = TRDP_MD_DEFAULT_SEND_PARAM;
+            sendParam.ttl = endpoint->def->ttl;
+            applyTelegramQos(*endpoint->def, sendParam);
+            applyTelegramPorts(*endpoint->def, sendParam);
+            const TRDP_ERR_T err =
+                tlm_notify(endpoint->mdSessionHandle, this, nullptr, telegram.comId, etbTopoCounter,
+                           opTrainTopoCounter, toTrdpIp(endpoint->def->srcIp), toTrdpIp(telegram.destIp),
+                           TRDP_FLAGS_DEFAULT, &sendParam, telegram.data, static_cast<UINT32>(telegram.size), nullptr,
+                           nullptr);
+            sent += err == TRDP_NO_ERR ? 1U : 0U;
+        }
+#endif
+    }
+    if (nativeTransport) {
+        nativeTransport->flush();
+    }
+    return sent;
+}
+
 bool TrdpEngine::stopTxTelegram(std::uint32_t comId) {
-    std::lock_guard lock(stateMtx);
-    auto *endpoint = findEndpoint(comId);
+    const auto table = endpointSnapshot();
+    auto *endpoint = findEndpoint(*table, comId);
     if (endpoint == nullptr) {
         std::cerr << "[TRDP] Unknown TX ComId " << comId << std::endl;
         return false;
     }
-    if (endpoint->def.direction != Direction::Tx || endpoint->def.type != TelegramType::PD) {
+    if (endpoint->def->direction != Direction::Tx || endpoint->def->type != TelegramType::PD) {
         std::cerr << "[TRDP] ComId " << comId << " is not a TX PD telegram" << std::endl;
         return false;
     }
 
-    endpoint->txCyclicActive = false;
-    endpoint->nextSend = std::chrono::steady_clock::time_point{};
+    {
+        std::lock_guard endpointLock(endpoint->mtx);
+        endpoint->txCyclicActive.store(false);
+        endpoint->nextSend = std::chrono::steady_clock::time_point{};
+    }
     std::cout << "[TRDP] Stopped cyclic PD publish for ComId " << comId << std::endl;
     return true;
 }
 
 std::optional<bool> TrdpEngine::txPublishActive(std::uint32_t comId) {
-    std::lock_guard lock(stateMtx);
-    auto *endpoint = findEndpoint(comId);
+    const auto table = endpointSnapshot();
+    auto *endpoint = findEndpoint(*table, comId);
     if (endpoint == nullptr) {
         return std::nullopt;
     }
-    if (endpoint->def.direction != Direction::Tx || endpoint->def.type != TelegramType::PD) {
+    if (endpoint->def->direction != Direction::Tx || endpoint->def->type != TelegramType::PD) {
         return std::nullopt;
     }
-    return endpoint->txCyclicActive;
+    return endpoint->txCyclicActive.load();
 }
 
 void TrdpEngine::handleRxTelegram(std::uint32_t comId, const std::vector<std::uint8_t> &payload) {
-    auto *endpoint = findEndpoint(comId);
+    const auto table = endpointSnapshot();
+    deliverRxTelegram(findEndpoint(*table, comId), comId, payload);
+}
+
+void TrdpEngine::deliverRxTelegram(EndpointHandle *endpoint, std::uint32_t comId,
+                                   const std::vector<std::uint8_t> &payload) {
     if (endpoint == nullptr) {
         std::cerr << "[TRDP] Received unknown ComId " << comId << std::endl;
         return;
     }
-    if (endpoint->def.direction != Direction::Rx) {
+    if (endpoint->def->direction != Direction::Rx) {
         std::cerr << "[TRDP] Received RX telegram for TX ComId " << comId << std::endl;
         return;
     }
 
+    std::shared_ptr<SdtChannel> sdt;
+    {
+        // Only configureSdt changes an RX endpoint's channel, so this lock is uncontended.
+        std::lock_guard endpointLock(endpoint->mtx);
+        sdt = endpoint->sdt;
+    }
+    if (sdt) {
+        sdt->check(payload.data(), payload.size(), clock.now());
+    }
+    if (const auto &checksums = endpoint->checksums) {
+        checksums->checked.fetch_add(1, std::memory_order_relaxed);
+        if (checksumMismatches(checksums->fields, payload.data(), payload.size()) != 0U) {
+            // Still decoded so the bad values can be inspected; logged on the first and every 1000th mismatch.
+            const auto count = checksums->mismatches.fetch_add(1, std::memory_order_relaxed) + 1U;
+            if (count == 1U || count % 1000U == 0U) {
+                std::cerr << "[TRDP] Checksum mismatch on ComId " << comId << " (" << count << " so far)"
+                          << std::endl;
+            }
+        }
+    }
     decodeFieldsIntoRuntime(endpoint->runtime->dataset(), *endpoint->runtime, payload);
+    if (primary) {
+        const auto stampNs = clock.wallNowNs();
+        FieldHistory::instance().record(comId, payload.data(), payload.size(), stampNs);
+        HistoryStore::instance().record(comId, payload.data(), payload.size(), stampNs);
+        RuleEngine::instance().onRx(comId, payload.data(), payload.size());
+    }
 
-    if (auto *hub = TelegramHub::instance()) {
+    if (auto *hub = eventHub.load()) {
         hub->publishRxUpdate(comId, endpoint->runtime->snapshotFields());
     }
 }
 
 void TrdpEngine::handleRxMdTelegram(std::uint32_t comId, const std::vector<std::uint8_t> &payload) {
+    const auto table = endpointSnapshot();
+    deliverRxMdTelegram(findEndpoint(*table, comId), comId, payload);
+}
+
+void TrdpEngine::deliverRxMdTelegram(EndpointHandle *endpoint, std::uint32_t comId,
+                                     const std::vector<std::uint8_t> &payload) {
     std::cout << "[TRDP] MD telegram callback ComId=" << comId << " bytes=" << payload.size() << std::endl;
-    handleRxTelegram(comId, payload);
-    if (auto *endpoint = findEndpoint(comId)) {
+    deliverRxTelegram(endpoint, comId, payload);
+    if (endpoint != nullptr) {
         const auto fields = endpoint->runtime->snapshotFields();
         noteMdReply("", comId, &fields);
     }
@@ -1927,6 +3569,8 @@ void TrdpEngine::handleRxMdTelegram(std::uint32_t comId, const std::vector<std::
 
 void TrdpEngine::simulateMdEvent(std::uint32_t comId, const std::string &sessionId, const std::string &event,
                                  const std::vector<std::uint8_t> &payload) {
+    // Holding lifecycle pins the live endpoint table and the transport a synthetic request replies through.
+    std::shared_lock lifecycle(lifecycleMtx);
     if (event == "reply") {
         if (auto *endpoint = findEndpoint(comId)) {
             auto fields = endpoint->runtime->snapshotFields();
@@ -1936,14 +3580,18 @@ void TrdpEngine::simulateMdEvent(std::uint32_t comId, const std::string &session
             }
             noteMdReply(sessionId, comId, &fields);
         }
+    } else if (event == "request") {
+        // Route a synthetic Mr through the automatic replier, e.g. to preview a reply template without a peer.
+        MdReplySessionId syntheticId{};
+        std::memcpy(syntheticId.data(), sessionId.data(), std::min(sessionId.size(), syntheticId.size()));
+        handleMdRequest(comId, syntheticId, 0U, payload.data(), payload.size());
     } else if (event == "confirm") {
         noteMdConfirm(sessionId, comId);
     } else if (event == "error") {
         noteMdError(sessionId, comId, "simulated-error");
     } else if (event == "timeout") {
-        MdTimelineState temp = recordMdTimeline(sessionId.empty() ? allocateMdSessionId(MdSendOptions{}) : sessionId,
-                                               comId, MdSendOptions{});
-        temp.lastEvent = "timeout";
+        const auto temp = recordMdTimeline(sessionId.empty() ? allocateMdSessionId(MdSendOptions{}) : sessionId,
+                                           comId, MdSendOptions{}, "timeout");
         notifyMdStatus(temp, "timeout", nullptr);
     }
 }
@@ -2075,7 +3723,7 @@ std::optional<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>> TrdpEngin
 }
 
 #ifdef TRDP_STACK_PRESENT
-void pdReceiveCallback(void *refCon, TRDP_APP_SESSION_T /*session*/, const TRDP_PD_INFO_T *pInfo, UINT8 *pData,
+void pdReceiveCallback(void *refCon, TRDP_APP_SESSION_T session, const TRDP_PD_INFO_T *pInfo, UINT8 *pData,
                        UINT32 dataSize) {
     if (refCon == nullptr || pInfo == nullptr || pData == nullptr) {
         return;
@@ -2085,20 +3733,86 @@ void pdReceiveCallback(void *refCon, TRDP_APP_SESSION_T /*session*/, const TRDP_
         return;
     }
     auto *engine = static_cast<TrdpEngine *>(refCon);
+    if (CaptureRecorder::instance().active()) {
+        CapturedTelegram telegram;
+        telegram.header.msgType = static_cast<TrdpMsgType>(pInfo->msgType);
+        telegram.header.sequenceCounter = pInfo->seqCount;
+        telegram.header.comId = pInfo->comId;
+        telegram.header.etbTopoCounter = pInfo->etbTopoCnt;
+        telegram.header.opTrainTopoCounter = pInfo->opTrnTopoCnt;
+        telegram.srcIp = pInfo->srcIpAddr;
+        telegram.destIp = pInfo->destIpAddr;
+        std::tie(telegram.srcPort, telegram.destPort) = engine->stackRxPorts(session, pInfo->comId);
+        telegram.data = pData;
+        telegram.size = dataSize;
+        telegram.timestampNs = engine->clock.wallNowNs();
+        CaptureRecorder::instance().record(telegram);
+    }
+    PayloadVerifier::instance().verify(pInfo->comId, pData, dataSize);
     std::vector<std::uint8_t> payload(pData, pData + dataSize);
     engine->handleRxTelegram(pInfo->comId, payload);
 }
 
-void mdReceiveCallback(void *refCon, TRDP_APP_SESSION_T /*session*/, const TRDP_MD_INFO_T *pInfo, UINT8 *pData,
+void pdSendCallback(void * /*refCon*/, TRDP_APP_SESSION_T session, const TRDP_PD_INFO_T *pInfo, UINT8 *pData,
+                    UINT32 dataSize) {
+    // Pre-send callback of our publishers: records the frame with the sequence counter the stack stamps into it.
+    if (pInfo == nullptr || pInfo->pUserRef == nullptr || !CaptureRecorder::instance().active()) {
+        return;
+    }
+    auto *engine = static_cast<TrdpEngine *>(pInfo->pUserRef);
+    const auto *endpoint = engine->findEndpoint(pInfo->comId);
+    if (endpoint == nullptr) {
+        return;
+    }
+    QueuedFrame queued;
+    queued.header.msgType = static_cast<TrdpMsgType>(pInfo->msgType);
+    queued.header.sequenceCounter = pInfo->seqCount;
+    queued.header.comId = pInfo->comId;
+    queued.header.etbTopoCounter = pInfo->etbTopoCnt;
+    queued.header.opTrainTopoCounter = pInfo->opTrnTopoCnt;
+    queued.destIp = pInfo->destIpAddr != 0U ? pInfo->destIpAddr : endpoint->def->destIp;
+    queued.srcPort = engine->stackSessionPort(session);
+    queued.destPort = endpoint->def->destPort != 0U ? endpoint->def->destPort : kDefaultTrdpPort;
+    engine->captureTx(*endpoint, queued, pData, pData != nullptr ? dataSize : 0U);
+}
+
+void mdReceiveCallback(void *refCon, TRDP_APP_SESSION_T session, const TRDP_MD_INFO_T *pInfo, UINT8 *pData,
                        UINT32 dataSize) {
     if (refCon == nullptr || pInfo == nullptr) {
         return;
     }
     auto *engine = static_cast<TrdpEngine *>(refCon);
+    if (pInfo->resultCode == TRDP_CONFIRMTO_ERR) {
+        engine->noteMdReplierConfirm(pInfo->comId, true);
+    }
     if (pInfo->resultCode != TRDP_NO_ERR) {
         std::cerr << "[TRDP] MD receive error for ComId " << pInfo->comId << ": " << pInfo->resultCode << std::endl;
         return;
     }
+    if (CaptureRecorder::instance().active()) {
+        CapturedTelegram telegram;
+        telegram.header.msgType = static_cast<TrdpMsgType>(pInfo->msgType);
+        telegram.header.sequenceCounter = pInfo->seqCount;
+        telegram.header.comId = pInfo->comId;
+        telegram.header.etbTopoCounter = pInfo->etbTopoCnt;
+        telegram.header.opTrainTopoCounter = pInfo->opTrnTopoCnt;
+        telegram.header.replyStatus = pInfo->replyStatus;
+        std::memcpy(telegram.header.sessionId.data(), &pInfo->sessionId, telegram.header.sessionId.size());
+        telegram.srcIp = pInfo->srcIpAddr;
+        telegram.destIp = pInfo->destIpAddr;
+        std::tie(telegram.srcPort, telegram.destPort) = engine->stackRxPorts(session, pInfo->comId);
+        telegram.data = pData;
+        telegram.size = pData != nullptr ? dataSize : 0U;
+        telegram.timestampNs = engine->clock.wallNowNs();
+        CaptureRecorder::instance().record(telegram);
+    }
+    if (pInfo->msgType == TRDP_MSG_MR) {
+        TrdpEngine::MdReplySessionId sessionId{};
+        std::memcpy(sessionId.data(), &pInfo->sessionId, sessionId.size());
+        engine->handleMdRequest(pInfo->comId, sessionId, pInfo->srcIpAddr, pData, pData != nullptr ? dataSize : 0U);
+    } else if (pInfo->msgType == TRDP_MSG_MC) {
+        engine->noteMdReplierConfirm(pInfo->comId, false);
+    }
     engine->registerMdReply(pInfo);
     const std::uint8_t *payloadPtr = pData;
     const UINT32 payloadSize = dataSize;
@@ -2108,27 +3822,319 @@ void mdReceiveCallback(void *refCon, TRDP_APP_SESSION_T /*session*/, const TRDP_
 }
 #endif
 
+void TrdpEngine::syncStackClock() {
+#ifdef TRDP_FAKE_STACK
+    if (clock.isVirtual() && stackAvailable) {
+        FakeTrdpStack::instance().advanceTo(fakeStackOrigin + (clock.now() - fakeClockOrigin));
+    }
+#endif
+}
+
+std::optional<std::chrono::steady_clock::time_point> TrdpEngine::nextStackEvent() {
+#ifdef TRDP_FAKE_STACK
+    if (clock.isVirtual() && stackAvailable) {
+        if (const auto due = FakeTrdpStack::instance().nextEvent()) {
+            return fakeClockOrigin + std::chrono::duration_cast<EngineClock::time_point::duration>(
+                                         *due - fakeStackOrigin);
+        }
+    }
+#endif
+    return std::nullopt;
+}
+
+void TrdpEngine::waitForTraffic(std::chrono::nanoseconds timeout) {
+    if (!shards.empty()) {
+        // The shard threads poll every port; the worker only waits for its own deadlines and for delayed MD replies
+        // queued from API threads, which notify cv.
+        const auto until = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock lock(stateMtx);
+        cv.wait_until(lock, until, [this, until]() {
+            const auto replyDue = nextMdReplyDue(pendingMdReplies);
+            return stopRequested.load() || parkRequested.load() || (replyDue && *replyDue < until);
+        });
+        return;
+    }
+    if (!nativeTransport) {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+    nativeTransport->poll(timeout, [this](const NativeFrame &frame) { handleNativeFrame(frame); });
+}
+
+void TrdpEngine::handleNativeFrame(const NativeFrame &frame) {
+    // Runs on the worker thread without stateMtx, like the TCNopen receive callbacks.
+    auto *endpoint = findEndpoint(frame.comId);
+    if (CaptureRecorder::instance().active()) {
+        // Everything that reaches our ports is recorded, including ComIds without an endpoint.
+        CapturedTelegram telegram;
+        telegram.header.msgType = frame.msgType;
+        telegram.header.sequenceCounter = frame.sequenceCounter;
+        telegram.header.comId = frame.comId;
+        telegram.header.etbTopoCounter = frame.etbTopoCounter;
+        telegram.header.opTrainTopoCounter = frame.opTrainTopoCounter;
+        telegram.header.replyStatus = frame.replyStatus;
+        telegram.header.sessionId = frame.sessionId;
+        telegram.header.replyTimeoutUs = frame.replyTimeoutUs;
+        telegram.srcIp = frame.srcIp;
+        telegram.destIp = endpoint != nullptr && endpoint->def->destIp != 0U ? endpoint->def->destIp : resolvedSessionIp;
+        telegram.srcPort = frame.srcPort;
+        telegram.destPort = frame.localPort;
+        telegram.data = frame.data;
+        telegram.size = frame.size;
+        telegram.timestampNs = clock.wallNowNs();
+        CaptureRecorder::instance().record(telegram);
+    }
+    if ((frame.msgType == TrdpMsgType::Pd || frame.msgType == TrdpMsgType::Pp) && primary &&
+        PayloadVerifier::instance().active()) {
+        // Verified before the endpoint lookup so a pure test receiver needs no RX telegrams configured.
+        PayloadVerifier::instance().verify(frame.comId, frame.data, frame.size);
+    }
+    if (endpoint == nullptr) {
+        // Shared ports carry other devices' telegrams as well; ignore what we have no endpoint for.
+        return;
+    }
+    const bool rxEndpoint = endpoint->def->direction == Direction::Rx;
+
+    switch (frame.msgType) {
+    case TrdpMsgType::Pd:
+    case TrdpMsgType::Pp:
+        if (rxEndpoint && endpoint->def->type == TelegramType::PD) {
+            deliverRxTelegram(endpoint, frame.comId, std::vector<std::uint8_t>(frame.data, frame.data + frame.size));
+        }
+        return;
+    case TrdpMsgType::Pr:
+    case TrdpMsgType::Pe:
+        return;
+    case TrdpMsgType::Mr:
+        handleMdRequest(frame.comId, frame.sessionId, frame.srcIp, frame.data, frame.size);
+        break;
+    case TrdpMsgType::Mc:
+        noteMdReplierConfirm(frame.comId, false);
+        return;
+    case TrdpMsgType::Mq:
+        // Confirm replies that ask for it so the peer's session completes.
+        if (nativeTransport->queueMdReply(TrdpMsgType::Mc, frame.comId, frame.sessionId, 0, 0U, nullptr, 0U)) {
+            nativeTransport->flush();
+        }
+        break;
+    case TrdpMsgType::Mn:
+    case TrdpMsgType::Mp:
+    case TrdpMsgType::Me:
+        break;
+    }
+
+    if (rxEndpoint && endpoint->def->type == TelegramType::MD && frame.size > 0U) {
+        deliverRxMdTelegram(endpoint, frame.comId, std::vector<std::uint8_t>(frame.data, frame.data + frame.size));
+    }
+}
+
+TrdpEngine::MemoryUsage TrdpEngine::memoryUsage() {
+    MemoryUsage usage;
+    const auto table = endpointSnapshot();
+    usage.endpoints = table->size();
+    usage.endpointBytes = table->index.footprint() + heapBytes(table->cyclic);
+    for (auto &[comId, endpoint] : *table) {
+        usage.endpointBytes += kTreeNodeOverhead + sizeof(comId) + sizeof(EndpointHandle);
+        if (endpoint.checksums) {
+            usage.endpointBytes +=
+                kSharedControlBlock + sizeof(ChecksumState) + heapBytes(endpoint.checksums->fields);
+        }
+        {
+            std::lock_guard endpointLock(endpoint.mtx);
+            usage.endpointBytes += heapBytes(endpoint.generatorConfig);
+            for (const auto &generator : endpoint.generatorConfig) {
+                usage.endpointBytes += heapBytes(generator.field);
+            }
+            if (endpoint.generators) {
+                usage.endpointBytes += kSharedControlBlock + sizeof(TxGeneratorSet);
+            }
+            if (endpoint.sdt) {
+                usage.endpointBytes += kSharedControlBlock + sizeof(SdtChannel);
+            }
+        }
+        std::lock_guard replierLock(replierMtx);
+        usage.endpointBytes += heapBytes(endpoint.replierConfig.replyDataset) + heapBytes(endpoint.replierConfig.fields);
+        if (endpoint.replier) {
+            usage.endpointBytes += kSharedControlBlock + sizeof(MdReplierState);
+        }
+    }
+
+    {
+        std::lock_guard lock(mdSessionMtx);
+        usage.mdSessions = mdTimelineSessions.size();
+        for (const auto &[sessionId, state] : mdTimelineSessions) {
+            usage.mdSessionBytes += kTreeNodeOverhead + sizeof(sessionId) + heapBytes(sessionId) +
+                                    sizeof(MdTimelineState) + heapBytes(state.sessionId) +
+                                    heapBytes(state.lastEvent) + heapBytes(state.protocol);
+        }
+    }
+    {
+        std::lock_guard lock(stateMtx);
+        std::lock_guard replierLock(replierMtx);
+        const auto queueBytes = [](const std::vector<PendingMdReply> &queue) {
+            auto bytes = heapBytes(queue);
+            for (const auto &pending : queue) {
+                bytes += heapBytes(pending.payload);
+            }
+            return bytes;
+        };
+        usage.mdSessionBytes += queueBytes(pendingMdReplies);
+        for (const auto &shard : shards) {
+            usage.mdSessionBytes += queueBytes(shard->pendingReplies);
+        }
+    }
+#ifdef TRDP_STACK_PRESENT
+    {
+        std::lock_guard lock(mdRequestMtx);
+        usage.mdSessions += mdRequestStates.size();
+        usage.mdSessionBytes += mdRequestStates.size() * (kTreeNodeOverhead + sizeof(MdSessionKey) +
+                                                          sizeof(MdRequestState));
+    }
+#endif
+
+    std::lock_guard lock(stateMtx);
+    const auto cacheEntryBytes = [](const CacheEntry &entry) {
+        const auto *text = std::get_if<std::string>(&entry.payload);
+        return kTreeNodeOverhead + sizeof(CacheEntry) + (text != nullptr ? heapBytes(*text) : 0U);
+    };
+    for (const auto &[uri, entry] : uriCache) {
+        usage.cacheBytes += sizeof(uri) + heapBytes(uri) + cacheEntryBytes(entry);
+    }
+    for (const auto &[ip, entry] : ipCache) {
+        usage.cacheBytes += sizeof(ip) + cacheEntryBytes(entry);
+    }
+    for (const auto &[label, entry] : labelCache) {
+        usage.cacheBytes += sizeof(label) + heapBytes(label) + cacheEntryBytes(entry);
+    }
+    usage.cacheEntries = uriCache.size() + ipCache.size() + labelCache.size();
+#ifdef TRDP_STACK_PRESENT
+    usage.stackHeapBytes = heapStorage.size();
+#endif
+    return usage;
+}
+
+TrdpEngine::TransportStatus TrdpEngine::transportStatus() {
+    std::lock_guard lock(stateMtx);
+    TransportStatus status;
+    status.virtualTime = clock.isVirtual();
+    status.workerJitter = workerJitter.snapshot();
+    status.clockSeconds = std::chrono::duration<double>(clock.elapsed()).count();
+    status.realSeconds = std::chrono::duration<double>(clock.realElapsed()).count();
+    for (auto &shard : shards) {
+        TransportStatus::Shard entry;
+        entry.index = shard->index;
+        entry.cpu = shard->realtime.cpu;
+        entry.ports = shard->portList;
+        entry.cyclicTelegrams = shard->cyclic.size();
+        entry.framesSent = shard->framesSent.load(std::memory_order_relaxed);
+        entry.jitter = shard->jitter.snapshot();
+        if (const auto cpu = threadCpuTime(shard->thread)) {
+            entry.cpuSeconds = std::chrono::duration<double>(*cpu).count();
+        }
+        status.shards.push_back(std::move(entry));
+    }
+    if (nativeTransport) {
+        status.backend = "native";
+        status.ports = nativeTransport->ports();
+        status.native = nativeTransport->stats();
+        return status;
+    }
+    if (stackAvailable && running.load()) {
+        status.backend = "stack";
+#ifdef TRDP_STACK_PRESENT
+        std::set<std::uint16_t> ports;
+        for (const auto &[port, session] : pdSessions) {
+            (void)session;
+            ports.insert(port);
+        }
+        for (const auto &[port, session] : mdAppSessions) {
+            (void)session;
+            ports.insert(port);
+        }
+        status.ports.assign(ports.begin(), ports.end());
+#endif
+        return status;
+    }
+    status.backend = "stub";
+    return status;
+}
+
 void TrdpEngine::processingLoop() {
     std::cout << "[TRDP] Worker thread started" << std::endl;
     std::unique_lock lock(stateMtx);
+    applyRealtime("worker", config.workerRealtime, config.prefault);
     while (!stopRequested.load()) {
+        if (parkRequested.load()) {
+            lock.unlock();
+            parkIfRequested();
+            lock.lock();
+            continue;
+        }
+        if (clock.isVirtual()) {
+            dispatchCyclicTransmissions(clock.now());
+            dispatchMdReplies(clock.now(), pendingMdReplies);
+            reapMdTimeouts(clock.now());
+            // Deliver what this step sent (loopback frames are queued by the time send returns) and what the fake
+            // stack has due by now, then jump straight to the next deadline.
+            lock.unlock();
+            syncStackClock();
+            waitForTraffic(std::chrono::nanoseconds(0));
+            processStackOnce(nullptr, nullptr);
+            lock.lock();
+            auto deadline = nextDeadline();
+            if (const auto stackEvent = nextStackEvent(); stackEvent && (!deadline || *stackEvent < *deadline)) {
+                deadline = stackEvent;
+            }
+            if (deadline) {
+                clock.advanceTo(*deadline);
+                continue;
+            }
+            // Nothing scheduled: time stands still until traffic or an API call schedules something.
+            lock.unlock();
+            waitForTraffic(stackIntervalHint());
+            processStackOnce(nullptr, nullptr);
+            lock.lock();
+            continue;
+        }
+
+        // On real time the worker's own cyclic sends, delayed MD replies and MD timeouts only take their own locks,
+        // as the shards do, so API calls waiting for stateMtx never wait for them.
+        lock.unlock();
+        const auto cyclicDue = dispatchCyclicTransmissions(clock.now());
+        dispatchMdReplies(clock.now(), pendingMdReplies);
+        reapMdTimeouts(clock.now());
 #ifdef TRDP_STACK_PRESENT
-        const auto pdContext = pdSessionInitialised ? prepareSelectContext(defaultPdSession()) : std::nullopt;
-        const auto mdContext = mdSessionInitialised ? prepareSelectContext(defaultMdSession()) : std::nullopt;
+        // Stack shards process every session themselves; the worker then only waits for its own deadlines.
+        const bool ownsSessions = shards.empty();
+        const auto pdContext = ownsSessions && pdSessionInitialised ? prepareSelectContext(defaultPdSession())
+                                                                    : std::nullopt;
+        const auto mdContext = ownsSessions && mdSessionInitialised ? prepareSelectContext(defaultMdSession())
+                                                                    : std::nullopt;
 #endif
-        dispatchCyclicTransmissions(std::chrono::steady_clock::now());
-        reapMdTimeouts(std::chrono::steady_clock::now());
-        const auto waitDuration = stackIntervalHint();
 
-        // Release the lock while doing any heavier processing or callbacks.
-        lock.unlock();
+        // Sleep until the earliest of the worker's own cyclic instants, the next delayed MD reply or MD timeout and
+        // the stack's poll interval, to the nanosecond rather than rounded up to the next millisecond.
+        auto wakeAt = clock.now() + (shards.empty() ? stackIntervalHint() : idleIntervalHint());
+        for (const auto &due : {cyclicDue, nextMdReplyDue(pendingMdReplies), nextMdTimeout()}) {
+            if (due) {
+                wakeAt = std::min(wakeAt, *due);
+            }
+        }
+        const auto waitDuration =
+            std::max(std::chrono::nanoseconds(wakeAt - clock.now()), std::chrono::nanoseconds(0));
 
 #ifdef TRDP_STACK_PRESENT
         if (stackAvailable && ((pdContext && pdContext->valid) || (mdContext && mdContext->valid))) {
-            auto waitOnContext = [](StackSelectContext &context, const char *label) {
+            auto waitOnContext = [waitDuration](StackSelectContext &context, const char *label) {
                 timeval tv{};
                 tv.tv_sec = static_cast<time_t>(context.interval.tv_sec);
                 tv.tv_usec = static_cast<suseconds_t>(context.interval.tv_usec);
+                // Wake up early for cyclic sends and delayed MD replies that fall due before the stack's own deadline.
+                if (toDuration(context.interval) > waitDuration) {
+                    const auto us = std::chrono::ceil<std::chrono::microseconds>(waitDuration).count();
+                    tv.tv_sec = static_cast<time_t>(us / 1000000);
+                    tv.tv_usec = static_cast<suseconds_t>(us % 1000000);
+                }
                 const int rv = select(static_cast<int>(context.maxFd) + 1, &context.readFds, &context.writeFds, nullptr, &tv);
                 if (rv < 0 && errno != EINTR) {
                     std::cerr << "[TRDP] select(" << label << ") failed: " << errno << std::endl;
@@ -2154,11 +4160,11 @@ void TrdpEngine::processingLoop() {
 
             processStackOnce(pdPtr, mdPtr);
         } else {
-            std::this_thread::sleep_for(waitDuration);
+            waitForTraffic(waitDuration);
             processStackOnce(nullptr, nullptr);
         }
 #else
-        std::this_thread::sleep_for(waitDuration);
+        waitForTraffic(waitDuration);
         processStackOnce(nullptr, nullptr);
 #endif
 
@@ -1,6 +1,14 @@
 #pragma once
 
+#include "buffer_arena.h"
+#include "checksum.h"
+#include "engine_clock.h"
+#include "md_replier.h"
+#include "native_transport.h"
+#include "realtime.h"
+#include "sdt.h"
 #include "telegram_model.h"
+#include "tx_generator.h"
 
 #include <atomic>
 #include <array>
@@ -11,9 +19,11 @@
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <string>
 #include <thread>
 #include <tuple>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -25,6 +35,8 @@ using TRDP_ERR_T = int;
 
 namespace trdp {
 
+class TelegramEventSink;
+
 enum class MdMode { Notify, Request, ReplyNoConfirm, ReplyWithConfirm, Confirm, Error };
 
 struct MdSendOptions {
@@ -52,11 +64,25 @@ struct MdSendOptions {
  *  - Mapping RX buffers into TelegramRuntime field values.
  *  - Encoding TX field values into buffers before sending.
  *  - Running a background processing loop to keep the stack alive.
+ *
+ * instance() is the engine of the default workspace, bound to TelegramRegistry::instance() and the TelegramHub
+ * plugin. Further engines serve their own registry and hub (see WorkspaceManager); they only support the native
+ * transport and do not feed the process-wide history, rule and verification services.
  */
 class TrdpEngine {
   public:
     static TrdpEngine &instance();
 
+    // Engine of an additional workspace. registry must outlive the engine.
+    TrdpEngine(TelegramRegistry &registry, std::string workspace);
+    ~TrdpEngine();
+
+    [[nodiscard]] const std::string &workspaceName() const noexcept { return workspace; }
+    [[nodiscard]] TelegramRegistry &telegramRegistry() noexcept { return registry; }
+    // Hub receiving this engine's RX updates, TX confirmations and MD events: the workspace's TelegramHub, or for
+    // the default engine the TelegramHub plugin, which registers itself when it starts. None by default.
+    void setHub(TelegramEventSink *hub) noexcept { eventHub.store(hub); }
+
     enum class DnrMode { CommonThread, DedicatedThread };
 
     struct CacheConfig {
@@ -71,7 +97,11 @@ class TrdpEngine {
         std::chrono::milliseconds confirmTimeout{std::chrono::seconds(5)};
     };
 
+    // Auto uses the TCNopen stack when it was compiled in and the built-in UDP transport otherwise.
+    enum class Transport { Auto, Stack, Native };
+
     struct TrdpConfig {
+        Transport transport{Transport::Auto};
         std::string rxInterface;
         std::string txInterface;
         std::string hostsFile;
@@ -81,6 +111,26 @@ class TrdpEngine {
         EcspConfig ecspConfig;
         // How often the worker thread should wake up when no events are pending.
         std::chrono::milliseconds idleInterval{std::chrono::milliseconds(50)};
+        // Local address the native sockets bind to instead of the wildcard, so several workspaces can share the
+        // TRDP ports on one host. Sockets bound this way do not receive multicast.
+        std::string hostIp;
+        // Run on virtual time: the worker jumps from one deadline to the next instead of sleeping. Needs the native
+        // transport, which is selected automatically, or the fake stack, whose clock then follows the engine's.
+        bool virtualTime{false};
+        // Processing threads. With more than one, the UDP ports are split between shard threads that each serve
+        // their own sockets (or, on the TCNopen stack, run tlc_process for the sessions of their ports), publish
+        // the cyclic PD telegrams of those ports and send the delayed MD replies to requests they received. The
+        // main worker keeps MD timeouts, topology counters and ECSP. start() fails on virtual time, which runs
+        // every deadline from one thread.
+        std::size_t shards{1};
+        // CPU each shard thread is pinned to, by shard index; a negative or missing entry leaves it unpinned.
+        std::vector<int> shardCpus;
+        // Scheduling policy, priority and CPU of the worker thread. Shard threads use the same policy and priority
+        // on their shardCpus. Each setting is read back and reported through RealtimeReport.
+        ThreadRealtime workerRealtime;
+        // Before going live, touch every TX/RX buffer, the native send and receive buffers, the TRDP heap and the
+        // processing thread stacks, so the first cycles do not page-fault.
+        bool prefault{false};
     };
 
     // Start TRDP stack and background worker. Idempotent.
@@ -92,10 +142,99 @@ class TrdpEngine {
 
     [[nodiscard]] bool isRunning() const noexcept { return running.load(); }
 
+    // Configuration the engine was last started with.
+    TrdpConfig activeConfig();
+
+    struct ReloadReport {
+        // False when the engine was not running; the next start() picks the registry up as it is.
+        bool applied{false};
+        // The new telegrams need a UDP port without a native socket or stack session, so the engine was restarted.
+        bool restarted{false};
+        std::size_t added{0};
+        std::size_t removed{0};
+        // Bound again from scratch: more than the addresses changed, or the dataset did.
+        std::size_t changed{0};
+        // Only the source or destination IP changed; moved in place (tlp_republish/tlp_resubscribe on the stack).
+        std::size_t readdressed{0};
+        std::size_t unchanged{0};
+        // How long the processing threads were parked, and the whole apply including the wait for them to park.
+        std::chrono::microseconds paused{0};
+        std::chrono::microseconds apply{0};
+    };
+
+    // Bring a running engine in line with the registry after its contents were replaced (e.g. by reloading the
+    // XML) without stopping traffic. Only the endpoints of added, removed and changed telegrams are unbound and
+    // bound; the others keep their runtime values, cycle phase, generator and SDT state and stack handles.
+    ReloadReport applyRegistryChanges();
+
+    struct TxCounters {
+        std::uint64_t pdSent{0};
+        std::uint64_t pdFailed{0};
+    };
+
+    // Totals since process start; used to derive achieved send rates.
+    [[nodiscard]] TxCounters txCounters() const noexcept;
+
+    // CPU time consumed by the processing threads (the worker and any shard threads), if the engine is running and
+    // the platform exposes per-thread clocks.
+    std::optional<std::chrono::nanoseconds> workerCpuTime();
+
+    struct TransportStatus {
+        // "stack", "native" or "stub" (neither backend available).
+        std::string backend;
+        std::vector<std::uint16_t> ports;
+        std::optional<NativeTransport::Stats> native;
+        bool virtualTime{false};
+        // Engine time and wall-clock time since the engine started; they only differ on virtual time.
+        double clockSeconds{0.0};
+        double realSeconds{0.0};
+
+        struct Shard {
+            std::size_t index{0};
+            int cpu{-1};
+            std::vector<std::uint16_t> ports;
+            std::size_t cyclicTelegrams{0};
+            // Native transport only; on the stack the sessions send the frames.
+            std::uint64_t framesSent{0};
+            std::optional<double> cpuSeconds;
+            CycleJitter::Snapshot jitter;
+        };
+        // Cyclic publications made by the worker thread (all of them unless the engine runs sharded).
+        CycleJitter::Snapshot workerJitter;
+        // Empty unless the engine runs sharded.
+        std::vector<Shard> shards;
+    };
+
+    TransportStatus transportStatus();
+
+    // Approximate heap bytes held by the engine beside the registry's definitions and runtimes.
+    struct MemoryUsage {
+        std::size_t endpoints{0};
+        // Endpoint objects, their ComId index and their compiled checksum, generator, SDT and replier state.
+        std::size_t endpointBytes{0};
+        // Open MD session timelines, tracked MD requests and queued delayed replies.
+        std::size_t mdSessions{0};
+        std::size_t mdSessionBytes{0};
+        // DNR URI, IP and label caches.
+        std::size_t cacheEntries{0};
+        std::size_t cacheBytes{0};
+        // Heap handed to the TRDP stack.
+        std::size_t stackHeapBytes{0};
+    };
+
+    MemoryUsage memoryUsage();
+
+    // Per-telegram PD send logging is useful interactively but dominates the cost of large generated loads.
+    void setPdSendLogging(bool enabled) noexcept { logPdSends.store(enabled); }
+
     // Push updated TX field values to the network. Returns false on failure.
     bool sendTxTelegram(std::uint32_t comId, const std::map<std::string, FieldValue> &txFields,
                         const std::optional<MdSendOptions> &mdOptions = std::nullopt);
 
+    // Encode fields as comId's TX buffer, checksum fields included, using the checksums its endpoint resolved.
+    std::vector<std::uint8_t> encodeTxBuffer(std::uint32_t comId, const TelegramRuntime &runtime,
+                                             const std::map<std::string, FieldValue> &fields);
+
     // Stop cyclic publishing for a TX PD telegram.
     bool stopTxTelegram(std::uint32_t comId);
 
@@ -108,6 +247,72 @@ class TrdpEngine {
     // Feed a freshly received MD telegram into the registry/runtime.
     void handleRxMdTelegram(std::uint32_t comId, const std::vector<std::uint8_t> &payload);
 
+    // A recorded telegram to put back on the wire (capture replay).
+    struct ReplayTelegram {
+        TrdpMsgType msgType{TrdpMsgType::Pd};
+        std::uint32_t comId{0};
+        std::uint32_t destIp{0};
+        std::uint16_t destPort{0};
+        const std::uint8_t *data{nullptr};
+        std::size_t size{0};
+    };
+
+    // Send a batch of replayed telegrams under one lock and one transport flush. PD goes through the TX
+    // endpoint of its ComId when there is one (tlp_put or native publish) and otherwise, on the native
+    // transport, straight to destIp:destPort. MD is sent as a notification (tlm_notify or a native Mn).
+    // Returns the number of telegrams sent.
+    std::size_t sendReplayTelegrams(const std::vector<ReplayTelegram> &telegrams);
+
+    struct MdReplierStats {
+        bool enabled{false};
+        MdReplierDef config;
+        std::uint32_t replyComId{0};
+        std::size_t replyBytes{0};
+        std::uint64_t requests{0};
+        std::uint64_t replies{0};
+        std::uint64_t throttled{0};
+        std::uint64_t failed{0};
+        std::uint64_t confirms{0};
+        std::uint64_t confirmTimeouts{0};
+        std::size_t pending{0};
+    };
+
+    // Enable, reconfigure or disable (def.enabled == false) the automatic MD replier of an MD endpoint.
+    // The reply template is recompiled from the current registry/runtime state. Returns false with a reason
+    // in error when the endpoint is unknown or the template cannot be built.
+    bool configureMdReplier(std::uint32_t comId, const MdReplierDef &def, std::string &error);
+    std::optional<MdReplierStats> mdReplierStats(std::uint32_t comId);
+
+    struct TxGeneratorStats {
+        std::vector<FieldGeneratorDef> config;
+        // False when the configured generators could not be compiled against the dataset.
+        bool active{false};
+        // Cyclic publications produced since the generators were (re)configured.
+        std::uint64_t cycles{0};
+    };
+
+    // Replace the field generators of a TX PD endpoint (an empty list removes them). Generated values are
+    // written into the TX buffer before every cyclic publication. Returns false with a reason in error when the
+    // endpoint is unknown or a generator cannot be resolved.
+    bool configureTxGenerators(std::uint32_t comId, const std::vector<FieldGeneratorDef> &defs, std::string &error);
+    std::optional<TxGeneratorStats> txGeneratorStats(std::uint32_t comId);
+
+    // Enable, reconfigure or disable (def.enabled == false) SDTv2 on a PD endpoint. The channel restarts with a
+    // fresh SSC. Returns false with a reason in error when the endpoint is unknown or the parameters do not fit.
+    bool configureSdt(std::uint32_t comId, const SdtDef &def, std::string &error);
+    // SDT state of a PD endpoint; stats.config.enabled is false when SDT is off. nullopt for unknown ComIds.
+    std::optional<SdtChannel::Stats> sdtStats(std::uint32_t comId);
+
+    struct ChecksumStats {
+        std::vector<ChecksumField> fields;
+        // Received telegrams verified and those with at least one wrong checksum.
+        std::uint64_t checked{0};
+        std::uint64_t mismatches{0};
+    };
+
+    // Checksum fields of a telegram with their RX verification counters; nullopt when it has none.
+    std::optional<ChecksumStats> checksumStats(std::uint32_t comId);
+
     // Developer/testing hooks for MD session state.
     void simulateMdEvent(std::uint32_t comId, const std::string &sessionId, const std::string &event,
                          const std::vector<std::uint8_t> &payload = {});
@@ -119,18 +324,76 @@ class TrdpEngine {
                                                                                       bool useCache = true);
 
   private:
-    TrdpEngine() = default;
+    TrdpEngine();
     TrdpEngine(const TrdpEngine &) = delete;
     TrdpEngine &operator=(const TrdpEngine &) = delete;
 
+    using MdReplySessionId = std::array<std::uint8_t, 16>;
+
+    struct MdReplierState {
+        MdReplierDef def;
+        std::uint32_t replyComId{0};
+        std::shared_ptr<MdReplyTemplate> replyTemplate;
+        std::vector<std::uint8_t> scratch;
+        double tokens{0.0};
+        std::chrono::steady_clock::time_point lastRefill{};
+        std::uint64_t requests{0};
+        std::uint64_t replies{0};
+        std::uint64_t throttled{0};
+        std::uint64_t failed{0};
+        std::uint64_t confirms{0};
+        std::uint64_t confirmTimeouts{0};
+        // Delayed replies queued for this replier and not yet sent, across the worker's and the shards' queues.
+        std::size_t pending{0};
+    };
+
+    struct PendingMdReply {
+        std::chrono::steady_clock::time_point due{};
+        std::uint32_t comId{0};
+        MdReplySessionId sessionId{};
+        std::uint32_t requesterIp{0};
+        std::vector<std::uint8_t> payload;
+    };
+
+    struct ChecksumState {
+        std::vector<ChecksumField> fields;
+        // Updated by the receive path without stateMtx.
+        std::atomic<std::uint64_t> checked{0};
+        std::atomic<std::uint64_t> mismatches{0};
+    };
+
+    struct Shard;
+
+    // One telegram's endpoint. def, runtime, the handles and checksums are fixed once the endpoint table is
+    // published; mtx guards the TX state below it, so API calls and the processing threads only contend per
+    // endpoint. def is the registry's definition, shared rather than copied; the settings the API can change at
+    // run time are kept beside it.
     struct EndpointHandle {
-        TelegramDef def;
+        std::shared_ptr<const TelegramDef> def;
         std::shared_ptr<TelegramRuntime> runtime;
         bool pdHandleReady{false};
         bool mdHandleReady{false};
         std::chrono::milliseconds cycle{0};
-        bool txCyclicActive{false};
+        // Computed checksum fields, rewritten after generators and verified on receive.
+        std::shared_ptr<ChecksumState> checksums{};
+        // Shard thread publishing this TX PD endpoint cyclically; nullptr when the main worker does.
+        Shard *shard{nullptr};
+        // Read without mtx (e.g. for every row of a telegram listing); written under it.
+        std::atomic<bool> txCyclicActive{false};
+
+        // Held while publishing, and while reading or changing nextSend, generators, sdt and their
+        // configurations.
+        std::mutex mtx;
         std::chrono::steady_clock::time_point nextSend{};
+        // Field generators of a TX PD endpoint, advanced before every cyclic publication.
+        std::shared_ptr<TxGeneratorSet> generators{};
+        std::vector<FieldGeneratorDef> generatorConfig;
+        // SDTv2 channel: seals every TX publication, validates every RX telegram.
+        std::shared_ptr<SdtChannel> sdt{};
+        SdtDef sdtConfig;
+        // Guarded by replierMtx, like replierConfig.
+        std::shared_ptr<MdReplierState> replier{};
+        MdReplierDef replierConfig;
 #ifdef TRDP_STACK_PRESENT
         TRDP_PUB_T pdPublishHandle{};
         TRDP_SUB_T pdSubscribeHandle{};
@@ -143,8 +406,18 @@ class TrdpEngine {
 
     bool bootstrapRegistry();
     bool initialiseTrdpStack();
+    bool initialiseNativeTransport();
+    // Block until traffic arrives on the native transport or the timeout elapses.
+    void waitForTraffic(std::chrono::nanoseconds timeout);
+    void handleNativeFrame(const NativeFrame &frame);
+    // Receive paths of handleRxTelegram/handleRxMdTelegram for an endpoint the caller already looked up (nullptr
+    // when the ComId is unknown).
+    void deliverRxTelegram(EndpointHandle *endpoint, std::uint32_t comId, const std::vector<std::uint8_t> &payload);
+    void deliverRxMdTelegram(EndpointHandle *endpoint, std::uint32_t comId, const std::vector<std::uint8_t> &payload);
     void teardownTrdpStack();
     std::chrono::milliseconds stackIntervalHint() const;
+    // TrdpConfig::idleInterval, or 100 ms when it is not set.
+    std::chrono::milliseconds idleIntervalHint() const;
 #ifdef TRDP_STACK_PRESENT
     struct StackSelectContext {
         TRDP_FDS_T readFds{};
@@ -158,6 +431,11 @@ class TrdpEngine {
 #endif
     void markTopologyChanged();
     bool publishPdBuffer(EndpointHandle &endpoint, const std::vector<std::uint8_t> &buffer);
+    // Send size bytes at data, e.g. straight from the runtime's arena slot under its lock.
+    bool publishPdBuffer(EndpointHandle &endpoint, const std::uint8_t *data, std::size_t size);
+    // Record a sent telegram with the header and addressing it went out with.
+    void captureTx(const EndpointHandle &endpoint, const QueuedFrame &queued, const std::uint8_t *data,
+                   std::size_t size);
     bool processStackOnce(
 #ifdef TRDP_STACK_PRESENT
         const StackSelectContext *pdContext, const StackSelectContext *mdContext
@@ -165,8 +443,31 @@ class TrdpEngine {
         void *pdContext, void *mdContext
 #endif
     );
-    void dispatchCyclicTransmissions(std::chrono::steady_clock::time_point now);
+    // Publish the worker's due cyclic endpoints; returns the earliest next due time among them.
+    std::optional<std::chrono::steady_clock::time_point> dispatchCyclicTransmissions(
+        std::chrono::steady_clock::time_point now);
+    // Publish a cycling TX PD endpoint when it is due and record its lateness in jitter. Returns its next due
+    // time, or nullopt when it is not cycling. Due times advance by whole cycles from the first one, so a late
+    // publication does not shift the following ones.
+    std::optional<std::chrono::steady_clock::time_point> publishIfDue(std::uint32_t comId, EndpointHandle &endpoint,
+                                                                      std::chrono::steady_clock::time_point now,
+                                                                      CycleJitter &jitter);
     void buildEndpoints();
+    // Fill handle for definition: compile its generators, SDT channel, checksums and replier and bind it to the
+    // stack or the native transport.
+    void bindEndpoint(EndpointHandle &handle, const std::shared_ptr<const TelegramDef> &definition,
+                      std::shared_ptr<TelegramRuntime> runtime);
+    // Release the stack publication, subscription or listener of an endpoint that is being dropped.
+    void unbindEndpoint(EndpointHandle &handle);
+    // Move a PD endpoint to the addresses of telegram, keeping its binding; false when it must be bound again.
+    bool readdressEndpoint(EndpointHandle &handle, const TelegramDef &telegram);
+    // Take over the binding and TX/replier state of an endpoint kept across a reload.
+    void adoptEndpoint(EndpointHandle &to, EndpointHandle &from);
+#ifdef TRDP_STACK_PRESENT
+    // Source and destination IP a PD endpoint is bound with: loopback TX addresses become the session interface,
+    // RX destinations not configured on this host the wildcard.
+    std::pair<std::uint32_t, std::uint32_t> pdStackAddresses(const TelegramDef &telegram) const;
+#endif
     void processingLoop();
     bool initialiseDnr();
     void initialiseEcsp();
@@ -194,8 +495,9 @@ class TrdpEngine {
     };
 
     std::string allocateMdSessionId(const MdSendOptions &options) const;
-    MdTimelineState &recordMdTimeline(const std::string &sessionId, std::uint32_t comId,
-                                      const MdSendOptions &options);
+    // Start tracking a session with lastEvent; returns a copy, as the worker may reap the entry at any time.
+    MdTimelineState recordMdTimeline(const std::string &sessionId, std::uint32_t comId, const MdSendOptions &options,
+                                     const std::string &lastEvent);
     void notifyMdStatus(const MdTimelineState &state, const std::string &event,
                         const std::map<std::string, FieldValue> *fields = nullptr);
     void noteMdReply(const std::string &sessionId, std::uint32_t comId,
@@ -203,10 +505,60 @@ class TrdpEngine {
     void noteMdConfirm(const std::string &sessionId, std::uint32_t comId);
     void noteMdError(const std::string &sessionId, std::uint32_t comId, const std::string &message);
 
+    // Endpoints by ComId. A table is built by start() and never changes shape afterwards; applyRegistryChanges()
+    // replaces it with a new one while the processing threads are parked, stop() with an empty one. The processing
+    // threads, and API calls holding lifecycleMtx, use endpointTable directly (it cannot change meanwhile); other
+    // callers take a snapshot, which keeps the endpoints alive across a reload or a stop().
+    struct EndpointTable {
+        // Endpoints hold a mutex, so the map owns them in place; index points into it.
+        std::map<std::uint32_t, EndpointHandle> handles;
+        ComIdIndex<EndpointHandle *> index;
+        // TX PD endpoints in buffer layout order, the order the dispatchers walk them.
+        std::vector<std::pair<std::uint32_t, EndpointHandle *>> cyclic;
+        std::shared_ptr<BufferArena> buffers;
+
+        auto begin() { return handles.begin(); }
+        auto end() { return handles.end(); }
+        auto begin() const { return handles.begin(); }
+        auto end() const { return handles.end(); }
+        [[nodiscard]] std::size_t size() const noexcept { return handles.size(); }
+        [[nodiscard]] bool empty() const noexcept { return handles.empty(); }
+    };
+    std::shared_ptr<EndpointTable> endpointSnapshot() const;
+    // Lookup in the live table, for the processing threads.
     EndpointHandle *findEndpoint(std::uint32_t comId);
+    static EndpointHandle *findEndpoint(EndpointTable &table, std::uint32_t comId);
+    // Lay the runtime buffers of table out in one arena: cyclic TX PD by cycle, then the other TX telegrams, then
+    // RX, with buffers the processing threads rewrite kept apart from their neighbours.
+    void layoutBuffers(EndpointTable &table) const;
+    // Lay out the buffers of a freshly filled table and build its ComId index.
+    void finishEndpointTable(EndpointTable &table) const;
+
+    std::shared_ptr<MdReplierState> compileMdReplier(const TelegramDef &telegram, const MdReplierDef &def,
+                                                     std::string &error) const;
+    void handleMdRequest(std::uint32_t comId, const MdReplySessionId &sessionId, std::uint32_t requesterIp,
+                         const std::uint8_t *data, std::size_t size);
+    void noteMdReplierConfirm(std::uint32_t comId, bool timedOut);
+    bool sendMdReply(EndpointHandle &endpoint, const MdReplierState &state, const MdReplySessionId &sessionId,
+                     std::uint32_t requesterIp, const std::vector<std::uint8_t> &payload);
+    // Send the replies of queue (the worker's pendingMdReplies or a shard's) that are due by now.
+    void dispatchMdReplies(std::chrono::steady_clock::time_point now, std::vector<PendingMdReply> &queue);
+    std::optional<std::chrono::steady_clock::time_point> nextMdReplyDue(const std::vector<PendingMdReply> &queue);
+    // Earliest reply or confirm deadline of the MD requests this simulator sent.
+    std::optional<std::chrono::steady_clock::time_point> nextMdTimeout();
+    // Earliest cyclic send, delayed MD reply or MD timeout; drives the virtual clock.
+    std::optional<std::chrono::steady_clock::time_point> nextDeadline();
+
+    // Guards every EndpointHandle::replier and the delayed reply queues, the worker's and the shards'.
+    std::mutex replierMtx;
+    // Delayed replies to requests received by the worker (or queued from API threads), as a min-heap on due.
+    std::vector<PendingMdReply> pendingMdReplies;
 
     std::atomic<bool> running{false};
     std::atomic<bool> stopRequested{false};
+    std::atomic<bool> logPdSends{true};
+    std::atomic<std::uint64_t> pdTxSent{0};
+    std::atomic<std::uint64_t> pdTxFailed{0};
     bool pdSessionInitialised{false};
     bool mdSessionInitialised{false};
     bool stackAvailable{false};
@@ -221,17 +573,100 @@ class TrdpEngine {
     TRDP_APP_SESSION_T defaultMdSession() const;
     TRDP_APP_SESSION_T pdSessionForPort(std::uint16_t port) const;
     TRDP_APP_SESSION_T mdSessionForPort(std::uint16_t port) const;
-    std::uint16_t resolvePortForEndpoint(const TelegramDef &telegram) const;
+    // Local port a PD or MD session is bound to; 0 for unknown sessions.
+    std::uint16_t stackSessionPort(TRDP_APP_SESSION_T session) const;
+    // Ports recorded for a telegram the stack delivered on session; TCNopen does not report the sender's port.
+    std::pair<std::uint16_t, std::uint16_t> stackRxPorts(TRDP_APP_SESSION_T session, std::uint32_t comId);
     void applyTopologyCounters(TRDP_APP_SESSION_T session);
 #endif
-    std::uint32_t etbTopoCounter{0};
-    std::uint32_t opTrainTopoCounter{0};
+    std::uint16_t resolvePortForEndpoint(const TelegramDef &telegram) const;
+    std::unique_ptr<NativeTransport> nativeTransport;
+    // Read by the send and capture paths without stateMtx.
+    std::atomic<std::uint32_t> etbTopoCounter{0};
+    std::atomic<std::uint32_t> opTrainTopoCounter{0};
     bool topologyCountersDirty{false};
+    TelegramRegistry &registry;
+    std::string workspace{"default"};
+    // Only the default engine drives the stack and the process-wide services.
+    bool primary{false};
+    std::atomic<TelegramEventSink *> eventHub{nullptr};
     TrdpConfig config;
+    EngineClock clock;
+    // Virtual time on the fake stack: move its clock along with ours, and the earliest of its pending events.
+    void syncStackClock();
+    std::optional<std::chrono::steady_clock::time_point> nextStackEvent();
+#ifdef TRDP_FAKE_STACK
+    // Where the fake stack's clock and ours stood when virtual time started; autoAdvance is restored on stop().
+    std::chrono::nanoseconds fakeStackOrigin{0};
+    EngineClock::time_point fakeClockOrigin{};
+    std::optional<bool> fakeStackAutoAdvance;
+#endif
+    std::chrono::steady_clock::time_point lastEcspPoll{};
     std::thread worker;
+    // Configuration, sessions, caches and the worker's scheduling state. Per-telegram API calls do not take it.
     std::mutex stateMtx;
+    // Shared by API calls that send through the transport or the stack, including the rule actions the processing
+    // threads run; exclusive while start() sets them up, stop() tears them down (after joining the processing
+    // threads) and applyRegistryChanges() swaps the endpoint table (after parking them).
+    std::shared_mutex lifecycleMtx;
+    // Serialises applyRegistryChanges(); taken before parking the processing threads, and never by them.
+    std::mutex reloadMtx;
     std::condition_variable cv;
-    std::map<std::uint32_t, EndpointHandle> endpoints;
+    // Only replaced with std::atomic_store, and only while no processing thread runs or all of them are parked.
+    std::shared_ptr<EndpointTable> endpointTable{std::make_shared<EndpointTable>()};
+
+    // A reload parks the worker and the shard threads at the top of their loops while it replaces the endpoint
+    // table. parkedThreads is guarded by parkMtx.
+    std::atomic<bool> parkRequested{false};
+    std::mutex parkMtx;
+    std::condition_variable parkCv;
+    std::size_t parkedThreads{0};
+    // Called by a processing thread when parkRequested is set; returns once the reload is done or the engine stops.
+    void parkIfRequested();
+    // Returns once every processing thread is parked; false when the engine is stopping instead.
+    bool parkProcessingThreads();
+    void releaseProcessingThreads();
+
+    // Processing thread of the sharded mode. It owns a group of ports, polls their native sockets or processes
+    // their stack sessions, and publishes the cyclic TX PD endpoints bound to them without stateMtx, under each
+    // endpoint's own lock.
+    struct Shard {
+        const TrdpEngine *engine{nullptr};
+        std::size_t index{0};
+        ThreadRealtime realtime;
+        bool prefault{false};
+        std::vector<std::uint16_t> portList;
+        // Native transport only.
+        std::unique_ptr<NativeTransport::PortGroup> ports;
+#ifdef TRDP_STACK_PRESENT
+        // TCNopen stack only: the PD and MD sessions of portList.
+        std::vector<TRDP_APP_SESSION_T> sessions;
+#endif
+        std::vector<std::pair<std::uint32_t, EndpointHandle *>> cyclic;
+        // Delayed replies to the MD requests this shard received, under replierMtx.
+        std::vector<PendingMdReply> pendingReplies;
+        // Frames written by this shard's flushes.
+        std::atomic<std::uint64_t> framesSent{0};
+        CycleJitter jitter;
+        std::thread thread;
+    };
+    void startShards();
+    // Hand every cyclic TX PD endpoint of the live table to the shard owning its port.
+    void assignShardEndpoints();
+    // Start-up touch of the endpoint buffers and native queues (TrdpConfig::prefault).
+    void prefaultBuffers();
+    // Apply the configured scheduling to the calling processing thread and record the checks.
+    void applyRealtime(const std::string &thread, const ThreadRealtime &settings, bool prefault) const;
+    void stopShards();
+    void shardLoop(Shard &shard);
+#ifdef TRDP_STACK_PRESENT
+    void stackShardLoop(Shard &shard);
+#endif
+    std::vector<std::unique_ptr<Shard>> shards;
+    // Shard run by the calling thread, if any; MD requests it receives are answered from its own queue.
+    static thread_local Shard *currentShard;
+    // Lateness of the cyclic publications made by the worker thread itself.
+    CycleJitter workerJitter;
 
 #ifdef TRDP_STACK_PRESENT
     using MdSessionKey = std::array<std::uint8_t, sizeof(TRDP_UUID_T)>;
@@ -257,6 +692,10 @@ class TrdpEngine {
 #endif
 
 #ifdef TRDP_STACK_PRESENT
+    friend void pdReceiveCallback(void *refCon, TRDP_APP_SESSION_T session, const TRDP_PD_INFO_T *pInfo, UINT8 *pData,
+                                  UINT32 dataSize);
+    friend void pdSendCallback(void *refCon, TRDP_APP_SESSION_T session, const TRDP_PD_INFO_T *pInfo, UINT8 *pData,
+                               UINT32 dataSize);
     friend void mdReceiveCallback(void *refCon, TRDP_APP_SESSION_T session, const TRDP_MD_INFO_T *pInfo, UINT8 *pData,
                                   UINT32 dataSize);
 #endif
@@ -291,7 +730,7 @@ std::optional<T> TrdpEngine::fetchCached(Map &map, const Key &key) const {
     if (it == map.end()) {
         return std::nullopt;
     }
-    const auto now = std::chrono::steady_clock::now();
+    const auto now = clock.now();
     if (now >= it->second.expiresAt) {
         return std::nullopt;
     }
@@ -301,9 +740,11 @@ std::optional<T> TrdpEngine::fetchCached(Map &map, const Key &key) const {
     return std::nullopt;
 }
 
-// Encode a set of fields into a TX buffer using the dataset layout in the provided runtime.
+// Encode a set of fields into a TX buffer using the dataset layout in the provided runtime, then fill in the
+// already resolved checksum fields.
 std::vector<std::uint8_t> encodeFieldsToBuffer(const TelegramRuntime &runtime,
-                                               const std::map<std::string, FieldValue> &fields);
+                                               const std::map<std::string, FieldValue> &fields,
+                                               const std::vector<ChecksumField> &checksums);
 
 } // namespace trdp
 
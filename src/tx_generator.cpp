@@ -0,0 +1,318 @@
+#include "tx_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace trdp {
+
+namespace {
+
+constexpr double kTwoPi = 6.283185307179586;
+
+std::size_t elementWidth(FieldType type) {
+    switch (type) {
+    case FieldType::BOOL:
+    case FieldType::INT8:
+    case FieldType::UINT8:
+        return 1U;
+    case FieldType::INT16:
+    case FieldType::UINT16:
+        return 2U;
+    case FieldType::INT32:
+    case FieldType::UINT32:
+    case FieldType::FLOAT:
+        return 4U;
+    case FieldType::DOUBLE:
+        return 8U;
+    case FieldType::STRING:
+    case FieldType::BYTES:
+        break;
+    }
+    return 0U;
+}
+
+std::size_t generatedWidth(const FieldDef &field) {
+    const auto width = elementWidth(field.type);
+    return width == 0U ? field.size : width * field.arrayLength;
+}
+
+bool integerType(FieldType type) { return type != FieldType::FLOAT && type != FieldType::DOUBLE; }
+
+// Full value range of an integer field type.
+bool typeRange(FieldType type, double &min, double &max) {
+    switch (type) {
+    case FieldType::BOOL:
+        min = 0.0;
+        max = 1.0;
+        return true;
+    case FieldType::INT8:
+        min = std::numeric_limits<std::int8_t>::min();
+        max = std::numeric_limits<std::int8_t>::max();
+        return true;
+    case FieldType::UINT8:
+        min = 0.0;
+        max = std::numeric_limits<std::uint8_t>::max();
+        return true;
+    case FieldType::INT16:
+        min = std::numeric_limits<std::int16_t>::min();
+        max = std::numeric_limits<std::int16_t>::max();
+        return true;
+    case FieldType::UINT16:
+        min = 0.0;
+        max = std::numeric_limits<std::uint16_t>::max();
+        return true;
+    case FieldType::INT32:
+        min = std::numeric_limits<std::int32_t>::min();
+        max = std::numeric_limits<std::int32_t>::max();
+        return true;
+    case FieldType::UINT32:
+        min = 0.0;
+        max = std::numeric_limits<std::uint32_t>::max();
+        return true;
+    case FieldType::FLOAT:
+    case FieldType::DOUBLE:
+    case FieldType::STRING:
+    case FieldType::BYTES:
+        break;
+    }
+    return false;
+}
+
+template <typename T> void store(std::uint8_t *dst, double value) {
+    T converted{};
+    if constexpr (std::is_integral_v<T>) {
+        const auto rounded = std::round(value);
+        if (std::isnan(rounded)) {
+            converted = T{};
+        } else if (rounded <= static_cast<double>(std::numeric_limits<T>::min())) {
+            converted = std::numeric_limits<T>::min();
+        } else if (rounded >= static_cast<double>(std::numeric_limits<T>::max())) {
+            converted = std::numeric_limits<T>::max();
+        } else {
+            converted = static_cast<T>(rounded);
+        }
+    } else {
+        converted = static_cast<T>(value);
+    }
+    std::memcpy(dst, &converted, sizeof(T));
+}
+
+std::uint64_t xorshift(std::uint64_t &state) {
+    state ^= state << 13U;
+    state ^= state >> 7U;
+    state ^= state << 17U;
+    return state;
+}
+
+} // namespace
+
+// ITU-T O.150 polynomials for orders 7, 9, 15, 23 and 31.
+std::uint32_t prbsTap(std::uint32_t order) {
+    switch (order) {
+    case 7:
+        return 6U;
+    case 9:
+        return 5U;
+    case 15:
+        return 14U;
+    case 23:
+        return 18U;
+    case 31:
+        return 28U;
+    default:
+        return 0U;
+    }
+}
+
+std::shared_ptr<TxGeneratorSet> TxGeneratorSet::compile(const std::vector<FieldGeneratorDef> &defs,
+                                                        const DatasetDef &dataset, std::string &error) {
+    auto set = std::make_shared<TxGeneratorSet>();
+    const auto bufferSize = dataset.computeSize();
+    for (const auto &def : defs) {
+        const auto *field = dataset.findField(def.field);
+        if (field == nullptr) {
+            error = "generator field '" + def.field + "' not found in dataset " + dataset.name;
+            return nullptr;
+        }
+        Generator generator;
+        generator.kind = def.kind;
+        generator.type = field->type;
+        generator.offset = field->offset;
+        generator.width = generatedWidth(*field);
+        if (generator.width == 0U || generator.offset + generator.width > bufferSize) {
+            error = "generator field '" + def.field + "' lies outside the TX buffer";
+            return nullptr;
+        }
+
+        if (def.kind == FieldGeneratorKind::Prbs) {
+            generator.order = def.order;
+            generator.tap = prbsTap(def.order);
+            if (generator.tap == 0U) {
+                error = "PRBS order for '" + def.field + "' must be 7, 9, 15, 23 or 31";
+                return nullptr;
+            }
+            const auto mask = (1U << def.order) - 1U;
+            generator.lfsr = def.seed & mask;
+            if (generator.lfsr == 0U) {
+                generator.lfsr = 1U;
+            }
+            generator.pattern.assign(generator.width, 0U);
+            set->generators.push_back(std::move(generator));
+            continue;
+        }
+
+        if (field->arrayLength != 1U || elementWidth(field->type) == 0U) {
+            error = "generator field '" + def.field + "' is not a numeric scalar; only PRBS can fill it";
+            return nullptr;
+        }
+        generator.min = def.min;
+        generator.max = def.max;
+        if (def.max <= def.min && !typeRange(field->type, generator.min, generator.max)) {
+            error = "generator for '" + def.field + "' needs min < max";
+            return nullptr;
+        }
+        generator.step = def.step;
+        generator.periodNs = static_cast<double>(std::chrono::nanoseconds(def.period).count());
+        const bool waveform = def.kind == FieldGeneratorKind::Sine || def.kind == FieldGeneratorKind::Square ||
+                              def.kind == FieldGeneratorKind::Sawtooth;
+        if (waveform && generator.periodNs <= 0.0) {
+            error = "generator for '" + def.field + "' needs a period";
+            return nullptr;
+        }
+        generator.value = def.kind == FieldGeneratorKind::RandomWalk ? (generator.min + generator.max) / 2.0
+                                                                     : generator.min;
+        generator.random = 0x9E3779B97F4A7C15ULL ^ def.seed;
+        set->generators.push_back(std::move(generator));
+    }
+    return set;
+}
+
+void TxGeneratorSet::advance(std::uint8_t *buffer, std::size_t size, std::chrono::steady_clock::time_point now) {
+    if (stepCount == 0U) {
+        start = now;
+    }
+    const auto elapsedNs = static_cast<double>(std::chrono::nanoseconds(now - start).count());
+    for (auto &generator : generators) {
+        switch (generator.kind) {
+        case FieldGeneratorKind::Counter:
+            if (stepCount > 0U) {
+                // Integer counters include max itself before wrapping back to min.
+                const auto span = generator.max - generator.min + (integerType(generator.type) ? 1.0 : 0.0);
+                auto offset = std::fmod(generator.value + generator.step - generator.min, span);
+                if (offset < 0.0) {
+                    offset += span;
+                }
+                generator.value = generator.min + offset;
+            }
+            break;
+        case FieldGeneratorKind::Ramp:
+            if (stepCount > 0U) {
+                generator.value += generator.step * generator.direction;
+                if (generator.value > generator.max) {
+                    generator.value = generator.max - (generator.value - generator.max);
+                    generator.direction = -1.0;
+                } else if (generator.value < generator.min) {
+                    generator.value = generator.min + (generator.min - generator.value);
+                    generator.direction = 1.0;
+                }
+                generator.value = std::clamp(generator.value, generator.min, generator.max);
+            }
+            break;
+        case FieldGeneratorKind::Sine: {
+            const auto phase = std::fmod(elapsedNs, generator.periodNs) / generator.periodNs;
+            generator.value = (generator.min + generator.max) / 2.0 +
+                              (generator.max - generator.min) / 2.0 * std::sin(kTwoPi * phase);
+            break;
+        }
+        case FieldGeneratorKind::Square: {
+            const auto phase = std::fmod(elapsedNs, generator.periodNs) / generator.periodNs;
+            generator.value = phase < 0.5 ? generator.max : generator.min;
+            break;
+        }
+        case FieldGeneratorKind::Sawtooth: {
+            const auto phase = std::fmod(elapsedNs, generator.periodNs) / generator.periodNs;
+            generator.value = generator.min + (generator.max - generator.min) * phase;
+            break;
+        }
+        case FieldGeneratorKind::RandomWalk:
+            if (stepCount > 0U) {
+                // Uniform move in [-step, step) from the top 53 bits.
+                const auto unit = static_cast<double>(xorshift(generator.random) >> 11U) * 0x1.0p-53;
+                generator.value =
+                    std::clamp(generator.value + (unit * 2.0 - 1.0) * generator.step, generator.min, generator.max);
+            }
+            break;
+        case FieldGeneratorKind::Prbs: {
+            // Fibonacci LFSR, one output bit per shift, most significant bit of each byte first.
+            const auto mask = (1U << generator.order) - 1U;
+            auto lfsr = generator.lfsr;
+            for (auto &byte : generator.pattern) {
+                std::uint32_t bits = 0U;
+                for (int bit = 0; bit < 8; ++bit) {
+                    const auto feedback = ((lfsr >> (generator.order - 1U)) ^ (lfsr >> (generator.tap - 1U))) & 1U;
+                    lfsr = ((lfsr << 1U) | feedback) & mask;
+                    bits = (bits << 1U) | feedback;
+                }
+                byte = static_cast<std::uint8_t>(bits);
+            }
+            generator.lfsr = lfsr;
+            break;
+        }
+        }
+    }
+    ++stepCount;
+    write(buffer, size);
+}
+
+void TxGeneratorSet::write(std::uint8_t *buffer, std::size_t size) const {
+    for (const auto &generator : generators) {
+        if (generator.offset + generator.width > size) {
+            continue;
+        }
+        writeOne(generator, buffer + generator.offset);
+    }
+}
+
+void TxGeneratorSet::writeOne(const Generator &generator, std::uint8_t *dst) const {
+    if (generator.kind == FieldGeneratorKind::Prbs) {
+        std::memcpy(dst, generator.pattern.data(), generator.pattern.size());
+        return;
+    }
+    switch (generator.type) {
+    case FieldType::BOOL:
+        dst[0] = generator.value >= 0.5 ? 1U : 0U;
+        break;
+    case FieldType::INT8:
+        store<std::int8_t>(dst, generator.value);
+        break;
+    case FieldType::UINT8:
+        store<std::uint8_t>(dst, generator.value);
+        break;
+    case FieldType::INT16:
+        store<std::int16_t>(dst, generator.value);
+        break;
+    case FieldType::UINT16:
+        store<std::uint16_t>(dst, generator.value);
+        break;
+    case FieldType::INT32:
+        store<std::int32_t>(dst, generator.value);
+        break;
+    case FieldType::UINT32:
+        store<std::uint32_t>(dst, generator.value);
+        break;
+    case FieldType::FLOAT:
+        store<float>(dst, generator.value);
+        break;
+    case FieldType::DOUBLE:
+        store<double>(dst, generator.value);
+        break;
+    case FieldType::STRING:
+    case FieldType::BYTES:
+        break;
+    }
+}
+
+} // namespace trdp
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "telegram_model.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace trdp {
+
+// Second tap k of the maximal-length polynomial x^order + x^k + 1 behind PRBS fields; 0 for unsupported orders.
+std::uint32_t prbsTap(std::uint32_t order);
+
+/**
+ * Precompiled field generators of one TX PD telegram.
+ *
+ * Each generator is resolved once to a byte offset, width and type in the dataset. advance() steps every
+ * generator and writes the new values straight into the TX buffer, so cyclic publication needs no field lookups
+ * or FieldValue conversions. Counters, ramps and random walks step once per publication; sine, square and
+ * sawtooth waveforms follow the time since the first publication; PRBS generators fill the field with the next
+ * bytes of a maximal-length LFSR sequence.
+ *
+ * Not thread-safe: the engine owns a set per endpoint and uses it under its state lock.
+ */
+class TxGeneratorSet {
+  public:
+    // Build the set; returns nullptr and fills error when a generator cannot be resolved against dataset.
+    static std::shared_ptr<TxGeneratorSet> compile(const std::vector<FieldGeneratorDef> &defs,
+                                                   const DatasetDef &dataset, std::string &error);
+
+    // Step every generator for a publication at now and write the values into buffer.
+    void advance(std::uint8_t *buffer, std::size_t size, std::chrono::steady_clock::time_point now);
+
+    [[nodiscard]] std::size_t size() const noexcept { return generators.size(); }
+    [[nodiscard]] std::uint64_t steps() const noexcept { return stepCount; }
+
+  private:
+    struct Generator {
+        FieldGeneratorKind kind{FieldGeneratorKind::Counter};
+        FieldType type{FieldType::UINT8};
+        std::size_t offset{0};
+        std::size_t width{0};
+        double min{0.0};
+        double max{0.0};
+        double step{0.0};
+        double periodNs{0.0};
+        double value{0.0};
+        // Ramp direction (+1/-1).
+        double direction{1.0};
+        // Random walk state (xorshift64) or PRBS shift register and its taps.
+        std::uint64_t random{0};
+        std::uint32_t lfsr{0};
+        std::uint32_t order{0};
+        std::uint32_t tap{0};
+        // Last PRBS bytes, rewritten by write().
+        std::vector<std::uint8_t> pattern;
+    };
+
+    void write(std::uint8_t *buffer, std::size_t size) const;
+    void writeOne(const Generator &generator, std::uint8_t *dst) const;
+
+    std::vector<Generator> generators;
+    std::chrono::steady_clock::time_point start{};
+    std::uint64_t stepCount{0};
+};
+
+} // namespace trdp
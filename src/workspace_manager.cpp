@@ -0,0 +1,161 @@
+#include "workspace_manager.h"
+
+#include "plugins/TelegramHub.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+namespace trdp {
+
+namespace {
+bool validName(const std::string &name) {
+    return !name.empty() && name.size() <= 64U && std::all_of(name.begin(), name.end(), [](unsigned char c) {
+        return std::isalnum(c) != 0 || c == '-' || c == '_';
+    });
+}
+} // namespace
+
+Workspace::Workspace(std::string name, std::string xmlPath)
+    : workspaceName(std::move(name)), xml(std::move(xmlPath)), ownedRegistry(std::make_unique<TelegramRegistry>()) {
+    ownedEngine = std::make_unique<TrdpEngine>(*ownedRegistry, workspaceName);
+    ownedHub = std::make_unique<TelegramHub>(*ownedRegistry, *ownedEngine);
+    ownedEngine->setHub(ownedHub.get());
+}
+
+Workspace::~Workspace() {
+    if (ownedEngine) {
+        ownedEngine->stop();
+        ownedEngine->setHub(nullptr);
+    }
+    if (ownedHub) {
+        ownedHub->closeConnections();
+    }
+}
+
+std::shared_ptr<Workspace> Workspace::makeDefault() {
+    auto workspace = std::shared_ptr<Workspace>(new Workspace());
+    workspace->workspaceName = WorkspaceManager::kDefaultName;
+    return workspace;
+}
+
+TelegramRegistry &Workspace::registry() const {
+    return ownedRegistry ? *ownedRegistry : TelegramRegistry::instance();
+}
+
+TrdpEngine &Workspace::engine() const { return ownedEngine ? *ownedEngine : TrdpEngine::instance(); }
+
+TelegramHub *Workspace::hub() const { return ownedHub ? ownedHub.get() : TelegramHub::instance(); }
+
+bool Workspace::registryReady() const { return ownedRegistry || ensureRegistryInitialized(); }
+
+WorkspaceManager::WorkspaceManager() : defaultWorkspace(Workspace::makeDefault()) {}
+
+WorkspaceManager &WorkspaceManager::instance() {
+    static WorkspaceManager manager;
+    return manager;
+}
+
+std::shared_ptr<Workspace> WorkspaceManager::create(const Config &config, std::string &error) {
+    if (!validName(config.name)) {
+        error = "Invalid workspace name; use letters, digits, '-' and '_'";
+        return nullptr;
+    }
+    if (config.name == kDefaultName) {
+        error = "The default workspace always exists";
+        return nullptr;
+    }
+    if (config.xmlPath.empty()) {
+        error = "Missing XML path";
+        return nullptr;
+    }
+    {
+        std::lock_guard lock(mtx);
+        if (workspaces.count(config.name) != 0U) {
+            error = "Workspace " + config.name + " already exists";
+            return nullptr;
+        }
+    }
+
+    // Loading and starting happen outside the lock; a concurrent create of the same name is caught below.
+    auto workspace = std::make_shared<Workspace>(config.name, config.xmlPath);
+    if (!loadFromTauXml(config.xmlPath, workspace->registry())) {
+        error = "Failed to load XML " + config.xmlPath;
+        return nullptr;
+    }
+    if (!workspace->engine().start(config.trdp)) {
+        error = "TRDP engine failed to start";
+        return nullptr;
+    }
+
+    std::lock_guard lock(mtx);
+    if (!workspaces.emplace(config.name, workspace).second) {
+        error = "Workspace " + config.name + " already exists";
+        return nullptr;
+    }
+    std::cout << "[TRDP] Workspace " << config.name << " started with "
+              << workspace->registry().snapshot()->telegrams.size() << " telegrams from " << config.xmlPath << std::endl;
+    return workspace;
+}
+
+bool WorkspaceManager::remove(const std::string &name, std::string &error) {
+    std::shared_ptr<Workspace> workspace;
+    {
+        std::lock_guard lock(mtx);
+        if (name.empty() || name == kDefaultName) {
+            error = "The default workspace cannot be removed";
+            return false;
+        }
+        const auto it = workspaces.find(name);
+        if (it == workspaces.end()) {
+            error = "Unknown workspace " + name;
+            return false;
+        }
+        workspace = std::move(it->second);
+        workspaces.erase(it);
+    }
+    // Requests still holding the workspace keep it alive, but it no longer runs.
+    workspace->engine().stop();
+    if (auto *hub = workspace->hub()) {
+        hub->closeConnections();
+    }
+    std::cout << "[TRDP] Workspace " << name << " removed" << std::endl;
+    return true;
+}
+
+std::shared_ptr<Workspace> WorkspaceManager::find(const std::string &name) {
+    std::lock_guard lock(mtx);
+    if (name.empty() || name == kDefaultName) {
+        return defaultWorkspace;
+    }
+    const auto it = workspaces.find(name);
+    return it != workspaces.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<Workspace> WorkspaceManager::resolve(const drogon::HttpRequestPtr &req) {
+    return find(req ? req->getParameter("workspace") : std::string());
+}
+
+std::vector<std::shared_ptr<Workspace>> WorkspaceManager::list() {
+    std::lock_guard lock(mtx);
+    std::vector<std::shared_ptr<Workspace>> result{defaultWorkspace};
+    for (const auto &[name, workspace] : workspaces) {
+        (void)name;
+        result.push_back(workspace);
+    }
+    return result;
+}
+
+void WorkspaceManager::stopAll() {
+    std::map<std::string, std::shared_ptr<Workspace>> stopping;
+    {
+        std::lock_guard lock(mtx);
+        stopping.swap(workspaces);
+    }
+    for (auto &[name, workspace] : stopping) {
+        (void)name;
+        workspace->engine().stop();
+    }
+}
+
+} // namespace trdp
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "telegram_model.h"
+#include "trdp_engine.h"
+
+#include <drogon/HttpRequest.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trdp {
+
+class TelegramHub;
+
+/**
+ * One simulated device: a telegram registry loaded from its own XML, an engine with its own sessions, interface
+ * binding and worker thread, and a hub for its WebSocket clients.
+ *
+ * The "default" workspace wraps the process singletons (TelegramRegistry::instance(), TrdpEngine::instance() and
+ * the TelegramHub plugin), so code that does not know about workspaces keeps working on it.
+ */
+class Workspace {
+  public:
+    // Additional workspace owning its registry, engine and hub.
+    Workspace(std::string name, std::string xmlPath);
+    ~Workspace();
+    Workspace(const Workspace &) = delete;
+    Workspace &operator=(const Workspace &) = delete;
+
+    static std::shared_ptr<Workspace> makeDefault();
+
+    [[nodiscard]] const std::string &name() const noexcept { return workspaceName; }
+    [[nodiscard]] const std::string &xmlPath() const noexcept { return xml; }
+    [[nodiscard]] bool isDefault() const noexcept { return !ownedEngine; }
+
+    TelegramRegistry &registry() const;
+    TrdpEngine &engine() const;
+    // Null while the default hub plugin is not running.
+    TelegramHub *hub() const;
+    // The default registry is loaded lazily from the default XML; workspaces are loaded when created.
+    bool registryReady() const;
+
+  private:
+    Workspace() = default;
+
+    std::string workspaceName;
+    std::string xml;
+    // Declared so the engine (and its worker) goes first on destruction.
+    std::unique_ptr<TelegramRegistry> ownedRegistry;
+    std::unique_ptr<TelegramHub> ownedHub;
+    std::unique_ptr<TrdpEngine> ownedEngine;
+};
+
+/**
+ * Process-wide set of workspaces. REST and WebSocket routes pick one with the "workspace" query parameter; without
+ * it they address the default workspace.
+ */
+class WorkspaceManager {
+  public:
+    static constexpr const char *kDefaultName = "default";
+
+    struct Config {
+        std::string name;
+        std::string xmlPath;
+        TrdpEngine::TrdpConfig trdp;
+    };
+
+    static WorkspaceManager &instance();
+
+    // Load the XML and start the engine; nullptr with error filled when the name is taken or startup fails.
+    std::shared_ptr<Workspace> create(const Config &config, std::string &error);
+    // Stop and drop a workspace; the default one cannot be removed.
+    bool remove(const std::string &name, std::string &error);
+
+    // nullptr for unknown names; an empty name is the default workspace.
+    std::shared_ptr<Workspace> find(const std::string &name);
+    std::shared_ptr<Workspace> resolve(const drogon::HttpRequestPtr &req);
+    std::vector<std::shared_ptr<Workspace>> list();
+
+    // Stop every additional workspace (process shutdown).
+    void stopAll();
+
+  private:
+    WorkspaceManager();
+
+    std::mutex mtx;
+    std::shared_ptr<Workspace> defaultWorkspace;
+    std::map<std::string, std::shared_ptr<Workspace>> workspaces;
+};
+
+} // namespace trdp